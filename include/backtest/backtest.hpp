@@ -1,19 +1,61 @@
+#pragma once
 #include "broker-interface/broker.hpp"
 #include "broker-interface/instruments.hpp"
 #include "broker-interface/subscription.hpp"
 #include "data/data_stream.hpp"
 #include "trader/trader.hpp"
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <optional>
 
 namespace midas::backtest {
 
 struct BacktestResult {
   TradeSummary summary;
+  /**
+   * The history replayed to the trader
+   */
   std::shared_ptr<DataStream> originalStream;
   std::string orderDetails;
+  /**
+   * Bars replayed per second of wall time, trader and order simulation
+   * included
+   */
+  double barsPerSecond;
+};
+
+
+/**
+ * How indicators are computed during a back test
+ */
+enum class BacktestMode {
+  /**
+   * As in live trading, one candle at a time while the bars are replayed
+   */
+  Streaming,
+  /**
+   * Over the whole history before the replay starts, traders then read
+   * precomputed values. Same decisions, without evaluating indicators in the
+   * loop.
+   */
+  FeatureMatrix,
 };
 
+/**
+ * A replay stops as soon as it crosses one of these, the rest of the
+ * history is not worth replaying
+ */
+struct BacktestLimits {
+  /**
+   * Largest fall of the realized profit from its peak
+   */
+  std::optional<double> maxDrawdown{};
+  /**
+   * Most orders the trader may transmit
+   */
+  std::optional<std::size_t> maxOrders{};
+};
 
 struct BacktestInterval {
   /**
@@ -30,11 +72,26 @@ BacktestInterval operator""_days(unsigned long long durationTime);
 
 }; // namespace literals
 
-BacktestResult performBacktest(
-    InstrumentEnum instrument, BacktestInterval interval,
-    std::function<std::unique_ptr<trader::Trader>(
-        std::shared_ptr<DataStream>, std::shared_ptr<midas::OrderManager>)>
-        traderFactory,
-    Broker &broker);
+/**
+ * Creates the trader under test, reading its candles from the given source
+ */
+typedef std::function<std::unique_ptr<trader::Trader>(
+    const trader::CandleSource &, std::shared_ptr<midas::OrderManager>)>
+    trader_factory_t;
+
+BacktestResult performBacktest(InstrumentEnum instrument,
+                               BacktestInterval interval,
+                               trader_factory_t traderFactory, Broker &broker,
+                               BacktestMode mode = BacktestMode::Streaming);
+
+/**
+ * Replays historical data to a trader, as if sent by a broker.
+ * A cursor moves over the history and the trader reads the bars up to it in
+ * place, no bar is copied into a stream on the way.
+ */
+BacktestResult replayBacktest(InstrumentEnum instrument,
+                              std::shared_ptr<DataStream> historicalData,
+                              trader_factory_t traderFactory,
+                              BacktestMode mode = BacktestMode::Streaming);
 
 }; // namespace midas::backtest
\ No newline at end of file
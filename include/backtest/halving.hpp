@@ -0,0 +1,100 @@
+#pragma once
+#include "backtest/backtest.hpp"
+#include "backtest/sweep.hpp"
+#include "broker-interface/instruments.hpp"
+#include "broker-interface/trades_summary.hpp"
+#include "data/data_stream.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Strategy search that spends little time on losing parameters.
+ * Every candidate is first replayed over a short prefix of the history, only
+ * the best of them are replayed further, over a horizon that grows with
+ * every round, until the few left reach the end of the history. Survivors
+ * resume from where they stopped rather than replaying the prefix again.
+ * Candidates crossing a limit, such as a drawdown, are dropped at once.
+ */
+namespace midas::backtest::halving {
+
+struct Options {
+  /**
+   * Bars every candidate is replayed over in the first round
+   */
+  std::size_t initialBars{4096};
+  /**
+   * Only the best 1 / reduction of the candidates of a round go on to the
+   * next, which replays reduction times as many bars
+   */
+  std::size_t reduction{3};
+  /**
+   * How candidates are replayed and ranked
+   */
+  sweep::Options search{};
+  /**
+   * Candidates that cross them are dropped
+   */
+  BacktestLimits limits{};
+};
+
+struct Candidate {
+  /**
+   * Position of the parameters in the searched list
+   */
+  std::size_t index;
+  sweep::parameters_t parameters;
+  /**
+   * As of the last bar it was replayed over
+   */
+  TradeSummary summary;
+  double score;
+  /**
+   * Number of bars it was replayed over before it was dropped, the size of
+   * the history for the ones that made it to the end
+   */
+  std::size_t bars;
+  /**
+   * It crossed a limit
+   */
+  bool aborted;
+};
+
+struct Result {
+  /**
+   * Candidates that were replayed further rank above the ones dropped
+   * before them, the ones that crossed a limit last. Then by score, best
+   * first, then by index.
+   */
+  std::vector<Candidate> candidates;
+  /**
+   * Bars replayed over all candidates and rounds. A full sweep replays every
+   * bar of the history once per candidate.
+   */
+  std::size_t replayedBars{0};
+};
+
+/**
+ * @throws std::invalid_argument if the reduction is below 2 or there are
+ * no initial bars
+ */
+Result successiveHalving(InstrumentEnum instrument,
+                         std::shared_ptr<DataStream> history,
+                         const std::vector<sweep::parameters_t> &parameters,
+                         sweep::trader_factory_t traderFactory,
+                         const Options &options = {});
+
+/**
+ * Successive halving with every trade off between the number of candidates
+ * and the length of the first round, from many candidates over
+ * initialBars to a few replayed over the whole history straight away.
+ * Candidates are drawn at random from the space, indices count across every
+ * trade off.
+ */
+Result hyperband(InstrumentEnum instrument, std::shared_ptr<DataStream> history,
+                 const sweep::ParameterSpace &space,
+                 sweep::trader_factory_t traderFactory, std::uint64_t seed,
+                 const Options &options = {});
+} // namespace midas::backtest::halving
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * Monte Carlo resampling of the trades of a back test.
+ * A back test is one ordering of its trades, resampling them many times
+ * shows the range of returns and drawdowns the same trades could have given.
+ * Paths draw their random numbers from a counter based generator, keyed by
+ * the seed and the path, so they are generated a batch at a time and the
+ * results do not depend on the number of workers.
+ */
+namespace midas::backtest::montecarlo {
+
+enum class Resampling {
+  /**
+   * Trades are drawn with replacement, paths have as many trades as the
+   * back test
+   */
+  Bootstrap,
+  /**
+   * Trades are shuffled. Every path ends at the same return, only the
+   * drawdowns vary.
+   */
+  Permutation,
+};
+
+struct Options {
+  std::size_t paths{10000};
+  Resampling resampling{Resampling::Bootstrap};
+  std::uint64_t seed{0};
+  /**
+   * Paths simulated at once, every core if zero
+   */
+  std::size_t concurrency{0};
+};
+
+/**
+ * Values of every path, ascending
+ */
+struct Distribution {
+  std::vector<double> values;
+
+  /**
+   * Value below which a fraction p of the paths fall, NaN if there are none
+   */
+  double quantile(double p) const;
+  double mean() const;
+};
+
+struct Result {
+  /**
+   * Sum of the returns of the trades of a path
+   */
+  Distribution totalReturn;
+  /**
+   * Largest fall from a peak of the running sum of a path, zero or more
+   */
+  Distribution maxDrawdown;
+};
+
+/**
+ * @param tradeReturns pnl of each trade, in the order they were made
+ */
+Result resample(std::span<const double> tradeReturns,
+                const Options &options = {});
+} // namespace midas::backtest::montecarlo
@@ -0,0 +1,69 @@
+#pragma once
+#include "backtest/backtest.hpp"
+#include "broker-interface/broker.hpp"
+#include "broker-interface/instruments.hpp"
+#include "broker-interface/trades_summary.hpp"
+#include "data/data_stream.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace midas::backtest {
+
+/**
+ * An instrument of a portfolio and the trader trading it
+ */
+struct PortfolioLeg {
+  InstrumentEnum instrument;
+  std::shared_ptr<DataStream> history;
+  trader_factory_t traderFactory;
+};
+
+struct PortfolioResult {
+  /**
+   * Orders and realized pnl of each instrument
+   */
+  std::unordered_map<InstrumentEnum, TradeSummary> instruments;
+  /**
+   * Every order of the portfolio, the ending balance is the sum of the
+   * realized pnl of every instrument
+   */
+  TradeSummary aggregate;
+  std::string orderDetails;
+  /**
+   * Distinct timestamps replayed
+   */
+  std::size_t epochs;
+  /**
+   * Bars of every instrument replayed per second of wall time
+   */
+  double barsPerSecond;
+};
+
+/**
+ * Replays the histories of several instruments together, in time order, to
+ * their traders, which share one order manager.
+ * The histories are merged on the fly by timestamp, through a heap over a
+ * cursor into each of them, no merged copy is made. Bars with the same
+ * timestamp make an epoch: the orders of every instrument are simulated
+ * first, then the traders of the epoch decide in parallel, traders of
+ * different instruments only share the order manager. The orders they
+ * transmit reach it in leg order once they all decided.
+ * @param concurrency traders deciding at once, every core if zero
+ * @throws std::invalid_argument if an instrument has more than one leg
+ */
+PortfolioResult replayPortfolio(const std::vector<PortfolioLeg> &legs,
+                                BacktestMode mode = BacktestMode::Streaming,
+                                std::size_t concurrency = 0);
+
+/**
+ * Loads the history of every instrument over the interval, as
+ * performBacktest does, then replays them together
+ */
+PortfolioResult performPortfolioBacktest(
+    const std::vector<std::pair<InstrumentEnum, trader_factory_t>> &traders,
+    BacktestInterval interval, Broker &broker,
+    BacktestMode mode = BacktestMode::Streaming);
+} // namespace midas::backtest
@@ -0,0 +1,181 @@
+#pragma once
+#include "broker-interface/order.hpp"
+#include "data/data_stream.hpp"
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <vector>
+
+/**
+ * Screening of trading rules over a whole history at once.
+ * Entry and exit rules are boolean expressions over indicator columns, such
+ * as fast > slow && macd.macd > macd.signal && rsi < 65, evaluated a column
+ * at a time. Fills are found by scanning the columns rather than by replaying
+ * bars through a trader. Screening a variant costs a few passes over the
+ * history, so many rule and parameter variants can be tried and only the
+ * promising ones back tested with performBacktest.
+ */
+namespace midas::backtest::screening {
+
+/**
+ * One value per candle of a Screen
+ */
+struct Column {
+  std::size_t index;
+  // no ordering, comparing columns builds conditions
+  bool operator==(const Column &) const = default;
+};
+
+/**
+ * A column or a constant
+ */
+struct Operand {
+  Operand(Column column) : column(column) {}
+  Operand(double constant) : constant(constant) {}
+  std::optional<Column> column;
+  double constant{0};
+};
+
+class Condition;
+Condition operator<(Operand left, Operand right);
+Condition operator<=(Operand left, Operand right);
+Condition operator>(Operand left, Operand right);
+Condition operator>=(Operand left, Operand right);
+Condition operator&&(Condition left, const Condition &right);
+Condition operator||(Condition left, const Condition &right);
+Condition operator!(Condition condition);
+
+/**
+ * Boolean column expression, one value per candle. Where an operand is NaN,
+ * such as an indicator that is not ready yet, it is false, negated or not.
+ */
+class Condition {
+  enum class Operation { Less, LessOrEqual, And, Or, Not };
+  struct Instruction {
+    Operation operation;
+    Operand left{0.0}, right{0.0};
+  };
+  // in postfix order, comparisons push a column and the others combine the
+  // columns on top
+  std::vector<Instruction> program;
+
+  static Condition compare(Operation operation, Operand left, Operand right);
+  static Condition combine(Operation operation, Condition left,
+                           const Condition &right);
+
+  friend class Screen;
+  friend Condition operator<(Operand left, Operand right);
+  friend Condition operator<=(Operand left, Operand right);
+  friend Condition operator>(Operand left, Operand right);
+  friend Condition operator>=(Operand left, Operand right);
+  friend Condition operator&&(Condition left, const Condition &right);
+  friend Condition operator||(Condition left, const Condition &right);
+  friend Condition operator!(Condition condition);
+};
+
+/**
+ * A bracket entered at the open after every candle the entry is true on,
+ * while there is no position
+ */
+struct Rules {
+  Condition entry;
+  OrderDirection direction{OrderDirection::BUY};
+  /**
+   * Distances of the profit taker and the stop loss from the entry price
+   */
+  double profitOffset{0}, stopLossOffset{0};
+  /**
+   * Leaves at the open after the candle it is true on, unless the bracket
+   * filled first
+   */
+  std::optional<Condition> exit{};
+};
+
+/**
+ * Profits are per unit, in price, before commissions
+ */
+struct ScreeningResult {
+  std::size_t trades{0}, profitTakers{0}, stopLosses{0}, ruleExits{0};
+  double profit{0}, maxDrawdown{0};
+  /**
+   * A position was still open at the end of the history, it is valued at
+   * the last close
+   */
+  bool openAtEnd{false};
+};
+
+/**
+ * Candle columns of a history and the indicators computed over them.
+ * Indicators are computed once, on first request, with the batch kernels.
+ */
+class Screen {
+public:
+  struct MacdColumns {
+    Column macd, signal, histogram;
+  };
+  struct BandColumns {
+    Column upper, middle, lower;
+  };
+
+  /**
+   * @param candleSizeSeconds the bars are folded into candles of this size,
+   * by default the bars are the candles. A last candle that is not complete
+   * is left out.
+   */
+  explicit Screen(const DataStream &history, std::size_t candleSizeSeconds = 0);
+
+  inline std::size_t size() const { return columns.front().size(); }
+  inline Column open() const { return {0}; }
+  inline Column high() const { return {1}; }
+  inline Column low() const { return {2}; }
+  inline Column close() const { return {3}; }
+  inline Column volume() const { return {4}; }
+  Column ema(Column input, int period);
+  Column sma(Column input, int period);
+  Column rsi(Column input, int period);
+  /**
+   * On the highs, lows and closes of the candles
+   */
+  Column atr(int period);
+  MacdColumns macd(Column input, int fastPeriod, int slowPeriod,
+                   int signalPeriod);
+  BandColumns bollingerBands(Column input, int period, double deviationsUp,
+                             double deviationsDown);
+
+  /**
+   * @throws std::invalid_argument if the column is not part of this screen
+   */
+  std::span<const double> values(Column column) const;
+  /**
+   * One byte per candle, 1 where the condition holds
+   */
+  std::vector<std::uint8_t> evaluate(const Condition &condition) const;
+  /**
+   * Simulates the fills of rules over the whole history, one position at a
+   * time. Brackets are checked from the candle after the entry, like the
+   * back test order manager does, and the stop loss wins when a candle
+   * reaches both levels.
+   */
+  ScreeningResult run(const Rules &rules) const;
+
+private:
+  enum class Type { Ema, Sma, Rsi, Atr, Macd, BollingerBands };
+  struct Key {
+    Type type;
+    std::vector<double> parameters;
+    std::vector<std::size_t> inputs;
+    auto operator<=>(const Key &) const = default;
+  };
+  std::vector<std::vector<double>> columns;
+  std::map<Key, std::size_t> registry;
+
+  /**
+   * Adds outputs columns for key unless it was computed before
+   * @return the first column of key and whether it has to be computed
+   */
+  std::pair<Column, bool> add(Key key, std::size_t outputs);
+};
+} // namespace midas::backtest::screening
@@ -0,0 +1,142 @@
+#pragma once
+#include "backtest/backtest.hpp"
+#include "broker-interface/instruments.hpp"
+#include "broker-interface/order.hpp"
+#include "broker-interface/trades_summary.hpp"
+#include "data/data_stream.hpp"
+#include "trader/trader.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Back tests of many parameter sets of a strategy at once.
+ * Every run replays the same read only history through its own cursor, so
+ * the history is loaded once whatever the number of runs, and runs are
+ * spread over a pool of workers. Each run is independent of the others, the
+ * results do not depend on the number of workers.
+ */
+namespace midas::backtest::sweep {
+
+/**
+ * Values of the swept parameters of a run, by name
+ */
+typedef std::map<std::string, double> parameters_t;
+
+/**
+ * A parameter swept from min to max
+ */
+struct Dimension {
+  std::string name;
+  double min, max;
+  /**
+   * Values are min plus whole steps. Grids take every step, sampled values
+   * are rounded to the nearest one. With no step values are continuous and
+   * grids only take min and max.
+   */
+  double step{0};
+};
+
+class ParameterSpace {
+public:
+  /**
+   * @throws std::invalid_argument if max is below min, the step is negative
+   * or the name was added before
+   */
+  ParameterSpace &add(Dimension dimension);
+  inline const std::vector<Dimension> &dimensions() const {
+    return dimensionList;
+  }
+  /**
+   * Every combination of the values of the dimensions, the last dimension
+   * varies fastest
+   */
+  std::vector<parameters_t> grid() const;
+  /**
+   * Points drawn uniformly and independently
+   */
+  std::vector<parameters_t> random(std::size_t count,
+                                   std::uint64_t seed) const;
+  /**
+   * Every dimension is split into count equal strata and every stratum is
+   * sampled by exactly one point, which covers each dimension evenly with
+   * far fewer points than a grid
+   */
+  std::vector<parameters_t> latinHypercube(std::size_t count,
+                                           std::uint64_t seed) const;
+
+private:
+  std::vector<Dimension> dimensionList;
+};
+
+/**
+ * Creates the trader of a run from its parameters
+ */
+typedef std::function<std::unique_ptr<trader::Trader>(
+    const parameters_t &, const trader::CandleSource &,
+    std::shared_ptr<midas::OrderManager>)>
+    trader_factory_t;
+
+/**
+ * How runs are replayed and ranked, by the sweep and by the searches built
+ * on it
+ */
+struct Options {
+  BacktestMode mode{BacktestMode::Streaming};
+  /**
+   * Runs processed at once, every core if zero
+   */
+  std::size_t concurrency{0};
+  /**
+   * Runs are ranked by it, highest first. The ending balance if unset.
+   */
+  std::function<double(const TradeSummary &)> score{};
+
+  double scoreOf(const TradeSummary &summary) const;
+  /**
+   * Size of the task arena the runs are processed in
+   */
+  int workers() const;
+};
+
+/**
+ * Failed or undefined scores rank last
+ */
+double rankOf(double score);
+
+struct Run {
+  /**
+   * Position of the parameters in the swept list
+   */
+  std::size_t index;
+  parameters_t parameters;
+  TradeSummary summary;
+  double score;
+};
+
+/**
+ * Runs ranked by score, best first. Runs with equal scores keep the order of
+ * their parameters.
+ */
+struct Table {
+  std::vector<Run> runs;
+};
+
+/**
+ * One line per run, the parameters first, comma separated
+ */
+std::ostream &operator<<(std::ostream &stream, const Table &table);
+
+/**
+ * Back tests the trader with each of the parameters over the history.
+ * The history must not change until the sweep returns.
+ */
+Table run(InstrumentEnum instrument, std::shared_ptr<DataStream> history,
+          const std::vector<parameters_t> &parameters,
+          trader_factory_t traderFactory, const Options &options = {});
+} // namespace midas::backtest::sweep
@@ -0,0 +1,84 @@
+#pragma once
+#include "backtest/backtest.hpp"
+#include "backtest/sweep.hpp"
+#include "broker-interface/instruments.hpp"
+#include "broker-interface/trades_summary.hpp"
+#include "data/data_stream.hpp"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Walk forward analysis of a strategy.
+ * The history is split into windows, each made of an in sample part the
+ * parameters are picked on and the out of sample part that follows, which
+ * the picked parameters are then traded on. Only out of sample results say
+ * how the strategy does on data it was not fitted to. Every window and
+ * candidate replays the same shared history, in parallel.
+ */
+namespace midas::backtest::walkforward {
+
+struct Options {
+  std::size_t inSampleBars{0}, outOfSampleBars{0};
+  /**
+   * Bars between the starts of consecutive windows, outOfSampleBars if zero
+   * so that out of sample parts follow each other
+   */
+  std::size_t step{0};
+  /**
+   * In sample parts all start at the first bar and grow with every window,
+   * rather than rolling forward
+   */
+  bool anchored{false};
+  /**
+   * How replays are processed and candidates picked
+   */
+  sweep::Options search{};
+};
+
+struct Window {
+  /**
+   * Bars of the in sample part, then of the out of sample part, which ends
+   * before end. Relative to the first bar of the history.
+   */
+  std::size_t inSampleBegin, outOfSampleBegin, end;
+  /**
+   * Position of the picked parameters in the candidate list
+   */
+  std::size_t picked;
+  sweep::parameters_t parameters;
+  double inSampleScore;
+  TradeSummary outOfSample;
+  double outOfSampleScore;
+  /**
+   * Realized pnl of every out of sample trade, in order
+   */
+  std::vector<double> tradeReturns;
+};
+
+struct Result {
+  std::vector<Window> windows;
+  /**
+   * Out of sample trades of every window, in order
+   */
+  std::vector<double> tradeReturns;
+  /**
+   * Out of sample score per bar over in sample score per bar, summed over
+   * windows. Near 1 if the strategy trades as well on unseen data as on the
+   * data it was fitted to, NaN if the in sample score is zero.
+   */
+  double efficiency;
+};
+
+/**
+ * Picks the best of the candidates on the in sample part of every window
+ * and trades it on the out of sample part. In sample ties go to the first
+ * candidate. Bars before a part only warm the trader up.
+ * @throws std::invalid_argument if there are no candidates, either part is
+ * empty or no window fits in the history
+ */
+Result run(InstrumentEnum instrument, std::shared_ptr<DataStream> history,
+           const std::vector<sweep::parameters_t> &candidates,
+           sweep::trader_factory_t traderFactory, const Options &options);
+} // namespace midas::backtest::walkforward
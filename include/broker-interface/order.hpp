@@ -239,6 +239,9 @@ public:
 class SimpleOrder : public Order {
 
 public:
+  /**
+   * Always a whole number of ticks of the instrument
+   */
   double targetPrice;
   SimpleOrder(unsigned int requestedQuantity, OrderDirection direction,
               InstrumentEnum instrument, ExecutionType type,
@@ -5,6 +5,7 @@
 #ifndef POSITION_TRACKER_HPP
 #define POSITION_TRACKER_HPP
 #include "instruments.hpp"
+#include "tick_price.hpp"
 #include <boost/signals2.hpp>
 #include <mutex>
 
@@ -17,11 +18,14 @@ public:
 private:
   struct PositionEntry {
     int quantity{0};
-    double price{0};
+    TickPrice price;
   };
   struct Position {
     std::deque<PositionEntry> shorts, longs;
-    double total{0};
+    /**
+     * Realized profit as ticks times quantity, exact until converted
+     */
+    std::int64_t totalTicks{0};
   };
   std::unordered_map<InstrumentEnum, Position> positions;
   std::recursive_mutex mutex;
@@ -0,0 +1,85 @@
+#pragma once
+#include "instruments.hpp"
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <stdexcept>
+
+namespace midas {
+
+/**
+ * A price as a whole number of ticks.
+ * The tick size is not stored, it is implied by the instrument the price
+ * belongs to, see InstrumentSpec. Keeping prices as integers makes
+ * comparisons and accumulated profit exact.
+ */
+struct TickPrice {
+  std::int64_t ticks{0};
+
+  constexpr auto operator<=>(const TickPrice &) const = default;
+  constexpr TickPrice operator+(std::int64_t offset) const {
+    return {ticks + offset};
+  }
+  constexpr TickPrice operator-(std::int64_t offset) const {
+    return {ticks - offset};
+  }
+  constexpr std::int64_t operator-(const TickPrice &other) const {
+    return ticks - other.ticks;
+  }
+};
+
+/**
+ * Minimum price increment and contract multiplier of an instrument.
+ * All supported instruments have a tick size of 1 / ticksPerPoint.
+ */
+struct InstrumentSpec {
+  std::int64_t ticksPerPoint;
+  double multiplier;
+
+  constexpr double tickSize() const { return 1.0 / ticksPerPoint; }
+  /**
+   * Currency value of a one tick move for a single contract or share
+   */
+  constexpr double tickValue() const { return multiplier / ticksPerPoint; }
+  /**
+   * Nearest tick to price
+   */
+  inline TickPrice toTicks(double price) const {
+    return {std::llround(price * ticksPerPoint)};
+  }
+  /**
+   * Number of whole ticks closest to a price distance
+   */
+  inline std::int64_t ticksIn(double distance) const {
+    return std::llround(distance * ticksPerPoint);
+  }
+  inline double toPrice(TickPrice price) const {
+    // dividing yields the closest double to the decimal price
+    return static_cast<double>(price.ticks) / ticksPerPoint;
+  }
+  inline double roundToTick(double price) const {
+    return toPrice(toTicks(price));
+  }
+  /**
+   * Currency value of a move of ticks for a single contract or share
+   */
+  constexpr double value(std::int64_t ticks) const {
+    return static_cast<double>(ticks) * multiplier / ticksPerPoint;
+  }
+};
+
+constexpr InstrumentSpec getInstrumentSpec(InstrumentEnum instrument) {
+  switch (instrument) {
+  case MicroNasdaqFutures:
+    return {.ticksPerPoint = 4, .multiplier = 2};
+  case MicroSPXFutures:
+    return {.ticksPerPoint = 4, .multiplier = 5};
+  case MicroRussel:
+    return {.ticksPerPoint = 10, .multiplier = 5};
+  case NVDA:
+  case TSLA:
+    return {.ticksPerPoint = 100, .multiplier = 1};
+  }
+  throw std::runtime_error("Unknown instrument enum");
+}
+} // namespace midas
@@ -1,7 +1,6 @@
 #pragma once
-#include <boost/date_time/posix_time/ptime.hpp>
+#include "timestamp.hpp"
 #include <boost/date_time/posix_time/time_formatters.hpp>
-#include <boost/date_time/posix_time/time_parsers.hpp>
 #include <ostream>
 #include <string>
 
@@ -12,21 +11,21 @@ struct Bar {
   Bar() = default;
   Bar(unsigned int barSizeSeconds, unsigned int tradeCount, double high,
       double low, double open, double close, double wap, double volume,
-      boost::posix_time::ptime utcTime)
+      Timestamp utcTime)
       : barSizeSeconds(barSizeSeconds), tradeCount(tradeCount), high(high),
         low(low), open(open), close(close), wap(wap), volume(volume),
         utcTime(utcTime) {}
 
   unsigned int barSizeSeconds, tradeCount;
   double high, low, open, close, wap, volume;
-  boost::posix_time::ptime utcTime;
+  Timestamp utcTime;
   template <typename CharT, typename TraitsT>
   friend std::basic_ostream<CharT, TraitsT> &
   operator<<(std::basic_ostream<CharT, TraitsT> &stream, const Bar &bar) {
-    stream << boost::posix_time::to_iso_extended_string(bar.utcTime) << ","
-           << bar.high << "," << bar.open << "," << bar.close << "," << bar.low
-           << "," << bar.volume << "," << bar.tradeCount << "," << bar.wap
-           << "," << bar.barSizeSeconds;
+    stream << boost::posix_time::to_iso_extended_string(toPtime(bar.utcTime))
+           << "," << bar.high << "," << bar.open << "," << bar.close << ","
+           << bar.low << "," << bar.volume << "," << bar.tradeCount << ","
+           << bar.wap << "," << bar.barSizeSeconds;
     return stream;
   }
 
@@ -0,0 +1,76 @@
+#pragma once
+#include "data_stream.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <span>
+
+namespace midas {
+
+struct BarArchiveHeader;
+
+/**
+ * Binary columnar storage for a DataStream.
+ *
+ * The file starts with a fixed header followed by one 64 byte aligned region
+ * per column (timestamps, opens, highs, lows, closes, waps, volumes,
+ * tradeCounts). Timestamps are stored as signed nanoseconds since the unix
+ * epoch, prices and volumes as doubles and trade counts as unsigned 32 bit
+ * integers. Values are stored in native byte order, archives written on a
+ * machine with a different byte order are rejected.
+ *
+ * Unlike the CSV export, reading an archive requires no parsing. The file is
+ * memory mapped read only and columns are exposed as spans into the mapping.
+ */
+class BarArchive {
+public:
+  static constexpr std::uint32_t formatVersion = 1;
+  /**
+   * Maps the archive at path.
+   * \throws ArchiveError if the file can not be opened or is not a valid
+   * archive
+   */
+  explicit BarArchive(const std::filesystem::path &path);
+
+  /**
+   * Writes the columns of data to path, replacing any existing file.
+   * The archive is written to a temporary file first and renamed into place,
+   * so readers never observe a partially written archive.
+   * @param begin @param end range of column indices to write, defaults to
+   * all bars
+   */
+  static void write(const std::filesystem::path &path, const DataStream &data,
+                    std::size_t begin = 0,
+                    std::size_t end = std::numeric_limits<std::size_t>::max());
+
+  unsigned int barSizeSeconds() const;
+  std::size_t size() const;
+  inline bool empty() const { return size() == 0; }
+
+  std::span<const Timestamp> timestamps() const;
+  std::span<const double> opens() const;
+  std::span<const double> highs() const;
+  std::span<const double> lows() const;
+  std::span<const double> closes() const;
+  std::span<const double> waps() const;
+  std::span<const double> volumes() const;
+  std::span<const std::uint32_t> tradeCounts() const;
+
+  /**
+   * Copies the mapped columns into a new data stream.
+   * Columns are bulk copied, bars are not routed through addBars and no
+   * listeners are notified.
+   */
+  std::shared_ptr<DataStream> toDataStream() const;
+
+private:
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+  const BarArchiveHeader *header;
+
+  template <typename T> std::span<const T> column(std::size_t index) const;
+};
+} // namespace midas
@@ -1,15 +1,63 @@
 #pragma once
 #include "bar.hpp"
+#include "ingest_ring.hpp"
+#include "timestamp.hpp"
 #include <algorithm>
-#include <boost/date_time/posix_time/ptime.hpp>
 #include <boost/signals2.hpp>
 #include <chrono>
 #include <condition_variable>
+#include <filesystem>
 #include <iterator>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <vector>
 
 namespace midas {
+
+/**
+ * Bounds the memory used by long running streams.
+ * Only the trailing window is kept in memory, older bars are evicted in
+ * whole blocks so the cost of shifting the columns is amortized.
+ */
+struct RetentionPolicy {
+  /**
+   * Minimum number of most recent bars kept in memory
+   */
+  std::size_t retainedBars;
+  /**
+   * Bars are evicted once at least this many are past the retained window
+   */
+  std::size_t blockSize{4096};
+  /**
+   * If set, every evicted block is written as a bar archive named after the
+   * absolute index of its first bar. Otherwise evicted bars are dropped.
+   */
+  std::optional<std::filesystem::path> spillDirectory{};
+};
+
+/**
+ * Lock free hand off of bars from the broker thread to the consumer.
+ * addBars pushes into a single producer single consumer ring and only wakes
+ * the consumer if it is parked in waitForData. Bars that do not fit in the
+ * ring fall back to the locked buffer, so the producer never blocks.
+ */
+struct RingIngestPolicy {
+  /**
+   * Number of bars the ring holds, rounded up to a power of two
+   */
+  std::size_t capacity{4096};
+  /**
+   * How long waitForData busy waits for bars before parking
+   */
+  std::chrono::microseconds maxSpin{0};
+  /**
+   * Doubles the spin time whenever bars arrive while spinning and halves it
+   * whenever the consumer has to park, up to maxSpin
+   */
+  bool adaptiveSpin{false};
+};
+
 /**
  * A representation of a data stream for an instrument.
  * Doesn't actually care about the instrument itself, only stores data.
@@ -18,6 +66,11 @@ namespace midas {
  * Note that a data stream must have uniform bar size.
  * If you need to mix different bar sizes, for example when you want to store
  * historical data along with realtime more granular data. Use two data streams.
+ *
+ * By default all bars are kept. With a retention policy older bars are
+ * evicted and the columns only hold bars from baseIndex() onwards. Absolute
+ * indices, i.e. counting evicted bars, stay stable for the lifetime of the
+ * stream.
  */
 class DataStream {
 public:
@@ -25,9 +78,12 @@ public:
   const unsigned int barSizeSeconds;
   std::vector<unsigned int> tradeCounts;
   std::vector<double> highs, lows, opens, closes, waps, volumes;
-  std::vector<boost::posix_time::ptime> timestamps;
+  std::vector<Timestamp> timestamps;
   typedef boost::signals2::signal<void()> update_signal_t;
-  typedef boost::signals2::signal<void()> reorder_signal_t;
+  /**
+   * Receives the lowest index whose contents changed
+   */
+  typedef boost::signals2::signal<void(std::size_t)> reorder_signal_t;
 
   /**
    * Waits for new data to arrive and processed it.
@@ -40,6 +96,11 @@ public:
   template <typename IteratorT>
     requires std::forward_iterator<IteratorT>
   void addBars(IteratorT begin, IteratorT end) {
+    if (ring) {
+      std::for_each(begin, end, [this](const Bar &bar) { pushToRing(bar); });
+      parker.unpark();
+      return;
+    }
     {
       std::lock_guard cvLock(bufferMutex);
       std::copy(begin, end, std::back_inserter(buffer));
@@ -54,6 +115,11 @@ public:
    * waiting for data so that they can do the processing
    */
   inline void addBars(const midas::Bar &bar) {
+    if (ring) {
+      pushToRing(bar);
+      parker.unpark();
+      return;
+    }
     {
       std::lock_guard cvLock(bufferMutex);
       buffer.push_back(bar);
@@ -61,6 +127,13 @@ public:
     bufferCv.notify_all();
   }
 
+  /**
+   * Switches ingestion to the lock free ring.
+   * Must be set before data is added, afterwards addBars must only be called
+   * from a single thread and waitForData from a single thread.
+   */
+  void setRingIngestPolicy(const RingIngestPolicy &policy);
+
   /**
    * Called before returning from waitForData
    * to process the new bars.
@@ -71,19 +144,67 @@ public:
   boost::signals2::connection
   addUpdateListener(const update_signal_t::slot_type &subscriber);
   /**
-   * Called before returning from waitForData
-   * to process the new bars.
-   * This happens after associated re-order events if any
-   * Note that this happens while a lock on the buffers is held.
-   * This should be kept in mind as it can block api thread
+   * Called before returning from waitForData when bars were inserted before
+   * existing data, with the lowest absolute index that changed. Everything
+   * before that index is untouched.
+   * This happens before the associated update event.
    */
   boost::signals2::connection
   addReOrderListener(const reorder_signal_t::slot_type &subscriber);
 
 
+  /**
+   * Number of bars held in the columns
+   */
   inline std::size_t size() const { return tradeCounts.size(); }
+  /**
+   * Absolute index of the first bar held in the columns
+   */
+  inline std::size_t baseIndex() const { return evictedBars; }
+  /**
+   * One past the absolute index of the last bar
+   */
+  inline std::size_t endIndex() const { return evictedBars + size(); }
+  /**
+   * Must be set before data is processed
+   */
+  void setRetentionPolicy(const RetentionPolicy &policy);
 
 private:
+  /**
+   * Appends or merges a batch of bars into the columns.
+   * @returns the lowest index that changed if bars were inserted before
+   * existing data
+   */
+  std::optional<std::size_t> ingest(std::vector<midas::Bar> &bars);
+  void storeBar(std::size_t index, const midas::Bar &bar);
+  void moveBar(std::size_t from, std::size_t to);
+  /**
+   * Evicts whole blocks that fall outside the retained window
+   */
+  void evictExpired();
+  std::optional<RetentionPolicy> retention;
+  std::size_t evictedBars{0};
+
+  inline void pushToRing(const midas::Bar &bar) {
+    if (!ring->tryPush(bar)) {
+      std::lock_guard lock(bufferMutex);
+      buffer.push_back(bar);
+      overflowPending.store(true, std::memory_order::release);
+    }
+  }
+  /**
+   * Takes everything queued in the ring and its overflow
+   */
+  bool drainRing(std::vector<midas::Bar> &bars);
+  bool waitForRing(std::vector<midas::Bar> &bars,
+                   std::chrono::milliseconds timeout);
+  RingIngestPolicy ringPolicy;
+  std::unique_ptr<SpscRing<midas::Bar>> ring;
+  Parker parker;
+  std::atomic<bool> overflowPending{false};
+  std::chrono::microseconds spinBudget{0};
+
   std::vector<midas::Bar> buffer
       /**
        * Protects the bar buffer
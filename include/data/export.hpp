@@ -1,14 +1,29 @@
 #pragma once
 #include "data_stream.hpp"
+#include <filesystem>
 #include <iostream>
 #include <istream>
+#include <thread>
 namespace midas {
 
 /**
  * Outputs in CSV style with header.
  * CSV is representation of a candle stick chart. in the following order of
  * columns datetime, high, open, close, low, volume, trades
+ * Rows are formatted into a local buffer and written in blocks.
  */
 std::ostream &operator<<(std::ostream &, const DataStream &);
 std::istream &operator>>(std::istream &, DataStream &);
-} // namespace midas
\ No newline at end of file
+
+/**
+ * Bulk loads a CSV export into the columns of data.
+ * The file is memory mapped and split into line aligned chunks that are
+ * parsed concurrently, straight into the columns.
+ * Bars that are in order and after any existing data are appended without
+ * notifying listeners, so this is intended for populating a stream before it
+ * is shared. Anything else falls back to addBars and waitForData.
+ * @param maxThreads upper bound on parser threads, small files use one
+ */
+void importCsv(const std::filesystem::path &path, DataStream &data,
+               unsigned int maxThreads = std::thread::hardware_concurrency());
+} // namespace midas
@@ -0,0 +1,113 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace midas {
+/**
+ * Bounded single producer single consumer queue.
+ * Neither side takes a lock, the producer and consumer indices live on
+ * separate cache lines so the two threads do not contend.
+ */
+template <typename T> class SpscRing {
+public:
+  /**
+   * @param minimumCapacity rounded up to a power of two
+   */
+  explicit SpscRing(std::size_t minimumCapacity)
+      : mask(std::bit_ceil(std::max<std::size_t>(minimumCapacity, 2)) - 1),
+        slots(mask + 1) {}
+
+  std::size_t capacity() const { return mask + 1; }
+
+  /**
+   * Producer side.
+   * @returns false if the ring is full
+   */
+  bool tryPush(const T &value) {
+    const std::size_t position = tail.load(std::memory_order::relaxed);
+    if (position - cachedHead > mask) {
+      cachedHead = head.load(std::memory_order::acquire);
+      if (position - cachedHead > mask) {
+        return false;
+      }
+    }
+    slots[position & mask] = value;
+    tail.store(position + 1, std::memory_order::release);
+    return true;
+  }
+
+  /**
+   * Consumer side, appends everything currently queued to out.
+   * @returns the number of elements taken
+   */
+  std::size_t popAll(std::vector<T> &out) {
+    const std::size_t first = head.load(std::memory_order::relaxed);
+    const std::size_t last = tail.load(std::memory_order::acquire);
+    for (std::size_t position = first; position != last; position++) {
+      out.push_back(slots[position & mask]);
+    }
+    head.store(last, std::memory_order::release);
+    return last - first;
+  }
+
+  bool empty() const {
+    return head.load(std::memory_order::acquire) ==
+           tail.load(std::memory_order::acquire);
+  }
+
+private:
+  static constexpr std::size_t cacheLineSize = 64;
+  const std::size_t mask;
+  std::vector<T> slots;
+  // written by the consumer
+  alignas(cacheLineSize) std::atomic<std::size_t> head{0};
+  // written by the producer, cachedHead saves reloading head on every push
+  alignas(cacheLineSize) std::atomic<std::size_t> tail{0};
+  std::size_t cachedHead{0};
+};
+
+/**
+ * Lets a single consumer sleep until a producer signals it.
+ * Producers only pay for a wake up syscall while the consumer is actually
+ * parked, otherwise signalling is a fence and a load.
+ *
+ * The consumer calls prepareToPark, re-checks its queue and then either
+ * cancelPark or park with the returned ticket. A signal sent after
+ * prepareToPark is never lost.
+ */
+class Parker {
+public:
+  inline std::uint32_t prepareToPark() {
+    parked.store(true, std::memory_order::relaxed);
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    return epoch.load(std::memory_order::acquire);
+  }
+  inline void cancelPark() {
+    parked.store(false, std::memory_order::relaxed);
+  }
+  /**
+   * Blocks until unpark is called after the ticket was taken, or timeout
+   * expires. May return spuriously.
+   */
+  void park(std::uint32_t ticket, std::chrono::nanoseconds timeout);
+  /**
+   * Producer side, call after publishing work
+   */
+  inline void unpark() {
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    if (parked.load(std::memory_order::relaxed)) {
+      wake();
+    }
+  }
+
+private:
+  void wake();
+  std::atomic<std::uint32_t> epoch{0};
+  std::atomic<bool> parked{false};
+};
+} // namespace midas
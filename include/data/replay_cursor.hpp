@@ -0,0 +1,52 @@
+#pragma once
+#include "data_stream.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+namespace midas {
+
+/**
+ * A growing view of a history that is known up front, for back tests.
+ * Readers see the bars of the history up to the cursor and nothing after
+ * it. Moving the cursor takes no lock, copies no bar and emits no signal, so
+ * whoever replays the history has to tell readers to process it.
+ *
+ * The history must not change while a cursor is over it. Any number of
+ * cursors can share the same history, each replayed on its own thread.
+ */
+class ReplayCursor {
+public:
+  explicit ReplayCursor(std::shared_ptr<DataStream> history)
+      : history(std::move(history)), begin(this->history->baseIndex()),
+        position(begin) {}
+  const std::shared_ptr<DataStream> history;
+  /**
+   * Absolute index of the first bar readers see
+   */
+  inline std::size_t beginIndex() const { return begin; }
+  /**
+   * One past the absolute index of the last visible bar
+   */
+  inline std::size_t endIndex() const { return position; }
+  /**
+   * Hides the bars before the absolute index beginIndex, readers start
+   * from it as if they were never there. Only before anything was read.
+   */
+  inline void startAt(std::size_t beginIndex) {
+    begin = std::clamp(beginIndex, begin, history->endIndex());
+    position = std::max(position, begin);
+  }
+  /**
+   * Makes every bar before the absolute index endIndex visible. The cursor
+   * never goes back.
+   */
+  inline void advanceTo(std::size_t endIndex) {
+    position = std::clamp(endIndex, position, history->endIndex());
+  }
+  inline bool exhausted() const { return position == history->endIndex(); }
+
+private:
+  std::size_t begin, position;
+};
+} // namespace midas
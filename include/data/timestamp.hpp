@@ -0,0 +1,86 @@
+#pragma once
+#include <boost/date_time/gregorian/gregorian_types.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace midas {
+/**
+ * UTC time as nanoseconds since the unix epoch.
+ * Bars and data columns store plain integers so that comparisons and
+ * searches are cheap, calendar types are only used at the edges such as
+ * logging and parsing.
+ */
+using Timestamp = std::int64_t;
+
+constexpr Timestamp nanosPerSecond = 1'000'000'000;
+constexpr Timestamp nanosPerDay = 86'400 * nanosPerSecond;
+
+constexpr Timestamp fromUnixSeconds(std::int64_t seconds) {
+  return seconds * nanosPerSecond;
+}
+
+/**
+ * Whole seconds elapsed between two timestamps
+ */
+constexpr std::int64_t secondsBetween(Timestamp from, Timestamp to) {
+  return (to - from) / nanosPerSecond;
+}
+
+inline Timestamp utcNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+inline const boost::posix_time::ptime
+    unixEpoch(boost::gregorian::date(1970, 1, 1));
+
+inline Timestamp fromPtime(const boost::posix_time::ptime &time) {
+  return (time - unixEpoch).total_nanoseconds();
+}
+
+inline boost::posix_time::ptime toPtime(Timestamp timestamp) {
+  // ptime has microsecond resolution
+  return unixEpoch + boost::posix_time::microseconds(timestamp / 1000);
+}
+
+/**
+ * Index of the first element of sorted that is not less than value.
+ * The loop has a fixed trip count and no data dependent branches.
+ */
+inline std::size_t lowerBound(std::span<const Timestamp> sorted,
+                              Timestamp value) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  const Timestamp *base = sorted.data();
+  std::size_t length = sorted.size();
+  while (length > 1) {
+    const std::size_t half = length / 2;
+    base += (base[half] < value) * half;
+    length -= half;
+  }
+  return (base - sorted.data()) + (*base < value);
+}
+
+/**
+ * Index of the first element of sorted that is greater than value.
+ */
+inline std::size_t upperBound(std::span<const Timestamp> sorted,
+                              Timestamp value) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  const Timestamp *base = sorted.data();
+  std::size_t length = sorted.size();
+  while (length > 1) {
+    const std::size_t half = length / 2;
+    base += (base[half] <= value) * half;
+    length -= half;
+  }
+  return (base - sorted.data()) + (*base <= value);
+}
+} // namespace midas
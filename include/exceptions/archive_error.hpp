@@ -0,0 +1,10 @@
+#pragma once
+#include <stdexcept>
+
+/**
+ * Bar archive is missing, truncated or written in an unsupported format
+ */
+class ArchiveError : public std::runtime_error::runtime_error {
+public:
+  ArchiveError(const std::string &message) : runtime_error(message) {}
+};
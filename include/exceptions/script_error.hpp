@@ -0,0 +1,15 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+
+/**
+ * Strategy script is malformed or uses something outside of the supported
+ * language subset
+ */
+class ScriptError : public std::runtime_error::runtime_error {
+public:
+  ScriptError(std::size_t line, const std::string &message)
+      : runtime_error("line " + std::to_string(line) + ": " + message),
+        line(line) {}
+  const std::size_t line;
+};
@@ -2,12 +2,14 @@
 #include "broker-interface/instruments.hpp"
 #include "broker-interface/order.hpp"
 #include "broker-interface/order_summary.hpp"
+#include "broker-interface/tick_price.hpp"
 #include "data/data_stream.hpp"
 #include "logging/logging.hpp"
 #include "trader_data.hpp"
 #include <boost/signals2.hpp>
 #include <boost/signals2/connection.hpp>
 #include <boost/signals2/variadic_signal.hpp>
+#include <functional>
 #include <memory>
 namespace midas::trader {
 
@@ -33,6 +35,7 @@ private:
   OrderSummaryTracker summary;
   std::recursive_mutex orderStateMutex;
   bool isPaused{false};
+  std::function<void()> orderEventListener;
 
 protected:
   TraderData data;
@@ -40,7 +43,7 @@ protected:
   std::shared_ptr<logging::thread_safe_logger_t> logger;
   decision_params_signal_t decisionParamsSignal;
   Trader(std::size_t lookBackSize, std::size_t candleSizeSeconds,
-         std::shared_ptr<DataStream> source,
+         const CandleSource &source,
          std::shared_ptr<midas::OrderManager> orderManager,
          std::shared_ptr<logging::thread_safe_logger_t> logger)
       : data(lookBackSize, candleSizeSeconds, source),
@@ -49,6 +52,16 @@ protected:
     data.processSource();
   }
 
+  /**
+   * Tells whoever drives the trader that one of its orders was filled or
+   * cancelled
+   */
+  inline void orderEvent(Order::StatusChangeEvent event) {
+    if (orderEventListener && (event.newStatus == OrderStatusEnum::Filled ||
+                               event.newStatus == OrderStatusEnum::Cancelled)) {
+      orderEventListener();
+    }
+  }
   void handleOrderStatusChangeEvent(Order &order,
                                     Order::StatusChangeEvent event);
 
@@ -66,6 +79,37 @@ protected:
 public:
   virtual ~Trader() = default;
   inline void triggerSourceProcessing() { data.processSource(); }
+  /**
+   * Number of source bars the trader looks back on
+   */
+  inline std::size_t requiredSourceBars() const {
+    return data.requiredSourceBars();
+  }
+  /**
+   * Computes the indicators over the whole history before it is replayed to
+   * the trader, for back tests
+   */
+  inline void precomputeFeatures(const DataStream &history) {
+    data.precomputeFeatures(history);
+  }
+  /**
+   * Called on the thread delivering order status changes once an order of
+   * the trader is done, set it before the trader places orders
+   */
+  inline void setOrderEventListener(std::function<void()> listener) {
+    orderEventListener = std::move(listener);
+  }
+  inline std::size_t candleSizeSeconds() const {
+    return data.candleSizeSeconds;
+  }
+  /**
+   * Generation of the data and number of candles completed in it, a change
+   * means a candle closed or the data was cleared
+   */
+  inline std::pair<std::uint64_t, std::size_t> closedCandles() const {
+    const auto candles = data.snapshot();
+    return {candles->generation, candles->endIndex};
+  }
   virtual void decide() = 0;
   virtual std::string traderName() const = 0;
   bool hasOpenPosition();
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <span>
+
+/**
+ * Technical indicators over whole columns, such as the columns of a
+ * DataStream, for back tests and screening.
+ * Every function writes one output per input. Outputs before the warm up are
+ * NaN, the rest match the TA-Lib function of the same name up to floating
+ * point rounding. The return value is the index of the first valid output,
+ * the same as the TA-Lib look back.
+ * The kernels run on the widest instruction set the CPU supports, picked on
+ * first use.
+ */
+namespace midas::trader::batch {
+
+enum class InstructionSet { Scalar, Avx2, Avx512 };
+
+const char *toString(InstructionSet instructionSet);
+/**
+ * Widest instruction set supported by this CPU and build
+ */
+InstructionSet detectInstructionSet();
+/**
+ * Instruction set the kernels currently run on
+ */
+InstructionSet instructionSet();
+/**
+ * Runs the kernels on instructionSet, for tests and benchmarks.
+ * Throws std::invalid_argument if the CPU does not support it.
+ */
+void useInstructionSet(InstructionSet instructionSet);
+
+/**
+ * TA_SMA
+ */
+std::size_t sma(std::span<const double> values, int period,
+                std::span<double> out);
+/**
+ * TA_EMA, seeded with the simple average of the first period values
+ */
+std::size_t ema(std::span<const double> values, int period,
+                std::span<double> out);
+/**
+ * TA_MIN
+ */
+std::size_t rollingMin(std::span<const double> values, int period,
+                       std::span<double> out);
+/**
+ * TA_MAX
+ */
+std::size_t rollingMax(std::span<const double> values, int period,
+                       std::span<double> out);
+/**
+ * TA_STDDEV, population deviation.
+ * The variance is summed around a nearby price rather than from raw squares,
+ * so small deviations of high prices keep their digits where TA-Lib loses
+ * them.
+ */
+std::size_t rollingStdDev(std::span<const double> values, int period,
+                          double deviations, std::span<double> out);
+/**
+ * TA_BBANDS with TA_MAType_SMA, the deviation is computed like rollingStdDev
+ */
+std::size_t bollingerBands(std::span<const double> values, int period,
+                           double deviationsUp, double deviationsDown,
+                           std::span<double> upper, std::span<double> middle,
+                           std::span<double> lower);
+/**
+ * TA_RSI, Wilder's smoothing
+ */
+std::size_t rsi(std::span<const double> values, int period,
+                std::span<double> out);
+/**
+ * TA_ATR, Wilder's smoothing
+ */
+std::size_t atr(std::span<const double> highs, std::span<const double> lows,
+                std::span<const double> closes, int period,
+                std::span<double> out);
+/**
+ * Index of the first candle whose low is at or below below, or whose high is
+ * at or above above, the size of the columns if there is none. For finding
+ * which of a stop loss and a profit taker fills first.
+ */
+std::size_t firstTouch(std::span<const double> highs,
+                       std::span<const double> lows, double below,
+                       double above);
+
+/**
+ * Index of the first value that is not NaN, the size of the column if there
+ * is none. Indicators of a column only see the values from there on.
+ */
+std::size_t firstValue(std::span<const double> values);
+
+/**
+ * Reads like a column, the same value at every index. Loops templated on
+ * their operands then take columns and scalars alike and still vectorize.
+ */
+struct Broadcast {
+  double value;
+  inline double operator[](std::size_t) const { return value; }
+};
+} // namespace midas::trader::batch
@@ -0,0 +1,107 @@
+#pragma once
+#include "data/bar.hpp"
+#include "data/timestamp.hpp"
+#include <cstddef>
+#include <optional>
+
+namespace midas::trader {
+
+/**
+ * Daily window candles are aligned to.
+ * Sessions repeat every day starting at open. Candles are aligned to the
+ * session open, never span a session close and bars outside of the session
+ * are ignored. The default covers the whole UTC day.
+ */
+struct TradingSession {
+  /**
+   * Any session open, only the time of day matters
+   */
+  Timestamp open{0};
+  Timestamp length{nanosPerDay};
+};
+
+/**
+ * Folds bars into time aligned candles one bar at a time.
+ * Every bar costs the same regardless of candle size. The candle currently
+ * being built is available as the forming candle.
+ */
+class CandleAggregator {
+public:
+  CandleAggregator(std::size_t candleSizeSeconds, std::size_t barSizeSeconds,
+                   TradingSession session = {});
+
+  /**
+   * Adds the next bar in time order. onCompleted is called with every candle
+   * the bar completes, which is the forming candle if the bar starts a new
+   * one and the new candle if the bar is the last one that fits in it.
+   */
+  template <typename OnCompleted>
+  void add(const Bar &bar, OnCompleted &&onCompleted) {
+    Timestamp start, end;
+    if (!bucket(bar.utcTime, start, end)) {
+      return;
+    }
+    if (formingCandle && start != formingStart) {
+      if (start < formingStart) {
+        // late bar for a candle that was already completed
+        return;
+      }
+      onCompleted(forming().value());
+      formingCandle = false;
+    }
+    fold(bar, start, end);
+    if (bar.utcTime + barSize >= formingEnd) {
+      onCompleted(forming().value());
+      formingCandle = false;
+    }
+  }
+
+  /**
+   * The candle being built, if any of its bars have arrived
+   */
+  std::optional<Bar> forming() const;
+  /**
+   * The candle being built including pending, a lower resolution candle that
+   * is still forming itself and has not been added yet
+   */
+  std::optional<Bar> forming(const std::optional<Bar> &pending) const;
+  void reset() { formingCandle = false; }
+
+  /**
+   * The candle being built, to go back to later
+   */
+  struct Checkpoint {
+    bool formingCandle;
+    Timestamp formingStart, formingEnd;
+    Bar candle;
+    double wapVolume;
+  };
+  inline Checkpoint checkpoint() const {
+    return {formingCandle, formingStart, formingEnd, candle, wapVolume};
+  }
+  inline void restore(const Checkpoint &checkpoint) {
+    formingCandle = checkpoint.formingCandle;
+    formingStart = checkpoint.formingStart;
+    formingEnd = checkpoint.formingEnd;
+    candle = checkpoint.candle;
+    wapVolume = checkpoint.wapVolume;
+  }
+
+private:
+  const Timestamp candleSize, barSize;
+  const TradingSession session;
+  bool formingCandle{false};
+  Timestamp formingStart{0}, formingEnd{0};
+  Bar candle{};
+  // volume weighted wap numerator, divided by volume on read
+  double wapVolume{0};
+
+  /**
+   * Finds the candle time falls in
+   * @returns false if time is outside the session
+   */
+  bool bucket(Timestamp time, Timestamp &start, Timestamp &end) const;
+  void fold(const Bar &bar, Timestamp start, Timestamp end);
+  static void merge(Bar &into, double &wapVolume, const Bar &bar);
+};
+} // namespace midas::trader
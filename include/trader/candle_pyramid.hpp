@@ -0,0 +1,146 @@
+#pragma once
+#include "data/data_stream.hpp"
+#include "data/replay_cursor.hpp"
+#include "trader/candle_aggregator.hpp"
+#include "trader/candle_series.hpp"
+#include "trader/indicator_graph.hpp"
+#include <array>
+#include <boost/signals2/connection.hpp>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace midas::trader {
+
+/**
+ * Candles of several resolutions built from a single stream.
+ * Every level aggregates the completed candles of the largest lower level
+ * that divides it, or the stream bars if there is none, so each candle is
+ * computed once no matter how many traders read it. Traders subscribe to a
+ * level and share its published snapshots.
+ */
+class CandlePyramid {
+public:
+  static constexpr std::array<std::size_t, 5> defaultResolutions{
+      60, 120, 300, 900, 3600};
+
+  /**
+   * @param resolutionsSeconds candle sizes, each a multiple of the stream bar
+   * size. There is always a level of the bar size itself.
+   * @param session candles of every level are aligned to the session open
+   * and cut at its close
+   */
+  explicit CandlePyramid(
+      std::shared_ptr<DataStream> source,
+      std::vector<std::size_t> resolutionsSeconds =
+          {defaultResolutions.begin(), defaultResolutions.end()},
+      TradingSession session = {});
+  /**
+   * Levels over the bars of a history up to the cursor. Moving the cursor
+   * emits nothing, processSource has to be called after it moves.
+   */
+  explicit CandlePyramid(
+      std::shared_ptr<const ReplayCursor> cursor,
+      std::vector<std::size_t> resolutionsSeconds =
+          {defaultResolutions.begin(), defaultResolutions.end()},
+      TradingSession session = {});
+
+  /**
+   * Grows the look back of the level to at least lookBackSize.
+   * @throws SamplingError if there is no level of candleSizeSeconds
+   */
+  std::shared_ptr<const CandleSeries> subscribe(std::size_t candleSizeSeconds,
+                                                std::size_t lookBackSize);
+  /**
+   * Indicators of the level, shared by every trader subscribed to it
+   * @throws SamplingError if there is no level of candleSizeSeconds
+   */
+  std::shared_ptr<IndicatorGraph> indicators(std::size_t candleSizeSeconds);
+  inline std::size_t barSizeSeconds() const { return source->barSizeSeconds; }
+  /**
+   * processes source, can be called manually at start to consume before any
+   * updates. Otherwise levels are kept in sync via source subscriptions.
+   */
+  void processSource();
+  /**
+   * Publishes indicators registered since the last update, which would
+   * otherwise wait for the next source bar
+   */
+  void publishIndicators();
+  /**
+   * Clears every level, the retained source is read again on the next
+   * update
+   */
+  void clear();
+  /**
+   * Handles a re-order of the source from firstChangedIndex on. Every level
+   * goes back to the latest checkpoint before that bar and the source is
+   * read again from there on the next update, so only the candles after the
+   * checkpoint are built and evaluated again. Clears if there is no usable
+   * checkpoint.
+   */
+  void repair(std::size_t firstChangedIndex);
+  /**
+   * Computes the indicators of every level over a whole history ahead of
+   * time, the levels then read them instead of evaluating candles as the
+   * source replays the same bars. For back tests, where the history is known
+   * up front. Indicators have to be registered first. A replay starts from
+   * the first bar its cursor shows.
+   */
+  void precomputeFeatures(const DataStream &history);
+
+private:
+  struct Level {
+    Level(std::size_t candleSizeSeconds, std::size_t barSizeSeconds,
+          TradingSession session)
+        : aggregator(candleSizeSeconds, barSizeSeconds, session),
+          series(std::make_shared<CandleSeries>(candleSizeSeconds, 1)),
+          indicators(std::make_shared<IndicatorGraph>(series)) {}
+    CandleAggregator aggregator;
+    std::shared_ptr<CandleSeries> series;
+    std::shared_ptr<IndicatorGraph> indicators;
+    // index of the level this one is built from
+    std::optional<std::size_t> parent;
+    std::vector<std::size_t> children;
+  };
+  /**
+   * State of every level before the source bar at sourceIndex was read
+   */
+  struct Checkpoint {
+    std::size_t sourceIndex;
+    std::vector<CandleAggregator::Checkpoint> aggregators;
+    std::vector<std::size_t> candles;
+    std::vector<std::optional<IndicatorGraph::Checkpoint>> indicators;
+  };
+  // late bars arrive within minutes, a checkpoint every 128 bars held for
+  // 16 of them reaches back a few hours of 5 second bars
+  static constexpr std::size_t checkpointBars = 128;
+  static constexpr std::size_t retainedCheckpoints = 16;
+  std::shared_ptr<DataStream> source;
+  // bounds what is read of the source when replaying a history
+  std::shared_ptr<const ReplayCursor> cursor;
+  std::vector<Level> levels;
+  std::size_t lastReadIndex{0};
+  std::deque<Checkpoint> checkpoints;
+  std::recursive_mutex writerMutex;
+  boost::signals2::scoped_connection updateListenerConnection,
+      reOrderListenerConnection;
+
+  void buildLevels(std::vector<std::size_t> resolutionsSeconds,
+                   TradingSession session);
+  inline std::size_t sourceEndIndex() const {
+    return cursor ? cursor->endIndex() : source->endIndex();
+  }
+  Level &find(std::size_t candleSizeSeconds);
+  void add(std::size_t level, const Bar &bar);
+  void publish();
+  void checkpoint();
+  /**
+   * @returns false if a level could not go back, it may have been changed
+   */
+  bool restore(const Checkpoint &checkpoint);
+};
+} // namespace midas::trader
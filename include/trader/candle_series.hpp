@@ -0,0 +1,195 @@
+#pragma once
+#include "data/bar.hpp"
+#include "data/timestamp.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace midas::trader {
+
+/**
+ * Storage for down sampled candles.
+ * Columns are sized once and never reallocated. Candles are only ever
+ * written past the end of every published snapshot, so readers never observe
+ * a write.
+ */
+struct CandleColumns {
+  explicit CandleColumns(std::size_t capacity)
+      : tradeCounts(capacity), highs(capacity), lows(capacity),
+        opens(capacity), closes(capacity), vwaps(capacity), volumes(capacity),
+        timestamps(capacity) {}
+  std::vector<unsigned int> tradeCounts;
+  std::vector<double> highs, lows, opens, closes, vwaps, volumes;
+  std::vector<Timestamp> timestamps;
+  inline std::size_t capacity() const { return tradeCounts.size(); }
+};
+
+/**
+ * Immutable view of the most recent candles.
+ * The spans point straight into the shared storage and are contiguous, so
+ * they can be handed to TA routines as is. Holding a snapshot keeps its
+ * storage alive after the series has moved on.
+ */
+class CandleSnapshot {
+public:
+  CandleSnapshot(std::shared_ptr<const CandleColumns> columns,
+                 std::size_t begin, std::size_t count, std::uint64_t sequence,
+                 std::uint64_t generation, std::size_t endIndex,
+                 std::optional<Bar> forming)
+      : sequence(sequence), generation(generation), endIndex(endIndex),
+        forming(std::move(forming)), columns(std::move(columns)),
+        begin(begin), count(count) {}
+  /**
+   * Increases every time new candles are published or the data is cleared
+   */
+  const std::uint64_t sequence;
+  /**
+   * Increases every time the data is cleared or candles are dropped from its
+   * end
+   */
+  const std::uint64_t generation;
+  /**
+   * Number of candles completed since the data was last cleared, the last
+   * candle of the snapshot has index endIndex - 1
+   */
+  const std::size_t endIndex;
+  /**
+   * Candle still being built, it follows the completed candles and is not
+   * part of the spans
+   */
+  const std::optional<Bar> forming;
+  inline std::size_t size() const { return count; }
+  inline bool empty() const { return count == 0; }
+  /**
+   * Same candles, limited to the most recent ones
+   */
+  inline CandleSnapshot last(std::size_t maxCount) const {
+    const std::size_t kept = std::min(count, maxCount);
+    return CandleSnapshot(columns, begin + count - kept, kept, sequence,
+                          generation, endIndex, forming);
+  }
+  inline std::span<const unsigned int> tradeCounts() const {
+    return view(columns->tradeCounts);
+  }
+  inline std::span<const double> highs() const { return view(columns->highs); }
+  inline std::span<const double> lows() const { return view(columns->lows); }
+  inline std::span<const double> opens() const { return view(columns->opens); }
+  inline std::span<const double> closes() const {
+    return view(columns->closes);
+  }
+  inline std::span<const double> vwaps() const { return view(columns->vwaps); }
+  inline std::span<const double> volumes() const {
+    return view(columns->volumes);
+  }
+  inline std::span<const Timestamp> timestamps() const {
+    return view(columns->timestamps);
+  }
+
+private:
+  std::shared_ptr<const CandleColumns> columns;
+  std::size_t begin, count;
+  template <typename T>
+  inline std::span<const T> view(const std::vector<T> &column) const {
+    return std::span<const T>(column.data() + begin, count);
+  }
+};
+
+/**
+ * Candles of a single resolution, published as snapshots.
+ * Readers take the latest snapshot without locking and without copying.
+ * Writers are not synchronized with each other, the owner serializes them.
+ */
+class CandleSeries {
+public:
+  const std::size_t candleSizeSeconds;
+
+  /**
+   * @param lookBackSize the number of candles published in every snapshot
+   */
+  CandleSeries(std::size_t candleSizeSeconds, std::size_t lookBackSize);
+
+  inline std::size_t lookBackSize() const { return retained; }
+  /**
+   * Latest published candles, at most lookBackSize of them, and the forming
+   * candle. Lock free.
+   */
+  inline std::shared_ptr<const CandleSnapshot> snapshot() const {
+    return published.load(std::memory_order::acquire);
+  }
+
+  /**
+   * Grows the look back to at least lookBackSize, never shrinks it
+   */
+  void retain(std::size_t lookBackSize);
+  void append(const Bar &candle);
+  void publish(std::optional<Bar> forming);
+  void clear();
+  /**
+   * Drops the candles from endIndex on and publishes the ones left, under a
+   * new generation
+   * @returns false if the storage no longer holds every candle from endIndex
+   * on, the series is left as it is
+   */
+  bool truncate(std::size_t endIndex);
+  /**
+   * Number of candles appended since the series was last cleared, published
+   * or not
+   */
+  inline std::size_t endIndex() const { return appended; }
+
+private:
+  /**
+   * Storage holds this many look backs before it is replaced, which bounds
+   * the cost of carrying the look back over to amortized constant time
+   */
+  static constexpr std::size_t storageLookBacks = 4;
+  std::size_t retained;
+  std::shared_ptr<CandleColumns> columns;
+  std::size_t columnsUsed{0};
+  std::uint64_t sequence{0}, generation{0};
+  std::size_t appended{0};
+  std::atomic<std::shared_ptr<const CandleSnapshot>> published;
+
+  /**
+   * Moves the most recent candles over to fresh storage of capacity
+   */
+  void replaceStorage(std::size_t capacity, std::size_t carried);
+};
+
+/**
+ * Tracks which candles of a series a reader has already consumed
+ */
+class CandleCursor {
+public:
+  /**
+   * Calls onCandle with the snapshot index of every candle that was not
+   * consumed yet, oldest first. If the series was cleared since the last
+   * call onReset is called first and every candle is passed again.
+   */
+  template <typename OnReset, typename OnCandle>
+  void advance(const CandleSnapshot &candles, OnReset &&onReset,
+               OnCandle &&onCandle) {
+    if (candles.generation != generation) {
+      generation = candles.generation;
+      consumed = 0;
+      onReset();
+    }
+    const std::size_t first = candles.endIndex - candles.size();
+    // candles that left the snapshot before they were read are skipped
+    for (std::size_t index = std::max(consumed, first);
+         index < candles.endIndex; index++) {
+      onCandle(index - first);
+    }
+    consumed = candles.endIndex;
+  }
+
+private:
+  std::uint64_t generation{0};
+  std::size_t consumed{0};
+};
+} // namespace midas::trader
@@ -0,0 +1,282 @@
+#pragma once
+#include "broker-interface/instruments.hpp"
+#include "broker-interface/order.hpp"
+#include "data/timestamp.hpp"
+#include "trader/base_trader.hpp"
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace midas::trader {
+
+class CoroutineTrader;
+
+/**
+ * Hands out coroutine frames carved from large chunks, released frames are
+ * kept for the next coroutine of about the same size.
+ * Not thread safe, a pool belongs to the trader scheduling the coroutines.
+ */
+class FramePool {
+public:
+  /**
+   * Frames are rounded up to a multiple of this many bytes
+   */
+  static constexpr std::size_t granularity = 64;
+  /**
+   * Larger frames come from the heap
+   */
+  static constexpr std::size_t maxPooledSize = 4096;
+  static constexpr std::size_t chunkSize = 64 * 1024;
+
+  FramePool() = default;
+  FramePool(const FramePool &) = delete;
+  FramePool &operator=(const FramePool &) = delete;
+
+  void *allocate(std::size_t size);
+  /**
+   * Returns a frame to the pool it came from
+   */
+  static void release(void *frame, std::size_t size) noexcept;
+  /**
+   * Bytes taken from the heap for pooled frames
+   */
+  inline std::size_t reserved() const { return chunks.size() * chunkSize; }
+
+private:
+  struct FreeFrame {
+    FreeFrame *next;
+  };
+  // every frame is preceded by the pool it came from, null for heap frames
+  static constexpr std::size_t headerSize = alignof(std::max_align_t);
+  std::vector<std::unique_ptr<std::byte[]>> chunks;
+  std::size_t chunkUsed{chunkSize};
+  std::array<FreeFrame *, maxPooledSize / granularity> freeFrames{};
+
+  static constexpr std::size_t blockSize(std::size_t size) {
+    return (size + headerSize + granularity - 1) / granularity * granularity;
+  }
+};
+
+/**
+ * A trading strategy written as a coroutine.
+ * Strategies are free functions whose first parameter is the
+ * CoroutineTrader scheduling them, they are started with
+ * CoroutineTrader::spawn and suspend on the awaitables of the trader. Take
+ * the other parameters by value, the frame outlives the call.
+ * Exceptions escaping a strategy end it and are logged.
+ */
+class Strategy {
+public:
+  struct promise_type {
+    std::exception_ptr error;
+
+    Strategy get_return_object() {
+      return Strategy(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    template <typename... Args>
+    static void *operator new(std::size_t size, CoroutineTrader &trader,
+                              Args &&...);
+    static void operator delete(void *frame, std::size_t size) noexcept {
+      FramePool::release(frame, size);
+    }
+  };
+
+  Strategy(Strategy &&other) noexcept
+      : handle(std::exchange(other.handle, {})) {}
+  Strategy &operator=(Strategy &&other) noexcept {
+    if (this != &other) {
+      if (handle) {
+        handle.destroy();
+      }
+      handle = std::exchange(other.handle, {});
+    }
+    return *this;
+  }
+  ~Strategy() {
+    if (handle) {
+      handle.destroy();
+    }
+  }
+  inline bool done() const { return !handle || handle.done(); }
+
+private:
+  friend class CoroutineTrader;
+  std::coroutine_handle<promise_type> handle;
+
+  explicit Strategy(std::coroutine_handle<promise_type> handle)
+      : handle(handle) {}
+};
+
+/**
+ * Runs coroutine strategies of one instrument, on the thread calling
+ * decide.
+ * Every strategy shares the candles and indicator graph of the trader, and
+ * resumes only from decide, so strategy code reads sequentially and needs
+ * no locks. decide resumes strategies waiting for a candle once per new
+ * completed candle, and strategies waiting for an order once the order is
+ * done. Orders are polled on their atomic state when deciding, their status
+ * changes only wake the scheduler driving the trader, if any. Timeouts are
+ * measured in candle time, so back tests replay them the same way as live
+ * trading.
+ * Spawn strategies before the trader is driven, or from the driving thread.
+ */
+class CoroutineTrader : public Trader {
+  struct Wait {
+    std::coroutine_handle<> handle;
+    /**
+     * Resumes on the next candle
+     */
+    bool candle{false};
+    /**
+     * Resumes on the first candle at or past this time
+     */
+    std::optional<Timestamp> until;
+    /**
+     * Resumes once this order is done
+     */
+    std::shared_ptr<Order> order;
+  };
+
+public:
+  class CandleAwaiter {
+  public:
+    inline bool await_ready() const noexcept { return false; }
+    inline void await_suspend(std::coroutine_handle<> handle) {
+      wait.handle = handle;
+      trader.waiting.push_back(&wait);
+    }
+    inline void await_resume() const noexcept {}
+
+  protected:
+    friend class CoroutineTrader;
+    CoroutineTrader &trader;
+    Wait wait;
+    CandleAwaiter(CoroutineTrader &trader, bool candle,
+                  std::optional<Timestamp> until,
+                  std::shared_ptr<Order> order = nullptr)
+        : trader(trader), wait{{}, candle, until, std::move(order)} {}
+  };
+
+  class FillAwaiter : public CandleAwaiter {
+  public:
+    inline bool await_ready() const { return wait.order->isDone(); }
+    /**
+     * Filled or Cancelled, the current state if the wait timed out
+     */
+    inline OrderStatusEnum await_resume() const { return wait.order->state(); }
+
+  private:
+    friend class CoroutineTrader;
+    using CandleAwaiter::CandleAwaiter;
+  };
+
+  CoroutineTrader(std::string name, std::size_t lookBackSize,
+                  std::size_t candleSizeSeconds, const CandleSource &source,
+                  const std::shared_ptr<midas::OrderManager> &orderManager,
+                  midas::InstrumentEnum instrument,
+                  const std::shared_ptr<logging::thread_safe_logger_t> &logger);
+
+  /**
+   * Runs strategy(*this, args...) until it first suspends
+   */
+  template <typename Function, typename... Args>
+  void spawn(Function &&strategy, Args &&...args) {
+    strategies.push_back(std::forward<Function>(strategy)(
+        *this, std::forward<Args>(args)...));
+    strategies.back().handle.resume();
+    reap();
+  }
+  void decide() override;
+  std::string traderName() const override;
+  /**
+   * Number of strategies that have not returned
+   */
+  inline std::size_t running() const { return strategies.size(); }
+  inline const FramePool &frames() const { return framePool; }
+
+  /**
+   * Suspends until the next completed candle
+   */
+  CandleAwaiter nextCandle();
+  /**
+   * Suspends until the first candle at least duration after the current one
+   */
+  CandleAwaiter timeout(std::chrono::nanoseconds duration);
+  /**
+   * Suspends until the order is filled or cancelled
+   */
+  FillAwaiter fill(std::shared_ptr<Order> order);
+  /**
+   * Suspends until the order is done, or until the first candle at least
+   * duration after the current one
+   */
+  FillAwaiter fill(std::shared_ptr<Order> order,
+                   std::chrono::nanoseconds duration);
+
+  std::shared_ptr<Order> market(OrderDirection direction,
+                                unsigned int quantity);
+  std::shared_ptr<Order> limit(OrderDirection direction, unsigned int quantity,
+                               double limitPrice);
+  std::shared_ptr<BracketedOrder> bracket(OrderDirection direction,
+                                          unsigned int quantity,
+                                          double entryPrice,
+                                          double stopLossPrice,
+                                          double profitPrice);
+
+  /**
+   * Register indicators before the first candle is awaited
+   */
+  inline IndicatorGraph &indicatorGraph() { return data.indicatorGraph(); }
+  /**
+   * Indicator values of the candle strategies last resumed on
+   */
+  inline const IndicatorSnapshot &indicators() const {
+    return *indicatorValues;
+  }
+  /**
+   * Look back candles of indicators()
+   */
+  inline const CandleSnapshot &candles() const { return *lookBackCandles; }
+  inline const std::shared_ptr<logging::thread_safe_logger_t> &log() const {
+    return logger;
+  }
+  const midas::InstrumentEnum instrument;
+
+private:
+  friend struct Strategy::promise_type;
+  const std::string name;
+  // declared first, frames are released into it as the strategies go
+  FramePool framePool;
+  std::vector<Strategy> strategies;
+  std::vector<Wait *> waiting;
+  std::vector<std::coroutine_handle<>> resuming;
+  std::shared_ptr<const IndicatorSnapshot> indicatorValues;
+  std::shared_ptr<const CandleSnapshot> lookBackCandles;
+  // candles the strategies last resumed on
+  std::optional<std::pair<std::uint64_t, std::size_t>> resumedOn;
+
+  std::optional<Timestamp> after(std::chrono::nanoseconds duration) const;
+  /**
+   * Drops the strategies that returned, logging the ones that threw
+   */
+  void reap();
+};
+
+template <typename... Args>
+void *Strategy::promise_type::operator new(std::size_t size,
+                                           CoroutineTrader &trader, Args &&...) {
+  return trader.framePool.allocate(size);
+}
+} // namespace midas::trader
@@ -0,0 +1,313 @@
+#pragma once
+#include "data/bar.hpp"
+#include "trader/candle_series.hpp"
+#include "trader/indicators.hpp"
+#include <algorithm>
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <variant>
+#include <vector>
+
+namespace midas::trader {
+
+enum class IndicatorType {
+  // candle columns, the roots of the graph
+  Open,
+  High,
+  Low,
+  Close,
+  Volume,
+  Ema,
+  Sma,
+  Rsi,
+  Atr,
+  Macd,
+  BollingerBands,
+};
+
+/**
+ * One value per candle of a registered indicator
+ */
+struct IndicatorOutput {
+  std::size_t slot;
+  auto operator<=>(const IndicatorOutput &) const = default;
+};
+
+/**
+ * Every output of an indicator graph over a whole candle series computed
+ * ahead of time, one column per output indexed by candle. Values before an
+ * indicator is ready are NaN.
+ */
+struct FeatureMatrix {
+  std::vector<std::vector<double>> columns;
+  /**
+   * Index of the first value of every column
+   */
+  std::vector<std::size_t> firstValues;
+  /**
+   * Subscribed history size of every column
+   */
+  std::vector<std::size_t> historySizes;
+  std::size_t candles{0};
+};
+
+/**
+ * Indicator values as of the completed candles of a candle snapshot
+ */
+class IndicatorSnapshot {
+public:
+  IndicatorSnapshot(std::shared_ptr<const CandleSnapshot> candles,
+                    std::shared_ptr<const std::vector<indicators::History>>
+                        histories)
+      : candles(std::move(candles)), histories(std::move(histories)) {}
+  IndicatorSnapshot(std::shared_ptr<const CandleSnapshot> candles,
+                    std::shared_ptr<const FeatureMatrix> features)
+      : candles(std::move(candles)), features(std::move(features)) {}
+  /**
+   * The candles the values were computed from
+   */
+  const std::shared_ptr<const CandleSnapshot> candles;
+  /**
+   * Number of the most recent values available, at most the subscribed
+   * history size
+   */
+  inline std::size_t size(IndicatorOutput output) const {
+    if (features) {
+      if (output.slot >= features->columns.size()) {
+        return 0;
+      }
+      const std::size_t first = features->firstValues[output.slot];
+      const std::size_t end = featuresEnd();
+      return end > first
+                 ? std::min(end - first, features->historySizes[output.slot])
+                 : 0;
+    }
+    return output.slot < histories->size() ? (*histories)[output.slot].size()
+                                            : 0;
+  }
+  inline bool ready(IndicatorOutput output) const { return size(output) > 0; }
+  /**
+   * @param offset from the most recent candle
+   * @return NaN past the available values
+   */
+  inline double value(IndicatorOutput output, std::size_t offset = 0) const {
+    if (offset >= size(output)) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (features) {
+      return features->columns[output.slot][featuresEnd() - 1 - offset];
+    }
+    return (*histories)[output.slot].back(offset);
+  }
+
+private:
+  friend class IndicatorGraph;
+  // values are either the histories of the graph or precomputed features
+  std::shared_ptr<const std::vector<indicators::History>> histories;
+  std::shared_ptr<const FeatureMatrix> features;
+
+  inline std::size_t featuresEnd() const {
+    return std::min(candles->endIndex, features->candles);
+  }
+};
+
+/**
+ * Indicators of a single candle series, computed once per completed candle
+ * no matter how many traders read them.
+ * An indicator is identified by its type, parameters and inputs, registering
+ * the same indicator again returns the outputs of the existing one. Inputs
+ * are candle columns or outputs of other indicators, which are always
+ * registered first, so registration order is a topological order of the
+ * dependency graph and every candle is evaluated in a single pass over it.
+ * The writer of the series feeds the graph every candle it appends and
+ * publishes the values along with the candles, as immutable snapshots.
+ */
+class IndicatorGraph {
+  using State =
+      std::variant<std::monostate, indicators::Ema, indicators::Sma,
+                   indicators::Rsi, indicators::Atr, indicators::Macd,
+                   indicators::BollingerBands>;
+  struct Key {
+    IndicatorType type;
+    std::vector<double> parameters;
+    std::vector<std::size_t> inputs;
+    auto operator<=>(const Key &) const = default;
+  };
+  struct Node {
+    Key key;
+    // state before the first candle, to start over from
+    State initial, state;
+    std::size_t firstOutput;
+  };
+
+public:
+  struct MacdOutputs {
+    IndicatorOutput macd, signal, histogram;
+  };
+  struct BandOutputs {
+    IndicatorOutput upper, middle, lower;
+  };
+
+  /**
+   * Computes the indicators registered so far over a whole series, leaving
+   * the graph untouched. Candles are collected first, then every indicator
+   * runs over all of them with the batch kernels, a column at a time.
+   */
+  class FeatureBuilder {
+  public:
+    inline void add(const Bar &candle) { candles.push_back(candle); }
+    std::shared_ptr<const FeatureMatrix> finish();
+
+  private:
+    friend class IndicatorGraph;
+    FeatureBuilder(std::vector<Node> nodes,
+                   std::vector<std::size_t> historySizes,
+                   std::size_t candles);
+    /**
+     * TA_MACD from two batch averages
+     * @return index of the first value
+     */
+    static std::size_t macdColumns(std::span<const double> values,
+                                   int fastPeriod, int slowPeriod,
+                                   int signalPeriod, std::span<double> macd,
+                                   std::span<double> signal,
+                                   std::span<double> histogram);
+    std::vector<Node> nodes;
+    std::vector<std::size_t> historySizes;
+    std::vector<Bar> candles;
+  };
+
+  /**
+   * Values and state of every indicator after some candle, to go back to
+   * when the candles after it change
+   */
+  class Checkpoint {
+  private:
+    friend class IndicatorGraph;
+    std::vector<State> states;
+    std::vector<std::size_t> historySizes;
+    std::vector<indicators::History> histories;
+  };
+
+  explicit IndicatorGraph(std::shared_ptr<const CandleSeries> series);
+
+  IndicatorOutput open();
+  IndicatorOutput high();
+  IndicatorOutput low();
+  IndicatorOutput close();
+  IndicatorOutput volume();
+  IndicatorOutput ema(IndicatorOutput input, int period);
+  IndicatorOutput sma(IndicatorOutput input, int period);
+  IndicatorOutput rsi(IndicatorOutput input, int period);
+  /**
+   * On the highs, lows and closes of the candles
+   */
+  IndicatorOutput atr(int period);
+  MacdOutputs macd(IndicatorOutput input, int fastPeriod, int slowPeriod,
+                   int signalPeriod);
+  BandOutputs bollingerBands(IndicatorOutput input, int period,
+                             double deviationsUp, double deviationsDown);
+
+  /**
+   * Keeps at least historySize of the most recent values of output, every
+   * output keeps its latest value
+   */
+  void subscribe(IndicatorOutput output, std::size_t historySize);
+  /**
+   * Number of distinct indicators, candle columns included
+   */
+  std::size_t size();
+  /**
+   * Values as of the latest published candles. Lock free.
+   */
+  inline std::shared_ptr<const IndicatorSnapshot> snapshot() const {
+    return published.load(std::memory_order::acquire);
+  }
+
+  /**
+   * Indicators were registered since the last publish, their values are
+   * published along with the next candles
+   */
+  inline bool pending() const {
+    return replay.load(std::memory_order::acquire);
+  }
+
+  /**
+   * Evaluates every indicator on the candle just appended to the series
+   */
+  void append(const Bar &candle);
+  /**
+   * Publishes the values along with the latest candles of the series.
+   * Indicators registered since the last publish are first computed over
+   * the candles the series retains, along with everything else.
+   */
+  void publish();
+  /**
+   * Starts over along with the series, dropping any features
+   */
+  void clear();
+  /**
+   * @returns nothing if the values are not evaluated candle by candle right
+   * now, because of features or indicators waiting to catch up
+   */
+  std::optional<Checkpoint> checkpoint();
+  /**
+   * Goes back to the values of checkpoint and publishes them, along with the
+   * series which has to be truncated to the same candle first. Candles
+   * appended from then on continue from the checkpoint.
+   * @returns false if indicators were registered or subscribed since the
+   * checkpoint or features are in use, the graph is left as it is
+   */
+  bool restore(const Checkpoint &checkpoint);
+  /**
+   * @param candles expected number of candles, to allocate up front
+   */
+  FeatureBuilder featureBuilder(std::size_t candles);
+  /**
+   * Reads values from features computed ahead of time instead of evaluating
+   * candles, for back tests. The features have to cover every candle since
+   * the series was last cleared and every indicator that is read.
+   */
+  void useFeatures(std::shared_ptr<const FeatureMatrix> features);
+
+private:
+  std::shared_ptr<const CandleSeries> series;
+  std::vector<Node> nodes;
+  std::map<Key, std::size_t> registry;
+  // capacity of every output history
+  std::vector<std::size_t> historySizes;
+  std::vector<indicators::History> histories;
+  std::shared_ptr<const FeatureMatrix> features;
+  // the histories changed since they were last published
+  bool changed{false};
+  // indicators were registered since the last publish
+  std::atomic<bool> replay{false};
+  std::atomic<std::shared_ptr<const IndicatorSnapshot>> published;
+  std::mutex mutex;
+
+  IndicatorOutput add(Key key, State state, std::size_t outputs);
+  void restart();
+  /**
+   * Starts over from the candles the series retains
+   */
+  void replayRetained(const CandleSnapshot &candles);
+  void publishLocked();
+  static void evaluate(std::vector<Node> &nodes,
+                       std::vector<indicators::History> &histories,
+                       const Bar &candle);
+  /**
+   * Adds a candle to a single indicator, reading its inputs and writing its
+   * outputs through input(i) and output(i, value)
+   */
+  template <typename Indicator, typename Input, typename Output>
+  static void step(const Node &node, Indicator &indicator, const Bar &candle,
+                   Input &&input, Output &&output);
+};
+} // namespace midas::trader
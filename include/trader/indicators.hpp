@@ -0,0 +1,375 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Streaming technical indicators.
+ * Each indicator is updated with one candle at a time in constant time and
+ * produces the same values as the matching TA-Lib function run over the
+ * same series from its first candle. Indicators are plain values, a forming
+ * candle is evaluated on a copy with peek so the state is never rolled back.
+ */
+namespace midas::trader::indicators {
+
+/**
+ * TA-Lib treats values this close to zero as zero
+ */
+inline bool isZero(double value) { return -1e-8 < value && value < 1e-8; }
+
+inline double trueRange(double high, double low, double previousClose) {
+  double range = high - low;
+  range = std::max(range, std::fabs(previousClose - high));
+  return std::max(range, std::fabs(previousClose - low));
+}
+
+/**
+ * The indicator as it would be with one more candle
+ */
+template <typename Indicator, typename... Values>
+inline Indicator peek(const Indicator &indicator, Values... values) {
+  Indicator next = indicator;
+  next.add(values...);
+  return next;
+}
+
+/**
+ * Exponential moving average seeded with the simple average of the first
+ * period values, TA_EMA
+ */
+class Ema {
+public:
+  explicit Ema(int period) : period(period), k(2.0 / (period + 1)) {}
+  inline void add(double value) {
+    if (count < period) {
+      current += value;
+      if (++count == period) {
+        current /= period;
+      }
+      return;
+    }
+    current = ((value - current) * k) + current;
+  }
+  inline bool ready() const { return count >= period; }
+  inline double value() const { return current; }
+  /**
+   * Starts from an average computed elsewhere, used where TA-Lib seeds an
+   * average from a window other than the first values
+   */
+  inline void seed(double average) {
+    count = period;
+    current = average;
+  }
+
+private:
+  int period;
+  double k;
+  int count{0};
+  // sum of the seed values until ready
+  double current{0};
+};
+
+/**
+ * Simple moving average, TA_SMA
+ */
+class Sma {
+public:
+  explicit Sma(int period) : period(period), window(period) {}
+  inline void add(double value) {
+    const double sum = total + value;
+    window[count % period] = value;
+    count++;
+    if (count < static_cast<std::size_t>(period)) {
+      total = sum;
+      return;
+    }
+    current = sum / period;
+    // the oldest value leaves the window with the next add
+    total = sum - window[count % period];
+  }
+  inline bool ready() const {
+    return count >= static_cast<std::size_t>(period);
+  }
+  inline double value() const { return current; }
+
+private:
+  int period;
+  std::vector<double> window;
+  std::size_t count{0};
+  // sum of the most recent period - 1 values
+  double total{0}, current{0};
+};
+
+/**
+ * Wilder's relative strength index, TA_RSI
+ */
+class Rsi {
+public:
+  explicit Rsi(int period) : period(period) {}
+  inline void add(double value) {
+    if (count++ == 0) {
+      previous = value;
+      return;
+    }
+    const double change = value - previous;
+    previous = value;
+    if (count <= period + 1) {
+      accumulate(change);
+      if (count == period + 1) {
+        averageGain /= period;
+        averageLoss /= period;
+        update();
+      }
+      return;
+    }
+    averageLoss *= (period - 1);
+    averageGain *= (period - 1);
+    accumulate(change);
+    averageLoss /= period;
+    averageGain /= period;
+    update();
+  }
+  inline bool ready() const { return count > period; }
+  inline double value() const { return current; }
+
+private:
+  int period;
+  int count{0};
+  double previous{0}, averageGain{0}, averageLoss{0}, current{0};
+
+  inline void accumulate(double change) {
+    if (change < 0) {
+      averageLoss -= change;
+    } else {
+      averageGain += change;
+    }
+  }
+  inline void update() {
+    const double total = averageGain + averageLoss;
+    current = isZero(total) ? 0.0 : 100.0 * (averageGain / total);
+  }
+};
+
+/**
+ * Wilder's average true range, TA_ATR
+ */
+class Atr {
+public:
+  explicit Atr(int period) : period(period) {}
+  inline void add(double high, double low, double close) {
+    if (count++ == 0) {
+      previousClose = close;
+      return;
+    }
+    const double range = trueRange(high, low, previousClose);
+    previousClose = close;
+    if (count <= period + 1) {
+      current += range;
+      if (count == period + 1) {
+        current /= period;
+      }
+      return;
+    }
+    current *= period - 1;
+    current += range;
+    current /= period;
+  }
+  inline bool ready() const { return count > period; }
+  inline double value() const { return current; }
+
+private:
+  int period;
+  int count{0};
+  double previousClose{0}, current{0};
+};
+
+/**
+ * Moving average convergence divergence, TA_MACD
+ */
+class Macd {
+public:
+  Macd(int fastPeriod, int slowPeriod, int signalPeriod)
+      : fastPeriod(std::min(fastPeriod, slowPeriod)),
+        slowPeriod(std::max(fastPeriod, slowPeriod)), fast(this->fastPeriod),
+        slow(this->slowPeriod), signalAverage(signalPeriod) {
+    seedValues.reserve(this->slowPeriod);
+  }
+  inline void add(double value) {
+    if (!slow.ready()) {
+      // TA-Lib seeds both averages so that they start on the same value
+      seedValues.push_back(value);
+      if (seedValues.size() < static_cast<std::size_t>(slowPeriod)) {
+        return;
+      }
+      slow.seed(average(0));
+      fast.seed(average(slowPeriod - fastPeriod));
+      seedValues = {};
+    } else {
+      fast.add(value);
+      slow.add(value);
+    }
+    line = fast.value() - slow.value();
+    signalAverage.add(line);
+  }
+  inline bool ready() const { return signalAverage.ready(); }
+  inline double macd() const { return line; }
+  inline double signal() const { return signalAverage.value(); }
+  inline double histogram() const { return line - signalAverage.value(); }
+
+private:
+  int fastPeriod, slowPeriod;
+  Ema fast, slow, signalAverage;
+  std::vector<double> seedValues;
+  double line{0};
+
+  inline double average(int from) const {
+    double total = 0;
+    for (std::size_t i = from; i < seedValues.size(); i++) {
+      total += seedValues[i];
+    }
+    return total / (slowPeriod - from);
+  }
+};
+
+/**
+ * Bollinger bands around a simple moving average, TA_BBANDS with
+ * TA_MAType_SMA
+ */
+class BollingerBands {
+public:
+  BollingerBands(int period, double deviationsUp, double deviationsDown)
+      : period(period), deviationsUp(deviationsUp),
+        deviationsDown(deviationsDown), middleAverage(period),
+        squares(period) {}
+  inline void add(double value) {
+    middleAverage.add(value);
+    const double square = value * value;
+    const double sum = squaresTotal + square;
+    squares[count % period] = square;
+    count++;
+    if (!middleAverage.ready()) {
+      squaresTotal = sum;
+      return;
+    }
+    const double middle = middleAverage.value();
+    double variance = sum / period;
+    squaresTotal = sum - squares[count % period];
+    variance -= middle * middle;
+    const double deviation = variance < 1e-8 ? 0.0 : std::sqrt(variance);
+    upperBand = middle + deviation * deviationsUp;
+    lowerBand = middle - deviation * deviationsDown;
+  }
+  inline bool ready() const { return middleAverage.ready(); }
+  inline double upper() const { return upperBand; }
+  inline double middle() const { return middleAverage.value(); }
+  inline double lower() const { return lowerBand; }
+
+private:
+  int period;
+  double deviationsUp, deviationsDown;
+  Sma middleAverage;
+  std::vector<double> squares;
+  std::size_t count{0};
+  double squaresTotal{0}, upperBand{0}, lowerBand{0};
+};
+
+/**
+ * Wilder's directional movement, TA_PLUS_DI, TA_MINUS_DI and TA_ADX
+ */
+class DirectionalMovement {
+public:
+  explicit DirectionalMovement(int period) : period(period) {}
+  inline void add(double high, double low, double close) {
+    if (count++ == 0) {
+      previousHigh = high;
+      previousLow = low;
+      previousClose = close;
+      return;
+    }
+    const double up = high - previousHigh;
+    const double down = previousLow - low;
+    previousHigh = high;
+    previousLow = low;
+    const double range = trueRange(high, low, previousClose);
+    previousClose = close;
+    if (count <= period) {
+      if (down > 0 && up < down) {
+        minusMovement += down;
+      } else if (up > 0 && up > down) {
+        plusMovement += up;
+      }
+      rangeTotal += range;
+      return;
+    }
+    minusMovement -= minusMovement / period;
+    plusMovement -= plusMovement / period;
+    if (down > 0 && up < down) {
+      minusMovement += down;
+    } else if (up > 0 && up > down) {
+      plusMovement += up;
+    }
+    rangeTotal = rangeTotal - (rangeTotal / period) + range;
+
+    const int step = count - period;
+    if (isZero(rangeTotal)) {
+      plusIndicator = minusIndicator = 0;
+      if (step == period) {
+        averageIndex = dxTotal / period;
+      }
+      return;
+    }
+    minusIndicator = 100.0 * (minusMovement / rangeTotal);
+    plusIndicator = 100.0 * (plusMovement / rangeTotal);
+    const double indicatorTotal = minusIndicator + plusIndicator;
+    const bool hasIndex = !isZero(indicatorTotal);
+    const double index =
+        hasIndex
+            ? 100.0 * (std::fabs(minusIndicator - plusIndicator) /
+                       indicatorTotal)
+            : 0.0;
+    if (step <= period) {
+      dxTotal += index;
+      if (step == period) {
+        averageIndex = dxTotal / period;
+      }
+    } else if (hasIndex) {
+      averageIndex = ((averageIndex * (period - 1)) + index) / period;
+    }
+  }
+  inline bool directionalReady() const { return count > period; }
+  inline bool ready() const { return count >= 2 * period; }
+  inline double plusDI() const { return plusIndicator; }
+  inline double minusDI() const { return minusIndicator; }
+  inline double adx() const { return averageIndex; }
+
+private:
+  int period;
+  int count{0};
+  double previousHigh{0}, previousLow{0}, previousClose{0};
+  double plusMovement{0}, minusMovement{0}, rangeTotal{0};
+  double plusIndicator{0}, minusIndicator{0}, dxTotal{0}, averageIndex{0};
+};
+
+/**
+ * The most recent values of an indicator, oldest first
+ */
+class History {
+public:
+  explicit History(std::size_t capacity) : values(capacity) {}
+  inline void push(double value) { values[pushed++ % values.size()] = value; }
+  inline std::size_t size() const { return std::min(pushed, values.size()); }
+  inline bool full() const { return pushed >= values.size(); }
+  /**
+   * @param offset from the end, 0 is the most recent value
+   */
+  inline double back(std::size_t offset = 0) const {
+    return values[(pushed - 1 - offset) % values.size()];
+  }
+  inline void clear() { pushed = 0; }
+
+private:
+  std::vector<double> values;
+  std::size_t pushed{0};
+};
+} // namespace midas::trader::indicators
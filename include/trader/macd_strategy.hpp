@@ -0,0 +1,20 @@
+#pragma once
+#include "trader/coroutine_trader.hpp"
+#include "trader/macd_trader.hpp"
+#include <cstddef>
+
+namespace midas::trader {
+
+/**
+ * The MacdTrader rules as a strategy: enters with a market order near a
+ * cross of the macd over its signal, holds for a few periods and exits on a
+ * histogram turn at an extreme rsi. Runs on 120 second candles with a look
+ * back of at least macdStrategyLookBack.
+ * @param parameters copied before the strategy first suspends
+ */
+Strategy macdStrategy(
+    CoroutineTrader &trader, std::size_t entryQuantity,
+    const MacdParameters &parameters = MacdTrader::defaultParameters);
+
+constexpr std::size_t macdStrategyLookBack = 100;
+} // namespace midas::trader
@@ -2,12 +2,43 @@
 // Created by ahi on 1/6/25.
 //
 #include "trader/base_trader.hpp"
+#include "trader/indicator_graph.hpp"
 
 #ifndef MACD_TRADER_HPP
 #define MACD_TRADER_HPP
 namespace midas::trader {
 
+/**
+ * Tunable settings of the MacdTrader, the defaults are what it trades with
+ * live
+ */
+struct MacdParameters {
+  int fastMATimePeriod = 5;
+  int slowMATimePeriod = 15;
+  int macdFastPeriod = 6, macdSlowPeriod = 13, macdSignalPeriod = 4;
+  int volumeMATimePeriod = 13;
+  int rsiTimePeriod = 6;
+  /**
+   * Entries are only taken this many candles after the macd crossed its
+   * signal
+   */
+  std::size_t maxCrossOverDistance = 25;
+  /**
+   * Longs are not entered and are left above the overbought rsi, shorts
+   * below the oversold rsi
+   */
+  double rsiOverbought = 75, rsiOversold = 25;
+  /**
+   * Candles the histogram has to move against a position before it is left
+   */
+  int numberOfConsecutivePeriodsRequired = 3;
+};
+
 class MacdTrader : public Trader {
+public:
+  static constexpr MacdParameters defaultParameters{};
+
+
 protected:
   std::recursive_mutex stateMutex;
   enum class TraderState {
@@ -16,44 +47,69 @@ protected:
     ShortPosition,
     Waiting,
   };
-  static constexpr int fastMATimePeriod = 5;
-  static constexpr int slowMATimePeriod = 15;
-  static constexpr int macdFastPeriod = 6, macdSlowPeriod = 13,
-                       macdSignalPeriod = 4;
-  static constexpr int volumeMATimePeriod = 13;
-  static constexpr int rsiTimePeriod = 6;
+  const MacdParameters parameters;
   InstrumentEnum instrument;
 
-  std::array<double, 100> slowMa, fastMa, macd, macdSignal, macdHistogram, rsi, volumeMa;
-  std::vector<double> closePrices, volumes, highs, lows, opens, vwaps;
-  std::vector<boost::posix_time::ptime> timestamps;
-  std::vector<unsigned int> trades;
-  int slowMAOutBeg = 0, fastMAOutBeg = 0, macdOutBegin = 0, slowMAOutSize = 0,
-      fastMAOutSize, macdOutSize = 0, rsiOutBegin = 0, rsiOutSize = 0, volumeMAOutBegin = 0, volumeMAOutSize = 0;
+  /**
+   * Outputs of the shared indicator graph of the candles, the histogram
+   * history is long enough to find a cross over
+   */
+  struct technical_analysis_t {
+    IndicatorOutput fastMa, slowMa, rsi, volumeMa;
+    IndicatorGraph::MacdOutputs macd;
+  } analysis;
+  std::shared_ptr<const IndicatorSnapshot> indicatorValues;
+  std::shared_ptr<const CandleSnapshot> candles;
+  std::span<const double> closePrices, volumes, highs, lows, opens, vwaps;
+  std::span<const midas::Timestamp> timestamps;
+  std::span<const unsigned int> trades;
   TraderState currentState{TraderState::NoPosition};
   const std::size_t entryQuantity;
   const bool useMKTOrders{true};
-  const int numberOfConsecutivePeriodsRequired{3};
-  std::optional<boost::posix_time::ptime> entryTime;
+  std::optional<midas::Timestamp> entryTime;
 
-  void clearBuffers();
+  /**
+   * Points the candle spans at the candles of the latest indicator values,
+   * nothing is copied
+   */
+  void loadCandles();
 
 public:
-  MacdTrader(const std::shared_ptr<midas::DataStream> &source,
+  MacdTrader(const CandleSource &source,
              const std::shared_ptr<midas::OrderManager> &orderManager,
              midas::InstrumentEnum instrument, std::size_t entryQuantity,
-             const std::shared_ptr<logging::thread_safe_logger_t> &logger);
+             const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+             const MacdParameters &parameters = defaultParameters);
   virtual ~MacdTrader() = default;
   void decide() override;
   std::string traderName() const override;
 
 protected:
   MacdTrader(std::size_t bufferSize,
-             const std::shared_ptr<midas::DataStream> &source,
+             const CandleSource &source,
              const std::shared_ptr<midas::OrderManager> &orderManager,
              midas::InstrumentEnum instrument, std::size_t entryQuantity,
-             const std::shared_ptr<logging::thread_safe_logger_t> &logger);
+             const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+             const MacdParameters &parameters = defaultParameters);
+  /**
+   * Brings the indicators up to date with the latest completed candles
+   */
   virtual void calculateTechnicalAnalysis();
+  /**
+   * Number of candles since the histogram last matched, the size of the
+   * history if it never did
+   */
+  template <typename Predicate>
+  std::size_t histogramEndDistance(Predicate &&matches) const {
+    const IndicatorOutput histogram = analysis.macd.histogram;
+    const std::size_t size = indicatorValues->size(histogram);
+    std::size_t distance = 0;
+    while (distance < size &&
+           !matches(indicatorValues->value(histogram, distance))) {
+      distance++;
+    }
+    return distance;
+  }
   void decideEntry();
   void decideLongExit();
   void decideShortExit();
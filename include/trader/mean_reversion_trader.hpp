@@ -3,27 +3,56 @@
 //
 # pragma once
 #include "./base_trader.hpp"
+#include "./indicator_graph.hpp"
 namespace midas::trader {
 
+/**
+ * Tunable settings of the MeanReversionTrader, the defaults are what it
+ * trades with live
+ */
+struct MeanReversionParameters {
+  int bbandsPeriod = 20;
+  /**
+   * Width of the bands in standard deviations
+   */
+  double bbandsDeviations = 2.0;
+  /**
+   * Distance of the stop loss beyond the band the position was entered on
+   */
+  double stopLossMargin = 2;
+};
+
 class MeanReversionTrader: public Trader {
+  public:
+  static constexpr MeanReversionParameters defaultParameters{};
 
   protected:
   struct candle_decision_t {
     double bullishIndicator{-1}, bearishIndicator{-1}, maxBullish{0}, maxBearish{0};
   };
-  static constexpr int roundingCoeff = 4;
-  std::array<double, 100> bbUpper, bbMiddle, bbLower;
-  int bbBegIndex = 0, bbOutSize = 0;
-  std::vector<unsigned int> trades;
-  std::vector<double> closePrices, volumes, highs, lows, opens, vwaps;
-  std::vector<boost::posix_time::ptime> timestamps;
+  const MeanReversionParameters parameters;
+  /**
+   * Bands from the shared indicator graph of the candles
+   */
+  IndicatorGraph::BandOutputs bbands;
+  std::shared_ptr<const IndicatorSnapshot> indicatorValues;
+  std::shared_ptr<const CandleSnapshot> candles;
+  std::span<const unsigned int> trades;
+  std::span<const double> closePrices, volumes, highs, lows, opens, vwaps;
+  std::span<const midas::Timestamp> timestamps;
   const midas::InstrumentEnum instrument;
+  const midas::InstrumentSpec instrumentSpec;
   const std::size_t entryQuantity;
-  MeanReversionTrader( std::size_t bufferSize, const std::shared_ptr<midas::DataStream> &source,
+  MeanReversionTrader( std::size_t bufferSize, const CandleSource &source,
                  const std::shared_ptr<midas::OrderManager> &orderManager,
                  midas::InstrumentEnum instrument, std::size_t entryQuantity,
-                 const std::shared_ptr<logging::thread_safe_logger_t> &logger);
-  void clearBuffers();
+                 const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+                 const MeanReversionParameters &parameters);
+  /**
+   * Points the candle spans at the candles of the latest indicator values,
+   * nothing is copied
+   */
+  void loadCandles();
   /**
    *
    * @param entryPrice decided entry price
@@ -42,13 +71,17 @@ class MeanReversionTrader: public Trader {
   virtual candle_decision_t decideCandle(std::size_t candleEndOffset);
   virtual std::size_t decideEntryQuantity();
   virtual double decideEntryPrice();
+  /**
+   * Brings the bands up to date with the latest completed candles
+   */
   virtual void calculateTechnicalAnalysis();
 
   public:
-  MeanReversionTrader(const std::shared_ptr<midas::DataStream> &source,
+  MeanReversionTrader(const CandleSource &source,
                const std::shared_ptr<midas::OrderManager> &orderManager,
                midas::InstrumentEnum instrument, std::size_t entryQuantity,
-               const std::shared_ptr<logging::thread_safe_logger_t> &logger);
+               const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+               const MeanReversionParameters &parameters = defaultParameters);
     void decide() override;
     std::string traderName() const override;
     virtual ~MeanReversionTrader() = default;
@@ -1,8 +1,34 @@
 #pragma once
 #include "trader/base_trader.hpp"
+#include "trader/indicator_graph.hpp"
+#include <cstdint>
+#include <span>
 #include <vector>
 
 namespace midas::trader {
+/**
+ * Tunable settings of the MomentumTrader, the defaults are what it trades
+ * with live
+ */
+struct MomentumParameters {
+  int fastMATimePeriod = 5;
+  int slowMATimePeriod = 15;
+  int volumeMATimePeriod = 15;
+  int atrTimePeriod = 21;
+  int rsiTimePeriod = 6;
+  int macdFastPeriod = 6, macdSlowPeriod = 13, macdSignalPeriod = 4;
+  int atrSmoothingPeriod = 9;
+  /**
+   * Longs are only entered below the overbought rsi, shorts above the
+   * oversold rsi
+   */
+  double rsiOverbought = 65, rsiOversold = 25;
+  /**
+   * Distances of the profit taker and the stop loss from the entry price
+   */
+  double profitOffset = 5, stopLossOffset = 15;
+};
+
 /**
  * Very simple momentum trader
  * Intended to scalp MNQ and MES and similar indexes.
@@ -10,40 +36,51 @@ namespace midas::trader {
 
 class MomentumTrader : public midas::trader::Trader {
 public:
-  static constexpr int fastMATimePeriod = 5;
-  static constexpr int slowMATimePeriod = 15;
-  static constexpr int volumeMATimePeriod = 15;
-  static constexpr int atrTimePeriod = 21;
-  static constexpr int rsiTimePeriod = 6;
-
-  static constexpr int macdFastPeriod = 6, macdSlowPeriod = 13,
-                       macdSignalPeriod = 4;
-  static constexpr int atrSmoothingPeriod = 9;
+  static constexpr MomentumParameters defaultParameters{};
   static constexpr double commissionEstimatePerUnit = 0.25;
-  static constexpr double roundingCoeff = 4; // minimum of .25 index moves
+  /**
+   * Number of most recent candles the decision looks at
+   */
+  static constexpr std::size_t decisionCandles = 6;
 protected:
+  const MomentumParameters parameters;
   std::atomic<int> bullishCandlesinARow{0}, bearishCandlesInARow{0};
+  /**
+   * Generation of the candles the streaks were counted on, a repair of the
+   * candles starts them over
+   */
+  std::uint64_t streakGeneration{0};
   struct candle_decision_t {
     double bullishIndicator{-1}, bearishIndicator{-1}, maxBullish{0}, maxBearish{0};
   };
-  std::array<double, 100> slowMa, fastMa, volumeMa, atr, atrMA, macd,
-      macdSignal, macdHistogram, rsi, bbUpper, bbMiddle, bbLower;
-  int slowMAOutBeg = 0, fastMAOutBeg = 0, volumeMAOutBegin = 0, atrOutBegin = 0,
-      atrMAOutBegin = 0, macdOutBegin = 0, slowMAOutSize = 0, fastMAOutSize,
-      volumeMAOutSize = 0, atrOutSize = 0, atrMAOutSize = 0, macdOutSize = 0,
-      rsiOutBegin = 0, rsiOutSize = 0, bbBegIndex = 0, bbOutSize = 0;
+  /**
+   * Outputs of the shared indicator graph of the candles
+   */
+  struct technical_analysis_t {
+    IndicatorOutput fastMa, slowMa, volumeMa, atr, atrMA, rsi;
+    IndicatorGraph::MacdOutputs macd;
+    IndicatorGraph::BandOutputs bbands;
+  } analysis;
+  std::shared_ptr<const IndicatorSnapshot> indicatorValues;
   const midas::InstrumentEnum instrument;
-  std::vector<unsigned int> trades;
-  std::vector<double> closePrices, volumes, highs, lows, opens, vwaps;
-  std::vector<boost::posix_time::ptime> timestamps;
+  const midas::InstrumentSpec instrumentSpec;
+  std::shared_ptr<const CandleSnapshot> candles;
+  std::span<const unsigned int> trades;
+  std::span<const double> closePrices, volumes, highs, lows, opens, vwaps;
+  std::span<const midas::Timestamp> timestamps;
 
-  void clearBuffers();
+  /**
+   * Points the candle spans at the candles of the latest indicator values,
+   * nothing is copied
+   */
+  void loadCandles();
 
 public:
-  MomentumTrader(const std::shared_ptr<midas::DataStream> &source,
+  MomentumTrader(const CandleSource &source,
                  const std::shared_ptr<midas::OrderManager> &orderManager,
                  midas::InstrumentEnum instrument, std::size_t entryQuantity,
-                 const std::shared_ptr<logging::thread_safe_logger_t> &logger);
+                 const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+                 const MomentumParameters &parameters = defaultParameters);
 
   virtual ~MomentumTrader() = default;
   void decide() override;
@@ -51,10 +88,11 @@ public:
 
 protected:
   MomentumTrader(std::size_t bufferSize,
-                 const std::shared_ptr<midas::DataStream> &source,
+                 const CandleSource &source,
                  const std::shared_ptr<midas::OrderManager> &orderManager,
                  midas::InstrumentEnum instrument, std::size_t entryQuantity,
-                 const std::shared_ptr<logging::thread_safe_logger_t> &logger);
+                 const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+                 const MomentumParameters &parameters = defaultParameters);
   const std::size_t entryQuantity;
   /**
    *
@@ -73,17 +111,22 @@ protected:
   virtual candle_decision_t decideCandle(std::size_t candleEndOffset);
   virtual std::size_t decideEntryQuantity();
   virtual double decideEntryPrice();
+  /**
+   * Brings the indicators up to date with the latest completed candles
+   */
   virtual void calculateTechnicalAnalysis();
 };
 
 class StockMomentumTrader : public MomentumTrader {
 public:
   StockMomentumTrader(
-      const std::shared_ptr<midas::DataStream> &source,
+      const CandleSource &source,
       const std::shared_ptr<midas::OrderManager> &orderManager,
       midas::InstrumentEnum instrument, std::size_t entryQuantity,
-      const std::shared_ptr<logging::thread_safe_logger_t> &logger)
-      : MomentumTrader(100, source, orderManager, instrument, entryQuantity, logger) {}
+      const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+      const MomentumParameters &parameters = defaultParameters)
+      : MomentumTrader(100, source, orderManager, instrument, entryQuantity,
+                       logger, parameters) {}
 
 protected:
   std::size_t decideEntryQuantity() override;
@@ -0,0 +1,223 @@
+#pragma once
+#include "broker-interface/order.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * The subset of Pine Script v5 strategies used by the scripts in
+ * pine_script_samples, compiled to a register machine whose registers are
+ * whole candle columns.
+ * Every instruction runs over all of the candles at once, so a run costs a
+ * few passes over the columns per instruction and nothing per candle is
+ * interpreted. Indicators run on the batch kernels.
+ *
+ * Supported are declarations and tuple declarations at the top level,
+ * arithmetic, comparison and logical operators, the ternary operator,
+ * history references x[n], if and else blocks holding strategy calls,
+ * ta.ema, ta.sma, ta.rsi, ta.atr, ta.macd, ta.dmi, ta.rising, ta.falling,
+ * ta.highest, ta.lowest, ta.change, math.abs, market strategy.entry and
+ * strategy.exit with stop, limit, loss, profit and trail arguments.
+ * Calls to plot functions are ignored. Anything else, such as var, :=, loops
+ * or user functions, is rejected with a ScriptError.
+ */
+namespace midas::trader::pine {
+
+/**
+ * A column with a value per candle, or a scalar with one value for all of
+ * them
+ */
+struct Register {
+  std::uint32_t index;
+  bool scalar;
+};
+
+enum class OpCode : std::uint8_t {
+  Add,
+  Subtract,
+  Multiply,
+  Divide,
+  Modulo,
+  Negate,
+  Abs,
+  Less,
+  LessOrEqual,
+  Equal,
+  NotEqual,
+  And,
+  Or,
+  Not,
+  /**
+   * a if c holds, b otherwise
+   */
+  Select,
+  /**
+   * a periods[0] candles back
+   */
+  Previous,
+  Ema,
+  Sma,
+  Rsi,
+  /**
+   * On the candles, without operands
+   */
+  Atr,
+  /**
+   * Three outputs, macd, signal and histogram
+   */
+  Macd,
+  /**
+   * On the candles, three outputs, +DI, -DI and ADX
+   */
+  Dmi,
+  Rising,
+  Falling,
+  Highest,
+  Lowest,
+};
+
+struct Instruction {
+  OpCode code;
+  /**
+   * First output, outputs of multiple output instructions are consecutive
+   */
+  Register out;
+  Register a{0, true}, b{0, true}, c{0, true};
+  std::array<int, 3> periods{};
+};
+
+/**
+ * Bracket arguments of strategy.exit, prices are read at the candle the
+ * entry is taken on
+ */
+struct Exit {
+  std::optional<Register> stop, limit, trailPrice;
+  /**
+   * In ticks from the entry price
+   */
+  std::optional<Register> loss, profit, trailPoints, trailOffset;
+};
+
+struct Entry {
+  std::string id;
+  OrderDirection direction;
+  /**
+   * Holds on the candles the entry is taken on
+   */
+  Register when;
+  /**
+   * The trader decides when the script does not
+   */
+  std::optional<Register> quantity;
+  Exit exit;
+};
+
+/**
+ * Compiled script
+ */
+struct Program {
+  static constexpr std::uint32_t open = 0, high = 1, low = 2, close = 3,
+                                 volume = 4, inputColumns = 5;
+  /**
+   * Scalar registers the runner sets before every run
+   */
+  static constexpr std::uint32_t positionSize = 0, minTick = 1;
+
+  std::string title;
+  std::vector<Instruction> code;
+  std::vector<Entry> entries;
+  /**
+   * Number of column registers, the candle columns included
+   */
+  std::uint32_t columns{inputColumns};
+  /**
+   * Initial scalar registers, the constants of the script
+   */
+  std::vector<double> scalars;
+  /**
+   * Register of every declared variable
+   */
+  std::map<std::string, Register, std::less<>> variables;
+  /**
+   * Number of candles before every column has values
+   */
+  std::size_t warmUp{0};
+};
+
+/**
+ * @throws ScriptError with the line of the first problem
+ */
+std::shared_ptr<const Program> compile(std::string_view source);
+std::shared_ptr<const Program> compileFile(const std::filesystem::path &path);
+
+/**
+ * Candle columns a program runs over, oldest first
+ */
+struct Series {
+  std::span<const double> opens, highs, lows, closes, volumes;
+};
+
+/**
+ * Runs a program. Registers are kept between runs, so runs over windows of
+ * about the same size do not allocate.
+ */
+class Machine {
+public:
+  struct Inputs {
+    /**
+     * Signed, positive for longs
+     */
+    double positionSize{0};
+    double minTick{0};
+  };
+
+  explicit Machine(std::shared_ptr<const Program> program);
+
+  /**
+   * @throws std::invalid_argument if the columns differ in size
+   */
+  void run(const Series &series, const Inputs &inputs);
+  /**
+   * Number of candles of the last run
+   */
+  inline std::size_t size() const { return candles; }
+  /**
+   * @param offset from the last candle
+   * @return NaN before the first candle
+   */
+  double value(Register reg, std::size_t offset = 0) const;
+  /**
+   * Non zero and not NaN, the way conditions hold in Pine
+   */
+  bool holds(Register reg, std::size_t offset = 0) const;
+  /**
+   * Every value of a column register, a scalar repeated for a scalar
+   */
+  std::vector<double> values(Register reg) const;
+
+private:
+  std::shared_ptr<const Program> program;
+  Series series;
+  std::size_t candles{0};
+  std::vector<std::vector<double>> columns;
+  std::vector<double> scalars;
+  // intermediate columns of the indicators with several steps
+  std::array<std::vector<double>, 4> scratch;
+
+  std::span<const double> read(Register reg) const;
+  std::span<double> write(Register reg);
+  void execute(const Instruction &instruction);
+  template <typename Visitor> void withOperand(Register reg, Visitor &&visit);
+  template <typename Operation>
+  void binary(const Instruction &instruction, Operation &&operation);
+  void dmi(const Instruction &instruction);
+};
+} // namespace midas::trader::pine
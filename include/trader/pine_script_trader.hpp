@@ -0,0 +1,45 @@
+#pragma once
+#include "trader/base_trader.hpp"
+#include "trader/pine_script.hpp"
+#include <memory>
+#include <optional>
+
+namespace midas::trader {
+
+/**
+ * Trades a compiled Pine Script strategy.
+ * The program runs over the look back candles once per completed candle,
+ * entries that hold on the last one are placed as brackets at its close,
+ * one position at a time. The order system has no trailing stops, a trail
+ * is approximated by a profit taker at its activation price.
+ */
+class PineScriptTrader : public Trader {
+public:
+  /**
+   * Recursive indicators forget their seed within a few of their periods,
+   * the look back is this many times the warm up of the program
+   */
+  static constexpr std::size_t warmUpFactor = 4;
+
+  PineScriptTrader(std::shared_ptr<const pine::Program> program,
+                   std::size_t candleSizeSeconds, const CandleSource &source,
+                   const std::shared_ptr<midas::OrderManager> &orderManager,
+                   midas::InstrumentEnum instrument, std::size_t entryQuantity,
+                   const std::shared_ptr<logging::thread_safe_logger_t> &logger);
+  void decide() override;
+  std::string traderName() const override;
+
+private:
+  const std::shared_ptr<const pine::Program> program;
+  pine::Machine machine;
+  const midas::InstrumentEnum instrument;
+  const midas::InstrumentSpec instrumentSpec;
+  const std::size_t entryQuantity;
+  // signed quantity of the last entry
+  double positionSize{0};
+  // candles the program last ran over, it only runs again on a new candle
+  std::optional<std::pair<std::uint64_t, std::size_t>> decided;
+
+  void enter(const pine::Entry &entry);
+};
+} // namespace midas::trader
@@ -0,0 +1,215 @@
+#pragma once
+#include "trader/indicators.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <utility>
+
+/**
+ * Indicator sets fixed at compile time.
+ * A strategy lists its indicators as types, such as
+ * Pipeline<Ema<5>, Ema<15>, Macd<6, 13, 4>, Rsi<6>>, and every candle updates
+ * all of them in a single inlined step. Each stage is the streaming
+ * indicator of the same name with its period as a constant, nothing is
+ * dispatched at run time, so a run over a series is one fused loop.
+ */
+namespace midas::trader::pipeline {
+
+enum class Field { Open, High, Low, Close, Volume };
+
+/**
+ * Columns of a candle series. Columns the indicators do not read may be
+ * left empty, the others hold size() candles.
+ */
+struct Columns {
+  std::span<const double> opens{}, highs{}, lows{}, closes{}, volumes{};
+  inline std::size_t size() const {
+    return std::max({opens.size(), highs.size(), lows.size(), closes.size(),
+                     volumes.size()});
+  }
+};
+
+template <Field Source>
+inline double read(const Columns &columns, std::size_t index) {
+  if constexpr (Source == Field::Open) {
+    return columns.opens[index];
+  } else if constexpr (Source == Field::High) {
+    return columns.highs[index];
+  } else if constexpr (Source == Field::Low) {
+    return columns.lows[index];
+  } else if constexpr (Source == Field::Close) {
+    return columns.closes[index];
+  } else {
+    return columns.volumes[index];
+  }
+}
+
+/**
+ * TA_EMA
+ */
+template <int Period, Field Source = Field::Close> class Ema {
+  static_assert(Period > 0, "Indicator period must be positive");
+
+public:
+  /**
+   * Candles before the first value
+   */
+  static constexpr std::size_t lookBack = Period - 1;
+  inline void add(const Columns &columns, std::size_t index) {
+    indicator.add(read<Source>(columns, index));
+  }
+  inline bool ready() const { return indicator.ready(); }
+  inline double value() const { return indicator.value(); }
+
+private:
+  indicators::Ema indicator{Period};
+};
+
+/**
+ * TA_SMA
+ */
+template <int Period, Field Source = Field::Close> class Sma {
+  static_assert(Period > 0, "Indicator period must be positive");
+
+public:
+  static constexpr std::size_t lookBack = Period - 1;
+  inline void add(const Columns &columns, std::size_t index) {
+    indicator.add(read<Source>(columns, index));
+  }
+  inline bool ready() const { return indicator.ready(); }
+  inline double value() const { return indicator.value(); }
+
+private:
+  indicators::Sma indicator{Period};
+};
+
+/**
+ * TA_RSI
+ */
+template <int Period, Field Source = Field::Close> class Rsi {
+  static_assert(Period > 0, "Indicator period must be positive");
+
+public:
+  static constexpr std::size_t lookBack = Period;
+  inline void add(const Columns &columns, std::size_t index) {
+    indicator.add(read<Source>(columns, index));
+  }
+  inline bool ready() const { return indicator.ready(); }
+  inline double value() const { return indicator.value(); }
+
+private:
+  indicators::Rsi indicator{Period};
+};
+
+/**
+ * TA_ATR, on the highs, lows and closes
+ */
+template <int Period> class Atr {
+  static_assert(Period > 0, "Indicator period must be positive");
+
+public:
+  static constexpr std::size_t lookBack = Period;
+  inline void add(const Columns &columns, std::size_t index) {
+    indicator.add(columns.highs[index], columns.lows[index],
+                  columns.closes[index]);
+  }
+  inline bool ready() const { return indicator.ready(); }
+  inline double value() const { return indicator.value(); }
+
+private:
+  indicators::Atr indicator{Period};
+};
+
+/**
+ * TA_MACD
+ */
+template <int FastPeriod, int SlowPeriod, int SignalPeriod,
+          Field Source = Field::Close>
+class Macd {
+  static_assert(FastPeriod > 0 && SlowPeriod > 0 && SignalPeriod > 0,
+                "Indicator period must be positive");
+
+public:
+  static constexpr std::size_t lookBack =
+      std::max(FastPeriod, SlowPeriod) + SignalPeriod - 2;
+  inline void add(const Columns &columns, std::size_t index) {
+    indicator.add(read<Source>(columns, index));
+  }
+  inline bool ready() const { return indicator.ready(); }
+  inline double macd() const { return indicator.macd(); }
+  inline double signal() const { return indicator.signal(); }
+  inline double histogram() const { return indicator.histogram(); }
+
+private:
+  indicators::Macd indicator{FastPeriod, SlowPeriod, SignalPeriod};
+};
+
+/**
+ * TA_BBANDS with TA_MAType_SMA
+ */
+template <int Period, double DeviationsUp = 2.0, double DeviationsDown = 2.0,
+          Field Source = Field::Close>
+class BollingerBands {
+  static_assert(Period > 0, "Indicator period must be positive");
+
+public:
+  static constexpr std::size_t lookBack = Period - 1;
+  inline void add(const Columns &columns, std::size_t index) {
+    indicator.add(read<Source>(columns, index));
+  }
+  inline bool ready() const { return indicator.ready(); }
+  inline double upper() const { return indicator.upper(); }
+  inline double middle() const { return indicator.middle(); }
+  inline double lower() const { return indicator.lower(); }
+
+private:
+  indicators::BollingerBands indicator{Period, DeviationsUp, DeviationsDown};
+};
+
+/**
+ * Indicators updated together, one candle at a time
+ */
+template <typename... Indicators> class Pipeline {
+public:
+  /**
+   * Candles before every indicator has a value
+   */
+  static constexpr std::size_t lookBack =
+      std::max({std::size_t{0}, Indicators::lookBack...});
+
+  inline void add(const Columns &columns, std::size_t index) {
+    std::apply(
+        [&](Indicators &...indicator) { (indicator.add(columns, index), ...); },
+        indicators);
+  }
+  inline bool ready() const {
+    return std::apply(
+        [](const Indicators &...indicator) {
+          return (indicator.ready() && ...);
+        },
+        indicators);
+  }
+  template <std::size_t Index> inline const auto &get() const {
+    return std::get<Index>(indicators);
+  }
+  template <typename Indicator> inline const Indicator &get() const {
+    return std::get<Indicator>(indicators);
+  }
+  /**
+   * Adds every candle of columns in a single loop, onCandle(index, pipeline)
+   * reads the values after each one
+   */
+  template <typename OnCandle>
+  inline void run(const Columns &columns, OnCandle &&onCandle) {
+    const std::size_t size = columns.size();
+    for (std::size_t index = 0; index < size; index++) {
+      add(columns, index);
+      onCandle(index, std::as_const(*this));
+    }
+  }
+
+private:
+  std::tuple<Indicators...> indicators;
+};
+} // namespace midas::trader::pipeline
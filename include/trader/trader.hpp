@@ -5,6 +5,7 @@
 #include "data/data_stream.hpp"
 
 #include "base_trader.hpp"
+#include "pine_script.hpp"
 #include <boost/signals2/variadic_signal.hpp>
 #include <memory>
 namespace midas::trader {
@@ -36,22 +37,62 @@ inline TraderType trader_from_string(const std::string &str) {
   throw std::runtime_error("Invalid TraderType");
 }
 
+struct MomentumParameters;
+struct MeanReversionParameters;
+struct MacdParameters;
+
 std::unique_ptr<Trader>
-momentumExploit(std::shared_ptr<DataStream> source,
+momentumExploit(const CandleSource &source,
                 std::shared_ptr<midas::OrderManager> orderManager,
                 InstrumentEnum instrument, std::size_t entryQuantity);
+/**
+ * With parameters other than the ones traded live, for searches
+ */
+std::unique_ptr<Trader>
+momentumExploit(const CandleSource &source,
+                std::shared_ptr<midas::OrderManager> orderManager,
+                InstrumentEnum instrument, std::size_t entryQuantity,
+                const MomentumParameters &parameters);
 std::unique_ptr<Trader>
-meanReversion(std::shared_ptr<DataStream> source,
+meanReversion(const CandleSource &source,
               std::shared_ptr<midas::OrderManager> orderManager,
               InstrumentEnum instrument, std::size_t entryQuantity);
+std::unique_ptr<Trader>
+meanReversion(const CandleSource &source,
+              std::shared_ptr<midas::OrderManager> orderManager,
+              InstrumentEnum instrument, std::size_t entryQuantity,
+              const MeanReversionParameters &parameters);
 
 std::unique_ptr<Trader>
-macdExploit(std::shared_ptr<DataStream> source,
+macdExploit(const CandleSource &source,
             std::shared_ptr<midas::OrderManager> orderManager,
             InstrumentEnum instrument, std::size_t entryQuantity);
+std::unique_ptr<Trader>
+macdExploit(const CandleSource &source,
+            std::shared_ptr<midas::OrderManager> orderManager,
+            InstrumentEnum instrument, std::size_t entryQuantity,
+            const MacdParameters &parameters);
+
+/**
+ * The MacdTrader rules written as a coroutine strategy
+ */
+std::unique_ptr<Trader>
+macdCoroutine(const CandleSource &source,
+              std::shared_ptr<midas::OrderManager> orderManager,
+              InstrumentEnum instrument, std::size_t entryQuantity);
+
+/**
+ * Trades a strategy script, compiled with pine::compile or pine::compileFile
+ */
+std::unique_ptr<Trader>
+pineScript(const CandleSource &source,
+           std::shared_ptr<midas::OrderManager> orderManager,
+           InstrumentEnum instrument, std::size_t entryQuantity,
+           std::shared_ptr<const pine::Program> program,
+           std::size_t candleSizeSeconds);
 
 std::unique_ptr<Trader>
-createTrader(TraderType type, std::shared_ptr<DataStream> source,
+createTrader(TraderType type, const CandleSource &source,
              std::shared_ptr<midas::OrderManager> orderManager,
              InstrumentEnum instrument, std::size_t entryQuantity);
 } // namespace midas::trader
\ No newline at end of file
@@ -5,30 +5,90 @@
 
 #include <atomic>
 #include <boost/signals2/connection.hpp>
+#include <boost/signals2/signal.hpp>
 #include <data/data_stream.hpp>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <trader/base_trader.hpp>
+#include <trader/candle_pyramid.hpp>
+#include <trader/trader_scheduler.hpp>
+#include <unordered_map>
 
 namespace midas {
 class Broker;
+struct TradingContext;
+
+/**
+ * Market data of an instrument, shared by every trader of it.
+ * Bars are subscribed to once and added to one stream, which one pyramid
+ * folds into candles of every resolution, so traders of the same instrument
+ * share their candles and indicators.
+ */
+struct InstrumentFeed {
+  std::shared_ptr<midas::DataStream> streamPtr;
+  std::shared_ptr<midas::trader::CandlePyramid> pyramid;
+  /**
+   * Emitted once the history is loaded, after historyLoaded is set
+   */
+  boost::signals2::signal<void()> historyEndSignal;
+  /**
+   * Emitted after bars were added to the stream
+   */
+  boost::signals2::signal<void()> barsAddedSignal;
+  bool historyLoaded{false};
+  /**
+   * Guards historyLoaded
+   */
+  std::mutex mutex;
+  boost::signals2::scoped_connection historicalBarConn, historicalEndCon,
+      realtimeBarCon;
+  std::shared_ptr<midas::Subscription> historicalSubscription,
+      realtimeSubscription;
+  InstrumentFeed(unsigned int numSecondsHistory, TradingContext *,
+                 midas::InstrumentEnum);
+};
+
 struct TradingContext {
   std::shared_ptr<midas::Broker> broker;
   std::shared_ptr<midas::OrderManager> orderManager;
+  /**
+   * Drives the traders of every TraderContext
+   */
+  std::shared_ptr<midas::trader::TraderScheduler> scheduler;
+  std::mutex feedsMutex;
+  std::unordered_map<midas::InstrumentEnum, std::shared_ptr<InstrumentFeed>>
+      feeds;
   std::jthread brokerProcessor;
 
   explicit TradingContext(std::atomic<bool> *stopProcessing);
+  /**
+   * @param broker connected here, then processed until stopProcessing is set
+   */
+  TradingContext(std::shared_ptr<midas::Broker> broker,
+                 std::atomic<bool> *stopProcessing);
+  /**
+   * The feed of the instrument. Created on first use, with numSecondsHistory
+   * of history, later traders of the instrument join it.
+   */
+  std::shared_ptr<InstrumentFeed> feed(midas::InstrumentEnum instrument,
+                                       unsigned int numSecondsHistory);
 };
 
 struct TraderContext {
-  std::shared_ptr<midas::DataStream> streamPtr;
+  std::shared_ptr<InstrumentFeed> feed;
+  std::shared_ptr<midas::trader::TraderScheduler> scheduler;
   std::unique_ptr<midas::trader::Trader> trader;
-  std::jthread streamProcessingThread;
-  boost::signals2::scoped_connection historicalBarConn, historicalEndCon,
-      realtimeBarCon;
-  std::shared_ptr<midas::Subscription> historicalSubscription,
-      realtimeSubscription;
-  TraderContext(std::atomic<bool> *, unsigned int numSecondsHistory,
-                TradingContext *, midas::InstrumentEnum, int entryQuantity, midas::trader::TraderType traderType);
+  /**
+   * Set once the history is loaded, the trader is scheduled from then on
+   */
+  std::unique_ptr<midas::trader::TraderScheduler::Registration> registration;
+  boost::signals2::scoped_connection historyEndCon, barsAddedCon;
+  TraderContext(unsigned int numSecondsHistory, TradingContext *,
+                midas::InstrumentEnum, int entryQuantity,
+                midas::trader::TraderType traderType);
+
+private:
+  void schedule();
 };
-}
\ No newline at end of file
+}
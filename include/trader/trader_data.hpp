@@ -1,13 +1,39 @@
 #pragma once
 #include "data/data_stream.hpp"
+#include "data/replay_cursor.hpp"
+#include "trader/candle_pyramid.hpp"
+#include "trader/candle_series.hpp"
+#include "trader/indicator_graph.hpp"
 #include <algorithm>
-#include <boost/circular_buffer.hpp>
-#include <execution>
+#include <concepts>
 #include <iterator>
+#include <memory>
 
 namespace midas::trader {
+
+/**
+ * Where a trader gets its candles from. Either a stream, which the trader
+ * down samples on its own, a pyramid shared with other traders, or a
+ * history replayed by a back test, also down sampled by the trader.
+ */
+struct CandleSource {
+  template <std::derived_from<DataStream> Stream>
+  CandleSource(std::shared_ptr<Stream> stream) : stream(std::move(stream)) {}
+  CandleSource(std::shared_ptr<CandlePyramid> pyramid)
+      : pyramid(std::move(pyramid)) {}
+  CandleSource(std::shared_ptr<const ReplayCursor> replay)
+      : replay(std::move(replay)) {}
+  std::shared_ptr<DataStream> stream;
+  std::shared_ptr<CandlePyramid> pyramid;
+  std::shared_ptr<const ReplayCursor> replay;
+};
+
 /**
  * Look back data for traders.
+ * Source bars are folded into time aligned candles as they arrive, the
+ * candle still being built is published as well. Candles are published as
+ * immutable snapshots. Readers take the latest snapshot without locking and
+ * without copying, while the source keeps updating in the background.
  */
 class TraderData {
 
@@ -15,50 +41,75 @@ public:
   const std::size_t lookBackSize, candleSizeSeconds;
 
 private:
-  const std::ptrdiff_t downSampleRate;
-  std::size_t lastReadIndex;
-  std::shared_ptr<DataStream> source;
-  boost::circular_buffer<unsigned int> tradeCounts;
-  boost::circular_buffer<double> highs, lows, opens, closes, vwaps, volumes;
-  boost::circular_buffer<boost::posix_time::ptime> timestamps;
-  boost::signals2::connection updateListenerConnection,
-      reOrderListenerConnection;
-  std::recursive_mutex buffersMutex;
+  std::shared_ptr<CandlePyramid> pyramid;
+  std::shared_ptr<const CandleSeries> series;
+  std::shared_ptr<IndicatorGraph> indicators;
+  const std::size_t downSampleRate;
 
 public:
   /**
    * @param lookBackSize the number of candles to keep
    * @param candleSizeSeconds required candle width, to perform down sampling if
    * needed
+   * @param source a stream or replay is down sampled for this trader only, a
+   * pyramid must have a level of candleSizeSeconds
+   * @param session candles are aligned to the session open and cut at its
+   * close. Ignored for pyramids, which have their own.
    */
   TraderData(std::size_t lookBackSize, std::size_t candleSizeSeconds,
-             std::shared_ptr<DataStream> source);
-  ~TraderData();
+             const CandleSource &source, TradingSession session = {});
   bool ok();
   operator bool() { return ok(); }
-  inline std::size_t size() { return tradeCounts.size(); }
+  inline std::size_t size() { return snapshot()->size(); }
+  /**
+   * Number of source bars needed to fill the look back
+   */
+  inline std::size_t requiredSourceBars() const {
+    return lookBackSize * downSampleRate;
+  }
   inline bool empty() { return size() == 0; }
+  /**
+   * Latest published candles, at most lookBackSize of them, and the forming
+   * candle. Lock free.
+   */
+  std::shared_ptr<const CandleSnapshot> snapshot() const;
+  /**
+   * The most recent lookBackSize candles of a snapshot of the series
+   */
+  std::shared_ptr<const CandleSnapshot>
+  lookBack(std::shared_ptr<const CandleSnapshot> candles) const;
+  /**
+   * Indicators shared with every trader reading the same candles, register
+   * them up front
+   */
+  inline IndicatorGraph &indicatorGraph() { return *indicators; }
+  /**
+   * Latest published indicator values. Lock free once registered indicators
+   * have been published.
+   */
+  std::shared_ptr<const IndicatorSnapshot> indicatorSnapshot() const;
+  /**
+   * Reads indicators computed ahead of time over the whole history, which
+   * the source is about to replay. Register the indicators first.
+   */
+  inline void precomputeFeatures(const DataStream &history) {
+    pyramid->precomputeFeatures(history);
+  }
+  /**
+   * Appends the latest candles to the given containers.
+   * Prefer snapshot, which does not copy.
+   */
   inline void copy(auto &trades, auto &highs, auto &lows, auto &opens,
                    auto &closes, auto &vwaps, auto &volumes, auto &timestamps) {
-    std::scoped_lock buffersLock(buffersMutex);
-
-    std::copy(std::execution::unseq, tradeCounts.begin(), tradeCounts.end(),
-              std::back_inserter(trades));
-
-    std::copy(std::execution::unseq, this->highs.begin(), this->highs.end(),
-              std::back_insert_iterator(highs));
-    std::copy(std::execution::unseq, this->lows.begin(), this->lows.end(),
-              std::back_inserter(lows));
-    std::copy(std::execution::unseq, this->opens.begin(), this->opens.end(),
-              std::back_inserter(opens));
-    std::copy(std::execution::unseq, this->closes.begin(), this->closes.end(),
-              std::back_inserter(closes));
-    std::copy(std::execution::unseq, this->vwaps.begin(), this->vwaps.end(),
-              std::back_inserter(vwaps));
-    std::copy(std::execution::unseq, this->volumes.begin(), this->volumes.end(),
-              std::back_inserter(volumes));
-    std::copy(std::execution::unseq, this->timestamps.begin(),
-              this->timestamps.end(), std::back_inserter(timestamps));
+    const auto candles = snapshot();
+    std::ranges::copy(candles->tradeCounts(), std::back_inserter(trades));
+    std::ranges::copy(candles->highs(), std::back_inserter(highs));
+    std::ranges::copy(candles->lows(), std::back_inserter(lows));
+    std::ranges::copy(candles->opens(), std::back_inserter(opens));
+    std::ranges::copy(candles->closes(), std::back_inserter(closes));
+    std::ranges::copy(candles->vwaps(), std::back_inserter(vwaps));
+    std::ranges::copy(candles->volumes(), std::back_inserter(volumes));
+    std::ranges::copy(candles->timestamps(), std::back_inserter(timestamps));
   }
   /**
    * processes source, can be called manually at start to consume before any
@@ -67,8 +118,9 @@ public:
    */
   void processSource();
   /**
-   * Clears data. Note that the same function is used to handle re-orfs
+   * Clears data. Re-orders of the source only rebuild the candles after
+   * them, see CandlePyramid::repair
    */
   void clear();
 };
-} // namespace midas::trader
\ No newline at end of file
+} // namespace midas::trader
@@ -0,0 +1,135 @@
+#pragma once
+#include "data/data_stream.hpp"
+#include "logging/logging.hpp"
+#include "trader/base_trader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tbb/task_arena.h>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace midas::trader {
+
+class TimerWheel;
+
+/**
+ * Drives live traders on a fixed pool of workers instead of a thread per
+ * trader.
+ * A trader is only woken when bars were added to its stream, when one of
+ * its orders changes or when a candle should have closed. The workers
+ * process the stream and call decide only if a candle closed or an order
+ * changed, a trader never runs on two workers at once.
+ * Candle close deadlines sit in a timer wheel, if no candle closed by the
+ * end of a candle period plus a grace the trader decides anyway, so a
+ * stalled feed is still noticed. Besides a tick of the deadline thread once
+ * a second, nothing runs while no event arrives.
+ */
+class TraderScheduler {
+public:
+  class Registration;
+
+  /**
+   * @param workers number of traders processed at once
+   * @param closeGrace how long after a candle period a candle that did not
+   * close is given up on
+   */
+  explicit TraderScheduler(
+      std::size_t workers = std::max(1u, std::thread::hardware_concurrency()),
+      std::chrono::seconds closeGrace = std::chrono::seconds(5));
+  /**
+   * Registrations must be gone by then
+   */
+  ~TraderScheduler();
+  TraderScheduler(const TraderScheduler &) = delete;
+  TraderScheduler &operator=(const TraderScheduler &) = delete;
+
+  /**
+   * Schedules the trader reading the stream until the registration is
+   * destroyed. The trader and stream must outlive the registration, and the
+   * stream is only processed by the scheduler from now on. Traders sharing
+   * a stream take turns, whichever runs first processes the bars for all of
+   * them.
+   */
+  std::unique_ptr<Registration> add(std::shared_ptr<DataStream> stream,
+                                    Trader &trader);
+  /**
+   * Blocks until no trader is being processed
+   */
+  void wait();
+
+private:
+  enum Event : std::uint32_t {
+    BarsAdded = 1,
+    OrderChanged = 2,
+    CandleDeadline = 4,
+    // the trader is queued or being processed
+    Queued = 1u << 31,
+  };
+  struct Scheduled {
+    const std::size_t id;
+    const std::shared_ptr<DataStream> stream;
+    // held while processing the stream, shared with the traders reading it
+    const std::shared_ptr<std::mutex> streamMutex;
+    Trader &trader;
+    std::atomic<std::uint32_t> state{0};
+    std::atomic<bool> removed{false};
+    // only touched by the worker processing the trader
+    std::optional<std::pair<std::uint64_t, std::size_t>> decidedOn;
+    bool decidedSinceDeadline{false};
+  };
+
+  const std::chrono::seconds closeGrace;
+  std::shared_ptr<logging::thread_safe_logger_t> logger;
+  tbb::task_arena arena;
+  std::atomic<std::size_t> inFlight{0};
+  // guards the traders and the deadlines
+  std::mutex mutex;
+  std::condition_variable_any deadlineCv;
+  std::unordered_map<std::size_t, std::shared_ptr<Scheduled>> traders;
+  std::unordered_map<const DataStream *, std::weak_ptr<std::mutex>>
+      streamMutexes;
+  std::unique_ptr<TimerWheel> deadlines;
+  std::size_t nextId{0};
+  // declared last, it stops before anything it reads goes
+  std::jthread deadlineThread;
+
+  void notify(const std::shared_ptr<Scheduled> &scheduled, Event event);
+  void run(const std::shared_ptr<Scheduled> &scheduled);
+  void process(Scheduled &scheduled, std::uint32_t events);
+  void remove(Scheduled &scheduled);
+  /**
+   * Second at which the candle forming at now should have closed
+   */
+  std::int64_t deadlineAfter(std::int64_t now,
+                             const Scheduled &scheduled) const;
+  void expireDeadlines(std::stop_token stop);
+
+public:
+  class Registration {
+  public:
+    ~Registration() { scheduler.remove(*scheduled); }
+    Registration(const Registration &) = delete;
+    Registration &operator=(const Registration &) = delete;
+    /**
+     * Call after adding bars to the stream, from any thread
+     */
+    inline void barsAdded() const { scheduler.notify(scheduled, BarsAdded); }
+
+  private:
+    friend class TraderScheduler;
+    TraderScheduler &scheduler;
+    std::shared_ptr<Scheduled> scheduled;
+    Registration(TraderScheduler &scheduler,
+                 std::shared_ptr<Scheduled> scheduled)
+        : scheduler(scheduler), scheduled(std::move(scheduled)) {}
+  };
+};
+} // namespace midas::trader
@@ -1,20 +1,24 @@
 #include "backtest/backtest.hpp"
-#include "backtest_order_manager.hpp"
+#include "backtest/portfolio.hpp"
 #include "broker-interface/broker.hpp"
 #include "broker-interface/instruments.hpp"
-#include "broker-interface/order_printer.hpp"
-#include "broker-interface/order_summary.hpp"
 #include "broker-interface/subscription.hpp"
 #include "data/bar.hpp"
+#include "data/bar_archive.hpp"
 #include "data/data_stream.hpp"
 #include "data/export.hpp"
+#include "exceptions/archive_error.hpp"
 #include "logging/logging.hpp"
+#include "replay.hpp"
 #include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <ios>
-#include <list>
 #include <memory>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -43,101 +47,111 @@ static std::shared_ptr<midas::DataStream> fetchHistoricalDataFromRemote(
 
 std::string
 buildFileName(unsigned int barSize, midas::InstrumentEnum instrument,
-              const midas::HistorySubscriptionStartPoint &duration) {
+              const midas::HistorySubscriptionStartPoint &duration,
+              const std::string &extension) {
   std::stringstream buffer;
   buffer << instrument << "-B" << barSize << "secs" << "-P_"
-         << duration.quantity << to_string(duration.unit) << ".csv";
+         << duration.quantity << to_string(duration.unit) << extension;
   return buffer.str();
 }
 
+/**
+ * Restores from the binary archive cache if present. Falls back to the CSV
+ * cache, converting it into an archive so the next load is cheap. Only if
+ * neither exist is the data fetched from the broker.
+ */
 static std::shared_ptr<midas::DataStream>
 loadHistoricalData(unsigned int barSize, midas::InstrumentEnum instrument,
                    midas::Broker &broker,
                    const midas::HistorySubscriptionStartPoint &duration,
                    std::shared_ptr<logging::thread_safe_logger_t> logger) {
-  const std::string filename = buildFileName(barSize, instrument, duration);
-  std::ifstream toRestore(filename, std::ios::in);
-  if (toRestore) {
-    INFO_LOG(*logger) << "Loading cached data";
-    std::shared_ptr<midas::DataStream> restoredStream =
-        std::make_shared<midas::DataStream>(barSize);
-    toRestore >> *restoredStream;
-    return restoredStream;
-  };
-  INFO_LOG(*logger) << "Fetching remote data";
-  std::shared_ptr<midas::DataStream> fetchedStream =
-      fetchHistoricalDataFromRemote(barSize, instrument, broker, duration);
+  const std::string archiveName =
+      buildFileName(barSize, instrument, duration, ".bars");
+  if (std::filesystem::exists(archiveName)) {
+    try {
+      INFO_LOG(*logger) << "Loading cached archive";
+      return midas::BarArchive(archiveName).toDataStream();
+    } catch (const ArchiveError &e) {
+      WARNING_LOG(*logger) << "Ignoring cached archive: " << e.what();
+    }
+  }
+  const std::string csvName =
+      buildFileName(barSize, instrument, duration, ".csv");
+  std::shared_ptr<midas::DataStream> stream;
+  if (std::filesystem::exists(csvName)) {
+    INFO_LOG(*logger) << "Loading cached csv data";
+    stream = std::make_shared<midas::DataStream>(barSize);
+    midas::importCsv(csvName, *stream);
+  } else {
+    INFO_LOG(*logger) << "Fetching remote data";
+    stream =
+        fetchHistoricalDataFromRemote(barSize, instrument, broker, duration);
+    // CSV is kept for interchange with other tools
+    std::ofstream toSave(csvName, std::ios::out);
+    toSave << *stream;
+  }
   // Now we save it
-  std::ofstream toSave(filename, std::ios::out);
-  toSave << *fetchedStream;
-  return fetchedStream;
+  midas::BarArchive::write(archiveName, *stream);
+  return stream;
 }
 
 midas::backtest::BacktestResult midas::backtest::performBacktest(
     InstrumentEnum instrument, BacktestInterval interval,
-    std::function<std::unique_ptr<trader::Trader>(
-        std::shared_ptr<DataStream>, std::shared_ptr<midas::OrderManager>)>
-        traderFactory,
-    Broker &broker) {
+    trader_factory_t traderFactory, Broker &broker, BacktestMode mode) {
   std::shared_ptr<logging::thread_safe_logger_t> logger =
       std::make_shared<logging::thread_safe_logger_t>(
           logging::create_channel_logger("backtest " + instrument));
-  std::shared_ptr<BacktestOrderManager> orderManager(
-      new BacktestOrderManager(logger));
   // now we need to request and wait for historical data.
   const unsigned int historicalBarSize =
       broker.estimateHistoricalBarSizeSeconds(interval.duration);
   INFO_LOG(*logger) << "Fetching historical data";
   std::shared_ptr<DataStream> historicalData = loadHistoricalData(
       historicalBarSize, instrument, broker, interval.duration, logger);
-  // Now that we have the historical data, lets create our dummy real time
-  // simulation source and our trader
   INFO_LOG(*logger) << "Fetched historical data";
-  std::shared_ptr<DataStream> realtimeSimStream =
-      std::make_shared<DataStream>(historicalBarSize);
-  auto traderPtr = traderFactory(realtimeSimStream, orderManager);
-
-  INFO_LOG(*logger) << "Starting simulation";
-  // We now enter the simulation phase
-  std::list<Bar> barBuffer;
-  for (std::size_t barIndex = 0; barIndex < historicalData->size();
-       barIndex++) {
-    midas::Bar bar(
-        historicalData->barSizeSeconds, historicalData->tradeCounts[barIndex],
-        historicalData->highs[barIndex], historicalData->lows[barIndex],
-        historicalData->opens[barIndex], historicalData->closes[barIndex],
-        historicalData->waps[barIndex], historicalData->volumes[barIndex],
-        historicalData->timestamps[barIndex]);
-    barBuffer.push_back(bar);
-    if (orderManager->hasActiveOrders()) {
-      // we only decide on new orders if we don't have current ones.
-      // This is a limitation that should be eventually removed
-      orderManager->simulate(&bar);
-      // we don't want to process trades and enter new trades on the same
-      // candle.
+  return replayBacktest(instrument, historicalData, traderFactory, mode);
+}
 
-    } else {
-      realtimeSimStream->addBars(
-          barBuffer.begin(),
-          barBuffer.end()); // simulate broker sending data events
-      realtimeSimStream->waitForData(0ms); // have the stream process the data
-      barBuffer.clear();
-      traderPtr->decide();
-    }
-  }
-  INFO_LOG(*logger) << "Simulation complete";
-  INFO_LOG(*logger) << "Total orders " << orderManager->totalSize();
-  OrderSummaryTracker summaryTracker;
-  OrderPrinter printer;
-  for (Order *orderPtr : orderManager->getFilledOrders()) {
-    summaryTracker.addToSummary(orderPtr);
-    orderPtr->visit(printer);
+midas::backtest::PortfolioResult midas::backtest::performPortfolioBacktest(
+    const std::vector<std::pair<InstrumentEnum, trader_factory_t>> &traders,
+    BacktestInterval interval, Broker &broker, BacktestMode mode) {
+  std::vector<PortfolioLeg> legs;
+  legs.reserve(traders.size());
+  for (const auto &[instrument, traderFactory] : traders) {
+    std::shared_ptr<logging::thread_safe_logger_t> logger =
+        std::make_shared<logging::thread_safe_logger_t>(
+            logging::create_channel_logger("backtest " + instrument));
+    const unsigned int historicalBarSize =
+        broker.estimateHistoricalBarSizeSeconds(interval.duration);
+    INFO_LOG(*logger) << "Fetching historical data";
+    legs.push_back(PortfolioLeg{
+        .instrument = instrument,
+        .history = loadHistoricalData(historicalBarSize, instrument, broker,
+                                      interval.duration, logger),
+        .traderFactory = traderFactory});
+    INFO_LOG(*logger) << "Fetched historical data";
   }
-  auto summary = summaryTracker.summary();
-  summary.endingBalance = orderManager->positionTracker.getPnl()[instrument];
-  BacktestResult result {
-    .summary = summary, .originalStream = realtimeSimStream,
-    .orderDetails = printer.str()
-  };
+  return replayPortfolio(legs, mode);
+}
+
+midas::backtest::BacktestResult midas::backtest::replayBacktest(
+    InstrumentEnum instrument, std::shared_ptr<DataStream> historicalData,
+    trader_factory_t traderFactory, BacktestMode mode) {
+  std::shared_ptr<logging::thread_safe_logger_t> logger =
+      std::make_shared<logging::thread_safe_logger_t>(
+          logging::create_channel_logger("backtest " + instrument));
+  Replay replay(instrument, historicalData, traderFactory, mode);
+  INFO_LOG(*logger) << "Starting simulation";
+  const auto simulationStart = std::chrono::steady_clock::now();
+  replay.advance(historicalData->size());
+  const std::chrono::duration<double> simulationTime =
+      std::chrono::steady_clock::now() - simulationStart;
+  const double barsPerSecond =
+      simulationTime.count() > 0
+          ? historicalData->size() / simulationTime.count()
+          : 0;
+  INFO_LOG(*logger) << "Simulation complete, " << barsPerSecond
+                    << " bars/s";
+  BacktestResult result = replay.result();
+  result.barsPerSecond = barsPerSecond;
   return result;
-}
\ No newline at end of file
+}
@@ -0,0 +1,144 @@
+#include "backtest/halving.hpp"
+#include "replay.hpp"
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+using namespace midas::backtest::halving;
+using midas::backtest::sweep::rankOf;
+
+namespace {
+bool ranksAbove(const Candidate &lhs, const Candidate &rhs) {
+  if (lhs.aborted != rhs.aborted) {
+    return rhs.aborted;
+  }
+  if (lhs.bars != rhs.bars) {
+    return lhs.bars > rhs.bars;
+  }
+  if (rankOf(lhs.score) != rankOf(rhs.score)) {
+    return rankOf(lhs.score) > rankOf(rhs.score);
+  }
+  return lhs.index < rhs.index;
+}
+} // namespace
+
+Result midas::backtest::halving::successiveHalving(
+    InstrumentEnum instrument, std::shared_ptr<DataStream> history,
+    const std::vector<sweep::parameters_t> &parameters,
+    sweep::trader_factory_t traderFactory, const Options &options) {
+  if (options.reduction < 2 || options.initialBars == 0) {
+    throw std::invalid_argument(
+        "Successive halving needs initial bars and a reduction of at least 2");
+  }
+  Result result;
+  result.candidates.resize(parameters.size());
+  // survivors are kept mid replay between rounds
+  std::vector<std::optional<Replay>> replays(parameters.size());
+  std::vector<std::size_t> alive(parameters.size());
+  std::iota(alive.begin(), alive.end(), 0);
+  tbb::task_arena arena(options.search.workers());
+  std::size_t horizon = std::min(options.initialBars, history->size());
+  while (!alive.empty()) {
+    arena.execute([&] {
+      tbb::parallel_for(
+          tbb::blocked_range<std::size_t>(0, alive.size(), 1),
+          [&](const tbb::blocked_range<std::size_t> &range) {
+            for (std::size_t i = range.begin(); i < range.end(); i++) {
+              const std::size_t index = alive[i];
+              if (!replays[index]) {
+                replays[index].emplace(
+                    instrument, history,
+                    [&](const trader::CandleSource &source,
+                        std::shared_ptr<midas::OrderManager> orderManager) {
+                      return traderFactory(parameters[index], source,
+                                           orderManager);
+                    },
+                    options.search.mode);
+              }
+              Replay &replay = *replays[index];
+              replay.advance(horizon, options.limits);
+              const TradeSummary summary = replay.summary();
+              result.candidates[index] =
+                  Candidate{.index = index,
+                            .parameters = parameters[index],
+                            .summary = summary,
+                            .score = options.search.scoreOf(summary),
+                            .bars = replay.position(),
+                            .aborted = replay.aborted()};
+            }
+          });
+    });
+    std::erase_if(alive, [&](std::size_t index) {
+      if (result.candidates[index].aborted) {
+        replays[index].reset();
+        return true;
+      }
+      return false;
+    });
+    if (horizon == history->size()) {
+      break;
+    }
+    std::ranges::sort(alive, [&](std::size_t lhs, std::size_t rhs) {
+      return ranksAbove(result.candidates[lhs], result.candidates[rhs]);
+    });
+    const std::size_t kept =
+        std::min(alive.size(),
+                 std::max<std::size_t>(1, alive.size() / options.reduction));
+    for (std::size_t i = kept; i < alive.size(); i++) {
+      replays[alive[i]].reset();
+    }
+    alive.resize(kept);
+    horizon = std::min(history->size(), horizon * options.reduction);
+  }
+  // survivors resume rather than restart, each bar is replayed once
+  for (const Candidate &candidate : result.candidates) {
+    result.replayedBars += candidate.bars;
+  }
+  std::ranges::sort(result.candidates, ranksAbove);
+  return result;
+}
+
+Result midas::backtest::halving::hyperband(
+    InstrumentEnum instrument, std::shared_ptr<DataStream> history,
+    const sweep::ParameterSpace &space, sweep::trader_factory_t traderFactory,
+    std::uint64_t seed, const Options &options) {
+  if (options.reduction < 2 || options.initialBars == 0) {
+    throw std::invalid_argument(
+        "Hyperband needs initial bars and a reduction of at least 2");
+  }
+  // the most rounds a bracket can have before its first round gets shorter
+  // than initialBars
+  std::size_t maxRounds = 0;
+  for (std::size_t bars = options.initialBars * options.reduction;
+       bars <= history->size(); bars *= options.reduction) {
+    maxRounds++;
+  }
+  Result result;
+  std::size_t offset = 0;
+  for (std::size_t rounds = maxRounds + 1; rounds-- > 0;) {
+    std::size_t scale = 1;
+    for (std::size_t i = 0; i < rounds; i++) {
+      scale *= options.reduction;
+    }
+    const std::size_t count =
+        (maxRounds + 1) * scale / (rounds + 1) +
+        ((maxRounds + 1) * scale % (rounds + 1) != 0);
+    Options bracket = options;
+    bracket.initialBars = std::max<std::size_t>(1, history->size() / scale);
+    Result bracketResult = successiveHalving(
+        instrument, history, space.random(count, seed + rounds),
+        traderFactory, bracket);
+    for (Candidate &candidate : bracketResult.candidates) {
+      candidate.index += offset;
+      result.candidates.push_back(std::move(candidate));
+    }
+    result.replayedBars += bracketResult.replayedBars;
+    offset += count;
+  }
+  std::ranges::sort(result.candidates, ranksAbove);
+  return result;
+}
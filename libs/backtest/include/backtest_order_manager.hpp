@@ -1,10 +1,13 @@
 #pragma once
+#include "broker-interface/instruments.hpp"
 #include "broker-interface/order.hpp"
 #include "data/bar.hpp"
 #include "logging/logging.hpp"
 #include <cstddef>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
 
 namespace midas::backtest {
 
@@ -20,19 +23,28 @@ public:
 
 class BacktestOrderManager : public midas::OrderManager {
   std::list<std::shared_ptr<Order>> activeOrdersList, completedOrdersList;
+  /**
+   * Traders of different instruments may transmit at once
+   */
+  std::recursive_mutex mutex;
 
 public:
   BacktestOrderManager(std::shared_ptr<logging::thread_safe_logger_t> &logger)
       : midas::OrderManager(logger) {}
   virtual void transmit(std::shared_ptr<Order>) override;
   virtual bool hasActiveOrders() override;
+  bool hasActiveOrders(InstrumentEnum instrument);
   /**
    * Simulates what happens to the orders when the bar elapses.
    * i.e stop orders triggered, limit orders triggered, etc.
+   * @param instrument only orders of it are simulated if set, the bar is of
+   * that instrument
    */
-  void simulate(const midas::Bar *);
+  void simulate(const midas::Bar *,
+                std::optional<InstrumentEnum> instrument = std::nullopt);
   virtual std::list<Order *> getFilledOrders() override;
   std::size_t inline totalSize() {
+    std::scoped_lock lock(mutex);
     return activeOrdersList.size() + completedOrdersList.size();
   }
 };
@@ -0,0 +1,76 @@
+#pragma once
+#include "backtest/backtest.hpp"
+#include "backtest_order_manager.hpp"
+#include "broker-interface/instruments.hpp"
+#include "broker-interface/trades_summary.hpp"
+#include "data/data_stream.hpp"
+#include "data/replay_cursor.hpp"
+#include "logging/logging.hpp"
+#include "trader/base_trader.hpp"
+#include <boost/signals2/connection.hpp>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace midas::backtest {
+
+/**
+ * A back test that can be replayed in parts.
+ * Stopping and advancing again later resumes where it stopped, the trader
+ * and its orders keep their state in between, so a replay extended over a
+ * longer horizon does not start over.
+ */
+class Replay {
+public:
+  /**
+   * @param firstBar bar the replay starts from, relative to the first bar of
+   * the history. The bars the trader looks back on before it only warm the
+   * trader up, it does not trade on them, earlier bars are not read.
+   */
+  Replay(InstrumentEnum instrument, std::shared_ptr<DataStream> history,
+         const trader_factory_t &traderFactory,
+         BacktestMode mode = BacktestMode::Streaming, std::size_t firstBar = 0);
+  // the pnl listener points back to the replay
+  Replay(const Replay &) = delete;
+  Replay &operator=(const Replay &) = delete;
+  /**
+   * Replays the bars up to endBar, relative to the first bar of the
+   * history. Stops early if a limit is crossed, after which the replay does
+   * not advance any more.
+   */
+  void advance(std::size_t endBar, const BacktestLimits &limits = {});
+  /**
+   * Bars up to which the history was replayed
+   */
+  inline std::size_t position() const { return nextBar; }
+  inline bool finished() const { return nextBar == history->size(); }
+  inline bool aborted() const { return limitCrossed; }
+  /**
+   * Summary of the orders filled so far
+   */
+  TradeSummary summary();
+  BacktestResult result();
+  /**
+   * Every change of the realized pnl, in order. One per trade that closed
+   * at a profit or a loss.
+   */
+  inline const std::vector<double> &tradeReturns() const {
+    return pnlChanges;
+  }
+
+private:
+  const InstrumentEnum instrument;
+  const std::shared_ptr<DataStream> history;
+  std::shared_ptr<logging::thread_safe_logger_t> logger;
+  std::shared_ptr<BacktestOrderManager> orderManager;
+  std::shared_ptr<ReplayCursor> cursor;
+  std::unique_ptr<trader::Trader> trader;
+  boost::signals2::scoped_connection pnlConnection;
+  std::size_t nextBar;
+  double realizedPnl{0}, peakPnl{0}, drawdown{0};
+  std::vector<double> pnlChanges;
+  bool limitCrossed{false};
+
+  bool crossed(const BacktestLimits &limits);
+};
+} // namespace midas::backtest
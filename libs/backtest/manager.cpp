@@ -1,14 +1,27 @@
 #include "backtest_order_manager.hpp"
 #include "broker-interface/order.hpp"
+#include "broker-interface/tick_price.hpp"
 #include "data/bar.hpp"
 #include <algorithm>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
 
 bool midas::backtest::BacktestOrderManager::hasActiveOrders() {
+  std::scoped_lock lock(mutex);
   return !activeOrdersList.empty();
 }
 
+bool midas::backtest::BacktestOrderManager::hasActiveOrders(
+    InstrumentEnum instrument) {
+  std::scoped_lock lock(mutex);
+  return std::ranges::any_of(activeOrdersList,
+                             [instrument](const std::shared_ptr<Order> &order) {
+                               return order->instrument == instrument;
+                             });
+}
+
 void midas::backtest::BacktestOrderManager::transmit(
     std::shared_ptr<Order> order) {
   order->setTransmitted();
@@ -33,15 +46,21 @@ void midas::backtest::BacktestOrderManager::transmit(
     }
   });
 
+  std::scoped_lock lock(mutex);
   activeOrdersList.push_back(order);
 }
 
-void midas::backtest::BacktestOrderManager::simulate(const midas::Bar *bar) {
+void midas::backtest::BacktestOrderManager::simulate(
+    const midas::Bar *bar, std::optional<InstrumentEnum> instrument) {
+  std::scoped_lock lock(mutex);
   SimulationOrderTransmitter transmitter(bar);
-  std::ranges::for_each(activeOrdersList,
-                        [&transmitter](std::shared_ptr<Order> &orderPtr) {
-                          orderPtr->visit(transmitter);
-                        });
+  std::ranges::for_each(
+      activeOrdersList,
+      [&transmitter, instrument](std::shared_ptr<Order> &orderPtr) {
+        if (!instrument || orderPtr->instrument == *instrument) {
+          orderPtr->visit(transmitter);
+        }
+      });
   for (auto it = activeOrdersList.begin(); it != activeOrdersList.end(); it++) {
     if (it->get()->isDone()) {
       auto copy = std::prev(it);
@@ -52,12 +71,19 @@ void midas::backtest::BacktestOrderManager::simulate(const midas::Bar *bar) {
   }
 }
 
-static bool isTriggered(midas::OrderDirection direction, double targetPrice,
+/**
+ * Prices are compared in whole ticks so that a target that sits exactly on a
+ * bar extreme always triggers
+ */
+static bool isTriggered(midas::OrderDirection direction,
+                        const midas::InstrumentSpec &spec, double targetPrice,
                         const midas::Bar *bar) {
-  if (direction == midas::OrderDirection::BUY && bar->low <= targetPrice) {
+  const midas::TickPrice target = spec.toTicks(targetPrice);
+  if (direction == midas::OrderDirection::BUY &&
+      spec.toTicks(bar->low) <= target) {
     return true;
   } else if (direction == midas::OrderDirection::SELL &&
-             bar->high >= targetPrice) {
+             spec.toTicks(bar->high) >= target) {
     return true;
   } else {
     return false;
@@ -68,12 +94,14 @@ static bool visitHelper(midas::SimpleOrder &order, const midas::Bar *bar) {
   const midas::OrderDirection direction =
       order.execType == midas::ExecutionType::Stop ? ~order.direction
                                                    : order.direction;
+  const midas::InstrumentSpec spec =
+      midas::getInstrumentSpec(order.instrument);
   if (order.execType == midas::ExecutionType::MKT) {
-    order.targetPrice =
-        direction == midas::OrderDirection::BUY ? bar->high : bar->low;
+    order.targetPrice = spec.roundToTick(
+        direction == midas::OrderDirection::BUY ? bar->high : bar->low);
     return true;
   } else {
-    return isTriggered(direction, order.targetPrice, bar);
+    return isTriggered(direction, spec, order.targetPrice, bar);
   }
 }
 
@@ -111,6 +139,7 @@ void midas::backtest::SimulationOrderTransmitter::visit(
 
 std::list<midas::Order *>
 midas::backtest::BacktestOrderManager::getFilledOrders() {
+  std::scoped_lock lock(mutex);
   std::list<midas::Order *> orderPtrs;
 
   for (auto &orderPtr : completedOrdersList) {
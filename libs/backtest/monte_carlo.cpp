@@ -0,0 +1,106 @@
+#include "backtest/monte_carlo.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <utility>
+
+using namespace midas::backtest::montecarlo;
+
+namespace {
+constexpr std::uint64_t golden = 0x9e3779b97f4a7c15;
+
+/**
+ * splitmix64 finalizer, a good hash of consecutive counters
+ */
+constexpr std::uint64_t mix(std::uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+  return x ^ (x >> 31);
+}
+
+/**
+ * Fills random with the numbers of a path. Each number only depends on its
+ * counter, there is no state carried between them, so the loop vectorizes.
+ */
+void generate(std::uint64_t key, std::vector<std::uint32_t> &random) {
+  const std::size_t count = random.size();
+  std::uint32_t *out = random.data();
+  for (std::size_t i = 0; i < count; i++) {
+    out[i] = static_cast<std::uint32_t>(mix(key + (i + 1) * golden) >> 32);
+  }
+}
+
+/**
+ * Maps a random number onto [0, bound) without a division
+ */
+inline std::size_t below(std::uint32_t random, std::size_t bound) {
+  return static_cast<std::size_t>((std::uint64_t{random} * bound) >> 32);
+}
+} // namespace
+
+double Distribution::quantile(double p) const {
+  if (values.empty()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  const double rank = std::clamp(p, 0.0, 1.0) * (values.size() - 1);
+  const auto lower = static_cast<std::size_t>(rank);
+  const std::size_t upper = std::min(lower + 1, values.size() - 1);
+  return values[lower] + (rank - lower) * (values[upper] - values[lower]);
+}
+
+double Distribution::mean() const {
+  if (values.empty()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  return std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+}
+
+Result midas::backtest::montecarlo::resample(
+    std::span<const double> tradeReturns, const Options &options) {
+  const std::size_t trades = tradeReturns.size();
+  Result result;
+  result.totalReturn.values.resize(options.paths);
+  result.maxDrawdown.values.resize(options.paths);
+  tbb::task_arena arena(options.concurrency == 0
+                            ? tbb::task_arena::automatic
+                            : static_cast<int>(options.concurrency));
+  arena.execute([&] {
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, options.paths),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+          // buffers are reused by the paths of a range
+          std::vector<std::uint32_t> random(trades);
+          std::vector<double> path(trades);
+          for (std::size_t p = range.begin(); p < range.end(); p++) {
+            generate(mix(options.seed ^ mix(p + 1)), random);
+            if (options.resampling == Resampling::Bootstrap) {
+              for (std::size_t i = 0; i < trades; i++) {
+                path[i] = tradeReturns[below(random[i], trades)];
+              }
+            } else {
+              // Fisher Yates from the original order, so that a path does
+              // not depend on the ones before it in the range
+              std::ranges::copy(tradeReturns, path.begin());
+              for (std::size_t i = trades; i > 1; i--) {
+                std::swap(path[i - 1], path[below(random[i - 1], i)]);
+              }
+            }
+            double total = 0, peak = 0, drawdown = 0;
+            for (const double value : path) {
+              total += value;
+              peak = std::max(peak, total);
+              drawdown = std::max(drawdown, peak - total);
+            }
+            result.totalReturn.values[p] = total;
+            result.maxDrawdown.values[p] = drawdown;
+          }
+        });
+  });
+  std::ranges::sort(result.totalReturn.values);
+  std::ranges::sort(result.maxDrawdown.values);
+  return result;
+}
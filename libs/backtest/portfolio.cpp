@@ -0,0 +1,223 @@
+#include "backtest/portfolio.hpp"
+#include "backtest_order_manager.hpp"
+#include "broker-interface/order_printer.hpp"
+#include "broker-interface/order_summary.hpp"
+#include "data/bar.hpp"
+#include "data/replay_cursor.hpp"
+#include "logging/logging.hpp"
+#include <chrono>
+#include <functional>
+#include <list>
+#include <queue>
+#include <stdexcept>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+/**
+ * Order manager of one leg. The legs of an epoch decide in parallel, so the
+ * orders a trader transmits are held back until every leg decided, then
+ * handed on in leg order. The order lists then come out the same whatever
+ * order the traders ran in.
+ */
+class LegOrderManager : public midas::OrderManager {
+  std::shared_ptr<midas::backtest::BacktestOrderManager> orderManager;
+  midas::InstrumentEnum instrument;
+  std::vector<std::shared_ptr<midas::Order>> pending;
+
+public:
+  LegOrderManager(
+      std::shared_ptr<logging::thread_safe_logger_t> &logger,
+      std::shared_ptr<midas::backtest::BacktestOrderManager> orderManager,
+      midas::InstrumentEnum instrument)
+      : midas::OrderManager(logger), orderManager(std::move(orderManager)),
+        instrument(instrument) {}
+  void transmit(std::shared_ptr<midas::Order> order) override {
+    pending.push_back(std::move(order));
+  }
+  bool hasActiveOrders() override {
+    return !pending.empty() || orderManager->hasActiveOrders(instrument);
+  }
+  std::list<midas::Order *> getFilledOrders() override {
+    std::list<midas::Order *> filled = orderManager->getFilledOrders();
+    filled.remove_if([this](const midas::Order *order) {
+      return order->instrument != instrument;
+    });
+    return filled;
+  }
+  /**
+   * Transmits the orders held back
+   */
+  void flush() {
+    for (std::shared_ptr<midas::Order> &order : pending) {
+      orderManager->transmit(std::move(order));
+    }
+    pending.clear();
+  }
+};
+
+struct LegReplay {
+  midas::InstrumentEnum instrument;
+  std::shared_ptr<midas::DataStream> history;
+  std::shared_ptr<midas::ReplayCursor> cursor;
+  std::shared_ptr<LegOrderManager> orderManager;
+  std::unique_ptr<midas::trader::Trader> trader;
+  std::size_t nextBar{0};
+
+  midas::Timestamp nextTime() const {
+    return history->timestamps[nextBar];
+  }
+};
+
+/**
+ * Next bar of a leg, earliest first. Legs with bars at the same time come
+ * out in leg order.
+ */
+typedef std::pair<midas::Timestamp, std::size_t> cursor_entry_t;
+} // namespace
+
+midas::backtest::PortfolioResult
+midas::backtest::replayPortfolio(const std::vector<PortfolioLeg> &legs,
+                                 BacktestMode mode, std::size_t concurrency) {
+  std::unordered_set<InstrumentEnum> instruments;
+  for (const PortfolioLeg &leg : legs) {
+    if (!instruments.insert(leg.instrument).second) {
+      // fills are routed to legs by instrument
+      throw std::invalid_argument("Instrument " + leg.instrument +
+                                  " has more than one leg");
+    }
+  }
+  std::shared_ptr<logging::thread_safe_logger_t> logger =
+      std::make_shared<logging::thread_safe_logger_t>(
+          logging::create_channel_logger("backtest portfolio"));
+  auto orderManager = std::make_shared<BacktestOrderManager>(logger);
+  std::vector<LegReplay> replays;
+  replays.reserve(legs.size());
+  std::priority_queue<cursor_entry_t, std::vector<cursor_entry_t>,
+                      std::greater<>>
+      heap;
+  std::size_t totalBars = 0;
+  for (const PortfolioLeg &leg : legs) {
+    auto cursor = std::make_shared<ReplayCursor>(leg.history);
+    auto legOrderManager =
+        std::make_shared<LegOrderManager>(logger, orderManager, leg.instrument);
+    auto trader =
+        leg.traderFactory(trader::CandleSource(cursor), legOrderManager);
+    if (mode == BacktestMode::FeatureMatrix) {
+      INFO_LOG(*logger) << "Precomputing indicators of " << leg.instrument;
+      trader->precomputeFeatures(*leg.history);
+    }
+    replays.push_back(LegReplay{.instrument = leg.instrument,
+                                .history = leg.history,
+                                .cursor = std::move(cursor),
+                                .orderManager = std::move(legOrderManager),
+                                .trader = std::move(trader)});
+    if (leg.history->size() > 0) {
+      heap.emplace(replays.back().nextTime(), replays.size() - 1);
+    }
+    totalBars += leg.history->size();
+  }
+
+  tbb::task_arena arena(concurrency == 0 ? tbb::task_arena::automatic
+                                         : static_cast<int>(concurrency));
+  std::vector<std::size_t> epoch, deciding;
+  std::size_t epochs = 0;
+  INFO_LOG(*logger) << "Starting simulation of " << legs.size()
+                    << " instruments";
+  const auto simulationStart = std::chrono::steady_clock::now();
+  while (!heap.empty()) {
+    const Timestamp time = heap.top().first;
+    epoch.clear();
+    while (!heap.empty() && heap.top().first == time) {
+      epoch.push_back(heap.top().second);
+      heap.pop();
+    }
+    epochs++;
+    deciding.clear();
+    for (const std::size_t index : epoch) {
+      LegReplay &replay = replays[index];
+      if (orderManager->hasActiveOrders(replay.instrument)) {
+        // as in a single instrument replay, a trader with active orders
+        // does not decide
+        const DataStream &history = *replay.history;
+        const std::size_t bar = replay.nextBar;
+        const midas::Bar current(
+            history.barSizeSeconds, history.tradeCounts[bar],
+            history.highs[bar], history.lows[bar], history.opens[bar],
+            history.closes[bar], history.waps[bar], history.volumes[bar],
+            history.timestamps[bar]);
+        orderManager->simulate(&current, replay.instrument);
+      } else {
+        deciding.push_back(index);
+      }
+    }
+    const auto decide = [&](std::size_t index) {
+      LegReplay &replay = replays[index];
+      replay.cursor->advanceTo(replay.history->baseIndex() + replay.nextBar +
+                               1);
+      replay.trader->triggerSourceProcessing();
+      replay.trader->decide();
+    };
+    if (deciding.size() == 1) {
+      decide(deciding.front());
+    } else if (deciding.size() > 1) {
+      arena.execute([&] {
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, deciding.size(), 1),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+              for (std::size_t i = range.begin(); i < range.end(); i++) {
+                decide(deciding[i]);
+              }
+            });
+      });
+    }
+    // deciding is in leg order
+    for (const std::size_t index : deciding) {
+      replays[index].orderManager->flush();
+    }
+    for (const std::size_t index : epoch) {
+      LegReplay &replay = replays[index];
+      if (++replay.nextBar < replay.history->size()) {
+        heap.emplace(replay.nextTime(), index);
+      }
+    }
+  }
+  const std::chrono::duration<double> simulationTime =
+      std::chrono::steady_clock::now() - simulationStart;
+  const double barsPerSecond = simulationTime.count() > 0
+                                   ? totalBars / simulationTime.count()
+                                   : 0;
+  INFO_LOG(*logger) << "Simulation complete, " << epochs << " epochs, "
+                    << barsPerSecond << " bars/s";
+
+  INFO_LOG(*logger) << "Total orders " << orderManager->totalSize();
+  PortfolioResult result{.instruments = {},
+                         .aggregate = {},
+                         .orderDetails = {},
+                         .epochs = epochs,
+                         .barsPerSecond = barsPerSecond};
+  std::unordered_map<InstrumentEnum, OrderSummaryTracker> trackers;
+  OrderSummaryTracker aggregateTracker;
+  OrderPrinter printer;
+  for (Order *orderPtr : orderManager->getFilledOrders()) {
+    trackers[orderPtr->instrument].addToSummary(orderPtr);
+    aggregateTracker.addToSummary(orderPtr);
+    orderPtr->visit(printer);
+  }
+  const auto pnl = orderManager->positionTracker.getPnl();
+  result.aggregate = aggregateTracker.summary();
+  result.aggregate.endingBalance = 0;
+  for (const LegReplay &replay : replays) {
+    TradeSummary summary = trackers[replay.instrument].summary();
+    const auto realized = pnl.find(replay.instrument);
+    summary.endingBalance = realized == pnl.end() ? 0 : realized->second;
+    result.aggregate.endingBalance += summary.endingBalance;
+    result.instruments.emplace(replay.instrument, summary);
+  }
+  result.orderDetails = printer.str();
+  return result;
+}
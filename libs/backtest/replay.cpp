@@ -0,0 +1,98 @@
+#include "replay.hpp"
+#include "broker-interface/order_printer.hpp"
+#include "broker-interface/order_summary.hpp"
+#include "data/bar.hpp"
+#include <algorithm>
+
+midas::backtest::Replay::Replay(InstrumentEnum instrument,
+                                std::shared_ptr<DataStream> history,
+                                const trader_factory_t &traderFactory,
+                                BacktestMode mode, std::size_t firstBar)
+    : instrument(instrument), history(history),
+      logger(std::make_shared<logging::thread_safe_logger_t>(
+          logging::create_channel_logger("backtest " + instrument))),
+      orderManager(std::make_shared<BacktestOrderManager>(logger)),
+      // The trader sees the history up to the cursor, as if it was sent by
+      // a broker one bar at a time
+      cursor(std::make_shared<ReplayCursor>(history)),
+      trader(traderFactory(trader::CandleSource(cursor), orderManager)),
+      nextBar(std::min(firstBar, history->size())) {
+  // the trader is warmed up on the bars it looks back on, not the whole
+  // history before the first bar
+  cursor->startAt(history->baseIndex() + nextBar -
+                  std::min(nextBar, trader->requiredSourceBars()));
+  if (mode == BacktestMode::FeatureMatrix) {
+    INFO_LOG(*logger) << "Precomputing indicators";
+    trader->precomputeFeatures(*history);
+  }
+  // the bars before the first are revealed along with it
+  cursor->advanceTo(history->baseIndex() + nextBar);
+  pnlConnection = orderManager->positionTracker.connectRealizedPnl([this] {
+    const double pnl = orderManager->positionTracker.getPnl()[this->instrument];
+    if (pnl != realizedPnl) {
+      pnlChanges.push_back(pnl - realizedPnl);
+      realizedPnl = pnl;
+    }
+    peakPnl = std::max(peakPnl, pnl);
+    drawdown = std::max(drawdown, peakPnl - pnl);
+  });
+}
+
+bool midas::backtest::Replay::crossed(const BacktestLimits &limits) {
+  return (limits.maxDrawdown && drawdown > *limits.maxDrawdown) ||
+         (limits.maxOrders && orderManager->totalSize() > *limits.maxOrders);
+}
+
+void midas::backtest::Replay::advance(std::size_t endBar,
+                                      const BacktestLimits &limits) {
+  endBar = std::min(endBar, history->size());
+  const std::size_t baseIndex = history->baseIndex();
+  for (; nextBar < endBar && !limitCrossed; nextBar++) {
+    if (orderManager->hasActiveOrders()) {
+      // we only decide on new orders if we don't have current ones.
+      // This is a limitation that should be eventually removed
+      const midas::Bar bar(
+          history->barSizeSeconds, history->tradeCounts[nextBar],
+          history->highs[nextBar], history->lows[nextBar],
+          history->opens[nextBar], history->closes[nextBar],
+          history->waps[nextBar], history->volumes[nextBar],
+          history->timestamps[nextBar]);
+      orderManager->simulate(&bar);
+      // we don't want to process trades and enter new trades on the same
+      // candle.
+      limitCrossed = crossed(limits);
+    } else {
+      // bars that elapsed while orders were active are revealed along with
+      // this one
+      cursor->advanceTo(baseIndex + nextBar + 1);
+      trader->triggerSourceProcessing();
+      trader->decide();
+      limitCrossed = crossed(limits);
+    }
+  }
+  if (limitCrossed) {
+    INFO_LOG(*logger) << "Limit crossed after " << nextBar << " bars";
+  }
+}
+
+midas::TradeSummary midas::backtest::Replay::summary() {
+  OrderSummaryTracker summaryTracker;
+  for (Order *orderPtr : orderManager->getFilledOrders()) {
+    summaryTracker.addToSummary(orderPtr);
+  }
+  auto summary = summaryTracker.summary();
+  summary.endingBalance = orderManager->positionTracker.getPnl()[instrument];
+  return summary;
+}
+
+midas::backtest::BacktestResult midas::backtest::Replay::result() {
+  INFO_LOG(*logger) << "Total orders " << orderManager->totalSize();
+  OrderPrinter printer;
+  for (Order *orderPtr : orderManager->getFilledOrders()) {
+    orderPtr->visit(printer);
+  }
+  return BacktestResult{.summary = summary(),
+                        .originalStream = history,
+                        .orderDetails = printer.str(),
+                        .barsPerSecond = 0};
+}
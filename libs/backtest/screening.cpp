@@ -0,0 +1,353 @@
+#include "backtest/screening.hpp"
+#include "trader/batch_indicators.hpp"
+#include "trader/candle_aggregator.hpp"
+#include "trader/indicators.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace midas::backtest::screening;
+using midas::trader::batch::Broadcast;
+using midas::trader::batch::firstValue;
+
+namespace {
+constexpr double notReady = std::numeric_limits<double>::quiet_NaN();
+
+/**
+ * Index of the first candle from from on where mask is set, size if none
+ */
+std::size_t findSet(const std::vector<std::uint8_t> &mask, std::size_t from) {
+  if (from >= mask.size()) {
+    return mask.size();
+  }
+  const void *found = std::memchr(mask.data() + from, 1, mask.size() - from);
+  return found == nullptr
+             ? mask.size()
+             : static_cast<const std::uint8_t *>(found) - mask.data();
+}
+} // namespace
+
+Condition Condition::compare(Operation operation, Operand left,
+                             Operand right) {
+  Condition condition;
+  condition.program.push_back({operation, left, right});
+  return condition;
+}
+
+Condition Condition::combine(Operation operation, Condition left,
+                             const Condition &right) {
+  left.program.insert(left.program.end(), right.program.begin(),
+                      right.program.end());
+  left.program.push_back({operation});
+  return left;
+}
+
+Condition midas::backtest::screening::operator<(Operand left, Operand right) {
+  return Condition::compare(Condition::Operation::Less, left, right);
+}
+
+Condition midas::backtest::screening::operator<=(Operand left,
+                                                 Operand right) {
+  return Condition::compare(Condition::Operation::LessOrEqual, left, right);
+}
+
+Condition midas::backtest::screening::operator>(Operand left, Operand right) {
+  return Condition::compare(Condition::Operation::Less, right, left);
+}
+
+Condition midas::backtest::screening::operator>=(Operand left,
+                                                 Operand right) {
+  return Condition::compare(Condition::Operation::LessOrEqual, right, left);
+}
+
+Condition midas::backtest::screening::operator&&(Condition left,
+                                                 const Condition &right) {
+  return Condition::combine(Condition::Operation::And, std::move(left),
+                            right);
+}
+
+Condition midas::backtest::screening::operator||(Condition left,
+                                                 const Condition &right) {
+  return Condition::combine(Condition::Operation::Or, std::move(left), right);
+}
+
+Condition midas::backtest::screening::operator!(Condition condition) {
+  condition.program.push_back({Condition::Operation::Not});
+  return condition;
+}
+
+Screen::Screen(const DataStream &history, std::size_t candleSizeSeconds)
+    : columns(5) {
+  auto &opens = columns[open().index], &highs = columns[high().index],
+       &lows = columns[low().index], &closes = columns[close().index],
+       &volumes = columns[volume().index];
+  const auto add = [&](const Bar &candle) {
+    opens.push_back(candle.open);
+    highs.push_back(candle.high);
+    lows.push_back(candle.low);
+    closes.push_back(candle.close);
+    volumes.push_back(candle.volume);
+  };
+  if (candleSizeSeconds == 0 || candleSizeSeconds == history.barSizeSeconds) {
+    opens = history.opens;
+    highs = history.highs;
+    lows = history.lows;
+    closes = history.closes;
+    volumes = history.volumes;
+    return;
+  }
+  trader::CandleAggregator aggregator(candleSizeSeconds,
+                                      history.barSizeSeconds);
+  for (std::size_t i = 0; i < history.size(); i++) {
+    aggregator.add(Bar(history.barSizeSeconds, history.tradeCounts[i],
+                       history.highs[i], history.lows[i], history.opens[i],
+                       history.closes[i], history.waps[i], history.volumes[i],
+                       history.timestamps[i]),
+                   add);
+  }
+}
+
+std::span<const double> Screen::values(Column column) const {
+  if (column.index >= columns.size()) {
+    throw std::invalid_argument("Column is not part of this screen");
+  }
+  return columns[column.index];
+}
+
+std::pair<Column, bool> Screen::add(Key key, std::size_t outputs) {
+  if (const auto found = registry.find(key); found != registry.end()) {
+    return {{found->second}, false};
+  }
+  for (const std::size_t input : key.inputs) {
+    if (input >= columns.size()) {
+      throw std::invalid_argument("Column is not part of this screen");
+    }
+  }
+  const std::size_t first = columns.size();
+  columns.resize(first + outputs, std::vector<double>(size(), notReady));
+  registry.emplace(std::move(key), first);
+  return {{first}, true};
+}
+
+Column Screen::ema(Column input, int period) {
+  const auto [column, added] =
+      add({Type::Ema, {static_cast<double>(period)}, {input.index}}, 1);
+  if (added) {
+    const auto values = this->values(input);
+    const std::size_t from = firstValue(values);
+    trader::batch::ema(values.subspan(from), period,
+                       std::span(columns[column.index]).subspan(from));
+  }
+  return column;
+}
+
+Column Screen::sma(Column input, int period) {
+  const auto [column, added] =
+      add({Type::Sma, {static_cast<double>(period)}, {input.index}}, 1);
+  if (added) {
+    const auto values = this->values(input);
+    const std::size_t from = firstValue(values);
+    trader::batch::sma(values.subspan(from), period,
+                       std::span(columns[column.index]).subspan(from));
+  }
+  return column;
+}
+
+Column Screen::rsi(Column input, int period) {
+  const auto [column, added] =
+      add({Type::Rsi, {static_cast<double>(period)}, {input.index}}, 1);
+  if (added) {
+    const auto values = this->values(input);
+    const std::size_t from = firstValue(values);
+    trader::batch::rsi(values.subspan(from), period,
+                       std::span(columns[column.index]).subspan(from));
+  }
+  return column;
+}
+
+Column Screen::atr(int period) {
+  const auto [column, added] = add(
+      {Type::Atr, {static_cast<double>(period)}, {high().index, low().index,
+                                                  close().index}},
+      1);
+  if (added) {
+    trader::batch::atr(values(high()), values(low()), values(close()), period,
+                       columns[column.index]);
+  }
+  return column;
+}
+
+Screen::MacdColumns Screen::macd(Column input, int fastPeriod, int slowPeriod,
+                                 int signalPeriod) {
+  const auto [column, added] =
+      add({Type::Macd,
+           {static_cast<double>(fastPeriod), static_cast<double>(slowPeriod),
+            static_cast<double>(signalPeriod)},
+           {input.index}},
+          3);
+  const MacdColumns outputs{
+      column, {column.index + 1}, {column.index + 2}};
+  if (added) {
+    // there is no batch macd, the streaming one is a single cheap pass
+    trader::indicators::Macd macd(fastPeriod, slowPeriod, signalPeriod);
+    const auto values = this->values(input);
+    for (std::size_t i = firstValue(values); i < values.size(); i++) {
+      macd.add(values[i]);
+      if (macd.ready()) {
+        columns[outputs.macd.index][i] = macd.macd();
+        columns[outputs.signal.index][i] = macd.signal();
+        columns[outputs.histogram.index][i] = macd.histogram();
+      }
+    }
+  }
+  return outputs;
+}
+
+Screen::BandColumns Screen::bollingerBands(Column input, int period,
+                                           double deviationsUp,
+                                           double deviationsDown) {
+  const auto [column, added] =
+      add({Type::BollingerBands,
+           {static_cast<double>(period), deviationsUp, deviationsDown},
+           {input.index}},
+          3);
+  const BandColumns outputs{column, {column.index + 1}, {column.index + 2}};
+  if (added) {
+    const auto values = this->values(input);
+    const std::size_t from = firstValue(values);
+    trader::batch::bollingerBands(
+        values.subspan(from), period, deviationsUp, deviationsDown,
+        std::span(columns[outputs.upper.index]).subspan(from),
+        std::span(columns[outputs.middle.index]).subspan(from),
+        std::span(columns[outputs.lower.index]).subspan(from));
+  }
+  return outputs;
+}
+
+std::vector<std::uint8_t> Screen::evaluate(const Condition &condition) const {
+  if (condition.program.empty()) {
+    throw std::invalid_argument("Condition is empty");
+  }
+  const std::size_t candles = size();
+  // the values of a condition and where none of its operands were NaN, so
+  // that negating does not turn a comparison with NaN true
+  struct Evaluated {
+    std::vector<std::uint8_t> values, valid;
+  };
+  std::vector<Evaluated> stack;
+  for (const Condition::Instruction &instruction : condition.program) {
+    using Operation = Condition::Operation;
+    if (instruction.operation == Operation::Less ||
+        instruction.operation == Operation::LessOrEqual) {
+      const bool orEqual = instruction.operation == Operation::LessOrEqual;
+      auto &[out, valid] = stack.emplace_back(
+          Evaluated{std::vector<std::uint8_t>(candles),
+                    std::vector<std::uint8_t>(candles)});
+      const auto compare = [&](const auto &left, const auto &right) {
+        if (orEqual) {
+          for (std::size_t i = 0; i < candles; i++) {
+            out[i] = left[i] <= right[i];
+          }
+        } else {
+          for (std::size_t i = 0; i < candles; i++) {
+            out[i] = left[i] < right[i];
+          }
+        }
+        for (std::size_t i = 0; i < candles; i++) {
+          // only NaN differs from itself
+          valid[i] = (left[i] == left[i]) & (right[i] == right[i]);
+        }
+      };
+      const Operand &left = instruction.left, &right = instruction.right;
+      if (left.column && right.column) {
+        compare(values(*left.column), values(*right.column));
+      } else if (left.column) {
+        compare(values(*left.column), Broadcast{right.constant});
+      } else if (right.column) {
+        compare(Broadcast{left.constant}, values(*right.column));
+      } else {
+        compare(Broadcast{left.constant}, Broadcast{right.constant});
+      }
+      continue;
+    }
+    if (instruction.operation == Operation::Not) {
+      auto &[out, valid] = stack.back();
+      for (std::size_t i = 0; i < candles; i++) {
+        out[i] = (out[i] ^ 1) & valid[i];
+      }
+      continue;
+    }
+    const Evaluated right = std::move(stack.back());
+    stack.pop_back();
+    auto &[out, valid] = stack.back();
+    if (instruction.operation == Operation::And) {
+      for (std::size_t i = 0; i < candles; i++) {
+        out[i] &= right.values[i];
+      }
+    } else {
+      for (std::size_t i = 0; i < candles; i++) {
+        out[i] |= right.values[i];
+      }
+    }
+    for (std::size_t i = 0; i < candles; i++) {
+      valid[i] &= right.valid[i];
+    }
+  }
+  return std::move(stack.back().values);
+}
+
+ScreeningResult Screen::run(const Rules &rules) const {
+  const std::vector<std::uint8_t> entries = evaluate(rules.entry);
+  const std::vector<std::uint8_t> exits =
+      rules.exit ? evaluate(*rules.exit) : std::vector<std::uint8_t>();
+  const auto opens = values(open()), highs = values(high()),
+             lows = values(low()), closes = values(close());
+  const std::size_t candles = size();
+  const bool buying = rules.direction == OrderDirection::BUY;
+  ScreeningResult result;
+  double peak = 0;
+  for (std::size_t signal = findSet(entries, 0); signal + 1 < candles;) {
+    const std::size_t entry = signal + 1;
+    const double entryPrice = opens[entry];
+    const double profitLevel = buying ? entryPrice + rules.profitOffset
+                                      : entryPrice - rules.profitOffset;
+    const double stopLevel = buying ? entryPrice - rules.stopLossOffset
+                                    : entryPrice + rules.stopLossOffset;
+    const std::size_t from = entry + 1;
+    const std::size_t touched =
+        from >= candles
+            ? candles
+            : from + trader::batch::firstTouch(
+                         highs.subspan(from), lows.subspan(from),
+                         buying ? stopLevel : profitLevel,
+                         buying ? profitLevel : stopLevel);
+    const std::size_t exitSignal =
+        rules.exit ? findSet(exits, entry) : candles;
+    double exitPrice;
+    std::size_t exit;
+    if (exitSignal + 1 < candles && exitSignal + 1 <= touched) {
+      exit = exitSignal + 1;
+      exitPrice = opens[exit];
+      result.ruleExits++;
+    } else if (touched < candles) {
+      exit = touched;
+      const bool stopped =
+          buying ? lows[exit] <= stopLevel : highs[exit] >= stopLevel;
+      exitPrice = stopped ? stopLevel : profitLevel;
+      stopped ? result.stopLosses++ : result.profitTakers++;
+    } else {
+      exit = candles;
+      exitPrice = closes.back();
+      result.openAtEnd = true;
+    }
+    result.trades++;
+    result.profit += buying ? exitPrice - entryPrice : entryPrice - exitPrice;
+    peak = std::max(peak, result.profit);
+    result.maxDrawdown = std::max(result.maxDrawdown, peak - result.profit);
+    // the candle the position was left on may signal the next entry
+    signal = findSet(entries, exit);
+  }
+  return result;
+}
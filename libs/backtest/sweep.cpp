@@ -0,0 +1,182 @@
+#include "backtest/sweep.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+using namespace midas::backtest::sweep;
+
+namespace {
+/**
+ * Rounds to the nearest step that is still within the dimension
+ */
+double snap(const Dimension &dimension, double value) {
+  if (dimension.step <= 0) {
+    return std::clamp(value, dimension.min, dimension.max);
+  }
+  double steps = std::round((value - dimension.min) / dimension.step);
+  if (dimension.min + steps * dimension.step > dimension.max) {
+    steps--;
+  }
+  return dimension.min + std::max(steps, 0.0) * dimension.step;
+}
+
+std::vector<double> gridValues(const Dimension &dimension) {
+  if (dimension.step <= 0) {
+    return dimension.min == dimension.max
+               ? std::vector<double>{dimension.min}
+               : std::vector<double>{dimension.min, dimension.max};
+  }
+  // the tolerance keeps max when the range is a whole number of steps
+  const auto steps = static_cast<std::size_t>(
+      std::floor((dimension.max - dimension.min) / dimension.step + 1e-9));
+  std::vector<double> values(steps + 1);
+  for (std::size_t i = 0; i <= steps; i++) {
+    values[i] = dimension.min + i * dimension.step;
+  }
+  return values;
+}
+} // namespace
+
+double Options::scoreOf(const TradeSummary &summary) const {
+  return score ? score(summary) : summary.endingBalance;
+}
+
+int Options::workers() const {
+  return concurrency == 0 ? tbb::task_arena::automatic
+                          : static_cast<int>(concurrency);
+}
+
+double midas::backtest::sweep::rankOf(double score) {
+  return std::isnan(score) ? -std::numeric_limits<double>::infinity() : score;
+}
+
+ParameterSpace &ParameterSpace::add(Dimension dimension) {
+  if (dimension.max < dimension.min || dimension.step < 0) {
+    throw std::invalid_argument("Invalid range for parameter " +
+                                dimension.name);
+  }
+  if (std::ranges::any_of(dimensionList, [&](const Dimension &existing) {
+        return existing.name == dimension.name;
+      })) {
+    throw std::invalid_argument("Parameter " + dimension.name +
+                                " is swept twice");
+  }
+  dimensionList.push_back(std::move(dimension));
+  return *this;
+}
+
+std::vector<parameters_t> ParameterSpace::grid() const {
+  std::vector<std::vector<double>> values;
+  values.reserve(dimensionList.size());
+  for (const Dimension &dimension : dimensionList) {
+    values.push_back(gridValues(dimension));
+  }
+  std::vector<parameters_t> points{{}};
+  for (std::size_t i = 0; i < dimensionList.size(); i++) {
+    std::vector<parameters_t> expanded;
+    expanded.reserve(points.size() * values[i].size());
+    for (const parameters_t &point : points) {
+      for (const double value : values[i]) {
+        expanded.push_back(point);
+        expanded.back()[dimensionList[i].name] = value;
+      }
+    }
+    points = std::move(expanded);
+  }
+  return points;
+}
+
+std::vector<parameters_t> ParameterSpace::random(std::size_t count,
+                                                 std::uint64_t seed) const {
+  std::mt19937_64 generator(seed);
+  std::vector<parameters_t> points(count);
+  for (parameters_t &point : points) {
+    for (const Dimension &dimension : dimensionList) {
+      std::uniform_real_distribution<double> uniform(dimension.min,
+                                                     dimension.max);
+      point[dimension.name] = snap(dimension, uniform(generator));
+    }
+  }
+  return points;
+}
+
+std::vector<parameters_t>
+ParameterSpace::latinHypercube(std::size_t count, std::uint64_t seed) const {
+  std::mt19937_64 generator(seed);
+  std::uniform_real_distribution<double> withinStratum(0, 1);
+  std::vector<parameters_t> points(count);
+  std::vector<std::size_t> strata(count);
+  for (const Dimension &dimension : dimensionList) {
+    // each point lands in a different stratum of every dimension
+    std::iota(strata.begin(), strata.end(), 0);
+    std::shuffle(strata.begin(), strata.end(), generator);
+    const double width = (dimension.max - dimension.min) / count;
+    for (std::size_t i = 0; i < count; i++) {
+      points[i][dimension.name] = snap(
+          dimension,
+          dimension.min + (strata[i] + withinStratum(generator)) * width);
+    }
+  }
+  return points;
+}
+
+Table midas::backtest::sweep::run(InstrumentEnum instrument,
+                                  std::shared_ptr<DataStream> history,
+                                  const std::vector<parameters_t> &parameters,
+                                  trader_factory_t traderFactory,
+                                  const Options &options) {
+  Table table;
+  table.runs.resize(parameters.size());
+  tbb::task_arena arena(options.workers());
+  arena.execute([&] {
+    // one run per task, runs are long and vary in length
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, parameters.size(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+          for (std::size_t i = range.begin(); i < range.end(); i++) {
+            const BacktestResult result = replayBacktest(
+                instrument, history,
+                [&](const trader::CandleSource &source,
+                    std::shared_ptr<midas::OrderManager> orderManager) {
+                  return traderFactory(parameters[i], source, orderManager);
+                },
+                options.mode);
+            table.runs[i] = Run{.index = i,
+                                .parameters = parameters[i],
+                                .summary = result.summary,
+                                .score = options.scoreOf(result.summary)};
+          }
+        });
+  });
+  std::ranges::stable_sort(table.runs, [](const Run &lhs, const Run &rhs) {
+    return rankOf(lhs.score) > rankOf(rhs.score);
+  });
+  return table;
+}
+
+std::ostream &midas::backtest::sweep::operator<<(std::ostream &stream,
+                                                 const Table &table) {
+  if (table.runs.empty()) {
+    return stream;
+  }
+  for (const auto &[name, value] : table.runs.front().parameters) {
+    stream << name << ",";
+  }
+  stream << "entries,profit takers,stop losses,ending balance,score\n";
+  for (const Run &run : table.runs) {
+    for (const auto &[name, value] : run.parameters) {
+      stream << value << ",";
+    }
+    stream << run.summary.numberOfEntryOrdersTriggered << ","
+           << run.summary.numberOfProfitTakersTriggered << ","
+           << run.summary.numberOfStopLossTriggered << ","
+           << run.summary.endingBalance << "," << run.score << "\n";
+  }
+  return stream;
+}
@@ -0,0 +1,145 @@
+#include "backtest/backtest.hpp"
+#include "backtest_order_manager.hpp"
+#include "broker-interface/instruments.hpp"
+#include "data/bar.hpp"
+#include "data/data_stream.hpp"
+#include "logging/logging.hpp"
+#include "random_walk.hpp"
+#include "replay.hpp"
+#include "trader/base_trader.hpp"
+#include "trader/batch_indicators.hpp"
+#include "trader/trader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas;
+using namespace backtest;
+using namespace backtest::tests;
+
+namespace {
+struct Decisions {
+  std::size_t count{0}, candles{0};
+};
+
+/**
+ * Decides nothing, counts the decisions and the candles it was shown
+ */
+struct IdleTrader : public trader::Trader {
+  IdleTrader(const trader::CandleSource &source,
+             std::shared_ptr<OrderManager> orderManager, Decisions &decisions)
+      : trader::Trader(
+            1, 60, source, orderManager,
+            std::make_shared<logging::thread_safe_logger_t>(
+                logging::create_channel_logger("idle trader"))),
+        decisions(decisions) {}
+  void decide() override {
+    decisions.count++;
+    decisions.candles = data.snapshot()->endIndex;
+  }
+  std::string traderName() const override { return "Idle trader"; }
+  Decisions &decisions;
+};
+} // namespace
+
+class BacktestModeTest : public testing::TestWithParam<trader::TraderType> {};
+
+TEST_P(BacktestModeTest, FeatureMatrixDecidesAsStreaming) {
+  const auto history = randomWalk(3, 2 * 17280);
+  ASSERT_EQ(history->size(), 2 * 17280);
+  const auto factory = [](const trader::CandleSource &source,
+                          std::shared_ptr<OrderManager> orderManager) {
+    return trader::createTrader(GetParam(), source, orderManager,
+                                InstrumentEnum::MicroNasdaqFutures, 1);
+  };
+  const BacktestResult streaming = replayBacktest(
+      InstrumentEnum::MicroNasdaqFutures, history, factory,
+      BacktestMode::Streaming);
+
+  // the features are computed by the batch kernels, which round differently
+  // on every instruction set
+  const trader::batch::InstructionSet widest =
+      trader::batch::detectInstructionSet();
+  for (const auto instructionSet : {trader::batch::InstructionSet::Scalar,
+                                    trader::batch::InstructionSet::Avx2,
+                                    trader::batch::InstructionSet::Avx512}) {
+    if (instructionSet > widest) {
+      break;
+    }
+    SCOPED_TRACE(trader::batch::toString(instructionSet));
+    trader::batch::useInstructionSet(instructionSet);
+    const BacktestResult precomputed = replayBacktest(
+        InstrumentEnum::MicroNasdaqFutures, history, factory,
+        BacktestMode::FeatureMatrix);
+
+    EXPECT_EQ(precomputed.orderDetails, streaming.orderDetails);
+    EXPECT_EQ(precomputed.originalStream->size(),
+              streaming.originalStream->size());
+    const TradeSummary &expected = streaming.summary;
+    const TradeSummary &summary = precomputed.summary;
+    EXPECT_EQ(summary.numberOfEntryOrdersTriggered,
+              expected.numberOfEntryOrdersTriggered);
+    EXPECT_EQ(summary.numberOfStopLossTriggered,
+              expected.numberOfStopLossTriggered);
+    EXPECT_EQ(summary.numberOfProfitTakersTriggered,
+              expected.numberOfProfitTakersTriggered);
+    EXPECT_EQ(summary.endingBalance, expected.endingBalance);
+  }
+  trader::batch::useInstructionSet(widest);
+}
+
+TEST(BacktestReplayTest, RevealsHistoryOneBarAtATime) {
+  const auto history = randomWalk(3, 2 * 17280);
+  Decisions replayed;
+  const auto factory = [&replayed](const trader::CandleSource &source,
+                                   std::shared_ptr<OrderManager> orderManager) {
+    auto trader =
+        std::make_unique<IdleTrader>(source, orderManager, replayed);
+    // nothing is visible before the replay starts
+    EXPECT_EQ(trader->closedCandles().second, 0);
+    return trader;
+  };
+  const BacktestResult result = replayBacktest(
+      InstrumentEnum::MicroNasdaqFutures, history, factory);
+  EXPECT_EQ(replayed.count, history->size());
+  // the last decision saw the whole history
+  auto logger = std::make_shared<logging::thread_safe_logger_t>(
+      logging::create_channel_logger("replay test"));
+  Decisions whole;
+  const IdleTrader wholeTrader(
+      history, std::make_shared<BacktestOrderManager>(logger), whole);
+  EXPECT_EQ(replayed.candles, wholeTrader.closedCandles().second);
+  EXPECT_EQ(result.originalStream, history);
+  EXPECT_GT(result.barsPerSecond, 0);
+}
+
+TEST(BacktestReplayTest, WarmsUpOnTheLookBackOnly) {
+  const auto history = randomWalk(3, 2 * 17280);
+  Decisions decisions;
+  const auto factory = [&decisions](const trader::CandleSource &source,
+                                    std::shared_ptr<OrderManager> orderManager) {
+    return std::make_unique<IdleTrader>(source, orderManager, decisions);
+  };
+  for (const BacktestMode mode :
+       {BacktestMode::Streaming, BacktestMode::FeatureMatrix}) {
+    decisions = {};
+    // the second day, the first one is only there to warm up on
+    Replay replay(InstrumentEnum::MicroNasdaqFutures, history, factory, mode,
+                  17280);
+    replay.advance(17280 + 1);
+    EXPECT_EQ(decisions.count, 1);
+    // the minute the trader looks back on, not the day before it
+    EXPECT_GE(decisions.candles, 1);
+    EXPECT_LE(decisions.candles, 2);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Traders, BacktestModeTest,
+    testing::Values(trader::TraderType::MomentumTrader,
+                    trader::TraderType::MACDTrader,
+                    trader::TraderType::MeanReversionTrader));
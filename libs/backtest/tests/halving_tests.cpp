@@ -0,0 +1,112 @@
+#include "backtest/halving.hpp"
+#include "broker-interface/instruments.hpp"
+#include "data/data_stream.hpp"
+#include "random_walk.hpp"
+#include "trader/trader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas;
+using namespace backtest;
+using namespace backtest::tests;
+
+TEST(HalvingTest, SurvivorMatchesFullBacktest) {
+  const auto history = randomWalk(17, 8640);
+  const auto parameters = candidates(11, 1);
+  const halving::Result result = halving::successiveHalving(
+      InstrumentEnum::MicroNasdaqFutures, history, parameters, momentum,
+      {.initialBars = 1000});
+
+  ASSERT_EQ(result.candidates.size(), parameters.size());
+  const halving::Candidate &best = result.candidates.front();
+  ASSERT_EQ(best.bars, history->size());
+  const BacktestResult full = replayBacktest(
+      InstrumentEnum::MicroNasdaqFutures, history,
+      [&](const trader::CandleSource &source,
+          std::shared_ptr<OrderManager> orderManager) {
+        return momentum(best.parameters, source, orderManager);
+      });
+  // resuming a survivor gives the same trades as replaying it at once
+  EXPECT_EQ(best.summary.numberOfEntryOrdersTriggered,
+            full.summary.numberOfEntryOrdersTriggered);
+  EXPECT_EQ(best.summary.endingBalance, full.summary.endingBalance);
+  EXPECT_LT(result.replayedBars, parameters.size() * history->size());
+  EXPECT_TRUE(std::ranges::is_sorted(result.candidates, std::greater{},
+                                     &halving::Candidate::bars));
+}
+
+TEST(HalvingTest, RanksIndependentlyOfWorkers) {
+  const auto history = randomWalk(17, 8640);
+  const auto parameters = candidates(11, 1);
+  const halving::Result serial = halving::successiveHalving(
+      InstrumentEnum::MicroNasdaqFutures, history, parameters, momentum,
+      {.initialBars = 1000, .search = {.concurrency = 1}});
+  const halving::Result parallel = halving::successiveHalving(
+      InstrumentEnum::MicroNasdaqFutures, history, parameters, momentum,
+      {.initialBars = 1000, .search = {.concurrency = 4}});
+
+  ASSERT_EQ(serial.candidates.size(), parallel.candidates.size());
+  EXPECT_EQ(serial.replayedBars, parallel.replayedBars);
+  for (std::size_t i = 0; i < serial.candidates.size(); i++) {
+    EXPECT_EQ(parallel.candidates[i].index, serial.candidates[i].index);
+    EXPECT_EQ(parallel.candidates[i].bars, serial.candidates[i].bars);
+    EXPECT_EQ(parallel.candidates[i].summary.endingBalance,
+              serial.candidates[i].summary.endingBalance);
+  }
+}
+
+TEST(HalvingTest, DropsCandidatesCrossingLimits) {
+  const auto history = randomWalk(17, 8640);
+  const auto parameters = candidates(11, 1);
+  const halving::Result result = halving::successiveHalving(
+      InstrumentEnum::MicroNasdaqFutures, history, parameters, momentum,
+      {.initialBars = 1000, .limits = {.maxOrders = 0}});
+
+  ASSERT_EQ(result.candidates.size(), parameters.size());
+  for (const halving::Candidate &candidate : result.candidates) {
+    if (candidate.aborted) {
+      EXPECT_LT(candidate.bars, history->size());
+    } else {
+      // only candidates that never placed an order are kept
+      EXPECT_EQ(candidate.summary.numberOfEntryOrdersTriggered, 0);
+    }
+  }
+  EXPECT_TRUE(std::ranges::any_of(result.candidates,
+                                  &halving::Candidate::aborted));
+}
+
+TEST(HalvingTest, HyperbandIndexesEveryBracket) {
+  const auto history = randomWalk(17, 8640);
+  sweep::ParameterSpace space;
+  space.add({"fast", 3, 11, 1}).add({"profit", 3, 6, 3});
+  const halving::Result result = halving::hyperband(
+      InstrumentEnum::MicroNasdaqFutures, history, space, momentum, 7,
+      {.initialBars = 2000, .reduction = 3});
+
+  // brackets of 1 and 0 halving rounds, 3 + 2 candidates
+  ASSERT_EQ(result.candidates.size(), 5);
+  std::set<std::size_t> indices;
+  for (const halving::Candidate &candidate : result.candidates) {
+    indices.insert(candidate.index);
+  }
+  EXPECT_EQ(indices.size(), result.candidates.size());
+  EXPECT_EQ(result.candidates.front().bars, history->size());
+}
+
+TEST(HalvingTest, RejectsInvalidOptions) {
+  const auto history = randomWalk(17, 8640);
+  EXPECT_THROW(halving::successiveHalving(InstrumentEnum::MicroNasdaqFutures,
+                                          history, candidates(11, 1), momentum,
+                                          {.reduction = 1}),
+               std::invalid_argument);
+  EXPECT_THROW(halving::successiveHalving(InstrumentEnum::MicroNasdaqFutures,
+                                          history, candidates(11, 1), momentum,
+                                          {.initialBars = 0}),
+               std::invalid_argument);
+}
@@ -0,0 +1,61 @@
+#include "backtest/monte_carlo.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+using namespace midas::backtest;
+
+namespace {
+const std::vector<double> trades{4, -2, 3, -5, 1, 2, -1, 6, -3, 2};
+}
+
+TEST(MonteCarloTest, PermutationKeepsTotalReturn) {
+  const auto result = montecarlo::resample(
+      trades, {.paths = 2000, .resampling = montecarlo::Resampling::Permutation});
+
+  const double total = std::accumulate(trades.begin(), trades.end(), 0.0);
+  ASSERT_EQ(result.totalReturn.values.size(), 2000);
+  for (const double value : result.totalReturn.values) {
+    EXPECT_DOUBLE_EQ(value, total);
+  }
+  EXPECT_GE(result.maxDrawdown.values.front(), 0);
+  // every losing trade in a row, the worst ordering
+  EXPECT_EQ(result.maxDrawdown.values.back(), 11);
+  EXPECT_TRUE(std::ranges::is_sorted(result.maxDrawdown.values));
+}
+
+TEST(MonteCarloTest, BootstrapCentersOnTotalReturn) {
+  const auto result = montecarlo::resample(trades, {.paths = 20000, .seed = 3});
+
+  const double total = std::accumulate(trades.begin(), trades.end(), 0.0);
+  EXPECT_NEAR(result.totalReturn.mean(), total, 0.2);
+  EXPECT_LT(result.totalReturn.quantile(0.05), total);
+  EXPECT_GT(result.totalReturn.quantile(0.95), total);
+  EXPECT_TRUE(std::ranges::is_sorted(result.totalReturn.values));
+}
+
+TEST(MonteCarloTest, IndependentOfWorkers) {
+  const auto serial =
+      montecarlo::resample(trades, {.paths = 5000, .seed = 9, .concurrency = 1});
+  const auto parallel =
+      montecarlo::resample(trades, {.paths = 5000, .seed = 9, .concurrency = 4});
+  EXPECT_EQ(serial.totalReturn.values, parallel.totalReturn.values);
+  EXPECT_EQ(serial.maxDrawdown.values, parallel.maxDrawdown.values);
+  const auto reseeded =
+      montecarlo::resample(trades, {.paths = 5000, .seed = 10});
+  EXPECT_NE(serial.maxDrawdown.values, reseeded.maxDrawdown.values);
+}
+
+TEST(MonteCarloTest, InterpolatesQuantiles) {
+  const montecarlo::Distribution distribution{{0, 10, 20}};
+  EXPECT_EQ(distribution.quantile(0), 0);
+  EXPECT_EQ(distribution.quantile(0.25), 5);
+  EXPECT_EQ(distribution.quantile(1), 20);
+  EXPECT_EQ(distribution.mean(), 10);
+  EXPECT_TRUE(std::isnan(montecarlo::Distribution{}.quantile(0.5)));
+  EXPECT_TRUE(montecarlo::resample({}, {.paths = 10}).maxDrawdown.values ==
+              std::vector<double>(10, 0.0));
+}
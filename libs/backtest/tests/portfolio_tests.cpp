@@ -0,0 +1,203 @@
+#include "backtest/portfolio.hpp"
+#include "broker-interface/instruments.hpp"
+#include "data/bar.hpp"
+#include "data/data_stream.hpp"
+#include "logging/logging.hpp"
+#include "random_walk.hpp"
+#include "trader/trader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <tbb/global_control.h>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas;
+using namespace backtest;
+using namespace backtest::tests;
+
+namespace {
+/**
+ * Time of the bar offset bars after the common start
+ */
+Timestamp at(int offset) {
+  return midas::fromUnixSeconds(1'700'000'000 + 5 * offset);
+}
+
+std::vector<PortfolioLeg> legs() {
+  const auto momentum = [](InstrumentEnum instrument) {
+    return [instrument](const trader::CandleSource &source,
+                        std::shared_ptr<OrderManager> orderManager) {
+      return trader::createTrader(trader::TraderType::MomentumTrader, source,
+                                  orderManager, instrument, 1);
+    };
+  };
+  return {
+      {InstrumentEnum::MicroNasdaqFutures, randomWalk(3, 8640),
+       momentum(InstrumentEnum::MicroNasdaqFutures)},
+      {InstrumentEnum::MicroSPXFutures, randomWalk(5, 6000, 5000, at(1000)),
+       momentum(InstrumentEnum::MicroSPXFutures)},
+      {InstrumentEnum::MicroRussel, randomWalk(7, 8640, 2000, at(4000)),
+       momentum(InstrumentEnum::MicroRussel)},
+  };
+}
+
+/**
+ * Times of the bars revealed to the traders, in the order they decided
+ */
+struct Decisions {
+  std::mutex mutex;
+  std::vector<Timestamp> times;
+};
+
+/**
+ * Decides nothing, records the time of the bar it decides on
+ */
+struct RecordingTrader : public trader::Trader {
+  RecordingTrader(const trader::CandleSource &source,
+                  std::shared_ptr<OrderManager> orderManager,
+                  std::shared_ptr<DataStream> history, Decisions &decisions)
+      : trader::Trader(
+            1, 60, source, orderManager,
+            std::make_shared<logging::thread_safe_logger_t>(
+                logging::create_channel_logger("recording trader"))),
+        history(history), decisions(decisions) {}
+  void decide() override {
+    std::scoped_lock lock(decisions.mutex);
+    decisions.times.push_back(history->timestamps[decided++]);
+  }
+  std::string traderName() const override { return "Recording trader"; }
+  std::shared_ptr<DataStream> history;
+  Decisions &decisions;
+  std::size_t decided{0};
+};
+
+/**
+ * Instruments in the order their orders were transmitted
+ */
+struct Transmissions {
+  std::mutex mutex;
+  std::vector<InstrumentEnum> instruments;
+};
+
+/**
+ * Buys on its first decision, after a pause if slow
+ */
+struct BuyingTrader : public trader::Trader {
+  BuyingTrader(const trader::CandleSource &source,
+               std::shared_ptr<OrderManager> orderManager,
+               InstrumentEnum instrument, bool slow,
+               Transmissions &transmissions)
+      : trader::Trader(
+            1, 60, source, orderManager,
+            std::make_shared<logging::thread_safe_logger_t>(
+                logging::create_channel_logger("buying trader"))),
+        instrument(instrument), slow(slow), transmissions(transmissions) {}
+  void decide() override {
+    if (decided++ > 0) {
+      return;
+    }
+    if (slow) {
+      std::this_thread::sleep_for(50ms);
+    }
+    executeMarket(instrument, 1, OrderDirection::BUY,
+                  [this](Order::StatusChangeEvent event) {
+                    if (event.newStatus == OrderStatusEnum::Accepted) {
+                      std::scoped_lock lock(transmissions.mutex);
+                      transmissions.instruments.push_back(instrument);
+                    }
+                  });
+  }
+  std::string traderName() const override { return "Buying trader"; }
+  InstrumentEnum instrument;
+  bool slow;
+  Transmissions &transmissions;
+  std::size_t decided{0};
+};
+} // namespace
+
+TEST(PortfolioTest, MatchesSingleInstrumentBacktests) {
+  const auto portfolio = legs();
+  const PortfolioResult result = replayPortfolio(portfolio);
+
+  ASSERT_EQ(result.instruments.size(), portfolio.size());
+  double total = 0;
+  for (const PortfolioLeg &leg : portfolio) {
+    // traders of different instruments do not interact
+    const BacktestResult single =
+        replayBacktest(leg.instrument, leg.history, leg.traderFactory);
+    const TradeSummary &summary = result.instruments.at(leg.instrument);
+    EXPECT_EQ(summary.numberOfEntryOrdersTriggered,
+              single.summary.numberOfEntryOrdersTriggered);
+    EXPECT_EQ(summary.numberOfStopLossTriggered,
+              single.summary.numberOfStopLossTriggered);
+    EXPECT_EQ(summary.numberOfProfitTakersTriggered,
+              single.summary.numberOfProfitTakersTriggered);
+    EXPECT_EQ(summary.endingBalance, single.summary.endingBalance);
+    total += summary.endingBalance;
+  }
+  EXPECT_DOUBLE_EQ(result.aggregate.endingBalance, total);
+  EXPECT_GT(result.aggregate.numberOfEntryOrdersTriggered, 0);
+  // together the instruments span bars 0 to 12640 of the common start
+  EXPECT_EQ(result.epochs, 4000 + 8640);
+}
+
+TEST(PortfolioTest, MergesInstrumentsInTimeOrder) {
+  Decisions decisions;
+  std::vector<PortfolioLeg> portfolio = legs();
+  for (PortfolioLeg &leg : portfolio) {
+    leg.traderFactory = [&decisions,
+                         history = leg.history](
+                            const trader::CandleSource &source,
+                            std::shared_ptr<OrderManager> orderManager) {
+      return std::make_unique<RecordingTrader>(source, orderManager, history,
+                                               decisions);
+    };
+  }
+  const PortfolioResult result = replayPortfolio(portfolio);
+
+  EXPECT_EQ(decisions.times.size(), 8640 + 6000 + 8640);
+  EXPECT_TRUE(std::ranges::is_sorted(decisions.times));
+  EXPECT_EQ(std::set<Timestamp>(decisions.times.begin(),
+                                decisions.times.end())
+                .size(),
+            result.epochs);
+  EXPECT_EQ(result.aggregate.numberOfEntryOrdersTriggered, 0);
+}
+
+TEST(PortfolioTest, TransmitsInLegOrder) {
+  Transmissions transmissions;
+  std::vector<PortfolioLeg> portfolio = legs();
+  for (PortfolioLeg &leg : portfolio) {
+    // every leg decides on the first epoch
+    leg.history = randomWalk(3, 10);
+    leg.traderFactory = [&transmissions, instrument = leg.instrument,
+                         slow = leg.instrument == portfolio.front().instrument](
+                            const trader::CandleSource &source,
+                            std::shared_ptr<OrderManager> orderManager) {
+      return std::make_unique<BuyingTrader>(source, orderManager, instrument,
+                                            slow, transmissions);
+    };
+  }
+  // the legs decide at once even on a single core
+  tbb::global_control parallelism(
+      tbb::global_control::max_allowed_parallelism, portfolio.size());
+  replayPortfolio(portfolio, BacktestMode::Streaming, portfolio.size());
+
+  std::vector<InstrumentEnum> expected;
+  for (const PortfolioLeg &leg : portfolio) {
+    expected.push_back(leg.instrument);
+  }
+  EXPECT_EQ(transmissions.instruments, expected);
+}
+
+TEST(PortfolioTest, RejectsRepeatedInstruments) {
+  std::vector<PortfolioLeg> portfolio = legs();
+  portfolio.push_back(portfolio.front());
+  EXPECT_THROW(replayPortfolio(portfolio), std::invalid_argument);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "backtest/sweep.hpp"
+#include "broker-interface/instruments.hpp"
+#include "data/bar.hpp"
+#include "data/data_stream.hpp"
+#include "trader/momentum_trader.hpp"
+#include "trader/trader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace midas::backtest::tests {
+/**
+ * Random walk 5 second bars, the same for the same seed
+ * @param price open of the first bar
+ * @param first time of the first bar
+ */
+inline std::shared_ptr<DataStream>
+randomWalk(unsigned int seed, std::size_t count, double price = 18000,
+           Timestamp first = midas::fromUnixSeconds(1'700'000'000)) {
+  std::mt19937 generator{seed};
+  std::normal_distribution<double> move(0, 2);
+  std::vector<Bar> bars;
+  bars.reserve(count);
+  Timestamp time = first;
+  double close = price;
+  for (std::size_t i = 0; i < count; i++) {
+    const double open = close;
+    close += move(generator);
+    bars.emplace_back(5, 10, std::max(open, close) + 1,
+                      std::min(open, close) - 1, open, close, close,
+                      50 + i % 13, time);
+    time += midas::fromUnixSeconds(5);
+  }
+  auto stream = std::make_shared<DataStream>(5);
+  stream->addBars(bars.begin(), bars.end());
+  stream->waitForData(std::chrono::milliseconds(0));
+  return stream;
+}
+
+/**
+ * Momentum trader of the micro Nasdaq with the "fast" and "profit" parameters
+ */
+inline std::unique_ptr<trader::Trader>
+momentum(const sweep::parameters_t &parameters,
+         const trader::CandleSource &source,
+         std::shared_ptr<OrderManager> orderManager) {
+  trader::MomentumParameters momentumParameters;
+  momentumParameters.fastMATimePeriod =
+      static_cast<int>(parameters.at("fast"));
+  momentumParameters.profitOffset = parameters.at("profit");
+  return trader::momentumExploit(source, orderManager,
+                                 InstrumentEnum::MicroNasdaqFutures, 1,
+                                 momentumParameters);
+}
+
+/**
+ * Momentum parameters, fast from 3 to lastFast, profit 3 and 6
+ */
+inline std::vector<sweep::parameters_t> candidates(double lastFast,
+                                                   double fastStep) {
+  sweep::ParameterSpace space;
+  space.add({"fast", 3, lastFast, fastStep}).add({"profit", 3, 6, 3});
+  return space.grid();
+}
+} // namespace midas::backtest::tests
@@ -0,0 +1,192 @@
+#include "backtest/screening.hpp"
+#include "data/bar.hpp"
+#include "data/data_stream.hpp"
+#include "random_walk.hpp"
+#include "trader/batch_indicators.hpp"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas;
+using namespace backtest::screening;
+using namespace backtest::tests;
+
+namespace {
+const Timestamp start = midas::fromUnixSeconds(1'699'999'980);
+
+/**
+ * Bars of open, high, low and close
+ */
+std::shared_ptr<DataStream> stream(const std::vector<std::array<double, 4>> &prices) {
+  std::vector<Bar> bars;
+  Timestamp time = start;
+  for (const auto &[open, high, low, close] : prices) {
+    bars.emplace_back(5, 10, high, low, open, close, close, 50, time);
+    time += midas::fromUnixSeconds(5);
+  }
+  auto history = std::make_shared<DataStream>(5);
+  history->addBars(bars.begin(), bars.end());
+  history->waitForData(0ms);
+  return history;
+}
+} // namespace
+
+TEST(ScreeningTest, EvaluatesConditionsColumnWise) {
+  const auto history = randomWalk(7, 5000, 18000, start);
+  Screen screen(*history);
+  ASSERT_EQ(screen.size(), 5000);
+  const Column fast = screen.ema(screen.close(), 9);
+  const Column slow = screen.ema(screen.close(), 21);
+  const Column rsi = screen.rsi(screen.close(), 14);
+  const auto macd = screen.macd(screen.close(), 12, 26, 9);
+  EXPECT_EQ(screen.ema(screen.close(), 9), fast);
+  EXPECT_EQ(screen.macd(screen.close(), 12, 26, 9).signal, macd.signal);
+
+  std::vector<double> expected(5000);
+  trader::batch::ema(history->closes, 21, expected);
+  const auto slowValues = screen.values(slow);
+  for (std::size_t i = 20; i < expected.size(); i++) {
+    EXPECT_DOUBLE_EQ(slowValues[i], expected[i]) << i;
+  }
+
+  const auto mask = screen.evaluate(
+      fast > slow && (macd.macd > macd.signal || !(rsi >= 65)) && rsi > 30);
+  const auto fastValues = screen.values(fast);
+  const auto rsiValues = screen.values(rsi);
+  const auto macdValues = screen.values(macd.macd);
+  const auto signalValues = screen.values(macd.signal);
+  std::size_t set = 0;
+  for (std::size_t i = 0; i < mask.size(); i++) {
+    const bool holds = fastValues[i] > slowValues[i] &&
+                       (macdValues[i] > signalValues[i] ||
+                        !(rsiValues[i] >= 65)) &&
+                       rsiValues[i] > 30;
+    EXPECT_EQ(mask[i], holds) << i;
+    set += holds;
+  }
+  EXPECT_GT(set, 0);
+  // not ready yet
+  EXPECT_EQ(mask[0], 0);
+}
+
+TEST(ScreeningTest, NegationsOfNotReadyIndicatorsAreFalse) {
+  const auto history = randomWalk(7, 100, 18000, start);
+  Screen screen(*history);
+  const Column rsi = screen.rsi(screen.close(), 14);
+  const auto rsiValues = screen.values(rsi);
+  const auto notOverbought = screen.evaluate(!(rsi >= 65));
+  const auto twice = screen.evaluate(!!(rsi >= 65));
+  const auto either = screen.evaluate(!(rsi >= 65 || screen.close() > 0));
+  std::size_t notReady = 0;
+  for (std::size_t i = 0; i < rsiValues.size(); i++) {
+    if (std::isnan(rsiValues[i])) {
+      notReady++;
+      EXPECT_EQ(notOverbought[i], 0) << i;
+      EXPECT_EQ(twice[i], 0) << i;
+    } else {
+      EXPECT_EQ(notOverbought[i], !(rsiValues[i] >= 65)) << i;
+      EXPECT_EQ(twice[i], rsiValues[i] >= 65) << i;
+    }
+    EXPECT_EQ(either[i], 0) << i;
+  }
+  EXPECT_GT(notReady, 0);
+}
+
+TEST(ScreeningTest, RejectsColumnsOfOtherScreens) {
+  const auto history = randomWalk(7, 100, 18000, start);
+  Screen screen(*history);
+  EXPECT_THROW(screen.values({5}), std::invalid_argument);
+  EXPECT_THROW(screen.ema({5}, 3), std::invalid_argument);
+  EXPECT_THROW(screen.evaluate(Column{5} > 1.0), std::invalid_argument);
+}
+
+TEST(ScreeningTest, FillsProfitTakersAndStopLosses) {
+  const auto history = stream({
+      {100, 100, 100, 100},
+      {100, 101, 99.5, 101}, // entry signal
+      {101, 102, 100.5, 99}, // entry at 101
+      {101.5, 104.5, 101, 100}, // profit taker at 104
+      {100, 100, 100, 100},
+      {100, 101, 100, 101}, // entry signal
+      {101, 101, 101, 100}, // entry at 101
+      {100, 105, 98, 100}, // both, the stop loss at 99 wins
+      {100, 100, 100, 100},
+  });
+  Screen screen(*history);
+  const ScreeningResult result = screen.run(
+      {.entry = screen.close() > 100.5, .profitOffset = 3, .stopLossOffset = 2});
+  EXPECT_EQ(result.trades, 2);
+  EXPECT_EQ(result.profitTakers, 1);
+  EXPECT_EQ(result.stopLosses, 1);
+  EXPECT_EQ(result.ruleExits, 0);
+  EXPECT_DOUBLE_EQ(result.profit, 1);
+  EXPECT_DOUBLE_EQ(result.maxDrawdown, 2);
+  EXPECT_FALSE(result.openAtEnd);
+}
+
+TEST(ScreeningTest, FillsShortBrackets) {
+  const auto history = stream({
+      {100, 100, 99, 99}, // entry signal
+      {99, 99, 99, 99}, // entry at 99, the entry candle is not checked
+      {99, 99.5, 96, 97}, // profit taker at 97, entry signal
+      {97, 97, 97, 97}, // entry at 97
+      {97, 97, 97, 97},
+  });
+  Screen screen(*history);
+  const ScreeningResult result =
+      screen.run({.entry = screen.close() < 99.5,
+                  .direction = OrderDirection::SELL,
+                  .profitOffset = 2,
+                  .stopLossOffset = 1});
+  EXPECT_EQ(result.trades, 2);
+  EXPECT_EQ(result.profitTakers, 1);
+  EXPECT_EQ(result.stopLosses, 0);
+  EXPECT_TRUE(result.openAtEnd);
+  // the second position is valued at the last close
+  EXPECT_DOUBLE_EQ(result.profit, 2);
+}
+
+TEST(ScreeningTest, ExitsOnRules) {
+  const auto history = stream({
+      {100, 100, 100, 100},
+      {100, 101, 100, 101}, // entry signal
+      {101, 101, 100, 100}, // entry at 101, exit signal
+      {99, 101, 99, 101}, // exit at 99, entry signal
+      {102, 102, 102, 102}, // entry at 102
+      {102, 103, 102, 103},
+  });
+  Screen screen(*history);
+  const ScreeningResult result =
+      screen.run({.entry = screen.close() > 100.5,
+                  .profitOffset = 100,
+                  .stopLossOffset = 100,
+                  .exit = screen.close() < 100.5});
+  EXPECT_EQ(result.trades, 2);
+  EXPECT_EQ(result.ruleExits, 1);
+  EXPECT_EQ(result.profitTakers + result.stopLosses, 0);
+  EXPECT_TRUE(result.openAtEnd);
+  EXPECT_DOUBLE_EQ(result.profit, -1);
+  EXPECT_DOUBLE_EQ(result.maxDrawdown, 2);
+}
+
+TEST(ScreeningTest, FoldsBarsIntoCandles) {
+  // 25 minutes and a bit of 5 second bars
+  const auto history = randomWalk(7, 25 * 12 + 5, 18000, start);
+  Screen screen(*history, 60);
+  ASSERT_EQ(screen.size(), 25);
+  const auto highs = screen.values(screen.high());
+  const auto closes = screen.values(screen.close());
+  for (std::size_t candle = 0; candle < screen.size(); candle++) {
+    double high = history->highs[candle * 12];
+    for (std::size_t bar = candle * 12; bar < (candle + 1) * 12; bar++) {
+      high = std::max(high, history->highs[bar]);
+    }
+    EXPECT_DOUBLE_EQ(highs[candle], high);
+    EXPECT_DOUBLE_EQ(closes[candle], history->closes[candle * 12 + 11]);
+  }
+}
@@ -17,45 +17,45 @@ protected:
   Bar belowTriggerPriceBar{
       30, 500, 99,
       45, 55,  70,
-      69, 69,  boost::posix_time::second_clock::universal_time()};
+      69, 69,  midas::utcNow()};
   Bar aboveTriggerPriceBar{
       30,  500, 205,
       101, 107, 205,
-      69,  69,  boost::posix_time::second_clock::universal_time()};
+      69,  69,  midas::utcNow()};
   Bar overlappingTriggerPriceBar{
       30, 500, 205,
       98, 200, 205,
-      69, 69,  boost::posix_time::second_clock::universal_time()};
+      69, 69,  midas::utcNow()};
 
   Bar overlappingBracketStop{
       30, 500, 104,
       45, 60,  100,
-      69, 69,  boost::posix_time::second_clock::universal_time()};
+      69, 69,  midas::utcNow()};
 
   Bar belowBracketStop{
       30, 500, 30,
       10, 15,  25,
-      69, 69,  boost::posix_time::second_clock::universal_time()};
+      69, 69,  midas::utcNow()};
 
   Bar aboveBracketStop{
       30, 500, 85,
       60, 60,  79,
-      69, 69,  boost::posix_time::second_clock::universal_time()};
+      69, 69,  midas::utcNow()};
 
   Bar overlappingBracketLimit{
       30,  500, 160,
       100, 60,  100,
-      69,  69,  boost::posix_time::second_clock::universal_time()};
+      69,  69,  midas::utcNow()};
 
   Bar belowBracketLimit{
       30,  500, 105,
       100, 100, 100,
-      69,  69,  boost::posix_time::second_clock::universal_time()};
+      69,  69,  midas::utcNow()};
 
   Bar aboveBracketLimit{
       30,  500, 200,
       180, 190, 195,
-      69,  69,  boost::posix_time::second_clock::universal_time()};
+      69,  69,  midas::utcNow()};
 
   std::unique_ptr<Order> createSimpleOrder(OrderDirection direction,
                                            ExecutionType execution) {
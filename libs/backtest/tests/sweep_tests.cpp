@@ -0,0 +1,116 @@
+#include "backtest/sweep.hpp"
+#include "broker-interface/instruments.hpp"
+#include "data/data_stream.hpp"
+#include "random_walk.hpp"
+#include "trader/trader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas;
+using namespace backtest;
+using namespace backtest::tests;
+
+TEST(ParameterSpaceTest, GridTakesEveryCombination) {
+  sweep::ParameterSpace space;
+  space.add({"fast", 3, 7, 2}).add({"profit", 4, 6});
+  const std::vector<sweep::parameters_t> expected{
+      {{"fast", 3}, {"profit", 4}}, {{"fast", 3}, {"profit", 6}},
+      {{"fast", 5}, {"profit", 4}}, {{"fast", 5}, {"profit", 6}},
+      {{"fast", 7}, {"profit", 4}}, {{"fast", 7}, {"profit", 6}},
+  };
+  EXPECT_EQ(space.grid(), expected);
+}
+
+TEST(ParameterSpaceTest, RejectsInvalidDimensions) {
+  sweep::ParameterSpace space;
+  EXPECT_THROW(space.add({"fast", 7, 3}), std::invalid_argument);
+  EXPECT_THROW(space.add({"fast", 3, 7, -1}), std::invalid_argument);
+  space.add({"fast", 3, 7, 1});
+  EXPECT_THROW(space.add({"fast", 1, 2}), std::invalid_argument);
+}
+
+TEST(ParameterSpaceTest, RandomPointsSitOnSteps) {
+  sweep::ParameterSpace space;
+  space.add({"fast", 3, 20, 1}).add({"profit", 1, 10});
+  const auto points = space.random(200, 5);
+  ASSERT_EQ(points.size(), 200);
+  for (const auto &point : points) {
+    const double fast = point.at("fast");
+    EXPECT_EQ(fast, std::round(fast));
+    EXPECT_GE(fast, 3);
+    EXPECT_LE(fast, 20);
+    EXPECT_GE(point.at("profit"), 1);
+    EXPECT_LE(point.at("profit"), 10);
+  }
+  EXPECT_EQ(space.random(200, 5), points);
+}
+
+TEST(ParameterSpaceTest, LatinHypercubeSamplesEveryStratumOnce) {
+  sweep::ParameterSpace space;
+  space.add({"fast", 0, 100}).add({"profit", 0, 10});
+  const auto points = space.latinHypercube(10, 3);
+  ASSERT_EQ(points.size(), 10);
+  std::set<int> fastStrata, profitStrata;
+  for (const auto &point : points) {
+    fastStrata.insert(static_cast<int>(point.at("fast") / 10));
+    profitStrata.insert(static_cast<int>(point.at("profit")));
+  }
+  EXPECT_EQ(fastStrata.size(), 10);
+  EXPECT_EQ(profitStrata.size(), 10);
+}
+
+TEST(SweepTest, RanksIndependentlyOfWorkers) {
+  const auto history = randomWalk(11, 17280);
+  sweep::ParameterSpace space;
+  space.add({"fast", 3, 6, 1}).add({"profit", 3, 6, 3});
+  const auto parameters = space.grid();
+  const sweep::Table serial =
+      sweep::run(InstrumentEnum::MicroNasdaqFutures, history, parameters,
+                 momentum, {.concurrency = 1});
+  const sweep::Table parallel =
+      sweep::run(InstrumentEnum::MicroNasdaqFutures, history, parameters,
+                 momentum, {.concurrency = 4});
+
+  ASSERT_EQ(serial.runs.size(), parameters.size());
+  ASSERT_EQ(parallel.runs.size(), parameters.size());
+  for (std::size_t i = 0; i < serial.runs.size(); i++) {
+    EXPECT_EQ(parallel.runs[i].index, serial.runs[i].index);
+    EXPECT_EQ(parallel.runs[i].parameters,
+              parameters[serial.runs[i].index]);
+    EXPECT_EQ(parallel.runs[i].summary.numberOfEntryOrdersTriggered,
+              serial.runs[i].summary.numberOfEntryOrdersTriggered);
+    EXPECT_EQ(parallel.runs[i].summary.endingBalance,
+              serial.runs[i].summary.endingBalance);
+    EXPECT_EQ(parallel.runs[i].score, serial.runs[i].summary.endingBalance);
+  }
+  EXPECT_TRUE(std::ranges::is_sorted(serial.runs, std::greater{},
+                                     &sweep::Run::score));
+}
+
+TEST(SweepTest, RunMatchesSingleBacktest) {
+  const auto history = randomWalk(11, 17280);
+  const sweep::parameters_t parameters{
+      {"fast", trader::MomentumTrader::defaultParameters.fastMATimePeriod},
+      {"profit", trader::MomentumTrader::defaultParameters.profitOffset}};
+  const sweep::Table table = sweep::run(
+      InstrumentEnum::MicroNasdaqFutures, history, {parameters}, momentum);
+  const BacktestResult single = replayBacktest(
+      InstrumentEnum::MicroNasdaqFutures, history,
+      [](const trader::CandleSource &source,
+         std::shared_ptr<OrderManager> orderManager) {
+        return trader::createTrader(trader::TraderType::MomentumTrader,
+                                    source, orderManager,
+                                    InstrumentEnum::MicroNasdaqFutures, 1);
+      });
+  ASSERT_EQ(table.runs.size(), 1);
+  EXPECT_EQ(table.runs.front().summary.numberOfEntryOrdersTriggered,
+            single.summary.numberOfEntryOrdersTriggered);
+  EXPECT_EQ(table.runs.front().summary.endingBalance,
+            single.summary.endingBalance);
+}
@@ -0,0 +1,92 @@
+#include "backtest/walk_forward.hpp"
+#include "broker-interface/instruments.hpp"
+#include "data/data_stream.hpp"
+#include "random_walk.hpp"
+#include "trader/trader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas;
+using namespace backtest;
+using namespace backtest::tests;
+
+TEST(WalkForwardTest, SplitsRollingWindows) {
+  const auto history = randomWalk(23, 8640);
+  const walkforward::Result result = walkforward::run(
+      InstrumentEnum::MicroNasdaqFutures, history, candidates(7, 2), momentum,
+      {.inSampleBars = 2000, .outOfSampleBars = 1000});
+
+  ASSERT_EQ(result.windows.size(), 6);
+  std::size_t trades = 0;
+  for (std::size_t w = 0; w < result.windows.size(); w++) {
+    const walkforward::Window &window = result.windows[w];
+    EXPECT_EQ(window.outOfSampleBegin, 2000 + w * 1000);
+    EXPECT_EQ(window.inSampleBegin, window.outOfSampleBegin - 2000);
+    EXPECT_EQ(window.end, window.outOfSampleBegin + 1000);
+    EXPECT_EQ(window.parameters, candidates(7, 2)[window.picked]);
+    EXPECT_EQ(window.outOfSampleScore, window.outOfSample.endingBalance);
+    EXPECT_NEAR(std::accumulate(window.tradeReturns.begin(),
+                                window.tradeReturns.end(), 0.0),
+                window.outOfSample.endingBalance, 1e-6);
+    trades += window.tradeReturns.size();
+  }
+  EXPECT_GT(trades, 0);
+  EXPECT_EQ(result.tradeReturns.size(), trades);
+}
+
+TEST(WalkForwardTest, AnchorsInSampleParts) {
+  const auto history = randomWalk(23, 8640);
+  const walkforward::Result result = walkforward::run(
+      InstrumentEnum::MicroNasdaqFutures, history, candidates(7, 2), momentum,
+      {.inSampleBars = 4000, .outOfSampleBars = 2000, .anchored = true});
+
+  ASSERT_EQ(result.windows.size(), 2);
+  for (const walkforward::Window &window : result.windows) {
+    EXPECT_EQ(window.inSampleBegin, 0);
+  }
+  EXPECT_EQ(result.windows[1].outOfSampleBegin, 6000);
+}
+
+TEST(WalkForwardTest, IndependentOfWorkers) {
+  const auto history = randomWalk(23, 8640);
+  const walkforward::Result serial = walkforward::run(
+      InstrumentEnum::MicroNasdaqFutures, history, candidates(7, 2), momentum,
+      {.inSampleBars = 3000,
+       .outOfSampleBars = 1500,
+       .search = {.concurrency = 1}});
+  const walkforward::Result parallel = walkforward::run(
+      InstrumentEnum::MicroNasdaqFutures, history, candidates(7, 2), momentum,
+      {.inSampleBars = 3000,
+       .outOfSampleBars = 1500,
+       .search = {.concurrency = 4}});
+
+  ASSERT_EQ(serial.windows.size(), parallel.windows.size());
+  for (std::size_t w = 0; w < serial.windows.size(); w++) {
+    EXPECT_EQ(serial.windows[w].picked, parallel.windows[w].picked);
+    EXPECT_EQ(serial.windows[w].outOfSample.endingBalance,
+              parallel.windows[w].outOfSample.endingBalance);
+  }
+  EXPECT_EQ(serial.tradeReturns, parallel.tradeReturns);
+}
+
+TEST(WalkForwardTest, RejectsInvalidWindows) {
+  const auto history = randomWalk(23, 8640);
+  EXPECT_THROW(walkforward::run(InstrumentEnum::MicroNasdaqFutures, history,
+                                candidates(7, 2), momentum,
+                                {.inSampleBars = 0, .outOfSampleBars = 100}),
+               std::invalid_argument);
+  EXPECT_THROW(walkforward::run(InstrumentEnum::MicroNasdaqFutures, history,
+                                candidates(7, 2), momentum,
+                                {.inSampleBars = 8000, .outOfSampleBars = 1000}),
+               std::invalid_argument);
+  EXPECT_THROW(walkforward::run(InstrumentEnum::MicroNasdaqFutures, history,
+                                {}, momentum,
+                                {.inSampleBars = 100, .outOfSampleBars = 100}),
+               std::invalid_argument);
+}
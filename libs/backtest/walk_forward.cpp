@@ -0,0 +1,116 @@
+#include "backtest/walk_forward.hpp"
+#include "replay.hpp"
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+using namespace midas::backtest::walkforward;
+using midas::backtest::sweep::rankOf;
+
+namespace {
+std::vector<Window> splitWindows(std::size_t bars, const Options &options) {
+  if (options.inSampleBars == 0 || options.outOfSampleBars == 0) {
+    throw std::invalid_argument(
+        "Walk forward windows need in and out of sample bars");
+  }
+  const std::size_t step =
+      options.step == 0 ? options.outOfSampleBars : options.step;
+  std::vector<Window> windows;
+  for (std::size_t outOfSampleBegin = options.inSampleBars;
+       outOfSampleBegin + options.outOfSampleBars <= bars;
+       outOfSampleBegin += step) {
+    Window window{};
+    window.inSampleBegin =
+        options.anchored ? 0 : outOfSampleBegin - options.inSampleBars;
+    window.outOfSampleBegin = outOfSampleBegin;
+    window.end = outOfSampleBegin + options.outOfSampleBars;
+    windows.push_back(std::move(window));
+  }
+  if (windows.empty()) {
+    throw std::invalid_argument("History is shorter than a walk forward "
+                                "window");
+  }
+  return windows;
+}
+} // namespace
+
+Result midas::backtest::walkforward::run(
+    InstrumentEnum instrument, std::shared_ptr<DataStream> history,
+    const std::vector<sweep::parameters_t> &candidates,
+    sweep::trader_factory_t traderFactory, const Options &options) {
+  if (candidates.empty()) {
+    throw std::invalid_argument("Walk forward needs candidate parameters");
+  }
+  Result result{.windows = splitWindows(history->size(), options),
+                .tradeReturns = {},
+                .efficiency = 0};
+  const auto replay = [&](const sweep::parameters_t &parameters,
+                          std::size_t firstBar, std::size_t endBar) {
+    Replay replay(
+        instrument, history,
+        [&](const trader::CandleSource &source,
+            std::shared_ptr<midas::OrderManager> orderManager) {
+          return traderFactory(parameters, source, orderManager);
+        },
+        options.search.mode, firstBar);
+    replay.advance(endBar);
+    return std::make_pair(replay.summary(), replay.tradeReturns());
+  };
+  std::vector<double> inSampleScores(result.windows.size() *
+                                     candidates.size());
+  tbb::task_arena arena(options.search.workers());
+  arena.execute([&] {
+    // every candidate of every window at once, replays are independent
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, inSampleScores.size(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+          for (std::size_t i = range.begin(); i < range.end(); i++) {
+            const Window &window = result.windows[i / candidates.size()];
+            inSampleScores[i] = options.search.scoreOf(
+                replay(candidates[i % candidates.size()], window.inSampleBegin,
+                       window.outOfSampleBegin)
+                    .first);
+          }
+        });
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, result.windows.size(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+          for (std::size_t w = range.begin(); w < range.end(); w++) {
+            Window &window = result.windows[w];
+            window.picked = 0;
+            window.inSampleScore = inSampleScores[w * candidates.size()];
+            for (std::size_t c = 1; c < candidates.size(); c++) {
+              const double candidateScore =
+                  inSampleScores[w * candidates.size() + c];
+              if (rankOf(candidateScore) > rankOf(window.inSampleScore)) {
+                window.picked = c;
+                window.inSampleScore = candidateScore;
+              }
+            }
+            window.parameters = candidates[window.picked];
+            std::tie(window.outOfSample, window.tradeReturns) =
+                replay(window.parameters, window.outOfSampleBegin, window.end);
+            window.outOfSampleScore =
+                options.search.scoreOf(window.outOfSample);
+          }
+        });
+  });
+  double inSampleRate = 0, outOfSampleRate = 0;
+  for (const Window &window : result.windows) {
+    inSampleRate += window.inSampleScore /
+                    (window.outOfSampleBegin - window.inSampleBegin);
+    outOfSampleRate += window.outOfSampleScore /
+                       (window.end - window.outOfSampleBegin);
+    result.tradeReturns.insert(result.tradeReturns.end(),
+                               window.tradeReturns.begin(),
+                               window.tradeReturns.end());
+  }
+  result.efficiency = inSampleRate == 0
+                          ? std::numeric_limits<double>::quiet_NaN()
+                          : outOfSampleRate / inSampleRate;
+  return result;
+}
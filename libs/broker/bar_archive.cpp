@@ -0,0 +1,213 @@
+#include "data/bar_archive.hpp"
+#include "exceptions/archive_error.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+
+namespace {
+enum ColumnIndex {
+  TimestampsColumn,
+  OpensColumn,
+  HighsColumn,
+  LowsColumn,
+  ClosesColumn,
+  WapsColumn,
+  VolumesColumn,
+  TradeCountsColumn,
+  NumberOfColumns
+};
+
+constexpr std::array<char, 8> archiveMagic{'M', 'I', 'D', 'A',
+                                           'S', 'B', 'A', 'R'};
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+constexpr std::size_t columnAlignment = 64;
+
+constexpr std::array<std::size_t, NumberOfColumns> columnElementSizes{
+    sizeof(std::int64_t), sizeof(double),        sizeof(double),
+    sizeof(double),       sizeof(double),        sizeof(double),
+    sizeof(double),       sizeof(std::uint32_t),
+};
+
+inline std::uint64_t alignUp(std::uint64_t offset) {
+  return (offset + columnAlignment - 1) / columnAlignment * columnAlignment;
+}
+} // namespace
+
+namespace midas {
+struct BarArchiveHeader {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint32_t byteOrderMark;
+  std::uint32_t barSizeSeconds;
+  std::uint32_t columnCount;
+  std::uint64_t barCount;
+  std::array<std::uint64_t, NumberOfColumns> columnOffsets;
+};
+} // namespace midas
+
+static void writeColumn(std::ofstream &stream, std::uint64_t offset,
+                        const void *data, std::size_t bytes) {
+  // pad up to the aligned column start
+  static const std::array<char, columnAlignment> padding{};
+  const auto position = static_cast<std::uint64_t>(stream.tellp());
+  stream.write(padding.data(), offset - position);
+  stream.write(static_cast<const char *>(data), bytes);
+}
+
+void midas::BarArchive::write(const std::filesystem::path &path,
+                              const DataStream &data, std::size_t begin,
+                              std::size_t end) {
+  end = std::min(end, data.size());
+  begin = std::min(begin, end);
+  const std::size_t count = end - begin;
+
+  BarArchiveHeader header{.magic = archiveMagic,
+                          .version = formatVersion,
+                          .byteOrderMark = byteOrderMark,
+                          .barSizeSeconds = data.barSizeSeconds,
+                          .columnCount = NumberOfColumns,
+                          .barCount = count,
+                          .columnOffsets = {}};
+  std::uint64_t offset = alignUp(sizeof(BarArchiveHeader));
+  for (std::size_t column = 0; column < NumberOfColumns; column++) {
+    header.columnOffsets[column] = offset;
+    offset = alignUp(offset + count * columnElementSizes[column]);
+  }
+
+  std::filesystem::path temporaryPath(path);
+  temporaryPath += ".tmp";
+  {
+    std::ofstream stream(temporaryPath, std::ios::out | std::ios::binary |
+                                            std::ios::trunc);
+    if (!stream) {
+      throw ArchiveError("Unable to open " + temporaryPath.string() +
+                         " for writing");
+    }
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    const auto &offsets = header.columnOffsets;
+    static_assert(sizeof(Timestamp) == sizeof(std::int64_t));
+    writeColumn(stream, offsets[TimestampsColumn],
+                data.timestamps.data() + begin, count * sizeof(std::int64_t));
+    writeColumn(stream, offsets[OpensColumn], data.opens.data() + begin,
+                count * sizeof(double));
+    writeColumn(stream, offsets[HighsColumn], data.highs.data() + begin,
+                count * sizeof(double));
+    writeColumn(stream, offsets[LowsColumn], data.lows.data() + begin,
+                count * sizeof(double));
+    writeColumn(stream, offsets[ClosesColumn], data.closes.data() + begin,
+                count * sizeof(double));
+    writeColumn(stream, offsets[WapsColumn], data.waps.data() + begin,
+                count * sizeof(double));
+    writeColumn(stream, offsets[VolumesColumn], data.volumes.data() + begin,
+                count * sizeof(double));
+    static_assert(sizeof(unsigned int) == sizeof(std::uint32_t));
+    writeColumn(stream, offsets[TradeCountsColumn],
+                data.tradeCounts.data() + begin,
+                count * sizeof(std::uint32_t));
+    if (!stream) {
+      throw ArchiveError("Failed writing " + temporaryPath.string());
+    }
+  }
+  std::filesystem::rename(temporaryPath, path);
+}
+
+midas::BarArchive::BarArchive(const std::filesystem::path &path) {
+  try {
+    file = boost::interprocess::file_mapping(path.c_str(),
+                                             boost::interprocess::read_only);
+    region =
+        boost::interprocess::mapped_region(file, boost::interprocess::read_only);
+  } catch (const boost::interprocess::interprocess_exception &e) {
+    throw ArchiveError("Unable to map " + path.string() + ": " + e.what());
+  }
+  if (region.get_size() < sizeof(BarArchiveHeader)) {
+    throw ArchiveError(path.string() + " is too small to be a bar archive");
+  }
+  header = static_cast<const BarArchiveHeader *>(region.get_address());
+  if (header->magic != archiveMagic) {
+    throw ArchiveError(path.string() + " is not a bar archive");
+  }
+  if (header->byteOrderMark != byteOrderMark) {
+    throw ArchiveError(path.string() + " was written with a different byte "
+                                       "order");
+  }
+  if (header->version != formatVersion ||
+      header->columnCount != NumberOfColumns) {
+    throw ArchiveError("Unsupported bar archive version " +
+                       std::to_string(header->version) + " in " +
+                       path.string());
+  }
+  for (std::size_t column = 0; column < NumberOfColumns; column++) {
+    const std::uint64_t end = header->columnOffsets[column] +
+                              header->barCount * columnElementSizes[column];
+    if (header->columnOffsets[column] % columnAlignment != 0 ||
+        end > region.get_size()) {
+      throw ArchiveError(path.string() + " is truncated or corrupt");
+    }
+  }
+  region.advise(boost::interprocess::mapped_region::advice_sequential);
+}
+
+template <typename T>
+std::span<const T> midas::BarArchive::column(std::size_t index) const {
+  const char *base = static_cast<const char *>(region.get_address());
+  return std::span<const T>(
+      reinterpret_cast<const T *>(base + header->columnOffsets[index]),
+      header->barCount);
+}
+
+unsigned int midas::BarArchive::barSizeSeconds() const {
+  return header->barSizeSeconds;
+}
+
+std::size_t midas::BarArchive::size() const { return header->barCount; }
+
+std::span<const midas::Timestamp> midas::BarArchive::timestamps() const {
+  return column<Timestamp>(TimestampsColumn);
+}
+
+std::span<const double> midas::BarArchive::opens() const {
+  return column<double>(OpensColumn);
+}
+
+std::span<const double> midas::BarArchive::highs() const {
+  return column<double>(HighsColumn);
+}
+
+std::span<const double> midas::BarArchive::lows() const {
+  return column<double>(LowsColumn);
+}
+
+std::span<const double> midas::BarArchive::closes() const {
+  return column<double>(ClosesColumn);
+}
+
+std::span<const double> midas::BarArchive::waps() const {
+  return column<double>(WapsColumn);
+}
+
+std::span<const double> midas::BarArchive::volumes() const {
+  return column<double>(VolumesColumn);
+}
+
+std::span<const std::uint32_t> midas::BarArchive::tradeCounts() const {
+  return column<std::uint32_t>(TradeCountsColumn);
+}
+
+
+std::shared_ptr<midas::DataStream> midas::BarArchive::toDataStream() const {
+  auto stream = std::make_shared<DataStream>(barSizeSeconds());
+  const auto copyColumn = [](auto source, auto &destination) {
+    destination.assign(source.begin(), source.end());
+  };
+  copyColumn(opens(), stream->opens);
+  copyColumn(highs(), stream->highs);
+  copyColumn(lows(), stream->lows);
+  copyColumn(closes(), stream->closes);
+  copyColumn(waps(), stream->waps);
+  copyColumn(volumes(), stream->volumes);
+  copyColumn(tradeCounts(), stream->tradeCounts);
+  copyColumn(timestamps(), stream->timestamps);
+  return stream;
+}
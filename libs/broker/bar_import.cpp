@@ -1,17 +1,230 @@
 #include "data/bar.hpp"
-#include <ranges>
+#include "data/export.hpp"
+#include "iso_timestamp.hpp"
+#include <algorithm>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <numeric>
+#include <thread>
+
+namespace {
+/**
+ * Parses a comma terminated field and advances cursor past the separator
+ */
+template <typename T>
+inline bool parseField(const char *&cursor, const char *end, T &value) {
+  const auto [fieldEnd, error] = std::from_chars(cursor, end, value);
+  if (error != std::errc() || (fieldEnd != end && *fieldEnd != ',')) {
+    return false;
+  }
+  cursor = fieldEnd == end ? end : fieldEnd + 1;
+  return true;
+}
+
+/**
+ * Parses a line in the CSV export format
+ * datetime,high,open,close,low,volume,trades,wap,barSizeSeconds
+ * Does not allocate.
+ */
+bool parseBarLine(std::string_view line, midas::Bar &bar) {
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+  const std::size_t timestampEnd = line.find(',');
+  if (timestampEnd == std::string_view::npos ||
+      !midas::internal::decodeIsoTimestamp(line.substr(0, timestampEnd),
+                                           bar.utcTime)) {
+    return false;
+  }
+  const char *cursor = line.data() + timestampEnd + 1;
+  const char *end = line.data() + line.size();
+  return parseField(cursor, end, bar.high) &&
+         parseField(cursor, end, bar.open) &&
+         parseField(cursor, end, bar.close) &&
+         parseField(cursor, end, bar.low) &&
+         parseField(cursor, end, bar.volume) &&
+         parseField(cursor, end, bar.tradeCount) &&
+         parseField(cursor, end, bar.wap) &&
+         parseField(cursor, end, bar.barSizeSeconds) && cursor == end;
+}
+
+inline bool isBlank(std::string_view line) {
+  return line.empty() || line == "\r";
+}
+
+/**
+ * Calls func for every non blank line in [begin, end)
+ */
+template <typename Func>
+void forEachLine(const char *begin, const char *end, Func func) {
+  while (begin < end) {
+    const char *lineEnd =
+        static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+    if (lineEnd == nullptr) {
+      lineEnd = end;
+    }
+    const std::string_view line(begin, lineEnd - begin);
+    if (!isBlank(line)) {
+      func(line);
+    }
+    begin = lineEnd + 1;
+  }
+}
+
+/**
+ * Runs func(chunkIndex) for every chunk on its own thread and rethrows the
+ * first failure once all threads have joined.
+ */
+template <typename Func> void runChunks(std::size_t numChunks, Func func) {
+  std::vector<std::exception_ptr> failures(numChunks);
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(numChunks);
+    for (std::size_t chunk = 0; chunk < numChunks; chunk++) {
+      workers.emplace_back([&failures, &func, chunk] {
+        try {
+          func(chunk);
+        } catch (...) {
+          failures[chunk] = std::current_exception();
+        }
+      });
+    }
+  }
+  for (auto &failure : failures) {
+    if (failure) {
+      std::rethrow_exception(failure);
+    }
+  }
+}
+
+/**
+ * Parses line into the pre sized columns of data at index
+ */
+void storeBar(midas::DataStream &data, std::size_t index,
+              std::string_view line) {
+  midas::Bar bar;
+  if (!parseBarLine(line, bar)) {
+    throw std::invalid_argument("Malformed bar: " + std::string(line));
+  }
+  if (bar.barSizeSeconds != data.barSizeSeconds) {
+    throw std::runtime_error("Non uniform bar sizes " +
+                             std::to_string(bar.barSizeSeconds) + " " +
+                             std::to_string(data.barSizeSeconds));
+  }
+  data.timestamps[index] = bar.utcTime;
+  data.opens[index] = bar.open;
+  data.highs[index] = bar.high;
+  data.lows[index] = bar.low;
+  data.closes[index] = bar.close;
+  data.waps[index] = bar.wap;
+  data.volumes[index] = bar.volume;
+  data.tradeCounts[index] = bar.tradeCount;
+}
+
+// Below this we are better off parsing on a single thread
+constexpr std::size_t minimumChunkBytes = 1 << 20;
+} // namespace
+
 midas::Bar midas::operator>>(const std::string &line, midas::Bar &bar) {
-  auto splitColumns = std::ranges::split_view(line, std::string(","));
-  std::vector<std::string> columns;
-  for (auto column : splitColumns) {
-    columns.emplace_back(std::string_view(column));
-  }
-  bar = midas::Bar(std::stoi(columns[8]), std::stoi(columns[6]),
-                   std::stod(columns[1]), std::stod(columns[4]),
-                   std::stod(columns[2]), std::stod(columns[3]),
-                   std::stod(columns[7]), std::stod(columns[5]),
-                   boost::posix_time::from_iso_extended_string(columns[0])
-
-  );
+  if (!parseBarLine(line, bar)) {
+    throw std::invalid_argument("Malformed bar: " + line);
+  }
   return bar;
-}
\ No newline at end of file
+}
+
+void midas::importCsv(const std::filesystem::path &path, DataStream &data,
+                      unsigned int maxThreads) {
+  boost::interprocess::file_mapping file(path.c_str(),
+                                         boost::interprocess::read_only);
+  if (std::filesystem::file_size(path) == 0) {
+    return;
+  }
+  boost::interprocess::mapped_region region(file,
+                                            boost::interprocess::read_only);
+  region.advise(boost::interprocess::mapped_region::advice_sequential);
+  const char *begin = static_cast<const char *>(region.get_address());
+  const char *end = begin + region.get_size();
+  // skip headers
+  const char *headerEnd =
+      static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+  if (headerEnd == nullptr) {
+    return;
+  }
+  begin = headerEnd + 1;
+
+  // Split into line aligned chunks, one per thread
+  const std::size_t totalBytes = end - begin;
+  const std::size_t numChunks = std::clamp<std::size_t>(
+      totalBytes / minimumChunkBytes, 1, std::max(maxThreads, 1u));
+  std::vector<const char *> boundaries{begin};
+  for (std::size_t chunk = 1; chunk < numChunks; chunk++) {
+    const char *boundary =
+        std::max(begin + totalBytes * chunk / numChunks, boundaries.back());
+    const char *lineEnd = static_cast<const char *>(
+        std::memchr(boundary, '\n', end - boundary));
+    boundaries.push_back(lineEnd == nullptr ? end : lineEnd + 1);
+  }
+  boundaries.push_back(end);
+
+  // First pass counts bars so that every chunk knows where its bars go
+  std::vector<std::size_t> chunkOffsets(numChunks + 1, 0);
+  runChunks(numChunks, [&](std::size_t chunk) {
+    std::size_t count = 0;
+    forEachLine(boundaries[chunk], boundaries[chunk + 1],
+                [&count](std::string_view) { count++; });
+    chunkOffsets[chunk + 1] = count;
+  });
+  std::partial_sum(chunkOffsets.begin(), chunkOffsets.end(),
+                   chunkOffsets.begin());
+
+  const std::size_t previousSize = data.size();
+  const std::size_t newSize = previousSize + chunkOffsets.back();
+  const auto resizeColumns = [&data](std::size_t size) {
+    data.timestamps.resize(size);
+    data.opens.resize(size);
+    data.highs.resize(size);
+    data.lows.resize(size);
+    data.closes.resize(size);
+    data.waps.resize(size);
+    data.volumes.resize(size);
+    data.tradeCounts.resize(size);
+  };
+  resizeColumns(newSize);
+
+  // Second pass parses straight into the columns
+  try {
+    runChunks(numChunks, [&](std::size_t chunk) {
+      std::size_t index = previousSize + chunkOffsets[chunk];
+      forEachLine(
+          boundaries[chunk], boundaries[chunk + 1],
+          [&](std::string_view line) { storeBar(data, index++, line); });
+    });
+  } catch (...) {
+    resizeColumns(previousSize);
+    throw;
+  }
+
+  // Exports are written in order. Anything else, including files that would
+  // land before existing data, goes through the regular ordered insert.
+  const auto firstImported = data.timestamps.begin() + previousSize;
+  const bool ordered =
+      std::is_sorted(firstImported, data.timestamps.end()) &&
+      (previousSize == 0 || firstImported == data.timestamps.end() ||
+       *std::prev(firstImported) <= *firstImported);
+  if (!ordered) {
+    std::vector<Bar> bars;
+    bars.reserve(newSize - previousSize);
+    for (std::size_t index = previousSize; index < newSize; index++) {
+      bars.emplace_back(data.barSizeSeconds, data.tradeCounts[index],
+                        data.highs[index], data.lows[index], data.opens[index],
+                        data.closes[index], data.waps[index],
+                        data.volumes[index], data.timestamps[index]);
+    }
+    resizeColumns(previousSize);
+    data.addBars(bars.begin(), bars.end());
+    data.waitForData(std::chrono::milliseconds(0));
+  }
+}
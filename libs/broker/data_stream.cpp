@@ -1,8 +1,14 @@
 #include "data/data_stream.hpp"
+#include "data/bar_archive.hpp"
 #include <string>
+#include <thread>
 bool midas::DataStream::waitForData(std::chrono::milliseconds timeout) {
   std::vector<midas::Bar> tempBuffer;
-  {
+  if (ring) {
+    if (!waitForRing(tempBuffer, timeout)) {
+      return false;
+    }
+  } else {
     std::unique_lock bufferLock(bufferMutex);
     const bool conditionSatisfied = bufferCv.wait_for(
         bufferLock, timeout, [this] { return !buffer.empty(); });
@@ -10,45 +16,197 @@ bool midas::DataStream::waitForData(std::chrono::milliseconds timeout) {
       // timedout while waiting
       return conditionSatisfied;
     }
-    // We copy bars to our temp storage so we can quickly release our lock and
-    // not block writer thread
-    std::copy(std::cbegin(buffer), std::cend(buffer),
-              std::back_inserter(tempBuffer));
-    buffer.clear();
+    // We take the bars to our temp storage so we can quickly release our lock
+    // and not block writer thread
+    tempBuffer.swap(buffer);
   }
   // Now we can take our time computing values
-  // First we insert into decomposed vectors
-  // Note that it is unknown if we can receive bars out of order or not
-  bool reordered = false;
-  for (auto bar : tempBuffer) {
+  const std::optional<std::size_t> firstChangedIndex = ingest(tempBuffer);
+  if (firstChangedIndex.has_value()) {
+    reorderSignal(evictedBars + firstChangedIndex.value());
+  }
+  updateSignal();
+  // Listeners have seen the new bars, so expired ones can go
+  evictExpired();
+  return true; // we processed the bars
+}
+
+static inline void spinPause() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+void midas::DataStream::setRingIngestPolicy(const RingIngestPolicy &policy) {
+  ringPolicy = policy;
+  spinBudget = policy.maxSpin;
+  ring = std::make_unique<SpscRing<midas::Bar>>(policy.capacity);
+}
+
+bool midas::DataStream::drainRing(std::vector<midas::Bar> &bars) {
+  ring->popAll(bars);
+  if (overflowPending.exchange(false, std::memory_order::acquire)) {
+    std::lock_guard bufferLock(bufferMutex);
+    std::move(buffer.begin(), buffer.end(), std::back_inserter(bars));
+    buffer.clear();
+  }
+  return !bars.empty();
+}
+
+bool midas::DataStream::waitForRing(std::vector<midas::Bar> &bars,
+                                    std::chrono::milliseconds timeout) {
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  const auto deadline = start + timeout;
+  const auto spinDeadline = start + std::min<clock::duration>(spinBudget,
+                                                              timeout);
+  bool parkedOnce = false;
+  while (!drainRing(bars)) {
+    const auto now = clock::now();
+    if (now >= deadline) {
+      return false;
+    }
+    if (now < spinDeadline) {
+      spinPause();
+      continue;
+    }
+    const std::uint32_t ticket = parker.prepareToPark();
+    // a producer may have published between draining and announcing we park
+    if (!ring->empty() || overflowPending.load(std::memory_order::acquire)) {
+      parker.cancelPark();
+      continue;
+    }
+    parkedOnce = true;
+    parker.park(ticket, deadline - now);
+  }
+  if (ringPolicy.adaptiveSpin) {
+    // spinning paid off if we never had to park
+    spinBudget = parkedOnce ? spinBudget / 2
+                            : std::min(ringPolicy.maxSpin,
+                                       std::max(spinBudget * 2,
+                                                std::chrono::microseconds(1)));
+  }
+  return true;
+}
+
+void midas::DataStream::setRetentionPolicy(const RetentionPolicy &policy) {
+  if (policy.blockSize == 0) {
+    throw std::invalid_argument("Retention block size must be positive");
+  }
+  if (policy.spillDirectory.has_value()) {
+    std::filesystem::create_directories(policy.spillDirectory.value());
+  }
+  retention = policy;
+}
+
+void midas::DataStream::evictExpired() {
+  if (!retention.has_value() ||
+      size() < retention->retainedBars + retention->blockSize) {
+    return;
+  }
+  const std::size_t expired = size() - retention->retainedBars;
+  const std::size_t evicted =
+      expired - expired % retention->blockSize; // whole blocks only
+  if (retention->spillDirectory.has_value()) {
+    for (std::size_t begin = 0; begin < evicted;
+         begin += retention->blockSize) {
+      BarArchive::write(retention->spillDirectory.value() /
+                            (std::to_string(evictedBars + begin) + ".bars"),
+                        *this, begin, begin + retention->blockSize);
+    }
+  }
+  // erase keeps the capacity, so a stream at steady state stops allocating
+  const auto evict = [evicted](auto &column) {
+    column.erase(column.begin(), column.begin() + evicted);
+  };
+  evict(timestamps);
+  evict(volumes);
+  evict(waps);
+  evict(closes);
+  evict(opens);
+  evict(lows);
+  evict(highs);
+  evict(tradeCounts);
+  evictedBars += evicted;
+}
+
+void midas::DataStream::storeBar(std::size_t index, const midas::Bar &bar) {
+  timestamps[index] = bar.utcTime;
+  volumes[index] = bar.volume;
+  waps[index] = bar.wap;
+  closes[index] = bar.close;
+  opens[index] = bar.open;
+  lows[index] = bar.low;
+  highs[index] = bar.high;
+  tradeCounts[index] = bar.tradeCount;
+}
+
+void midas::DataStream::moveBar(std::size_t from, std::size_t to) {
+  timestamps[to] = timestamps[from];
+  volumes[to] = volumes[from];
+  waps[to] = waps[from];
+  closes[to] = closes[from];
+  opens[to] = opens[from];
+  lows[to] = lows[from];
+  highs[to] = highs[from];
+  tradeCounts[to] = tradeCounts[from];
+}
+
+std::optional<std::size_t>
+midas::DataStream::ingest(std::vector<midas::Bar> &bars) {
+  for (const auto &bar : bars) {
     if (bar.barSizeSeconds != barSizeSeconds) {
       throw std::runtime_error("Non uniform bar sizes " +
                                std::to_string(bar.barSizeSeconds) + " " +
                                std::to_string(barSizeSeconds));
     }
-    const auto timeUpperBound =
-        std::upper_bound(timestamps.begin(), timestamps.end(), bar.utcTime);
-    // We should always be inserting at the end, unless we receive out of order
-    // data
-    reordered = reordered || (timeUpperBound != timestamps.end());
-    const auto insertionDistance =
-        std::distance(timestamps.begin(), timeUpperBound);
-
-    // Insert data point, they all have the same order
-    timestamps.insert(timeUpperBound, bar.utcTime);
-    volumes.insert(volumes.begin() + insertionDistance, bar.volume);
-    waps.insert(waps.begin() + insertionDistance, bar.wap);
-    closes.insert(closes.begin() + insertionDistance, bar.close);
-    opens.insert(opens.begin() + insertionDistance, bar.open);
-    lows.insert(lows.begin() + insertionDistance, bar.low);
-    highs.insert(highs.begin() + insertionDistance, bar.high);
-    tradeCounts.insert(tradeCounts.begin() + insertionDistance, bar.tradeCount);
-  }
-  if (reordered) {
-    reorderSignal();
   }
-  updateSignal();
-  return true; // we processed the bars
+  // Note that it is unknown if we can receive bars out of order or not.
+  // A stable sort keeps bars with equal timestamps in arrival order, and
+  // existing bars stay ahead of new bars with the same timestamp.
+  const auto byTime = [](const midas::Bar &lhs, const midas::Bar &rhs) {
+    return lhs.utcTime < rhs.utcTime;
+  };
+  if (!std::is_sorted(bars.begin(), bars.end(), byTime)) {
+    std::stable_sort(bars.begin(), bars.end(), byTime);
+  }
+  const std::size_t oldSize = size();
+  const std::size_t newSize = oldSize + bars.size();
+  timestamps.resize(newSize);
+  volumes.resize(newSize);
+  waps.resize(newSize);
+  closes.resize(newSize);
+  opens.resize(newSize);
+  lows.resize(newSize);
+  highs.resize(newSize);
+  tradeCounts.resize(newSize);
+  if (bars.empty()) {
+    return std::nullopt;
+  }
+
+  const std::size_t firstChangedIndex = upperBound(
+      std::span(timestamps.data(), oldSize), bars.front().utcTime);
+  if (firstChangedIndex == oldSize) {
+    // We should always be appending, unless we receive out of order data
+    for (std::size_t index = 0; index < bars.size(); index++) {
+      storeBar(oldSize + index, bars[index]);
+    }
+    return std::nullopt;
+  }
+  // Merge from the back so every affected bar is moved exactly once
+  std::size_t existing = oldSize, incoming = bars.size(), target = newSize;
+  while (incoming > 0) {
+    target--;
+    if (existing > firstChangedIndex &&
+        bars[incoming - 1].utcTime < timestamps[existing - 1]) {
+      moveBar(--existing, target);
+    } else {
+      storeBar(target, bars[--incoming]);
+    }
+  }
+  return firstChangedIndex;
 }
 
 boost::signals2::connection midas::DataStream::addUpdateListener(
@@ -59,4 +217,4 @@ boost::signals2::connection midas::DataStream::addUpdateListener(
 boost::signals2::connection midas::DataStream::addReOrderListener(
     const reorder_signal_t::slot_type &subscriber) {
   return reorderSignal.connect(subscriber);
-}
\ No newline at end of file
+}
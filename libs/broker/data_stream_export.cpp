@@ -1,19 +1,46 @@
 #include "data/export.hpp"
-#include <boost/date_time/posix_time/time_formatters.hpp>
+#include "iso_timestamp.hpp"
+#include <array>
+#include <charconv>
 #include <string>
+#include <vector>
 using namespace std::chrono_literals;
+
+namespace {
+// Longest row is well below this
+constexpr std::size_t maxRowSize = 512;
+constexpr std::size_t writeBlockSize = 1 << 16;
+
+template <typename T> inline char *appendField(char *cursor, T value) {
+  *cursor++ = ',';
+  return std::to_chars(cursor, cursor + 32, value).ptr;
+}
+} // namespace
+
 std::ostream &midas::operator<<(std::ostream &stream, const DataStream &data) {
 
   // First we write the headers
   stream << "datetime,high,open,close,low,volume,trades,wap,barSizeSeconds";
 
+  std::vector<char> buffer(writeBlockSize + maxRowSize);
+  char *cursor = buffer.data();
   for (std::size_t index = 0; index < data.timestamps.size(); index++) {
-    const midas::Bar bar(data.barSizeSeconds, data.tradeCounts[index],
-                         data.highs[index], data.lows[index], data.opens[index],
-                         data.closes[index], data.waps[index],
-                         data.volumes[index], data.timestamps[index]);
-    stream << "\n" << bar;
+    *cursor++ = '\n';
+    cursor = internal::encodeIsoTimestamp(data.timestamps[index], cursor);
+    cursor = appendField(cursor, data.highs[index]);
+    cursor = appendField(cursor, data.opens[index]);
+    cursor = appendField(cursor, data.closes[index]);
+    cursor = appendField(cursor, data.lows[index]);
+    cursor = appendField(cursor, data.volumes[index]);
+    cursor = appendField(cursor, data.tradeCounts[index]);
+    cursor = appendField(cursor, data.waps[index]);
+    cursor = appendField(cursor, data.barSizeSeconds);
+    if (static_cast<std::size_t>(cursor - buffer.data()) >= writeBlockSize) {
+      stream.write(buffer.data(), cursor - buffer.data());
+      cursor = buffer.data();
+    }
   }
+  stream.write(buffer.data(), cursor - buffer.data());
 
   return stream;
 }
@@ -22,11 +49,17 @@ std::istream &midas::operator>>(std::istream &stream, DataStream &data) {
   // skip headers
   std::string line;
   std::getline(stream, line);
+  std::vector<Bar> bars;
   while (std::getline(stream, line)) {
+    if (line.empty()) {
+      continue;
+    }
     Bar bar;
     line >> bar;
-    data.addBars(bar);
+    bars.push_back(bar);
   }
+  // a single hand off rather than a lock and notification per line
+  data.addBars(bars.begin(), bars.end());
   data.waitForData(0ms);
   return stream;
 }
@@ -0,0 +1,152 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+namespace midas::internal {
+
+/**
+ * Days since the unix epoch of a proleptic gregorian date.
+ * See http://howardhinnant.github.io/date_algorithms.html
+ */
+constexpr std::int64_t daysFromCivil(std::int64_t year, unsigned int month,
+                                     unsigned int day) {
+  year -= month <= 2;
+  const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const auto yearOfEra = static_cast<unsigned int>(year - era * 400);
+  const unsigned int dayOfYear =
+      (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const unsigned int dayOfEra =
+      yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + static_cast<std::int64_t>(dayOfEra) - 719468;
+}
+
+struct CivilDate {
+  std::int64_t year;
+  unsigned int month, day;
+};
+
+/**
+ * Inverse of daysFromCivil
+ */
+constexpr CivilDate civilFromDays(std::int64_t days) {
+  days += 719468;
+  const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const auto dayOfEra = static_cast<unsigned int>(days - era * 146097);
+  const unsigned int yearOfEra =
+      (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) /
+      365;
+  const unsigned int dayOfYear =
+      dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const unsigned int monthPrime = (5 * dayOfYear + 2) / 153;
+  const unsigned int day = dayOfYear - (153 * monthPrime + 2) / 5 + 1;
+  const unsigned int month = monthPrime < 10 ? monthPrime + 3 : monthPrime - 9;
+  return {.year = yearOfEra + era * 400 + (month <= 2),
+          .month = month,
+          .day = day};
+}
+
+inline bool parseFixedDigits(const char *text, int count, unsigned int &value) {
+  value = 0;
+  for (int i = 0; i < count; i++) {
+    const unsigned int digit = static_cast<unsigned char>(text[i]) - '0';
+    if (digit > 9) {
+      return false;
+    }
+    value = value * 10 + digit;
+  }
+  return true;
+}
+
+/**
+ * Decodes the extended ISO-8601 format written by the CSV export,
+ * YYYY-MM-DDTHH:MM:SS with an optional fraction of up to nine digits.
+ * No allocation or locale lookups are performed.
+ * @return false if text is not in the expected format
+ */
+inline bool decodeIsoTimestamp(std::string_view text, std::int64_t &nanos) {
+  if (text.size() < 19 || text[4] != '-' || text[7] != '-' ||
+      (text[10] != 'T' && text[10] != ' ') || text[13] != ':' ||
+      text[16] != ':') {
+    return false;
+  }
+  unsigned int year, month, day, hours, minutes, seconds;
+  const char *data = text.data();
+  if (!parseFixedDigits(data, 4, year) ||
+      !parseFixedDigits(data + 5, 2, month) ||
+      !parseFixedDigits(data + 8, 2, day) ||
+      !parseFixedDigits(data + 11, 2, hours) ||
+      !parseFixedDigits(data + 14, 2, minutes) ||
+      !parseFixedDigits(data + 17, 2, seconds) || month < 1 || month > 12 ||
+      day < 1 || day > 31 || hours > 23 || minutes > 59 || seconds > 60) {
+    return false;
+  }
+  std::int64_t fraction = 0;
+  if (text.size() > 19) {
+    const std::size_t digits = text.size() - 20;
+    if (text[19] != '.' || digits == 0 || digits > 9) {
+      return false;
+    }
+    unsigned int fractionDigits;
+    if (!parseFixedDigits(data + 20, static_cast<int>(digits),
+                          fractionDigits)) {
+      return false;
+    }
+    fraction = fractionDigits;
+    for (std::size_t i = digits; i < 9; i++) {
+      fraction *= 10;
+    }
+  }
+  const std::int64_t secondsSinceEpoch =
+      daysFromCivil(year, month, day) * 86400 + hours * 3600 + minutes * 60 +
+      seconds;
+  nanos = secondsSinceEpoch * 1'000'000'000 + fraction;
+  return true;
+}
+
+/**
+ * Writes nanos in the format accepted by decodeIsoTimestamp.
+ * Fractions are only written when non zero.
+ * @param buffer must have room for at least 29 characters
+ * @return pointer past the last written character
+ */
+inline char *encodeIsoTimestamp(std::int64_t nanos, char *buffer) {
+  std::int64_t days = nanos / (86400 * 1'000'000'000LL);
+  std::int64_t remainder = nanos % (86400 * 1'000'000'000LL);
+  if (remainder < 0) {
+    remainder += 86400 * 1'000'000'000LL;
+    days -= 1;
+  }
+  const CivilDate date = civilFromDays(days);
+  const auto secondsOfDay =
+      static_cast<unsigned int>(remainder / 1'000'000'000);
+  auto fraction = static_cast<unsigned int>(remainder % 1'000'000'000);
+  const auto writeDigits = [&buffer](std::uint64_t value, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+      buffer[i] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    }
+    buffer += count;
+  };
+  writeDigits(date.year, 4);
+  *buffer++ = '-';
+  writeDigits(date.month, 2);
+  *buffer++ = '-';
+  writeDigits(date.day, 2);
+  *buffer++ = 'T';
+  writeDigits(secondsOfDay / 3600, 2);
+  *buffer++ = ':';
+  writeDigits(secondsOfDay / 60 % 60, 2);
+  *buffer++ = ':';
+  writeDigits(secondsOfDay % 60, 2);
+  if (fraction != 0) {
+    int digits = 9;
+    while (fraction % 10 == 0) {
+      fraction /= 10;
+      digits--;
+    }
+    *buffer++ = '.';
+    writeDigits(fraction, digits);
+  }
+  return buffer;
+}
+} // namespace midas::internal
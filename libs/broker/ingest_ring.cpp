@@ -0,0 +1,42 @@
+#include "data/ingest_ring.hpp"
+#include <thread>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t) &&
+                  std::atomic<std::uint32_t>::is_always_lock_free,
+              "futex requires a plain 32 bit word");
+
+void midas::Parker::park(std::uint32_t ticket,
+                         std::chrono::nanoseconds timeout) {
+  if (timeout > std::chrono::nanoseconds::zero()) {
+#if defined(__linux__)
+    const auto seconds =
+        std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    const timespec relative{.tv_sec = seconds.count(),
+                            .tv_nsec = (timeout - seconds).count()};
+    // returns immediately if epoch already moved past ticket
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&epoch),
+            FUTEX_WAIT_PRIVATE, ticket, &relative, nullptr, 0);
+#else
+    // no futex, poll at a coarse interval instead
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (epoch.load(std::memory_order::acquire) == ticket &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+#endif
+  }
+  cancelPark();
+}
+
+void midas::Parker::wake() {
+  epoch.fetch_add(1, std::memory_order::release);
+#if defined(__linux__)
+  syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&epoch),
+          FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+}
@@ -3,65 +3,45 @@
 //
 #include "broker-interface/position_tracker.hpp"
 
-static double getInstrumentMultiplier(midas::InstrumentEnum instrument) {
-  switch (instrument) {
-
-  case midas::MicroNasdaqFutures:
-    return 2;
-    break;
-  case midas::MicroSPXFutures:
-    return 5;
-    break;
-  case midas::NVDA:
-    return 1;
-    break;
-  case midas::TSLA:
-    return 1;
-    break;
-  case midas::MicroRussel:
-    return 5;
-    break;
-  }
-  throw std::runtime_error("invalid instrument");
-}
-
 void midas::PositionTracker::handle_position_update(InstrumentEnum instrument,
                                                     int quantity,
                                                     double price) {
   std::scoped_lock lock(mutex);
   auto &position = positions[instrument];
-  double profitAccum{position.total};
+  const TickPrice tickPrice = getInstrumentSpec(instrument).toTicks(price);
+  std::int64_t profitAccum{position.totalTicks};
   if (quantity < 0) {
 
     while (!position.longs.empty() && quantity != 0) {
       auto diff = std::min(std::abs(quantity), position.longs.front().quantity);
-      auto priceDiff = price - position.longs.front().price;
-      profitAccum += priceDiff * diff * getInstrumentMultiplier(instrument);
-      position.longs[0].quantity -= std::abs(quantity);
+      const std::int64_t priceDiff = tickPrice - position.longs.front().price;
+      profitAccum += priceDiff * diff;
+      position.longs[0].quantity -= diff;
       if (position.longs[0].quantity == 0) {
         position.longs.pop_front();
       }
       quantity += diff;
     }
     if (quantity != 0) {
-      position.shorts.push_back({.quantity = quantity, .price = price});
+      position.shorts.push_back({.quantity = quantity, .price = tickPrice});
     }
   } else {
     while (!position.shorts.empty() && quantity != 0) {
       auto diff = std::min(quantity, std::abs(position.shorts.front().quantity));
-      auto priceDiff = price - position.shorts.front().price;
-      profitAccum += priceDiff * diff * getInstrumentMultiplier(instrument);
-      position.shorts[0].quantity -= std::abs(quantity);
+      const std::int64_t priceDiff =
+          tickPrice - position.shorts.front().price;
+      profitAccum += priceDiff * diff;
+      position.shorts[0].quantity += diff;
       if (position.shorts[0].quantity == 0) {
         position.shorts.pop_front();
       }
       quantity -= diff;
     }
     if (quantity != 0) {
-      position.longs.push_back({.quantity = quantity, .price = price});
+      position.longs.push_back({.quantity = quantity, .price = tickPrice});
     }
   }
-  position.total = profitAccum;
+  position.totalTicks = profitAccum;
   realized_pnl_signal();
 }
 
@@ -71,7 +51,8 @@ midas::PositionTracker::getPnl() {
   std::unordered_map<midas::InstrumentEnum, double> realized;
 
   for (auto &[instrument, position] : positions) {
-    realized[instrument] = position.total;
+    realized[instrument] =
+        getInstrumentSpec(instrument).value(position.totalTicks);
   }
   return realized;
 }
@@ -0,0 +1,85 @@
+#include "data/bar_archive.hpp"
+#include "exceptions/archive_error.hpp"
+#include <boost/date_time/posix_time/time_parsers.hpp>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+class BarArchiveTest : public ::testing::Test {
+protected:
+  std::filesystem::path archivePath;
+  midas::DataStream original{5};
+
+  void SetUp() override {
+    archivePath = std::filesystem::temp_directory_path() /
+                  ("bar_archive_test_" +
+                   std::string(::testing::UnitTest::GetInstance()
+                                   ->current_test_info()
+                                   ->name()) +
+                   ".bars");
+    const auto start = midas::fromPtime(
+        boost::posix_time::time_from_string("2025-01-06 14:30:00.000"));
+    for (int i = 0; i < 1000; i++) {
+      original.addBars(midas::Bar(5, 10 + i, 101.25 + i, 99.5 + i, 100 + i,
+                                  100.75 + i, 100.5 + i, 1000 + i,
+                                  start + midas::fromUnixSeconds(5 * i)));
+    }
+    original.waitForData(0ms);
+  }
+
+  void TearDown() override { std::filesystem::remove(archivePath); }
+};
+
+TEST_F(BarArchiveTest, RoundTrip) {
+  midas::BarArchive::write(archivePath, original);
+  midas::BarArchive archive(archivePath);
+  ASSERT_EQ(archive.size(), original.size());
+  EXPECT_EQ(archive.barSizeSeconds(), original.barSizeSeconds);
+
+  auto restored = archive.toDataStream();
+  EXPECT_EQ(restored->barSizeSeconds, original.barSizeSeconds);
+  EXPECT_EQ(restored->timestamps, original.timestamps);
+  EXPECT_EQ(restored->opens, original.opens);
+  EXPECT_EQ(restored->highs, original.highs);
+  EXPECT_EQ(restored->lows, original.lows);
+  EXPECT_EQ(restored->closes, original.closes);
+  EXPECT_EQ(restored->waps, original.waps);
+  EXPECT_EQ(restored->volumes, original.volumes);
+  EXPECT_EQ(restored->tradeCounts, original.tradeCounts);
+}
+
+TEST_F(BarArchiveTest, ColumnViews) {
+  midas::BarArchive::write(archivePath, original);
+  midas::BarArchive archive(archivePath);
+  EXPECT_EQ(archive.closes()[10], original.closes[10]);
+  EXPECT_EQ(archive.tradeCounts()[999], original.tradeCounts[999]);
+  EXPECT_EQ(archive.timestamps()[42], original.timestamps[42]);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(archive.volumes().data()) % 64,
+            0);
+}
+
+TEST_F(BarArchiveTest, EmptyStream) {
+  midas::DataStream empty(5);
+  midas::BarArchive::write(archivePath, empty);
+  midas::BarArchive archive(archivePath);
+  EXPECT_TRUE(archive.empty());
+  EXPECT_EQ(archive.toDataStream()->size(), 0);
+}
+
+TEST_F(BarArchiveTest, RejectsForeignFile) {
+  {
+    std::ofstream stream(archivePath);
+    stream << "datetime,high,open,close,low,volume,trades,wap,barSizeSeconds"
+              "\n2025-01-06T14:30:00,1,1,1,1,1,1,1,5\n";
+  }
+  EXPECT_THROW(midas::BarArchive archive(archivePath), ArchiveError);
+}
+
+TEST_F(BarArchiveTest, RejectsTruncatedFile) {
+  midas::BarArchive::write(archivePath, original);
+  std::filesystem::resize_file(archivePath,
+                               std::filesystem::file_size(archivePath) / 2);
+  EXPECT_THROW(midas::BarArchive archive(archivePath), ArchiveError);
+}
@@ -5,8 +5,9 @@
 
 TEST(DataUnitAssertions, BarIO) {
   std::stringstream streamSimulator;
-  midas::Bar originalBar(30, 100, 500, 333.1, 111.5, 130, 120, 1000,
-                         boost::posix_time::second_clock::universal_time());
+  midas::Bar originalBar(
+      30, 100, 500, 333.1, 111.5, 130, 120, 1000,
+      midas::fromUnixSeconds(midas::utcNow() / midas::nanosPerSecond));
   streamSimulator << originalBar;
   midas::Bar parsed;
   std::string line;
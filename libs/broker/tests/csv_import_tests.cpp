@@ -0,0 +1,138 @@
+#include "data/export.hpp"
+#include <boost/date_time/posix_time/time_parsers.hpp>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+class CsvImportTest : public ::testing::Test {
+protected:
+  std::filesystem::path csvPath;
+  const midas::Timestamp start = midas::fromPtime(
+      boost::posix_time::time_from_string("2025-01-06 14:30:00.000"));
+
+  void SetUp() override {
+    csvPath = std::filesystem::temp_directory_path() /
+              ("csv_import_test_" +
+               std::string(::testing::UnitTest::GetInstance()
+                               ->current_test_info()
+                               ->name()) +
+               ".csv");
+  }
+
+  void TearDown() override { std::filesystem::remove(csvPath); }
+
+  void fill(midas::DataStream &stream, int numBars) {
+    for (int i = 0; i < numBars; i++) {
+      stream.addBars(midas::Bar(5, 10 + i, 21001.25 + i * 0.25, 20999.5 + i,
+                                21000 + i / 3.0, 21000.75 + i, 21000.5 + i,
+                                1000 + i,
+                                start + midas::fromUnixSeconds(5 * i)));
+    }
+    stream.waitForData(0ms);
+  }
+
+  void exportTo(const midas::DataStream &stream) {
+    std::ofstream file(csvPath, std::ios::out);
+    file << stream;
+  }
+
+  static void expectSameColumns(const midas::DataStream &lhs,
+                                const midas::DataStream &rhs) {
+    EXPECT_EQ(lhs.timestamps, rhs.timestamps);
+    EXPECT_EQ(lhs.opens, rhs.opens);
+    EXPECT_EQ(lhs.highs, rhs.highs);
+    EXPECT_EQ(lhs.lows, rhs.lows);
+    EXPECT_EQ(lhs.closes, rhs.closes);
+    EXPECT_EQ(lhs.waps, rhs.waps);
+    EXPECT_EQ(lhs.volumes, rhs.volumes);
+    EXPECT_EQ(lhs.tradeCounts, rhs.tradeCounts);
+  }
+};
+
+TEST_F(CsvImportTest, RoundTrip) {
+  midas::DataStream original(5);
+  fill(original, 500);
+  exportTo(original);
+
+  midas::DataStream imported(5);
+  midas::importCsv(csvPath, imported);
+  ASSERT_EQ(imported.size(), original.size());
+  expectSameColumns(imported, original);
+}
+
+TEST_F(CsvImportTest, ParallelChunksPreserveOrder) {
+  // Large enough to be split into several chunks
+  midas::DataStream original(5);
+  fill(original, 60000);
+  exportTo(original);
+
+  midas::DataStream imported(5);
+  midas::importCsv(csvPath, imported, 4);
+  ASSERT_EQ(imported.size(), original.size());
+  expectSameColumns(imported, original);
+}
+
+TEST_F(CsvImportTest, StreamOperatorMatchesBulkImport) {
+  midas::DataStream original(5);
+  fill(original, 100);
+  exportTo(original);
+
+  midas::DataStream viaStream(5), viaImport(5);
+  std::ifstream file(csvPath);
+  file >> viaStream;
+  midas::importCsv(csvPath, viaImport);
+  expectSameColumns(viaStream, viaImport);
+}
+
+TEST_F(CsvImportTest, OutOfOrderRowsAreSorted) {
+  {
+    std::ofstream file(csvPath);
+    file << "datetime,high,open,close,low,volume,trades,wap,barSizeSeconds\n"
+         << "2025-01-06T14:30:10,3,3,3,3,3,3,3,5\n"
+         << "2025-01-06T14:30:00,1,1,1,1,1,1,1,5\r\n"
+         << "\n"
+         << "2025-01-06T14:30:05,2,2,2,2,2,2,2,5";
+  }
+  midas::DataStream imported(5);
+  midas::importCsv(csvPath, imported);
+  ASSERT_EQ(imported.size(), 3);
+  EXPECT_TRUE(
+      std::is_sorted(imported.timestamps.begin(), imported.timestamps.end()));
+  EXPECT_EQ(imported.closes, std::vector<double>({1, 2, 3}));
+}
+
+TEST_F(CsvImportTest, FractionalSeconds) {
+  midas::Bar bar;
+  std::string("2025-01-06T14:30:00.25,1,2,3,4,5,6,7,5") >> bar;
+  EXPECT_EQ(bar.utcTime, start + 250'000'000);
+  EXPECT_EQ(bar.high, 1);
+  EXPECT_EQ(bar.low, 4);
+  EXPECT_EQ(bar.tradeCount, 6);
+  EXPECT_EQ(bar.barSizeSeconds, 5);
+  std::string("2025-01-06T14:30:00.000000001,1,2,3,4,5,6,7,5") >> bar;
+  EXPECT_EQ(bar.utcTime, start + 1);
+}
+
+TEST_F(CsvImportTest, MalformedRowThrows) {
+  {
+    std::ofstream file(csvPath);
+    file << "datetime,high,open,close,low,volume,trades,wap,barSizeSeconds\n"
+         << "2025-01-06T14:30:00,1,1,1,1,1,1,1,5\n"
+         << "2025-01-06T14:30:05,2,two,2,2,2,2,2,5\n";
+  }
+  midas::DataStream imported(5);
+  EXPECT_THROW(midas::importCsv(csvPath, imported), std::invalid_argument);
+  EXPECT_EQ(imported.size(), 0);
+}
+
+TEST_F(CsvImportTest, NonUniformBarSizeThrows) {
+  {
+    std::ofstream file(csvPath);
+    file << "datetime,high,open,close,low,volume,trades,wap,barSizeSeconds\n"
+         << "2025-01-06T14:30:00,1,1,1,1,1,1,1,30\n";
+  }
+  midas::DataStream imported(5);
+  EXPECT_THROW(midas::importCsv(csvPath, imported), std::runtime_error);
+}
@@ -0,0 +1,188 @@
+#include "data/bar_archive.hpp"
+#include "data/data_stream.hpp"
+#include <boost/date_time/posix_time/time_parsers.hpp>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+class DataStreamTest : public ::testing::Test {
+protected:
+  midas::DataStream stream{5};
+  std::optional<std::size_t> reorderIndex;
+  int updates{0};
+  const midas::Timestamp start = midas::fromPtime(
+      boost::posix_time::time_from_string("2025-01-06 14:30:00.000"));
+
+  void SetUp() override {
+    stream.addReOrderListener(
+        [this](std::size_t index) { reorderIndex = index; });
+    stream.addUpdateListener([this] { updates++; });
+  }
+
+  midas::Bar barAt(int slot, double close) {
+    return midas::Bar(5, 1, close, close, close, close, close, 1,
+                      start + midas::fromUnixSeconds(5 * slot));
+  }
+
+  void add(std::vector<midas::Bar> bars) {
+    stream.addBars(bars.begin(), bars.end());
+    stream.waitForData(0ms);
+  }
+};
+
+TEST_F(DataStreamTest, InOrderBatchAppends) {
+  add({barAt(0, 1), barAt(1, 2)});
+  add({barAt(2, 3), barAt(3, 4)});
+  EXPECT_EQ(stream.closes, std::vector<double>({1, 2, 3, 4}));
+  EXPECT_FALSE(reorderIndex.has_value());
+  EXPECT_EQ(updates, 2);
+}
+
+TEST_F(DataStreamTest, UnsortedBatchAfterExistingDataIsNotAReorder) {
+  add({barAt(0, 1)});
+  add({barAt(3, 4), barAt(1, 2), barAt(2, 3)});
+  EXPECT_EQ(stream.closes, std::vector<double>({1, 2, 3, 4}));
+  EXPECT_FALSE(reorderIndex.has_value());
+}
+
+TEST_F(DataStreamTest, LateBarsAreMergedAndReportLowestChangedIndex) {
+  add({barAt(0, 0), barAt(2, 2), barAt(4, 4), barAt(6, 6)});
+  add({barAt(7, 7), barAt(5, 5), barAt(3, 3)});
+  EXPECT_EQ(stream.closes, std::vector<double>({0, 2, 3, 4, 5, 6, 7}));
+  EXPECT_EQ(stream.opens, stream.closes);
+  EXPECT_EQ(stream.size(), 7);
+  EXPECT_TRUE(
+      std::is_sorted(stream.timestamps.begin(), stream.timestamps.end()));
+  ASSERT_TRUE(reorderIndex.has_value());
+  EXPECT_EQ(reorderIndex.value(), 2);
+}
+
+TEST_F(DataStreamTest, EqualTimestampsKeepArrivalOrder) {
+  add({barAt(0, 0), barAt(1, 1), barAt(2, 2)});
+  add({barAt(1, 10), barAt(1, 11)});
+  EXPECT_EQ(stream.closes, std::vector<double>({0, 1, 10, 11, 2}));
+  ASSERT_TRUE(reorderIndex.has_value());
+  EXPECT_EQ(reorderIndex.value(), 2);
+}
+
+TEST_F(DataStreamTest, NonUniformBarSizeLeavesDataUntouched) {
+  add({barAt(0, 0)});
+  std::vector<midas::Bar> bars{barAt(1, 1),
+                               midas::Bar(30, 1, 1, 1, 1, 1, 1, 1, start)};
+  stream.addBars(bars.begin(), bars.end());
+  EXPECT_THROW(stream.waitForData(0ms), std::runtime_error);
+  EXPECT_EQ(stream.size(), 1);
+}
+
+TEST_F(DataStreamTest, RetentionEvictsWholeBlocks) {
+  stream.setRetentionPolicy({.retainedBars = 3, .blockSize = 4});
+  add({barAt(0, 0), barAt(1, 1), barAt(2, 2), barAt(3, 3), barAt(4, 4),
+       barAt(5, 5)});
+  // 6 bars only exceed the window by 3, less than a block
+  EXPECT_EQ(stream.baseIndex(), 0);
+  add({barAt(6, 6), barAt(7, 7), barAt(8, 8), barAt(9, 9)});
+  EXPECT_EQ(stream.baseIndex(), 4);
+  EXPECT_EQ(stream.endIndex(), 10);
+  EXPECT_EQ(stream.closes, std::vector<double>({4, 5, 6, 7, 8, 9}));
+  EXPECT_EQ(stream.timestamps.front(), barAt(4, 4).utcTime);
+}
+
+TEST_F(DataStreamTest, RetentionCapacityStaysFlat) {
+  stream.setRetentionPolicy({.retainedBars = 16, .blockSize = 64});
+  std::size_t capacity = 0;
+  for (int slot = 0; slot < 10000; slot++) {
+    add({barAt(slot, slot)});
+    if (slot == 1000) {
+      capacity = stream.closes.capacity();
+    }
+  }
+  EXPECT_LT(stream.size(), 16 + 64);
+  EXPECT_EQ(stream.closes.capacity(), capacity);
+  EXPECT_EQ(stream.closes.back(), 9999);
+}
+
+TEST_F(DataStreamTest, ReorderIndexIsAbsolute) {
+  stream.setRetentionPolicy({.retainedBars = 2, .blockSize = 2});
+  add({barAt(0, 0), barAt(2, 2), barAt(4, 4), barAt(6, 6)});
+  ASSERT_EQ(stream.baseIndex(), 2);
+  add({barAt(5, 5)});
+  ASSERT_TRUE(reorderIndex.has_value());
+  EXPECT_EQ(reorderIndex.value(), 3);
+}
+
+TEST_F(DataStreamTest, RetentionSpillsEvictedBlocks) {
+  const auto spillDirectory =
+      std::filesystem::temp_directory_path() / "data_stream_spill_test";
+  std::filesystem::remove_all(spillDirectory);
+  stream.setRetentionPolicy({.retainedBars = 1,
+                             .blockSize = 2,
+                             .spillDirectory = spillDirectory});
+  add({barAt(0, 0), barAt(1, 1), barAt(2, 2), barAt(3, 3), barAt(4, 4)});
+  ASSERT_EQ(stream.baseIndex(), 4);
+  midas::BarArchive first(spillDirectory / "0.bars");
+  midas::BarArchive second(spillDirectory / "2.bars");
+  ASSERT_EQ(first.size(), 2);
+  EXPECT_EQ(first.closes()[1], 1);
+  EXPECT_EQ(second.closes()[0], 2);
+  EXPECT_EQ(second.timestamps()[1], barAt(3, 3).utcTime);
+  std::filesystem::remove_all(spillDirectory);
+}
+
+TEST_F(DataStreamTest, RingIngestTimesOutWithoutData) {
+  stream.setRingIngestPolicy({.capacity = 8});
+  EXPECT_FALSE(stream.waitForData(1ms));
+  EXPECT_EQ(updates, 0);
+}
+
+TEST_F(DataStreamTest, RingIngestOverflowFallsBackToBuffer) {
+  stream.setRingIngestPolicy({.capacity = 4});
+  std::vector<midas::Bar> bars;
+  for (int slot = 0; slot < 10; slot++) {
+    bars.push_back(barAt(slot, slot));
+  }
+  add(bars);
+  EXPECT_EQ(stream.closes,
+            std::vector<double>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  EXPECT_FALSE(reorderIndex.has_value());
+}
+
+TEST_F(DataStreamTest, RingIngestWakesParkedConsumer) {
+  stream.setRingIngestPolicy(
+      {.capacity = 16, .maxSpin = 20us, .adaptiveSpin = true});
+  constexpr int barCount = 5000;
+  std::jthread producer([this] {
+    for (int slot = 0; slot < barCount; slot++) {
+      stream.addBars(barAt(slot, slot));
+      if (slot % 500 == 0) {
+        // let the consumer park
+        std::this_thread::sleep_for(2ms);
+      }
+    }
+  });
+  const auto deadline = std::chrono::steady_clock::now() + 10s;
+  while (stream.size() < barCount &&
+         std::chrono::steady_clock::now() < deadline) {
+    stream.waitForData(100ms);
+  }
+  ASSERT_EQ(stream.size(), barCount);
+  EXPECT_EQ(stream.closes.back(), barCount - 1);
+  EXPECT_TRUE(
+      std::is_sorted(stream.timestamps.begin(), stream.timestamps.end()));
+}
+
+TEST(TimestampSearch, MatchesStandardBounds) {
+  const std::vector<midas::Timestamp> sorted{1, 3, 3, 3, 7, 9, 9, 12};
+  for (midas::Timestamp value = 0; value < 14; value++) {
+    EXPECT_EQ(midas::lowerBound(sorted, value),
+              std::lower_bound(sorted.begin(), sorted.end(), value) -
+                  sorted.begin());
+    EXPECT_EQ(midas::upperBound(sorted, value),
+              std::upper_bound(sorted.begin(), sorted.end(), value) -
+                  sorted.begin());
+  }
+  EXPECT_EQ(midas::upperBound({}, 5), 0);
+}
@@ -65,4 +65,25 @@ TEST(PositionTracking, LongLoss) {
   EXPECT_EQ(0, tracker.getPnl()[midas::NVDA]);  // no realized profit
   tracker.handle_position_update(instrument, -1, 90);
   EXPECT_EQ(-10, tracker.getPnl()[midas::NVDA]);
-}
\ No newline at end of file
+}
+TEST(PositionTracking, FractionalTicksDoNotDrift) {
+  midas::PositionTracker tracker;
+  midas::InstrumentEnum instrument = midas::NVDA;
+  for (int i = 0; i < 1000; i++) {
+    tracker.handle_position_update(instrument, 1, 100.01 + 0.01 * i);
+    tracker.handle_position_update(instrument, -1, 100.02 + 0.01 * i);
+  }
+  // one cent per round trip
+  EXPECT_EQ(10, tracker.getPnl()[midas::NVDA]);
+}
+
+TEST(TickPrice, RoundsToInstrumentTicks) {
+  const auto futures = midas::getInstrumentSpec(midas::MicroSPXFutures);
+  EXPECT_EQ(futures.toTicks(5000.13).ticks, 20000 + 1);
+  EXPECT_EQ(futures.roundToTick(5000.13), 5000.25);
+  EXPECT_EQ(futures.ticksIn(5), 20);
+  EXPECT_EQ(futures.tickValue(), 1.25);
+  const auto stock = midas::getInstrumentSpec(midas::NVDA);
+  EXPECT_EQ(stock.roundToTick(130.374), 130.37);
+  EXPECT_EQ(stock.toTicks(130.37) - stock.toTicks(130.0), 37);
+}
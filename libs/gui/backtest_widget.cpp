@@ -23,10 +23,10 @@ BacktestWidget::BacktestWidget(
   setLayout(layout);
   thread = std::jthread([this] {
     auto traderFactory =
-        [this](std::shared_ptr<midas::DataStream> streamPtr,
+        [this](const midas::trader::CandleSource &source,
                std::shared_ptr<midas::OrderManager> orderManager) {
           return midas::trader::createTrader(this->traderType,
-              streamPtr, orderManager, this->instrument, this->entryQuantity);
+              source, orderManager, this->instrument, this->entryQuantity);
         };
     midas::backtest::BacktestResult results = midas::backtest::performBacktest(
         this->instrument, 10_days, traderFactory, *(this->context->broker));
@@ -46,7 +46,7 @@ void gui::MainWindow::newActiveTrader() {
     return;
   }
   traders.emplace_back(std::make_shared<midas::TraderContext>(
-      quitSignal, 100 * 120, tradingContext.get(), data->instrument,
+      100 * 120, tradingContext.get(), data->instrument,
       data->quantity, data->traderType));
   TraderWidget *traderWidget = new TraderWidget(traders.back());
   traderTabs->addTab(traderWidget, traderWidget->getName());
@@ -1,21 +1,40 @@
 #include "ibkr/internal/bar_conversion.hpp"
 #include "Decimal.h"
-#include <boost/date_time/posix_time/conversion.hpp>
+#include <charconv>
+#include <stdexcept>
 
 midas::Bar ibkr::internal::convertIbkrBar(const Bar &ibkrBar, unsigned int barSizeSeconds) {
-  const double wapDouble = DecimalFunctions::decimalToDouble(ibkrBar.wap);
-  const double volumeDouble = DecimalFunctions::decimalToDouble(ibkrBar.volume);
+  long epochSeconds = 0;
+  const char *end = ibkrBar.time.data() + ibkrBar.time.size();
+  const auto [parsedEnd, error] =
+      std::from_chars(ibkrBar.time.data(), end, epochSeconds);
+  if (error != std::errc() || parsedEnd != end) {
+    throw std::invalid_argument("Bar time is not epoch seconds: " +
+                                ibkrBar.time);
+  }
+  return convertIbkrBar(epochSeconds, ibkrBar.open, ibkrBar.high, ibkrBar.low,
+                        ibkrBar.close, ibkrBar.volume, ibkrBar.wap,
+                        ibkrBar.count, barSizeSeconds);
+}
+
+midas::Bar ibkr::internal::convertIbkrBar(long epochSeconds, double open,
+                                          double high, double low,
+                                          double close, Decimal volume,
+                                          Decimal wap, int count,
+                                          unsigned int barSizeSeconds) {
+  const double wapDouble = DecimalFunctions::decimalToDouble(wap);
+  const double volumeDouble = DecimalFunctions::decimalToDouble(volume);
 
   midas::Bar bar(
     barSizeSeconds,
-    ibkrBar.count,
-    ibkrBar.high,
-    ibkrBar.low,
-    ibkrBar.open,
-    ibkrBar.close,
+    count,
+    high,
+    low,
+    open,
+    close,
     wapDouble,
     volumeDouble,
-    boost::posix_time::from_time_t(std::stol(ibkrBar.time))
+    midas::fromUnixSeconds(epochSeconds)
   );
 
   
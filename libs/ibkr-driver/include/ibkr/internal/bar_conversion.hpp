@@ -7,4 +7,12 @@ namespace ibkr::internal {
    * Note that an assumption is made that bar time string is utc epoch timestamps
    */
   midas::Bar convertIbkrBar(const Bar &ibkrBar, unsigned int barSizeSeconds);
+  /**
+   * Realtime bars already carry their time as utc epoch seconds, no string
+   * round trip needed
+   */
+  midas::Bar convertIbkrBar(long epochSeconds, double open, double high,
+                            double low, double close, Decimal volume,
+                            Decimal wap, int count,
+                            unsigned int barSizeSeconds);
 }
\ No newline at end of file
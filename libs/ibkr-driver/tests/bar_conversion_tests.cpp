@@ -23,6 +23,17 @@ TEST(IBKRDriver, BarConversion) {
   EXPECT_EQ(converted.tradeCount, internalBar.count);
   EXPECT_EQ(converted.volume, 1000);
   EXPECT_EQ(converted.wap, 40.56);
-  EXPECT_EQ(std::to_string(boost::posix_time::to_time_t(converted.utcTime)),
+  EXPECT_EQ(std::to_string(converted.utcTime / midas::nanosPerSecond),
             internalBar.time);
+}
+
+TEST(IBKRDriver, RealtimeBarConversion) {
+  midas::Bar converted = ibkr::internal::convertIbkrBar(
+      1736173800, 20, 25, 15, 22.4, DecimalFunctions::doubleToDecimal(1000),
+      DecimalFunctions::doubleToDecimal(40.56), 500, 5);
+  EXPECT_EQ(converted.barSizeSeconds, 5);
+  EXPECT_EQ(converted.open, 20);
+  EXPECT_EQ(converted.close, 22.4);
+  EXPECT_EQ(converted.volume, 1000);
+  EXPECT_EQ(converted.utcTime, 1736173800 * midas::nanosPerSecond);
 }
\ No newline at end of file
@@ -89,16 +89,8 @@ void ibkr::internal::Client::realtimeBar(TickerId tickerId, long time,
                                          double open, double high, double low,
                                          double close, Decimal volume,
                                          Decimal wap, int count) {
-  Bar internalBar;
-  internalBar.time = std::to_string(time);
-  internalBar.high = high;
-  internalBar.low = low;
-  internalBar.open = open;
-  internalBar.close = close;
-  internalBar.wap = wap;
-  internalBar.volume = volume;
-  internalBar.count = count;
-  midas::Bar bar = ibkr::internal::convertIbkrBar(internalBar, 5);
+  midas::Bar bar = ibkr::internal::convertIbkrBar(
+      time, open, high, low, close, volume, wap, count, 5);
   applyToActiveSubscriptions(
       [&bar](midas::Subscription &subscription,
              [[maybe_unused]] ActiveSubscriptionState &state) {
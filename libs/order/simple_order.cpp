@@ -1,11 +1,12 @@
 #include "broker-interface/order.hpp"
+#include "broker-interface/tick_price.hpp"
 
 midas::SimpleOrder::SimpleOrder(
     unsigned int requestedQuantity, OrderDirection direction,
     InstrumentEnum instrument, ExecutionType type,
     std::shared_ptr<logging::thread_safe_logger_t> logger, double targetPrice)
     : Order(requestedQuantity, direction, instrument, type, logger),
-      targetPrice(targetPrice) {}
+      targetPrice(getInstrumentSpec(instrument).roundToTick(targetPrice)) {}
 
 void midas::SimpleOrder::visit(midas::OrderVisitor &transmitter) {
   transmitter.visit(*this);
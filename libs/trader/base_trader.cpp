@@ -86,6 +86,7 @@ void midas::trader::Trader::handleOrderStatusChangeEvent(
     updatedSummary->hasOpenPosition = this->hasOpenPosition();
     summarySignal(updatedSummary.value());
   }
+  orderEvent(event);
 }
 
 void midas::trader::Trader::executeMarket(
@@ -96,8 +97,11 @@ void midas::trader::Trader::executeMarket(
   auto orderPtr = std::make_shared<SimpleOrder>(quantity, direction, instrument,
                                                 ExecutionType::MKT, logger, 0);
   orderPtr->addStatusChangeListener(
-      [callback](Order &order [[maybe_unused]],
-                 Order::StatusChangeEvent event) { callback(event); });
+      [this, callback](Order &order [[maybe_unused]],
+                       Order::StatusChangeEvent event) {
+        callback(event);
+        orderEvent(event);
+      });
   orderManager->transmit(orderPtr);
 }
 
@@ -111,8 +115,11 @@ void midas::trader::Trader::executeLimit(
                                                 ExecutionType::Limit, logger,
                                                 limitPrice);
   orderPtr->addStatusChangeListener(
-      [callback](Order &order [[maybe_unused]],
-                 Order::StatusChangeEvent event) { callback(event); });
+      [this, callback](Order &order [[maybe_unused]],
+                       Order::StatusChangeEvent event) {
+        callback(event);
+        orderEvent(event);
+      });
   orderManager->transmit(orderPtr);
 }
 
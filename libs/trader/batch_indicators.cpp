@@ -0,0 +1,306 @@
+#include "trader/batch_indicators.hpp"
+#include "batch_kernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace midas::trader::batch {
+
+const Kernels &scalarKernels() {
+  static constexpr Kernels kernels = makeKernels<ScalarLanes>();
+  return kernels;
+}
+
+namespace {
+std::atomic<const Kernels *> activeKernels{nullptr};
+std::atomic<InstructionSet> activeInstructionSet{InstructionSet::Scalar};
+
+const Kernels &kernelsFor(InstructionSet instructionSet) {
+  switch (instructionSet) {
+#ifdef MIDAS_SIMD_KERNELS
+  case InstructionSet::Avx512:
+    return avx512Kernels();
+  case InstructionSet::Avx2:
+    return avx2Kernels();
+#endif
+  default:
+    return scalarKernels();
+  }
+}
+
+const Kernels &kernels() {
+  const Kernels *active = activeKernels.load(std::memory_order::acquire);
+  if (active == nullptr) {
+    useInstructionSet(detectInstructionSet());
+    active = activeKernels.load(std::memory_order::acquire);
+  }
+  return *active;
+}
+
+std::size_t toPeriod(int period) {
+  if (period < 1) {
+    throw std::invalid_argument("Indicator period must be positive");
+  }
+  return static_cast<std::size_t>(period);
+}
+
+void checkSize(std::size_t size, std::span<const double> column) {
+  if (column.size() != size) {
+    throw std::invalid_argument("Indicator columns must have the same size");
+  }
+}
+
+/**
+ * Fills the outputs of the warm up with NaN
+ * @return whether there is any output past the warm up
+ */
+bool warmUp(std::span<double> out, std::size_t lookBack) {
+  std::fill_n(out.begin(), std::min(lookBack, out.size()),
+              std::numeric_limits<double>::quiet_NaN());
+  return lookBack < out.size();
+}
+
+/**
+ * Sum of values from first to last, in order
+ */
+double total(const double *values, std::size_t first, std::size_t last) {
+  double sum = 0;
+  for (std::size_t i = first; i <= last; i++) {
+    sum += values[i];
+  }
+  return sum;
+}
+
+/**
+ * Wilder's smoothing weighs every new value by 1 / period
+ */
+struct WilderWeights {
+  explicit WilderWeights(std::size_t period)
+      : gain(1.0 / period), decay(static_cast<double>(period - 1) / period) {}
+  const double gain, decay;
+};
+} // namespace
+
+const char *toString(InstructionSet instructionSet) {
+  switch (instructionSet) {
+  case InstructionSet::Avx512:
+    return "AVX-512";
+  case InstructionSet::Avx2:
+    return "AVX2";
+  default:
+    return "scalar";
+  }
+}
+
+InstructionSet detectInstructionSet() {
+#ifdef MIDAS_SIMD_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return InstructionSet::Avx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return InstructionSet::Avx2;
+  }
+#endif
+  return InstructionSet::Scalar;
+}
+
+InstructionSet instructionSet() {
+  kernels();
+  return activeInstructionSet.load(std::memory_order::acquire);
+}
+
+void useInstructionSet(InstructionSet instructionSet) {
+  if (instructionSet > detectInstructionSet()) {
+    throw std::invalid_argument(std::string(toString(instructionSet)) +
+                                " is not supported by this CPU");
+  }
+  activeInstructionSet.store(instructionSet, std::memory_order::release);
+  activeKernels.store(&kernelsFor(instructionSet),
+                      std::memory_order::release);
+}
+
+std::size_t sma(std::span<const double> values, int period,
+                std::span<double> out) {
+  const std::size_t window = toPeriod(period);
+  checkSize(values.size(), out);
+  const std::size_t lookBack = window - 1;
+  if (warmUp(out, lookBack)) {
+    kernels().windowMean(values.data(), values.size(), window, out.data());
+  }
+  return lookBack;
+}
+
+std::size_t ema(std::span<const double> values, int period,
+                std::span<double> out) {
+  const std::size_t window = toPeriod(period);
+  checkSize(values.size(), out);
+  const std::size_t lookBack = window - 1;
+  if (warmUp(out, lookBack)) {
+    const double seed = total(values.data(), 0, lookBack) / period;
+    const double k = 2.0 / (period + 1);
+    out[lookBack] = seed;
+    kernels().smooth(values.data() + window, values.size() - window, k,
+                     1.0 - k, seed, out.data() + window);
+  }
+  return lookBack;
+}
+
+std::size_t rollingMin(std::span<const double> values, int period,
+                       std::span<double> out) {
+  const std::size_t window = toPeriod(period);
+  checkSize(values.size(), out);
+  const std::size_t lookBack = window - 1;
+  if (warmUp(out, lookBack)) {
+    kernels().windowMin(values.data(), values.size(), window, out.data());
+  }
+  return lookBack;
+}
+
+std::size_t rollingMax(std::span<const double> values, int period,
+                       std::span<double> out) {
+  const std::size_t window = toPeriod(period);
+  checkSize(values.size(), out);
+  const std::size_t lookBack = window - 1;
+  if (warmUp(out, lookBack)) {
+    kernels().windowMax(values.data(), values.size(), window, out.data());
+  }
+  return lookBack;
+}
+
+std::size_t rollingStdDev(std::span<const double> values, int period,
+                          double deviations, std::span<double> out) {
+  const std::size_t window = toPeriod(period);
+  checkSize(values.size(), out);
+  const std::size_t lookBack = window - 1;
+  if (!warmUp(out, lookBack)) {
+    return lookBack;
+  }
+  const Kernels &active = kernels();
+  active.windowVariance(values.data(), values.size(), window, out.data());
+  active.deviation(out.data() + lookBack, values.size() - lookBack,
+                   deviations, out.data() + lookBack);
+  return lookBack;
+}
+
+std::size_t bollingerBands(std::span<const double> values, int period,
+                           double deviationsUp, double deviationsDown,
+                           std::span<double> upper, std::span<double> middle,
+                           std::span<double> lower) {
+  const std::size_t window = toPeriod(period);
+  checkSize(values.size(), upper);
+  checkSize(values.size(), middle);
+  checkSize(values.size(), lower);
+  const std::size_t lookBack = window - 1;
+  warmUp(upper, lookBack);
+  warmUp(lower, lookBack);
+  if (!warmUp(middle, lookBack)) {
+    return lookBack;
+  }
+  const Kernels &active = kernels();
+  const std::size_t size = values.size() - lookBack;
+  active.windowMean(values.data(), values.size(), window, middle.data());
+  // the upper band holds the variance, then the deviation
+  active.windowVariance(values.data(), values.size(), window, upper.data());
+  active.deviation(upper.data() + lookBack, size, 1.0,
+                   upper.data() + lookBack);
+  active.bands(middle.data() + lookBack, upper.data() + lookBack, size,
+               deviationsUp, deviationsDown, upper.data() + lookBack,
+               lower.data() + lookBack);
+  return lookBack;
+}
+
+std::size_t rsi(std::span<const double> values, int period,
+                std::span<double> out) {
+  const std::size_t window = toPeriod(period);
+  checkSize(values.size(), out);
+  const std::size_t lookBack = window;
+  if (!warmUp(out, lookBack)) {
+    return lookBack;
+  }
+  const Kernels &active = kernels();
+  // the averages start from the plain average of the first period moves
+  double gain = 0, loss = 0;
+  for (std::size_t i = 1; i <= window; i++) {
+    const double change = values[i] - values[i - 1];
+    if (change < 0) {
+      loss -= change;
+    } else {
+      gain += change;
+    }
+  }
+  gain /= period;
+  loss /= period;
+  active.relativeStrength(&gain, &loss, 1, out.data() + lookBack);
+  const WilderWeights weights(window);
+  std::array<double, chunkSize> gains, losses;
+  for (std::size_t first = lookBack + 1; first < values.size();
+       first += chunkSize) {
+    const std::size_t count = std::min(chunkSize, values.size() - first);
+    active.changes(values.data() + first - 1, count, gains.data(),
+                   losses.data());
+    active.smooth(gains.data(), count, weights.gain, weights.decay, gain,
+                  gains.data());
+    active.smooth(losses.data(), count, weights.gain, weights.decay, loss,
+                  losses.data());
+    gain = gains[count - 1];
+    loss = losses[count - 1];
+    active.relativeStrength(gains.data(), losses.data(), count,
+                            out.data() + first);
+  }
+  return lookBack;
+}
+
+std::size_t atr(std::span<const double> highs, std::span<const double> lows,
+                std::span<const double> closes, int period,
+                std::span<double> out) {
+  const std::size_t window = toPeriod(period);
+  checkSize(highs.size(), lows);
+  checkSize(highs.size(), closes);
+  checkSize(highs.size(), out);
+  const std::size_t lookBack = window;
+  if (!warmUp(out, lookBack)) {
+    return lookBack;
+  }
+  const Kernels &active = kernels();
+  // the average starts from the plain average of the first period ranges,
+  // which are parked in the warm up until then
+  active.trueRanges(highs.data() + 1, lows.data() + 1, closes.data(), window,
+                    out.data() + 1);
+  double average = total(out.data(), 1, window) / period;
+  warmUp(out, lookBack);
+  out[lookBack] = average;
+  // ranges are smoothed in place, a chunk at a time while in cache
+  const WilderWeights weights(window);
+  for (std::size_t first = lookBack + 1; first < highs.size();
+       first += chunkSize) {
+    const std::size_t count = std::min(chunkSize, highs.size() - first);
+    double *ranges = out.data() + first;
+    active.trueRanges(highs.data() + first, lows.data() + first,
+                      closes.data() + first - 1, count, ranges);
+    active.smooth(ranges, count, weights.gain, weights.decay, average,
+                  ranges);
+    average = ranges[count - 1];
+  }
+  return lookBack;
+}
+
+std::size_t firstTouch(std::span<const double> highs,
+                       std::span<const double> lows, double below,
+                       double above) {
+  checkSize(highs.size(), lows);
+  return kernels().firstTouch(highs.data(), lows.data(), highs.size(), below,
+                              above);
+}
+
+std::size_t firstValue(std::span<const double> values) {
+  const auto found = std::ranges::find_if(
+      values, [](double value) { return !std::isnan(value); });
+  return static_cast<std::size_t>(found - values.begin());
+}
+} // namespace midas::trader::batch
@@ -0,0 +1,56 @@
+#include "batch_kernels.hpp"
+#include <immintrin.h>
+
+namespace midas::trader::batch {
+namespace {
+struct Avx2Lanes {
+  using reg = __m256d;
+  using mask = __m256d;
+  static constexpr std::size_t width = 4;
+  static reg load(const double *from) { return _mm256_loadu_pd(from); }
+  static void store(double *to, reg value) { _mm256_storeu_pd(to, value); }
+  static reg set(double value) { return _mm256_set1_pd(value); }
+  static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+  static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+  static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+  static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+  static reg fma(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+  static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+  static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+  static reg sqrt(reg value) { return _mm256_sqrt_pd(value); }
+  static mask less(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+  static mask lessOrEqual(reg a, reg b) {
+    return _mm256_cmp_pd(a, b, _CMP_LE_OQ);
+  }
+  static mask either(mask a, mask b) { return _mm256_or_pd(a, b); }
+  static bool any(mask value) { return _mm256_movemask_pd(value) != 0; }
+  static reg select(mask condition, reg ifTrue, reg ifFalse) {
+    return _mm256_blendv_pd(ifFalse, ifTrue, condition);
+  }
+  /**
+   * Moves every lane up by Step lanes, the lowest lanes become zero
+   */
+  template <std::size_t Step> static reg shiftUp(reg value) {
+    if constexpr (Step == 1) {
+      return _mm256_blend_pd(
+          _mm256_permute4x64_pd(value, _MM_SHUFFLE(2, 1, 0, 0)),
+          _mm256_setzero_pd(), 0b0001);
+    } else {
+      static_assert(Step == 2);
+      return _mm256_blend_pd(
+          _mm256_permute4x64_pd(value, _MM_SHUFFLE(1, 0, 0, 0)),
+          _mm256_setzero_pd(), 0b0011);
+    }
+  }
+  static double last(reg value) {
+    const __m128d high = _mm256_extractf128_pd(value, 1);
+    return _mm_cvtsd_f64(_mm_unpackhi_pd(high, high));
+  }
+};
+} // namespace
+
+const Kernels &avx2Kernels() {
+  static constexpr Kernels kernels = makeKernels<Avx2Lanes>();
+  return kernels;
+}
+} // namespace midas::trader::batch
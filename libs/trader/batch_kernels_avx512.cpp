@@ -0,0 +1,53 @@
+#include "batch_kernels.hpp"
+#include <immintrin.h>
+
+namespace midas::trader::batch {
+namespace {
+struct Avx512Lanes {
+  using reg = __m512d;
+  using mask = __mmask8;
+  static constexpr std::size_t width = 8;
+  static reg load(const double *from) { return _mm512_loadu_pd(from); }
+  static void store(double *to, reg value) { _mm512_storeu_pd(to, value); }
+  static reg set(double value) { return _mm512_set1_pd(value); }
+  static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+  static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+  static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+  static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+  static reg fma(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+  static reg min(reg a, reg b) { return _mm512_min_pd(a, b); }
+  static reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+  static reg sqrt(reg value) { return _mm512_sqrt_pd(value); }
+  static mask less(reg a, reg b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ);
+  }
+  static mask lessOrEqual(reg a, reg b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ);
+  }
+  static mask either(mask a, mask b) { return a | b; }
+  static bool any(mask value) { return value != 0; }
+  static reg select(mask condition, reg ifTrue, reg ifFalse) {
+    return _mm512_mask_blend_pd(condition, ifFalse, ifTrue);
+  }
+  /**
+   * Moves every lane up by Step lanes, the lowest lanes become zero
+   */
+  template <std::size_t Step> static reg shiftUp(reg value) {
+    const __m512i lanes = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m512i from = _mm512_sub_epi64(lanes, _mm512_set1_epi64(Step));
+    return _mm512_maskz_permutexvar_pd(static_cast<__mmask8>(0xFF << Step),
+                                       from, value);
+  }
+  static double last(reg value) {
+    const __m128d high =
+        _mm256_extractf128_pd(_mm512_extractf64x4_pd(value, 1), 1);
+    return _mm_cvtsd_f64(_mm_unpackhi_pd(high, high));
+  }
+};
+} // namespace
+
+const Kernels &avx512Kernels() {
+  static constexpr Kernels kernels = makeKernels<Avx512Lanes>();
+  return kernels;
+}
+} // namespace midas::trader::batch
@@ -0,0 +1,93 @@
+#include "trader/candle_aggregator.hpp"
+#include "exceptions/sampling_error.hpp"
+#include <algorithm>
+
+namespace {
+midas::Timestamp floorDiv(midas::Timestamp value, midas::Timestamp divisor) {
+  const midas::Timestamp quotient = value / divisor;
+  return quotient - ((value % divisor != 0) && ((value < 0) != (divisor < 0)));
+}
+} // namespace
+
+midas::trader::CandleAggregator::CandleAggregator(std::size_t candleSizeSeconds,
+                                                  std::size_t barSizeSeconds,
+                                                  TradingSession session)
+    : candleSize(fromUnixSeconds(candleSizeSeconds)),
+      barSize(fromUnixSeconds(barSizeSeconds)), session(session) {
+  if (candleSize <= 0 || barSize <= 0 || candleSize % barSize != 0) {
+    throw SamplingError(
+        "Requested candle size is not divisible by stream bar size");
+  }
+  if (session.length <= 0 || session.length > nanosPerDay) {
+    throw SamplingError("Trading session must be shorter than a day");
+  }
+}
+
+bool midas::trader::CandleAggregator::bucket(Timestamp time, Timestamp &start,
+                                             Timestamp &end) const {
+  const Timestamp sessionOpen =
+      session.open + floorDiv(time - session.open, nanosPerDay) * nanosPerDay;
+  const Timestamp intoSession = time - sessionOpen;
+  if (intoSession >= session.length) {
+    return false;
+  }
+  start = sessionOpen + intoSession / candleSize * candleSize;
+  // the last candle of a session is cut short at the close
+  end = std::min(start + candleSize, sessionOpen + session.length);
+  return true;
+}
+
+void midas::trader::CandleAggregator::fold(const Bar &bar, Timestamp start,
+                                           Timestamp end) {
+  if (!formingCandle) {
+    formingCandle = true;
+    formingStart = start;
+    formingEnd = end;
+    candle = Bar(candleSize / nanosPerSecond, bar.tradeCount, bar.high,
+                 bar.low, bar.open, bar.close, 0, bar.volume, bar.utcTime);
+    wapVolume = bar.wap * bar.volume;
+    return;
+  }
+  merge(candle, wapVolume, bar);
+}
+
+void midas::trader::CandleAggregator::merge(Bar &into, double &wapVolume,
+                                            const Bar &bar) {
+  into.tradeCount += bar.tradeCount;
+  into.high = std::max(into.high, bar.high);
+  into.low = std::min(into.low, bar.low);
+  into.close = bar.close;
+  into.volume += bar.volume;
+  into.utcTime = bar.utcTime;
+  wapVolume += bar.wap * bar.volume;
+}
+
+std::optional<midas::Bar> midas::trader::CandleAggregator::forming() const {
+  if (!formingCandle) {
+    return std::nullopt;
+  }
+  Bar result = candle;
+  // Might be zero due to no trades happening in the interval
+  result.wap = (candle.volume != 0) ? (wapVolume / candle.volume) : 0.0;
+  return result;
+}
+
+std::optional<midas::Bar> midas::trader::CandleAggregator::forming(
+    const std::optional<Bar> &pending) const {
+  Timestamp start, end;
+  if (!pending || !bucket(pending->utcTime, start, end)) {
+    return forming();
+  }
+  if (!formingCandle || start != formingStart) {
+    // pending opens the next candle, the forming one completes with the
+    // next add
+    Bar result = *pending;
+    result.barSizeSeconds = candleSize / nanosPerSecond;
+    return result;
+  }
+  Bar result = candle;
+  double resultWapVolume = wapVolume;
+  merge(result, resultWapVolume, *pending);
+  result.wap = (result.volume != 0) ? (resultWapVolume / result.volume) : 0.0;
+  return result;
+}
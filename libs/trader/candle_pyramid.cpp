@@ -0,0 +1,260 @@
+#include "trader/candle_pyramid.hpp"
+#include "exceptions/sampling_error.hpp"
+#include <algorithm>
+#include <functional>
+#include <optional>
+
+midas::trader::CandlePyramid::CandlePyramid(
+    std::shared_ptr<DataStream> source,
+    std::vector<std::size_t> resolutionsSeconds, TradingSession session)
+    : source(source) {
+  buildLevels(std::move(resolutionsSeconds), session);
+  updateListenerConnection = source->addUpdateListener(
+      std::bind(&CandlePyramid::processSource, this));
+  reOrderListenerConnection = source->addReOrderListener(
+      std::bind(&CandlePyramid::repair, this, std::placeholders::_1));
+}
+
+midas::trader::CandlePyramid::CandlePyramid(
+    std::shared_ptr<const ReplayCursor> cursor,
+    std::vector<std::size_t> resolutionsSeconds, TradingSession session)
+    : source(cursor->history), cursor(cursor) {
+  // the history does not change, there is nothing to listen to
+  buildLevels(std::move(resolutionsSeconds), session);
+}
+
+void midas::trader::CandlePyramid::buildLevels(
+    std::vector<std::size_t> resolutionsSeconds, TradingSession session) {
+  if (resolutionsSeconds.empty()) {
+    throw SamplingError("Candle pyramid requires at least one resolution");
+  }
+  // traders reading the bars as they come share the pyramid too
+  resolutionsSeconds.push_back(source->barSizeSeconds);
+  // parents have to come before their children
+  std::ranges::sort(resolutionsSeconds);
+  const auto [last, end] = std::ranges::unique(resolutionsSeconds);
+  resolutionsSeconds.erase(last, end);
+  levels.reserve(resolutionsSeconds.size());
+  for (const std::size_t resolution : resolutionsSeconds) {
+    // candles carry the time of their last bar, so every level completes on
+    // the stream bar size
+    levels.emplace_back(resolution, source->barSizeSeconds, session);
+    if (!cursor) {
+      // a repair truncates every level back to a checkpoint, levels nobody
+      // looks far back into still keep the candles since the oldest one
+      levels.back().series->retain(checkpointBars * retainedCheckpoints *
+                                       source->barSizeSeconds / resolution +
+                                   1);
+    }
+    for (std::size_t below = levels.size() - 1; below-- > 0;) {
+      if (resolution % levels[below].series->candleSizeSeconds == 0) {
+        levels.back().parent = below;
+        levels[below].children.push_back(levels.size() - 1);
+        break;
+      }
+    }
+  }
+}
+
+midas::trader::CandlePyramid::Level &
+midas::trader::CandlePyramid::find(std::size_t candleSizeSeconds) {
+  const auto level = std::ranges::find_if(levels, [&](const Level &level) {
+    return level.series->candleSizeSeconds == candleSizeSeconds;
+  });
+  if (level == levels.end()) {
+    throw SamplingError("No pyramid level for requested candle size");
+  }
+  return *level;
+}
+
+std::shared_ptr<const midas::trader::CandleSeries>
+midas::trader::CandlePyramid::subscribe(std::size_t candleSizeSeconds,
+                                        std::size_t lookBackSize) {
+  std::scoped_lock lock(writerMutex);
+  Level &level = find(candleSizeSeconds);
+  level.series->retain(lookBackSize);
+  return level.series;
+}
+
+std::shared_ptr<midas::trader::IndicatorGraph>
+midas::trader::CandlePyramid::indicators(std::size_t candleSizeSeconds) {
+  std::scoped_lock lock(writerMutex);
+  return find(candleSizeSeconds).indicators;
+}
+
+void midas::trader::CandlePyramid::add(std::size_t level, const Bar &bar) {
+  levels[level].aggregator.add(bar, [this, level](const Bar &candle) {
+    levels[level].series->append(candle);
+    levels[level].indicators->append(candle);
+    for (const std::size_t child : levels[level].children) {
+      add(child, candle);
+    }
+  });
+}
+
+void midas::trader::CandlePyramid::publish() {
+  // a forming candle is part of the forming candle of every level built on
+  // top of it
+  std::vector<std::optional<Bar>> forming(levels.size());
+  for (std::size_t i = 0; i < levels.size(); i++) {
+    const Level &level = levels[i];
+    forming[i] = level.parent ? level.aggregator.forming(forming[*level.parent])
+                              : level.aggregator.forming();
+    level.series->publish(forming[i]);
+    level.indicators->publish();
+  }
+}
+
+void midas::trader::CandlePyramid::processSource() {
+  std::scoped_lock lock(writerMutex);
+  // lastReadIndex is absolute, the source may have evicted older bars. Bars
+  // evicted before they were read are skipped, candles stay time aligned.
+  const std::size_t baseIndex = source->baseIndex();
+  lastReadIndex = std::max(lastReadIndex, baseIndex);
+  if (cursor) {
+    // so are bars before the start of a replay
+    lastReadIndex = std::max(lastReadIndex, cursor->beginIndex());
+  }
+  const std::size_t endIndex = sourceEndIndex();
+  if (lastReadIndex == endIndex) {
+    return;
+  }
+  for (; lastReadIndex < endIndex; lastReadIndex++) {
+    // a replayed history is never re-ordered, and after a repair the
+    // checkpoint it restored is already the last one
+    if (!cursor && lastReadIndex % checkpointBars == 0 &&
+        (checkpoints.empty() ||
+         checkpoints.back().sourceIndex != lastReadIndex)) {
+      checkpoint();
+    }
+    const std::size_t readIndex = lastReadIndex - baseIndex;
+    const Bar bar(source->barSizeSeconds, source->tradeCounts[readIndex],
+                  source->highs[readIndex], source->lows[readIndex],
+                  source->opens[readIndex], source->closes[readIndex],
+                  source->waps[readIndex], source->volumes[readIndex],
+                  source->timestamps[readIndex]);
+    for (std::size_t level = 0; level < levels.size(); level++) {
+      if (!levels[level].parent) {
+        add(level, bar);
+      }
+    }
+  }
+  // the forming candles change with every bar
+  publish();
+}
+
+void midas::trader::CandlePyramid::publishIndicators() {
+  std::scoped_lock lock(writerMutex);
+  for (Level &level : levels) {
+    if (level.indicators->pending()) {
+      level.indicators->publish();
+    }
+  }
+}
+
+void midas::trader::CandlePyramid::clear() {
+  std::scoped_lock lock(writerMutex);
+  for (Level &level : levels) {
+    level.aggregator.reset();
+    level.series->clear();
+    level.indicators->clear();
+  }
+  lastReadIndex = source->baseIndex();
+  checkpoints.clear();
+}
+
+void midas::trader::CandlePyramid::repair(std::size_t firstChangedIndex) {
+  std::scoped_lock lock(writerMutex);
+  if (firstChangedIndex >= lastReadIndex) {
+    // the changed bars were not read yet
+    return;
+  }
+  // later checkpoints include changed bars
+  while (!checkpoints.empty() &&
+         checkpoints.back().sourceIndex > firstChangedIndex) {
+    checkpoints.pop_back();
+  }
+  // bars evicted since the checkpoint can not be read again
+  if (checkpoints.empty() ||
+      checkpoints.back().sourceIndex < source->baseIndex() ||
+      !restore(checkpoints.back())) {
+    clear();
+    return;
+  }
+  lastReadIndex = checkpoints.back().sourceIndex;
+}
+
+void midas::trader::CandlePyramid::checkpoint() {
+  Checkpoint checkpoint{lastReadIndex, {}, {}, {}};
+  checkpoint.aggregators.reserve(levels.size());
+  checkpoint.candles.reserve(levels.size());
+  checkpoint.indicators.reserve(levels.size());
+  for (Level &level : levels) {
+    checkpoint.aggregators.push_back(level.aggregator.checkpoint());
+    checkpoint.candles.push_back(level.series->endIndex());
+    checkpoint.indicators.push_back(level.indicators->checkpoint());
+  }
+  if (checkpoints.size() == retainedCheckpoints) {
+    checkpoints.pop_front();
+  }
+  checkpoints.push_back(std::move(checkpoint));
+}
+
+bool midas::trader::CandlePyramid::restore(const Checkpoint &checkpoint) {
+  for (std::size_t i = 0; i < levels.size(); i++) {
+    Level &level = levels[i];
+    level.aggregator.restore(checkpoint.aggregators[i]);
+    // the indicators publish along with the truncated candles
+    if (!level.series->truncate(checkpoint.candles[i]) ||
+        !checkpoint.indicators[i] ||
+        !level.indicators->restore(*checkpoint.indicators[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void midas::trader::CandlePyramid::precomputeFeatures(
+    const DataStream &history) {
+  std::scoped_lock lock(writerMutex);
+  // the history is folded by copies of the levels, from the first bar that
+  // is replayed so the features line up with the candles
+  const std::size_t first =
+      cursor ? std::max(cursor->beginIndex(), history.baseIndex()) -
+                   history.baseIndex()
+             : 0;
+  std::vector<CandleAggregator> aggregators;
+  std::vector<IndicatorGraph::FeatureBuilder> builders;
+  aggregators.reserve(levels.size());
+  builders.reserve(levels.size());
+  for (Level &level : levels) {
+    aggregators.push_back(level.aggregator);
+    aggregators.back().reset();
+    builders.push_back(level.indicators->featureBuilder(
+        history.size() * history.barSizeSeconds /
+            level.series->candleSizeSeconds +
+        1));
+  }
+  const auto add = [&](auto &self, std::size_t level, const Bar &bar) -> void {
+    aggregators[level].add(bar, [&](const Bar &candle) {
+      builders[level].add(candle);
+      for (const std::size_t child : levels[level].children) {
+        self(self, child, candle);
+      }
+    });
+  };
+  for (std::size_t i = first; i < history.size(); i++) {
+    const Bar bar(history.barSizeSeconds, history.tradeCounts[i],
+                  history.highs[i], history.lows[i], history.opens[i],
+                  history.closes[i], history.waps[i], history.volumes[i],
+                  history.timestamps[i]);
+    for (std::size_t level = 0; level < levels.size(); level++) {
+      if (!levels[level].parent) {
+        add(add, level, bar);
+      }
+    }
+  }
+  for (std::size_t level = 0; level < levels.size(); level++) {
+    levels[level].indicators->useFeatures(builders[level].finish());
+  }
+}
@@ -0,0 +1,87 @@
+#include "trader/candle_series.hpp"
+
+midas::trader::CandleSeries::CandleSeries(std::size_t candleSizeSeconds,
+                                          std::size_t lookBackSize)
+    : candleSizeSeconds(candleSizeSeconds),
+      retained(std::max<std::size_t>(lookBackSize, 1)),
+      columns(std::make_shared<CandleColumns>(retained * storageLookBacks)) {
+  publish(std::nullopt);
+}
+
+void midas::trader::CandleSeries::retain(std::size_t lookBackSize) {
+  if (lookBackSize <= retained) {
+    return;
+  }
+  retained = lookBackSize;
+  if (columns->capacity() < retained * storageLookBacks) {
+    replaceStorage(retained * storageLookBacks, columnsUsed);
+  }
+}
+
+void midas::trader::CandleSeries::replaceStorage(std::size_t capacity,
+                                                 std::size_t carried) {
+  // published snapshots keep the old storage alive for as long as readers
+  // need it
+  auto fresh = std::make_shared<CandleColumns>(capacity);
+  const std::size_t first = columnsUsed - carried;
+  const auto carryOver = [first, carried](const auto &from, auto &to) {
+    std::copy_n(from.begin() + first, carried, to.begin());
+  };
+  carryOver(columns->tradeCounts, fresh->tradeCounts);
+  carryOver(columns->highs, fresh->highs);
+  carryOver(columns->lows, fresh->lows);
+  carryOver(columns->opens, fresh->opens);
+  carryOver(columns->closes, fresh->closes);
+  carryOver(columns->vwaps, fresh->vwaps);
+  carryOver(columns->volumes, fresh->volumes);
+  carryOver(columns->timestamps, fresh->timestamps);
+  columns = std::move(fresh);
+  columnsUsed = carried;
+}
+
+void midas::trader::CandleSeries::append(const Bar &candle) {
+  if (columnsUsed == columns->capacity()) {
+    replaceStorage(columns->capacity(), std::min(columnsUsed, retained));
+  }
+  const std::size_t index = columnsUsed++;
+  appended++;
+  columns->tradeCounts[index] = candle.tradeCount;
+  columns->highs[index] = candle.high;
+  columns->lows[index] = candle.low;
+  columns->opens[index] = candle.open;
+  columns->closes[index] = candle.close;
+  columns->vwaps[index] = candle.wap;
+  columns->volumes[index] = candle.volume;
+  columns->timestamps[index] = candle.utcTime;
+}
+
+void midas::trader::CandleSeries::publish(std::optional<Bar> forming) {
+  const std::size_t count = std::min(columnsUsed, retained);
+  published.store(std::make_shared<const CandleSnapshot>(
+                      columns, columnsUsed - count, count, ++sequence,
+                      generation, appended, std::move(forming)),
+                  std::memory_order::release);
+}
+
+void midas::trader::CandleSeries::clear() {
+  // readers may still hold the old storage
+  columns = std::make_shared<CandleColumns>(columns->capacity());
+  columnsUsed = 0;
+  appended = 0;
+  generation++;
+  publish(std::nullopt);
+}
+
+bool midas::trader::CandleSeries::truncate(std::size_t endIndex) {
+  if (endIndex > appended || appended - endIndex > columnsUsed) {
+    return false;
+  }
+  columnsUsed -= appended - endIndex;
+  appended = endIndex;
+  // published snapshots may still read the dropped candles, which are about
+  // to be written over
+  replaceStorage(columns->capacity(), columnsUsed);
+  generation++;
+  publish(std::nullopt);
+  return true;
+}
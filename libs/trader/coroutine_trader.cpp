@@ -0,0 +1,185 @@
+#include "trader/coroutine_trader.hpp"
+#include "logging/logging.hpp"
+
+#include <algorithm>
+#include <new>
+
+using namespace midas::trader;
+
+void *FramePool::allocate(std::size_t size) {
+  const std::size_t block = blockSize(size);
+  std::byte *memory;
+  FramePool *owner = this;
+  if (block > maxPooledSize) {
+    memory = static_cast<std::byte *>(::operator new(size + headerSize));
+    owner = nullptr;
+  } else if (FreeFrame *&free = freeFrames[block / granularity - 1]; free) {
+    memory = reinterpret_cast<std::byte *>(std::exchange(free, free->next));
+  } else {
+    if (chunkUsed + block > chunkSize) {
+      chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(chunkSize));
+      chunkUsed = 0;
+    }
+    memory = chunks.back().get() + chunkUsed;
+    chunkUsed += block;
+  }
+  ::new (memory) FramePool *(owner);
+  return memory + headerSize;
+}
+
+void FramePool::release(void *frame, std::size_t size) noexcept {
+  std::byte *memory = static_cast<std::byte *>(frame) - headerSize;
+  FramePool *owner = *std::launder(reinterpret_cast<FramePool **>(memory));
+  if (!owner) {
+    ::operator delete(memory);
+    return;
+  }
+  FreeFrame *&free = owner->freeFrames[blockSize(size) / granularity - 1];
+  free = ::new (memory) FreeFrame{free};
+}
+
+CoroutineTrader::CoroutineTrader(
+    std::string name, std::size_t lookBackSize, std::size_t candleSizeSeconds,
+    const CandleSource &source,
+    const std::shared_ptr<midas::OrderManager> &orderManager,
+    midas::InstrumentEnum instrument,
+    const std::shared_ptr<logging::thread_safe_logger_t> &logger)
+    : Trader(lookBackSize, candleSizeSeconds, source, orderManager, logger),
+      instrument(instrument), name(std::move(name)) {}
+
+void CoroutineTrader::decide() {
+  const bool ready = data.ok() && !paused();
+  if (!ready) {
+    Trader::decision_params_t decisionParams{
+        {paused() ? "Paused" : "Not enough data", "true"}};
+    decisionParamsSignal(decisionParams);
+  }
+  std::optional<Timestamp> now;
+  if (ready) {
+    auto values = data.indicatorSnapshot();
+    const std::pair candlesKey{values->candles->generation,
+                               values->candles->endIndex};
+    if (resumedOn != candlesKey) {
+      resumedOn = candlesKey;
+      lookBackCandles = data.lookBack(values->candles);
+      indicatorValues = std::move(values);
+      now = lookBackCandles->timestamps().back();
+    }
+  }
+  // strategies resumed below wait again on later candles, so the due ones
+  // are taken out first
+  resuming.clear();
+  std::erase_if(waiting, [&](const Wait *wait) {
+    const bool due = (wait->order && wait->order->isDone()) ||
+                     (now && (wait->candle || (wait->until &&
+                                               *wait->until <= *now)));
+    if (due) {
+      resuming.push_back(wait->handle);
+    }
+    return due;
+  });
+  for (const std::coroutine_handle<> handle : resuming) {
+    handle.resume();
+  }
+  if (!resuming.empty()) {
+    reap();
+  }
+}
+
+std::string CoroutineTrader::traderName() const {
+  return name + " - " + instrument;
+}
+
+std::optional<midas::Timestamp>
+CoroutineTrader::after(std::chrono::nanoseconds duration) const {
+  if (!lookBackCandles) {
+    return std::nullopt;
+  }
+  return lookBackCandles->timestamps().back() + duration.count();
+}
+
+CoroutineTrader::CandleAwaiter CoroutineTrader::nextCandle() {
+  return CandleAwaiter(*this, true, std::nullopt);
+}
+
+CoroutineTrader::CandleAwaiter
+CoroutineTrader::timeout(std::chrono::nanoseconds duration) {
+  // before the first candle there is no time to count from
+  const auto until = after(duration);
+  return CandleAwaiter(*this, !until, until);
+}
+
+CoroutineTrader::FillAwaiter
+CoroutineTrader::fill(std::shared_ptr<Order> order) {
+  return FillAwaiter(*this, false, std::nullopt, std::move(order));
+}
+
+CoroutineTrader::FillAwaiter
+CoroutineTrader::fill(std::shared_ptr<Order> order,
+                      std::chrono::nanoseconds duration) {
+  const auto until = after(duration);
+  return FillAwaiter(*this, !until, until, std::move(order));
+}
+
+std::shared_ptr<midas::Order>
+CoroutineTrader::market(OrderDirection direction, unsigned int quantity) {
+  INFO_LOG(*logger) << "Executing market order for " << instrument << " x"
+                    << quantity << " " << direction;
+  auto order = std::make_shared<SimpleOrder>(quantity, direction, instrument,
+                                             ExecutionType::MKT, logger, 0);
+  order->addStatusChangeListener(
+      [this](Order &, Order::StatusChangeEvent event) { orderEvent(event); });
+  orderManager->transmit(order);
+  return order;
+}
+
+std::shared_ptr<midas::Order> CoroutineTrader::limit(OrderDirection direction,
+                                                     unsigned int quantity,
+                                                     double limitPrice) {
+  INFO_LOG(*logger) << "Executing limit order for " << instrument << " x"
+                    << quantity << " " << direction
+                    << " limitPrice: " << limitPrice;
+  auto order = std::make_shared<SimpleOrder>(
+      quantity, direction, instrument, ExecutionType::Limit, logger,
+      limitPrice);
+  order->addStatusChangeListener(
+      [this](Order &, Order::StatusChangeEvent event) { orderEvent(event); });
+  orderManager->transmit(order);
+  return order;
+}
+
+std::shared_ptr<midas::BracketedOrder>
+CoroutineTrader::bracket(OrderDirection direction, unsigned int quantity,
+                         double entryPrice, double stopLossPrice,
+                         double profitPrice) {
+  INFO_LOG(*logger) << "Entering order for " << instrument << " x" << quantity
+                    << " " << direction << " entryPrice: " << entryPrice
+                    << " stopLossLimit: " << stopLossPrice
+                    << " profitLimit: " << profitPrice;
+  auto order = std::make_shared<BracketedOrder>(quantity, direction,
+                                                instrument, entryPrice,
+                                                profitPrice, stopLossPrice,
+                                                logger);
+  // the base trader keeps the summary of brackets
+  enterBracket(order);
+  return order;
+}
+
+void CoroutineTrader::reap() {
+  std::erase_if(strategies, [this](const Strategy &strategy) {
+    if (!strategy.done()) {
+      return false;
+    }
+    if (const std::exception_ptr error = strategy.handle.promise().error) {
+      try {
+        std::rethrow_exception(error);
+      } catch (const std::exception &e) {
+        ERROR_LOG(*logger) << "Strategy of " << traderName()
+                           << " failed: " << e.what();
+      } catch (...) {
+        ERROR_LOG(*logger) << "Strategy of " << traderName() << " failed";
+      }
+    }
+    return true;
+  });
+}
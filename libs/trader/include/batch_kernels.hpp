@@ -0,0 +1,397 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+namespace midas::trader::batch {
+/**
+ * Building blocks of the batch indicators, one table per instruction set.
+ * Sums run from the oldest value like TA-Lib does, so the instruction sets
+ * only differ in rounding.
+ */
+struct Kernels {
+  /**
+   * out[i] is the mean of in[i - period + 1] to in[i], from i = period - 1
+   */
+  void (*windowMean)(const double *in, std::size_t size, std::size_t period,
+                     double *out);
+  /**
+   * Population variance of the same windows as windowMean
+   */
+  void (*windowVariance)(const double *in, std::size_t size,
+                         std::size_t period, double *out);
+  void (*windowMin)(const double *in, std::size_t size, std::size_t period,
+                    double *out);
+  void (*windowMax)(const double *in, std::size_t size, std::size_t period,
+                    double *out);
+  /**
+   * out[i] = decay * out[i - 1] + gain * in[i] starting from seed, the shape
+   * of exponential and Wilder smoothing. in and out may be the same.
+   */
+  void (*smooth)(const double *in, std::size_t size, double gain, double decay,
+                 double seed, double *out);
+  /**
+   * Standard deviation times deviations, zero where the variance is below
+   * TA-Lib's epsilon. in and out may be the same.
+   */
+  void (*deviation)(const double *variance, std::size_t size,
+                    double deviations, double *out);
+  /**
+   * upper may be the deviation
+   */
+  void (*bands)(const double *middle, const double *deviation,
+                std::size_t size, double deviationsUp, double deviationsDown,
+                double *upper, double *lower);
+  /**
+   * Upward and downward moves from values[i] to values[i + 1]
+   */
+  void (*changes)(const double *values, std::size_t size, double *gains,
+                  double *losses);
+  void (*relativeStrength)(const double *gains, const double *losses,
+                           std::size_t size, double *out);
+  /**
+   * True range of every candle against the close before it
+   */
+  void (*trueRanges)(const double *highs, const double *lows,
+                     const double *previousCloses, std::size_t size,
+                     double *out);
+  /**
+   * Index of the first candle whose low reaches below or whose high reaches
+   * above, size if there is none
+   */
+  std::size_t (*firstTouch)(const double *highs, const double *lows,
+                            std::size_t size, double below, double above);
+};
+
+const Kernels &scalarKernels();
+const Kernels &avx2Kernels();
+const Kernels &avx512Kernels();
+
+// Every instruction set compiles its own copy of the algorithms below, with
+// its own lanes type, so nothing is shared between translation units. No
+// standard library templates either: their instantiations are weak symbols
+// the linker may take from the wider instruction set files for the whole
+// program, see tests/check_kernel_symbols.cmake.
+namespace {
+
+inline double smaller(double a, double b) { return b < a ? b : a; }
+inline double larger(double a, double b) { return a < b ? b : a; }
+inline std::size_t smaller(std::size_t a, std::size_t b) {
+  return b < a ? b : a;
+}
+inline std::size_t larger(std::size_t a, std::size_t b) {
+  return a < b ? b : a;
+}
+
+/**
+ * Scratch values of a kernel call
+ */
+class Scratch {
+public:
+  explicit Scratch(std::size_t size) : values(new double[size]) {}
+  ~Scratch() { delete[] values; }
+  Scratch(const Scratch &) = delete;
+  Scratch &operator=(const Scratch &) = delete;
+  double *data() { return values; }
+  double &operator[](std::size_t i) { return values[i]; }
+
+private:
+  double *values;
+};
+
+/**
+ * One lane, the reference the vector lanes are written against
+ */
+struct ScalarLanes {
+  using reg = double;
+  using mask = bool;
+  static constexpr std::size_t width = 1;
+  static reg load(const double *from) { return *from; }
+  static void store(double *to, reg value) { *to = value; }
+  static reg set(double value) { return value; }
+  static reg add(reg a, reg b) { return a + b; }
+  static reg sub(reg a, reg b) { return a - b; }
+  static reg mul(reg a, reg b) { return a * b; }
+  static reg div(reg a, reg b) { return a / b; }
+  static reg fma(reg a, reg b, reg c) { return a * b + c; }
+  static reg min(reg a, reg b) { return smaller(a, b); }
+  static reg max(reg a, reg b) { return larger(a, b); }
+  static reg sqrt(reg value) { return std::sqrt(value); }
+  static mask less(reg a, reg b) { return a < b; }
+  static mask lessOrEqual(reg a, reg b) { return a <= b; }
+  static mask either(mask a, mask b) { return a || b; }
+  static bool any(mask value) { return value; }
+  static reg select(mask condition, reg ifTrue, reg ifFalse) {
+    return condition ? ifTrue : ifFalse;
+  }
+  static double last(reg value) { return value; }
+};
+
+/**
+ * Runs body over [begin, end) a vector at a time, the remainder one value at
+ * a time
+ */
+template <typename Lanes, typename Body>
+inline void forEachLane(std::size_t begin, std::size_t end, Body &&body) {
+  std::size_t i = begin;
+  for (; i + Lanes::width <= end; i += Lanes::width) {
+    body.template operator()<Lanes>(i);
+  }
+  for (; i < end; i++) {
+    body.template operator()<ScalarLanes>(i);
+  }
+}
+
+/**
+ * Inclusive scan of v[j] += factor^step * v[j - step] within a vector
+ */
+template <typename V>
+inline typename V::reg scanLanes(typename V::reg value, double factor) {
+  if constexpr (V::width > 1) {
+    value = V::fma(V::template shiftUp<1>(value), V::set(factor), value);
+  }
+  if constexpr (V::width > 2) {
+    factor *= factor;
+    value = V::fma(V::template shiftUp<2>(value), V::set(factor), value);
+  }
+  if constexpr (V::width > 4) {
+    factor *= factor;
+    value = V::fma(V::template shiftUp<4>(value), V::set(factor), value);
+  }
+  return value;
+}
+
+template <typename L>
+void windowMean(const double *in, std::size_t size, std::size_t period,
+                double *out) {
+  if (size < period) {
+    return;
+  }
+  double total = 0;
+  for (std::size_t i = 0; i < period; i++) {
+    total += in[i];
+  }
+  const double divisor = static_cast<double>(period);
+  out[period - 1] = total / divisor;
+  // the running total moves by the value entering minus the value leaving,
+  // a prefix sum of those moves gives a whole vector of totals at once
+  forEachLane<L>(period, size, [&]<typename V>(std::size_t i) {
+    const auto moves = V::sub(V::load(in + i), V::load(in + i - period));
+    const auto totals = V::add(scanLanes<V>(moves, 1.0), V::set(total));
+    V::store(out + i, V::div(totals, V::set(divisor)));
+    total = V::last(totals);
+  });
+}
+
+/**
+ * Values worked on at a time where a kernel needs scratch space, small
+ * enough to stay in cache
+ */
+constexpr std::size_t chunkSize = 4096;
+
+/**
+ * Outputs between restarts of the running sums in windowVariance
+ */
+constexpr std::size_t varianceRestart = 4096;
+
+template <typename L>
+void windowVariance(const double *in, std::size_t size, std::size_t period,
+                    double *out) {
+  const double divisor = static_cast<double>(period);
+  // Squares of prices cancel catastrophically, TA-Lib loses most digits of
+  // a small variance that way. Sums run over values shifted by a price from
+  // the same stretch instead, and restart every so often to bound the drift.
+  for (std::size_t start = period - 1; start < size;
+       start += varianceRestart) {
+    const double shift = in[start];
+    double total = 0, squares = 0;
+    for (std::size_t i = start + 1 - period; i <= start; i++) {
+      const double value = in[i] - shift;
+      total += value;
+      squares += value * value;
+    }
+    const double mean = total / divisor;
+    out[start] = squares / divisor - mean * mean;
+    forEachLane<L>(
+        start + 1, smaller(start + varianceRestart, size),
+        [&]<typename V>(std::size_t i) {
+          const auto entering = V::sub(V::load(in + i), V::set(shift));
+          const auto leaving =
+              V::sub(V::load(in + i - period), V::set(shift));
+          const auto totals = V::add(
+              scanLanes<V>(V::sub(entering, leaving), 1.0), V::set(total));
+          const auto squareTotals = V::add(
+              scanLanes<V>(V::sub(V::mul(entering, entering),
+                                  V::mul(leaving, leaving)),
+                           1.0),
+              V::set(squares));
+          const auto means = V::div(totals, V::set(divisor));
+          V::store(out + i, V::sub(V::div(squareTotals, V::set(divisor)),
+                                   V::mul(means, means)));
+          total = V::last(totals);
+          squares = V::last(squareTotals);
+        });
+  }
+}
+
+/**
+ * van Herk/Gil-Werman, constant work per value whatever the period
+ */
+template <typename L, bool Maximum>
+void windowExtreme(const double *in, std::size_t size, std::size_t period,
+                   double *out) {
+  if (size < period) {
+    return;
+  }
+  const auto pick = [](double a, double b) {
+    return Maximum ? larger(a, b) : smaller(a, b);
+  };
+  // extremes from the start and from the end of blocks of period values,
+  // every window is the end of one block and the start of the next. Outputs
+  // go a chunk at a time so the blocks stay in cache.
+  const std::size_t chunk = larger(chunkSize, period);
+  Scratch fromStart(chunk + period), fromEnd(chunk + period);
+  for (std::size_t first = period - 1; first < size; first += chunk) {
+    const std::size_t outputs = smaller(chunk, size - first);
+    const double *window = in + first + 1 - period;
+    const std::size_t length = outputs + period - 1;
+    for (std::size_t block = 0; block < length; block += period) {
+      const std::size_t end = smaller(block + period, length);
+      fromStart[block] = window[block];
+      for (std::size_t i = block + 1; i < end; i++) {
+        fromStart[i] = pick(fromStart[i - 1], window[i]);
+      }
+      fromEnd[end - 1] = window[end - 1];
+      for (std::size_t i = end - 1; i-- > block;) {
+        fromEnd[i] = pick(fromEnd[i + 1], window[i]);
+      }
+    }
+    forEachLane<L>(0, outputs, [&]<typename V>(std::size_t i) {
+      const auto blockEnd = V::load(fromEnd.data() + i);
+      const auto blockStart = V::load(fromStart.data() + i + period - 1);
+      V::store(out + first + i, Maximum ? V::max(blockEnd, blockStart)
+                                        : V::min(blockEnd, blockStart));
+    });
+  }
+}
+
+template <typename L>
+void smooth(const double *in, std::size_t size, double gain, double decay,
+            double seed, double *out) {
+  // decay^(lane + 1), how much of the previous vector reaches every lane
+  double carried[L::width];
+  double power = decay;
+  for (double &lane : carried) {
+    lane = power;
+    power *= decay;
+  }
+  double previous = seed;
+  forEachLane<L>(0, size, [&]<typename V>(std::size_t i) {
+    const auto fresh = scanLanes<V>(V::mul(V::load(in + i), V::set(gain)),
+                                    decay);
+    const auto smoothed =
+        V::fma(V::load(carried), V::set(previous), fresh);
+    V::store(out + i, smoothed);
+    previous = V::last(smoothed);
+  });
+}
+
+template <typename L>
+void deviation(const double *variance, std::size_t size, double deviations,
+               double *out) {
+  forEachLane<L>(0, size, [&]<typename V>(std::size_t i) {
+    const auto spread = V::load(variance + i);
+    const auto scaled = V::mul(V::sqrt(spread), V::set(deviations));
+    V::store(out + i, V::select(V::less(spread, V::set(1e-8)), V::set(0),
+                                scaled));
+  });
+}
+
+template <typename L>
+void bands(const double *middle, const double *deviation, std::size_t size,
+           double deviationsUp, double deviationsDown, double *upper,
+           double *lower) {
+  forEachLane<L>(0, size, [&]<typename V>(std::size_t i) {
+    const auto center = V::load(middle + i);
+    const auto spread = V::load(deviation + i);
+    V::store(upper + i, V::add(center, V::mul(spread, V::set(deviationsUp))));
+    V::store(lower + i,
+             V::sub(center, V::mul(spread, V::set(deviationsDown))));
+  });
+}
+
+template <typename L>
+void changes(const double *values, std::size_t size, double *gains,
+             double *losses) {
+  forEachLane<L>(0, size, [&]<typename V>(std::size_t i) {
+    const auto current = V::load(values + i + 1);
+    const auto previous = V::load(values + i);
+    V::store(gains + i, V::max(V::sub(current, previous), V::set(0)));
+    V::store(losses + i, V::max(V::sub(previous, current), V::set(0)));
+  });
+}
+
+template <typename L>
+void relativeStrength(const double *gains, const double *losses,
+                      std::size_t size, double *out) {
+  forEachLane<L>(0, size, [&]<typename V>(std::size_t i) {
+    const auto gain = V::load(gains + i);
+    const auto total = V::add(gain, V::load(losses + i));
+    const auto strength = V::mul(V::set(100), V::div(gain, total));
+    V::store(out + i,
+             V::select(V::less(total, V::set(1e-8)), V::set(0), strength));
+  });
+}
+
+template <typename L>
+void trueRanges(const double *highs, const double *lows,
+                const double *previousCloses, std::size_t size, double *out) {
+  forEachLane<L>(0, size, [&]<typename V>(std::size_t i) {
+    const auto high = V::load(highs + i);
+    const auto low = V::load(lows + i);
+    const auto previousClose = V::load(previousCloses + i);
+    auto range = V::sub(high, low);
+    range = V::max(range, V::max(V::sub(previousClose, high),
+                                 V::sub(high, previousClose)));
+    range = V::max(range, V::max(V::sub(previousClose, low),
+                                 V::sub(low, previousClose)));
+    V::store(out + i, range);
+  });
+}
+
+template <typename L>
+std::size_t firstTouch(const double *highs, const double *lows,
+                       std::size_t size, double below, double above) {
+  // whole vectors are tested until one touches, the candle within it is
+  // then found one at a time
+  std::size_t i = 0;
+  for (; i + L::width <= size; i += L::width) {
+    if (L::any(L::either(L::lessOrEqual(L::load(lows + i), L::set(below)),
+                         L::lessOrEqual(L::set(above), L::load(highs + i))))) {
+      break;
+    }
+  }
+  for (; i < size; i++) {
+    if (lows[i] <= below || above <= highs[i]) {
+      return i;
+    }
+  }
+  return size;
+}
+
+template <typename L> constexpr Kernels makeKernels() {
+  return {
+      .windowMean = windowMean<L>,
+      .windowVariance = windowVariance<L>,
+      .windowMin = windowExtreme<L, false>,
+      .windowMax = windowExtreme<L, true>,
+      .smooth = smooth<L>,
+      .deviation = deviation<L>,
+      .bands = bands<L>,
+      .changes = changes<L>,
+      .relativeStrength = relativeStrength<L>,
+      .trueRanges = trueRanges<L>,
+      .firstTouch = firstTouch<L>,
+  };
+}
+} // namespace
+} // namespace midas::trader::batch
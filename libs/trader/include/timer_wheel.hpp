@@ -0,0 +1,81 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace midas::trader {
+/**
+ * Hashed timing wheel of whole ticks.
+ * Arming a timer and expiring the timers of a tick only touch one slot.
+ * Timers more than a turn away sit in their slot until their turn comes.
+ * An id has at most one timer armed.
+ * Not thread safe.
+ */
+class TimerWheel {
+public:
+  struct Timer {
+    std::size_t id;
+    std::int64_t tick;
+  };
+
+  TimerWheel(std::size_t slotCount, std::int64_t now)
+      : slots(slotCount), now(now) {}
+
+  /**
+   * Timers at or before the current tick expire on the next advance.
+   * Replaces the timer of id if one is armed.
+   */
+  inline void arm(std::size_t id, std::int64_t tick) {
+    cancel(id);
+    tick = std::max(tick, now + 1);
+    slots[slotOf(tick)].push_back({id, tick});
+    armed.emplace(id, tick);
+  }
+  /**
+   * Disarms the timer of id, if any
+   */
+  inline void cancel(std::size_t id) {
+    const auto found = armed.find(id);
+    if (found == armed.end()) {
+      return;
+    }
+    std::erase_if(slots[slotOf(found->second)],
+                  [id](const Timer &timer) { return timer.id == id; });
+    armed.erase(found);
+  }
+  /**
+   * Moves to tick, appending the timers that expired on the way to expired
+   */
+  void advance(std::int64_t tick, std::vector<Timer> &expired) {
+    // a full turn visits every slot
+    const std::int64_t steps = std::min<std::int64_t>(
+        tick - now, static_cast<std::int64_t>(slots.size()));
+    for (std::int64_t step = 1; step <= steps; step++) {
+      std::vector<Timer> &slot = slots[slotOf(now + step)];
+      const auto kept = std::partition(
+          slot.begin(), slot.end(),
+          [tick](const Timer &timer) { return timer.tick > tick; });
+      for (auto timer = kept; timer != slot.end(); timer++) {
+        armed.erase(timer->id);
+      }
+      expired.insert(expired.end(), kept, slot.end());
+      slot.erase(kept, slot.end());
+    }
+    now = std::max(now, tick);
+  }
+  inline std::int64_t current() const { return now; }
+  inline bool empty() const { return armed.empty(); }
+
+private:
+  std::vector<std::vector<Timer>> slots;
+  std::int64_t now;
+  // tick of every armed timer, by id
+  std::unordered_map<std::size_t, std::int64_t> armed;
+
+  inline std::size_t slotOf(std::int64_t tick) const {
+    return static_cast<std::size_t>(tick) % slots.size();
+  }
+};
+} // namespace midas::trader
@@ -0,0 +1,453 @@
+#include "trader/indicator_graph.hpp"
+#include "trader/batch_indicators.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace midas::trader;
+
+namespace {
+double checkPeriod(int period) {
+  if (period < 1) {
+    throw std::invalid_argument("Indicator period must be positive");
+  }
+  return period;
+}
+} // namespace
+
+IndicatorGraph::IndicatorGraph(std::shared_ptr<const CandleSeries> series)
+    : series(std::move(series)),
+      published(std::make_shared<const IndicatorSnapshot>(
+          this->series->snapshot(),
+          std::make_shared<const std::vector<indicators::History>>())) {}
+
+IndicatorOutput IndicatorGraph::open() {
+  return add({IndicatorType::Open, {}, {}}, {}, 1);
+}
+
+IndicatorOutput IndicatorGraph::high() {
+  return add({IndicatorType::High, {}, {}}, {}, 1);
+}
+
+IndicatorOutput IndicatorGraph::low() {
+  return add({IndicatorType::Low, {}, {}}, {}, 1);
+}
+
+IndicatorOutput IndicatorGraph::close() {
+  return add({IndicatorType::Close, {}, {}}, {}, 1);
+}
+
+IndicatorOutput IndicatorGraph::volume() {
+  return add({IndicatorType::Volume, {}, {}}, {}, 1);
+}
+
+IndicatorOutput IndicatorGraph::ema(IndicatorOutput input, int period) {
+  return add({IndicatorType::Ema, {checkPeriod(period)}, {input.slot}},
+             indicators::Ema(period), 1);
+}
+
+IndicatorOutput IndicatorGraph::sma(IndicatorOutput input, int period) {
+  return add({IndicatorType::Sma, {checkPeriod(period)}, {input.slot}},
+             indicators::Sma(period), 1);
+}
+
+IndicatorOutput IndicatorGraph::rsi(IndicatorOutput input, int period) {
+  return add({IndicatorType::Rsi, {checkPeriod(period)}, {input.slot}},
+             indicators::Rsi(period), 1);
+}
+
+IndicatorOutput IndicatorGraph::atr(int period) {
+  const Key key{IndicatorType::Atr,
+                {checkPeriod(period)},
+                {high().slot, low().slot, close().slot}};
+  return add(key, indicators::Atr(period), 1);
+}
+
+IndicatorGraph::MacdOutputs IndicatorGraph::macd(IndicatorOutput input,
+                                                 int fastPeriod,
+                                                 int slowPeriod,
+                                                 int signalPeriod) {
+  const Key key{IndicatorType::Macd,
+                {checkPeriod(fastPeriod), checkPeriod(slowPeriod),
+                 checkPeriod(signalPeriod)},
+                {input.slot}};
+  const IndicatorOutput first =
+      add(key, indicators::Macd(fastPeriod, slowPeriod, signalPeriod), 3);
+  return {first, {first.slot + 1}, {first.slot + 2}};
+}
+
+IndicatorGraph::BandOutputs
+IndicatorGraph::bollingerBands(IndicatorOutput input, int period,
+                               double deviationsUp, double deviationsDown) {
+  const Key key{IndicatorType::BollingerBands,
+                {checkPeriod(period), deviationsUp, deviationsDown},
+                {input.slot}};
+  const IndicatorOutput first = add(
+      key, indicators::BollingerBands(period, deviationsUp, deviationsDown),
+      3);
+  return {first, {first.slot + 1}, {first.slot + 2}};
+}
+
+IndicatorOutput IndicatorGraph::add(Key key, State state,
+                                    std::size_t outputs) {
+  std::scoped_lock lock(mutex);
+  if (const auto found = registry.find(key); found != registry.end()) {
+    return {nodes[found->second].firstOutput};
+  }
+  for (const std::size_t input : key.inputs) {
+    if (input >= historySizes.size()) {
+      throw std::invalid_argument(
+          "Indicator input is not registered in this graph");
+    }
+  }
+  const std::size_t firstOutput = historySizes.size();
+  historySizes.resize(firstOutput + outputs, 1);
+  registry.emplace(key, nodes.size());
+  nodes.push_back({std::move(key), state, state, firstOutput});
+  // the new indicator has to catch up with the others
+  replay.store(true, std::memory_order::release);
+  return {firstOutput};
+}
+
+void IndicatorGraph::subscribe(IndicatorOutput output,
+                               std::size_t historySize) {
+  std::scoped_lock lock(mutex);
+  if (output.slot >= historySizes.size()) {
+    throw std::invalid_argument("Indicator is not registered in this graph");
+  }
+  if (historySize > historySizes[output.slot]) {
+    historySizes[output.slot] = historySize;
+    replay.store(true, std::memory_order::release);
+  }
+}
+
+std::size_t IndicatorGraph::size() {
+  std::scoped_lock lock(mutex);
+  return nodes.size();
+}
+
+void IndicatorGraph::restart() {
+  for (Node &node : nodes) {
+    node.state = node.initial;
+  }
+  histories.clear();
+  histories.reserve(historySizes.size());
+  for (const std::size_t historySize : historySizes) {
+    histories.emplace_back(historySize);
+  }
+  changed = true;
+}
+
+void IndicatorGraph::append(const Bar &candle) {
+  std::scoped_lock lock(mutex);
+  if (features) {
+    return;
+  }
+  if (replay.load(std::memory_order::relaxed)) {
+    // the published candles are every candle before this one
+    replayRetained(*series->snapshot());
+  }
+  evaluate(nodes, histories, candle);
+  changed = true;
+}
+
+void IndicatorGraph::publish() {
+  std::scoped_lock lock(mutex);
+  publishLocked();
+}
+
+void IndicatorGraph::clear() {
+  std::scoped_lock lock(mutex);
+  // features are indexed from the first candle, which is gone
+  features.reset();
+  restart();
+  publishLocked();
+}
+
+std::optional<IndicatorGraph::Checkpoint> IndicatorGraph::checkpoint() {
+  std::scoped_lock lock(mutex);
+  if (features || replay.load(std::memory_order::relaxed)) {
+    return std::nullopt;
+  }
+  Checkpoint checkpoint;
+  checkpoint.states.reserve(nodes.size());
+  for (const Node &node : nodes) {
+    checkpoint.states.push_back(node.state);
+  }
+  checkpoint.historySizes = historySizes;
+  checkpoint.histories = histories;
+  return checkpoint;
+}
+
+bool IndicatorGraph::restore(const Checkpoint &checkpoint) {
+  std::scoped_lock lock(mutex);
+  if (features || checkpoint.states.size() != nodes.size() ||
+      checkpoint.historySizes != historySizes) {
+    return false;
+  }
+  for (std::size_t i = 0; i < nodes.size(); i++) {
+    nodes[i].state = checkpoint.states[i];
+  }
+  histories = checkpoint.histories;
+  changed = true;
+  publishLocked();
+  return true;
+}
+
+void IndicatorGraph::publishLocked() {
+  auto candles = series->snapshot();
+  if (features) {
+    // features are only dropped when the series starts over, which the
+    // indicators do anyway
+    replay.store(false, std::memory_order::release);
+    published.store(std::make_shared<const IndicatorSnapshot>(
+                        std::move(candles), features),
+                    std::memory_order::release);
+    return;
+  }
+  if (replay.load(std::memory_order::relaxed)) {
+    replayRetained(*candles);
+  }
+  // a new forming candle alone leaves the values as they are
+  auto values =
+      changed ? std::make_shared<const std::vector<indicators::History>>(
+                    histories)
+              : published.load(std::memory_order::relaxed)->histories;
+  changed = false;
+  published.store(std::make_shared<const IndicatorSnapshot>(
+                      std::move(candles), std::move(values)),
+                  std::memory_order::release);
+}
+
+void IndicatorGraph::replayRetained(const CandleSnapshot &candles) {
+  restart();
+  for (std::size_t i = 0; i < candles.size(); i++) {
+    evaluate(nodes, histories,
+             Bar(series->candleSizeSeconds, candles.tradeCounts()[i],
+                 candles.highs()[i], candles.lows()[i], candles.opens()[i],
+                 candles.closes()[i], candles.vwaps()[i],
+                 candles.volumes()[i], candles.timestamps()[i]));
+  }
+  replay.store(false, std::memory_order::release);
+}
+
+IndicatorGraph::FeatureBuilder
+IndicatorGraph::featureBuilder(std::size_t candles) {
+  std::scoped_lock lock(mutex);
+  return FeatureBuilder(nodes, historySizes, candles);
+}
+
+void IndicatorGraph::useFeatures(
+    std::shared_ptr<const FeatureMatrix> features) {
+  std::scoped_lock lock(mutex);
+  this->features = std::move(features);
+  publishLocked();
+}
+
+IndicatorGraph::FeatureBuilder::FeatureBuilder(
+    std::vector<Node> nodes, std::vector<std::size_t> historySizes,
+    std::size_t candles)
+    : nodes(std::move(nodes)), historySizes(std::move(historySizes)) {
+  this->candles.reserve(candles);
+}
+
+std::shared_ptr<const FeatureMatrix> IndicatorGraph::FeatureBuilder::finish() {
+  constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+  const auto features = std::make_shared<FeatureMatrix>();
+  features->candles = candles.size();
+  features->columns.assign(
+      historySizes.size(),
+      std::vector<double>(candles.size(),
+                          std::numeric_limits<double>::quiet_NaN()));
+  features->firstValues.assign(historySizes.size(), none);
+  features->historySizes = historySizes;
+  auto &columns = features->columns;
+  auto &firstValues = features->firstValues;
+  for (const Node &node : nodes) {
+    const auto &inputs = node.key.inputs;
+    const auto &parameters = node.key.parameters;
+    // the same candles as evaluate, from the first one every input has a
+    // value for
+    std::size_t first = 0;
+    for (const std::size_t input : inputs) {
+      first = std::max(first, firstValues[input]);
+    }
+    if (first == none) {
+      continue;
+    }
+    const auto input = [&](std::size_t i) {
+      return std::span<const double>(columns[inputs[i]]).subspan(first);
+    };
+    const auto output = [&](std::size_t i) {
+      return std::span<double>(columns[node.firstOutput + i]).subspan(first);
+    };
+    const auto candleColumn = [&](double Bar::*field) {
+      for (std::size_t candle = 0; candle < candles.size(); candle++) {
+        columns[node.firstOutput][candle] = candles[candle].*field;
+      }
+      return std::size_t{0};
+    };
+    const auto period = [&parameters](std::size_t i) {
+      return static_cast<int>(parameters[i]);
+    };
+    std::size_t outputs = 1, lookBack = 0;
+    switch (node.key.type) {
+    case IndicatorType::Open:
+      lookBack = candleColumn(&Bar::open);
+      break;
+    case IndicatorType::High:
+      lookBack = candleColumn(&Bar::high);
+      break;
+    case IndicatorType::Low:
+      lookBack = candleColumn(&Bar::low);
+      break;
+    case IndicatorType::Close:
+      lookBack = candleColumn(&Bar::close);
+      break;
+    case IndicatorType::Volume:
+      lookBack = candleColumn(&Bar::volume);
+      break;
+    case IndicatorType::Ema:
+      lookBack = batch::ema(input(0), period(0), output(0));
+      break;
+    case IndicatorType::Sma:
+      lookBack = batch::sma(input(0), period(0), output(0));
+      break;
+    case IndicatorType::Rsi:
+      lookBack = batch::rsi(input(0), period(0), output(0));
+      break;
+    case IndicatorType::Atr:
+      lookBack =
+          batch::atr(input(0), input(1), input(2), period(0), output(0));
+      break;
+    case IndicatorType::Macd:
+      outputs = 3;
+      lookBack = macdColumns(input(0), period(0), period(1), period(2),
+                             output(0), output(1), output(2));
+      break;
+    case IndicatorType::BollingerBands:
+      outputs = 3;
+      lookBack = batch::bollingerBands(input(0), period(0), parameters[1],
+                                       parameters[2], output(0), output(1),
+                                       output(2));
+      break;
+    }
+    if (first + lookBack < candles.size()) {
+      for (std::size_t i = 0; i < outputs; i++) {
+        firstValues[node.firstOutput + i] = first + lookBack;
+      }
+    }
+  }
+  return features;
+}
+
+std::size_t IndicatorGraph::FeatureBuilder::macdColumns(
+    std::span<const double> values, int fastPeriod, int slowPeriod,
+    int signalPeriod, std::span<double> macd, std::span<double> signal,
+    std::span<double> histogram) {
+  const std::size_t fast = std::min(fastPeriod, slowPeriod);
+  const std::size_t slow = std::max(fastPeriod, slowPeriod);
+  const std::size_t lookBack = slow + signalPeriod - 2;
+  std::ranges::fill(macd, std::numeric_limits<double>::quiet_NaN());
+  std::ranges::fill(signal, std::numeric_limits<double>::quiet_NaN());
+  std::ranges::fill(histogram, std::numeric_limits<double>::quiet_NaN());
+  if (lookBack >= values.size()) {
+    return lookBack;
+  }
+  // TA-Lib seeds both averages so that they start on the same value, the
+  // fast one from the last of the values that seed the slow one
+  std::vector<double> slowAverage(values.size()), line(values.size());
+  batch::ema(values, static_cast<int>(slow), slowAverage);
+  batch::ema(values.subspan(slow - fast), static_cast<int>(fast),
+             std::span(line).subspan(slow - fast));
+  for (std::size_t i = slow - 1; i < values.size(); i++) {
+    line[i] -= slowAverage[i];
+  }
+  // the histogram holds the signal until the outputs are copied, its warm
+  // up is NaN either way
+  batch::ema(std::span<const double>(line).subspan(slow - 1), signalPeriod,
+             histogram.subspan(slow - 1));
+  for (std::size_t i = lookBack; i < values.size(); i++) {
+    macd[i] = line[i];
+    signal[i] = histogram[i];
+    histogram[i] = line[i] - signal[i];
+  }
+  return lookBack;
+}
+
+void IndicatorGraph::evaluate(std::vector<Node> &nodes,
+                              std::vector<indicators::History> &histories,
+                              const Bar &candle) {
+  for (Node &node : nodes) {
+    const auto &inputs = node.key.inputs;
+    // indicators only see candles their inputs have values for
+    if (!std::ranges::all_of(inputs, [&histories](std::size_t slot) {
+          return histories[slot].size() > 0;
+        })) {
+      continue;
+    }
+    std::visit(
+        [&](auto &indicator) {
+          step(
+              node, indicator, candle,
+              [&](std::size_t i) { return histories[inputs[i]].back(); },
+              [&](std::size_t i, double value) {
+                histories[node.firstOutput + i].push(value);
+              });
+        },
+        node.state);
+  }
+}
+
+template <typename Indicator, typename Input, typename Output>
+void IndicatorGraph::step(const Node &node, Indicator &indicator,
+                          const Bar &candle, Input &&input, Output &&output) {
+  if constexpr (std::is_same_v<Indicator, std::monostate>) {
+    switch (node.key.type) {
+    case IndicatorType::Open:
+      output(0, candle.open);
+      break;
+    case IndicatorType::High:
+      output(0, candle.high);
+      break;
+    case IndicatorType::Low:
+      output(0, candle.low);
+      break;
+    case IndicatorType::Close:
+      output(0, candle.close);
+      break;
+    case IndicatorType::Volume:
+      output(0, candle.volume);
+      break;
+    default:
+      break;
+    }
+  } else if constexpr (std::is_same_v<Indicator, indicators::Atr>) {
+    indicator.add(input(0), input(1), input(2));
+    if (indicator.ready()) {
+      output(0, indicator.value());
+    }
+  } else if constexpr (std::is_same_v<Indicator, indicators::Macd>) {
+    indicator.add(input(0));
+    if (indicator.ready()) {
+      output(0, indicator.macd());
+      output(1, indicator.signal());
+      output(2, indicator.histogram());
+    }
+  } else if constexpr (std::is_same_v<Indicator,
+                                      indicators::BollingerBands>) {
+    indicator.add(input(0));
+    if (indicator.ready()) {
+      output(0, indicator.upper());
+      output(1, indicator.middle());
+      output(2, indicator.lower());
+    }
+  } else {
+    // moving averages and oscillators of a single input
+    indicator.add(input(0));
+    if (indicator.ready()) {
+      output(0, indicator.value());
+    }
+  }
+}
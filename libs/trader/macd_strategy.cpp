@@ -0,0 +1,125 @@
+#include "trader/macd_strategy.hpp"
+#include "logging/logging.hpp"
+
+using namespace midas;
+using namespace midas::trader;
+
+namespace {
+struct Analysis {
+  // a copy, the strategy outlives the call that spawned it
+  const MacdParameters parameters;
+  IndicatorOutput rsi, volumeMa;
+  IndicatorGraph::MacdOutputs macd;
+
+  Analysis(IndicatorGraph &graph, const MacdParameters &parameters)
+      : parameters(parameters) {
+    const IndicatorOutput close = graph.close();
+    macd = graph.macd(close, parameters.macdFastPeriod,
+                      parameters.macdSlowPeriod, parameters.macdSignalPeriod);
+    rsi = graph.rsi(close, parameters.rsiTimePeriod);
+    volumeMa = graph.ema(graph.volume(), parameters.volumeMATimePeriod);
+    graph.subscribe(macd.histogram, parameters.maxCrossOverDistance + 1);
+  }
+
+  /**
+   * Seconds a position is held before exits are considered
+   */
+  std::int64_t minimumSecondsInPosition() const {
+    return parameters.numberOfConsecutivePeriodsRequired * 5;
+  }
+
+  /**
+   * Number of candles since the histogram last matched, the size of the
+   * history if it never did
+   */
+  template <typename Predicate>
+  std::size_t histogramEndDistance(const IndicatorSnapshot &values,
+                                   Predicate &&matches) const {
+    const std::size_t size = values.size(macd.histogram);
+    std::size_t distance = 0;
+    while (distance < size && !matches(values.value(macd.histogram, distance))) {
+      distance++;
+    }
+    return distance;
+  }
+
+  std::optional<OrderDirection> entry(const IndicatorSnapshot &values) const {
+    const auto volumes = values.candles->volumes();
+    if (!(volumes.back() > values.value(volumeMa))) {
+      return std::nullopt;
+    }
+    const auto crossed = [this](std::size_t distance) {
+      return distance > 1 && distance <= parameters.maxCrossOverDistance;
+    };
+    const double currentRsi = values.value(rsi);
+    if (crossed(histogramEndDistance(values, [](double x) { return x < 0; })) &&
+        !(currentRsi > parameters.rsiOverbought)) {
+      return OrderDirection::BUY;
+    }
+    if (crossed(histogramEndDistance(values, [](double x) { return x > 0; })) &&
+        !(currentRsi < parameters.rsiOversold)) {
+      return OrderDirection::SELL;
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * Longs exit on a declining histogram while overbought, shorts on a rising
+   * one while oversold
+   */
+  bool exit(const IndicatorSnapshot &values, OrderDirection position) const {
+    const bool isLong = position == OrderDirection::BUY;
+    const double currentRsi = values.value(rsi);
+    if (isLong ? !(currentRsi > parameters.rsiOverbought)
+               : !(currentRsi < parameters.rsiOversold)) {
+      return false;
+    }
+    const std::size_t size = values.size(macd.histogram);
+    const auto consecutivePeriodsRequired =
+        static_cast<std::size_t>(parameters.numberOfConsecutivePeriodsRequired);
+    for (std::size_t offset = 0;
+         offset <= consecutivePeriodsRequired && offset + 1 < size; offset++) {
+      const double current = values.value(macd.histogram, offset),
+                   previous = values.value(macd.histogram, offset + 1);
+      if (isLong ? !(current < previous) : !(current > previous)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+} // namespace
+
+Strategy midas::trader::macdStrategy(CoroutineTrader &trader,
+                                     std::size_t entryQuantity,
+                                     const MacdParameters &parameters) {
+  const Analysis analysis(trader.indicatorGraph(), parameters);
+  const auto quantity = static_cast<unsigned int>(entryQuantity);
+  while (true) {
+    co_await trader.nextCandle();
+    const std::optional<OrderDirection> direction =
+        analysis.entry(trader.indicators());
+    if (!direction) {
+      continue;
+    }
+    INFO_LOG(*trader.log()) << "entering "
+                            << (*direction == OrderDirection::BUY ? "long"
+                                                                  : "short")
+                            << " position";
+    const Timestamp entryTime = trader.candles().timestamps().back();
+    if (co_await trader.fill(trader.market(*direction, quantity)) !=
+        OrderStatusEnum::Filled) {
+      continue;
+    }
+    do {
+      co_await trader.nextCandle();
+    } while (secondsBetween(entryTime, trader.candles().timestamps().back()) <
+                 analysis.minimumSecondsInPosition() ||
+             !analysis.exit(trader.indicators(), *direction));
+    const OrderDirection exitDirection = *direction == OrderDirection::BUY
+                                             ? OrderDirection::SELL
+                                             : OrderDirection::BUY;
+    // a cancelled exit is not retried, as with the MacdTrader
+    co_await trader.fill(trader.market(exitDirection, quantity));
+  }
+}
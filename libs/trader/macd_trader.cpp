@@ -3,60 +3,55 @@
 //
 #include "trader/macd_trader.hpp"
 
-#include <ta_func.h>
 using namespace midas;
 using namespace midas::trader;
 
 MacdTrader::MacdTrader(
-    const std::shared_ptr<midas::DataStream> &source,
+    const CandleSource &source,
     const std::shared_ptr<midas::OrderManager> &orderManager,
     midas::InstrumentEnum instrument, std::size_t entryQuantity,
-    const std::shared_ptr<logging::thread_safe_logger_t> &logger)
-    : MacdTrader(100, source, orderManager, instrument, entryQuantity, logger) {
+    const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+    const MacdParameters &parameters)
+    : MacdTrader(100, source, orderManager, instrument, entryQuantity, logger,
+                 parameters) {
 
 }
 
 MacdTrader::MacdTrader(
-    std::size_t bufferSize, const std::shared_ptr<midas::DataStream> &source,
+    std::size_t bufferSize, const CandleSource &source,
     const std::shared_ptr<midas::OrderManager> &orderManager,
     midas::InstrumentEnum instrument, std::size_t entryQuantity,
-    const std::shared_ptr<logging::thread_safe_logger_t> &logger)
+    const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+    const MacdParameters &parameters)
     : Trader(bufferSize, 120, source, orderManager, logger),
-      instrument(instrument), entryQuantity(entryQuantity) {
-  closePrices.reserve(data.lookBackSize);
-  volumes.reserve(data.lookBackSize);
-  highs.reserve(data.lookBackSize);
-  lows.reserve(data.lookBackSize);
-  opens.reserve(data.lookBackSize);
-  trades.reserve(data.lookBackSize);
-  timestamps.reserve(data.lookBackSize);
+      parameters(parameters), instrument(instrument),
+      entryQuantity(entryQuantity) {
+  IndicatorGraph &graph = data.indicatorGraph();
+  const IndicatorOutput close = graph.close();
+  analysis.fastMa = graph.ema(close, parameters.fastMATimePeriod);
+  analysis.slowMa = graph.ema(close, parameters.slowMATimePeriod);
+  analysis.macd = graph.macd(close, parameters.macdFastPeriod,
+                             parameters.macdSlowPeriod,
+                             parameters.macdSignalPeriod);
+  analysis.rsi = graph.rsi(close, parameters.rsiTimePeriod);
+  analysis.volumeMa = graph.ema(graph.volume(), parameters.volumeMATimePeriod);
+  graph.subscribe(analysis.macd.histogram,
+                  parameters.maxCrossOverDistance + 1);
 }
 
-void MacdTrader::calculateTechnicalAnalysis() {
-  clearBuffers();
-  data.copy(trades, highs, lows, opens, closePrices, vwaps, volumes,
-            timestamps);
-  TA_MACD(0, closePrices.size() - 1, closePrices.data(), macdFastPeriod,
-          macdSlowPeriod, macdSignalPeriod, &macdOutBegin, &macdOutSize,
-          macd.data(), macdSignal.data(), macdHistogram.data());
-  TA_RSI(0, closePrices.size() - 1, closePrices.data(), rsiTimePeriod,
-         &rsiOutBegin, &rsiOutSize, rsi.data());
-  TA_EMA(0, closePrices.size() - 1, closePrices.data(), fastMATimePeriod,
-         &fastMAOutBeg, &fastMAOutSize, fastMa.data());
-  TA_EMA(0, closePrices.size() - 1, closePrices.data(), slowMATimePeriod,
-         &slowMAOutBeg, &slowMAOutSize, slowMa.data());
-  TA_EMA(0, volumes.size() - 1, volumes.data(), volumeMATimePeriod,
-         &volumeMAOutBegin, &volumeMAOutSize, volumeMa.data());
-}
+void MacdTrader::calculateTechnicalAnalysis() { loadCandles(); }
 
-void MacdTrader::clearBuffers() {
-  closePrices.clear();
-  volumes.clear();
-  highs.clear();
-  lows.clear();
-  opens.clear();
-  trades.clear();
-  timestamps.clear();
+void MacdTrader::loadCandles() {
+  indicatorValues = data.indicatorSnapshot();
+  candles = data.lookBack(indicatorValues->candles);
+  trades = candles->tradeCounts();
+  highs = candles->highs();
+  lows = candles->lows();
+  opens = candles->opens();
+  closePrices = candles->closes();
+  vwaps = candles->vwaps();
+  volumes = candles->volumes();
+  timestamps = candles->timestamps();
 }
 
 std::string MacdTrader::traderName() const {
@@ -103,14 +98,23 @@ void MacdTrader::decideLongExit() {
   if (!entryTime.has_value()) {
     throw std::runtime_error("No entry time set");
   }
-  auto timeDiff =  timestamps.back() - entryTime.value();
-  if (  timeDiff.total_seconds() < numberOfConsecutivePeriodsRequired * 5) {
+  const auto secondsInPosition =
+      midas::secondsBetween(entryTime.value(), timestamps.back());
+  if (secondsInPosition < parameters.numberOfConsecutivePeriodsRequired * 5) {
     return;
   }
-  bool overbought = rsi[rsiOutSize - 1] > 75;
+  bool overbought =
+      indicatorValues->value(analysis.rsi) > parameters.rsiOverbought;
   bool histogramDeclining = true;
-  for (int i = macdOutSize - 1; i >= macdOutSize - 1 - numberOfConsecutivePeriodsRequired && i > 0; i -= 1) {
-    histogramDeclining = histogramDeclining && macdHistogram[i] < macdHistogram[i - 1];
+  const IndicatorOutput macdHistogram = analysis.macd.histogram;
+  const std::size_t histogramSize = indicatorValues->size(macdHistogram);
+  const auto periods =
+      static_cast<std::size_t>(parameters.numberOfConsecutivePeriodsRequired);
+  for (std::size_t offset = 0;
+       offset <= periods && offset + 1 < histogramSize; offset++) {
+    histogramDeclining = histogramDeclining &&
+                         indicatorValues->value(macdHistogram, offset) <
+                             indicatorValues->value(macdHistogram, offset + 1);
   }
   if ( histogramDeclining && overbought) {
     currentState = TraderState::Waiting;
@@ -133,14 +137,23 @@ void MacdTrader::decideShortExit() {
   if (!entryTime.has_value()) {
     throw std::runtime_error("No entry time set");
   }
-  auto timeDiff =  timestamps.back() - entryTime.value();
-  if (  timeDiff.total_seconds() < numberOfConsecutivePeriodsRequired * 5) {
+  const auto secondsInPosition =
+      midas::secondsBetween(entryTime.value(), timestamps.back());
+  if (secondsInPosition < parameters.numberOfConsecutivePeriodsRequired * 5) {
     return;
   }
-  bool oversold = rsi[rsiOutSize - 1] < 25;
+  bool oversold =
+      indicatorValues->value(analysis.rsi) < parameters.rsiOversold;
   bool histogramIncreasing = true;
-  for (int i = macdOutSize - 1; i >= macdOutSize - 1 - numberOfConsecutivePeriodsRequired && i > 0; i -= 1) {
-    histogramIncreasing = histogramIncreasing && macdHistogram[i] > macdHistogram[i - 1];
+  const IndicatorOutput macdHistogram = analysis.macd.histogram;
+  const std::size_t histogramSize = indicatorValues->size(macdHistogram);
+  const auto periods =
+      static_cast<std::size_t>(parameters.numberOfConsecutivePeriodsRequired);
+  for (std::size_t offset = 0;
+       offset <= periods && offset + 1 < histogramSize; offset++) {
+    histogramIncreasing = histogramIncreasing &&
+                          indicatorValues->value(macdHistogram, offset) >
+                              indicatorValues->value(macdHistogram, offset + 1);
   }
   if ( histogramIncreasing  && oversold) {
     currentState = TraderState::Waiting;
@@ -164,27 +177,22 @@ void MacdTrader::decideEntry() {
   // for longs we are looking for change in histogram from negative to positive
   // for shorts we are looking for change from positive to negative
 
-  const std::size_t maxCrossOverDistance = 25;
-  auto lastNegativeHistogramItr =
-      std::find_if(macdHistogram.rbegin(), macdHistogram.rend(),
-                   [](double x) { return x < 0; });
   std::size_t const lastNegativeHistogramEndDistance =
-      std::distance(macdHistogram.rbegin(), lastNegativeHistogramItr);
+      histogramEndDistance([](double x) { return x < 0; });
   bool macdCrossPositive =
       lastNegativeHistogramEndDistance > 1 &&
-      lastNegativeHistogramEndDistance <= maxCrossOverDistance;
-  bool oversold = rsi[rsiOutSize - 1] < 25;
-  bool overbought = rsi[rsiOutSize - 1] > 75;
-  bool volumeAcceptable = volumes[volumes.size() - 1] >
-                            volumeMa[volumeMAOutSize - 1 ];
-  auto lastPositiveHistogramItr =
-      std::find_if(macdHistogram.rbegin(), macdHistogram.rend(),
-                   [](double x) { return x > 0; });
+      lastNegativeHistogramEndDistance <= parameters.maxCrossOverDistance;
+  bool oversold =
+      indicatorValues->value(analysis.rsi) < parameters.rsiOversold;
+  bool overbought =
+      indicatorValues->value(analysis.rsi) > parameters.rsiOverbought;
+  bool volumeAcceptable =
+      volumes[volumes.size() - 1] > indicatorValues->value(analysis.volumeMa);
   const std::size_t lastPositiveHistogramEndDistance =
-      std::distance(macdHistogram.rbegin(), lastPositiveHistogramItr);
+      histogramEndDistance([](double x) { return x > 0; });
   bool macdCrossNegative =
       lastPositiveHistogramEndDistance > 1 &&
-      lastPositiveHistogramEndDistance <= maxCrossOverDistance;
+      lastPositiveHistogramEndDistance <= parameters.maxCrossOverDistance;
 
   auto executeCallback =
       [this](Order::StatusChangeEvent event, TraderState targetState) {
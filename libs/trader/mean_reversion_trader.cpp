@@ -4,70 +4,86 @@
 
 #include "trader/mean_reversion_trader.hpp"
 
-#include <ta_func.h>
-
 using namespace midas::trader;
 
 MeanReversionTrader::MeanReversionTrader(
-    const std::shared_ptr<midas::DataStream> &source,
+    const CandleSource &source,
     const std::shared_ptr<midas::OrderManager> &orderManager,
     midas::InstrumentEnum instrument, std::size_t entryQuantity,
-    const std::shared_ptr<logging::thread_safe_logger_t> &logger)
+    const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+    const MeanReversionParameters &parameters)
     : MeanReversionTrader(100, source, orderManager, instrument, entryQuantity,
-                          logger) {}
+                          logger, parameters) {}
 
 MeanReversionTrader::MeanReversionTrader(
-    std::size_t bufferSize, const std::shared_ptr<midas::DataStream> &source,
+    std::size_t bufferSize, const CandleSource &source,
     const std::shared_ptr<midas::OrderManager> &orderManager,
     midas::InstrumentEnum instrument, std::size_t entryQuantity,
-    const std::shared_ptr<logging::thread_safe_logger_t> &logger)
+    const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+    const MeanReversionParameters &parameters)
     : Trader(bufferSize, 120, source, orderManager, logger),
-      instrument(instrument), entryQuantity(entryQuantity) {}
-
-void MeanReversionTrader::clearBuffers() {
-  closePrices.clear();
-  volumes.clear();
-  highs.clear();
-  highs.clear();
-  lows.clear();
-  opens.clear();
-  trades.clear();
-  timestamps.clear();
-};
+      parameters(parameters), instrument(instrument),
+      instrumentSpec(getInstrumentSpec(instrument)),
+      entryQuantity(entryQuantity) {
+  IndicatorGraph &graph = data.indicatorGraph();
+  bbands = graph.bollingerBands(graph.close(), parameters.bbandsPeriod,
+                                parameters.bbandsDeviations,
+                                parameters.bbandsDeviations);
+  for (const IndicatorOutput output :
+       {bbands.upper, bbands.middle, bbands.lower}) {
+    graph.subscribe(output, parameters.bbandsPeriod);
+  }
+}
+
+void MeanReversionTrader::loadCandles() {
+  indicatorValues = data.indicatorSnapshot();
+  candles = data.lookBack(indicatorValues->candles);
+  trades = candles->tradeCounts();
+  highs = candles->highs();
+  lows = candles->lows();
+  opens = candles->opens();
+  closePrices = candles->closes();
+  vwaps = candles->vwaps();
+  volumes = candles->volumes();
+  timestamps = candles->timestamps();
+}
 
 std::pair<double, double> MeanReversionTrader::decideProfitAndStopLossLevels(
     double entryPrice [[maybe_unused]], OrderDirection direction) {
-  double profitTaker = bbMiddle.back();
+  const double upper = indicatorValues->value(bbands.upper);
+  const double middle = indicatorValues->value(bbands.middle);
+  const double lower = indicatorValues->value(bbands.lower);
+  double profitTaker = middle;
   double stopLoss;
   if (direction == OrderDirection::BUY) {
-    stopLoss = bbLower.back() - 2;
+    stopLoss = lower - parameters.stopLossMargin;
     if (stopLoss >= entryPrice) {
-      stopLoss = entryPrice - bbUpper.back() - bbMiddle.back() - 0.5;
+      stopLoss = entryPrice - upper - middle - 0.5;
     }
     if (profitTaker <= entryPrice) {
-      profitTaker = entryPrice + bbUpper.back() - bbMiddle.back() + 0.5;
+      profitTaker = entryPrice + upper - middle + 0.5;
     }
   } else {
-    stopLoss = bbUpper.back() + 2;
+    stopLoss = upper + parameters.stopLossMargin;
     if (stopLoss <= entryPrice) {
-      stopLoss = entryPrice + bbUpper.back() - bbMiddle.back() + 0.5;
+      stopLoss = entryPrice + upper - middle + 0.5;
     }
     if (profitTaker >= entryPrice) {
-      profitTaker = entryPrice - bbUpper.back() - bbMiddle.back() - 0.5;
+      profitTaker = entryPrice - upper - middle - 0.5;
     }
   }
-  profitTaker = std::round(profitTaker * roundingCoeff) / roundingCoeff;
-  stopLoss = std::round(stopLoss * roundingCoeff) / roundingCoeff;
+  profitTaker = instrumentSpec.roundToTick(profitTaker);
+  stopLoss = instrumentSpec.roundToTick(stopLoss);
   return {profitTaker, stopLoss};
 }
 
 MeanReversionTrader::candle_decision_t
 MeanReversionTrader::decideCandle(std::size_t candleEndOffset) {
   const int sizeOffset = -1 - candleEndOffset;
-  bool aboveUpper =
-      closePrices[closePrices.size() + sizeOffset] >= bbUpper[bbUpper.size() + sizeOffset];
-  bool belowLower =
-      closePrices[closePrices.size() + sizeOffset] <= bbLower[bbLower.size() + sizeOffset];
+  bool aboveUpper = closePrices[closePrices.size() + sizeOffset] >=
+                    indicatorValues->value(bbands.upper, candleEndOffset);
+  bool belowLower = closePrices[closePrices.size() + sizeOffset] <=
+                    indicatorValues->value(bbands.lower, candleEndOffset);
 
   double bullishIndicator = static_cast<double>(belowLower);
   double bearishIndicator = static_cast<double>(aboveUpper);
@@ -88,17 +104,10 @@ std::size_t MeanReversionTrader::decideEntryQuantity() { return entryQuantity; }
 
 double MeanReversionTrader::decideEntryPrice() {
   double entryPrice = closePrices.back();
-  return std::round(entryPrice * roundingCoeff) / roundingCoeff;
+  return instrumentSpec.roundToTick(entryPrice);
 }
 
-void MeanReversionTrader::calculateTechnicalAnalysis() {
-  clearBuffers();
-  data.copy(trades, highs, lows, opens, closePrices, vwaps, volumes,
-            timestamps);
-  TA_BBANDS(0, closePrices.size() - 1, closePrices.data(), 20, 2.0, 2.0, TA_MAType_SMA,
-            &bbBegIndex, &bbOutSize, bbUpper.data(), bbMiddle.data(),
-            bbLower.data());
-}
+void MeanReversionTrader::calculateTechnicalAnalysis() { loadCandles(); }
 
 void MeanReversionTrader::decide() {
   if (!data.ok() || hasOpenPosition() || paused()) {
@@ -134,14 +143,14 @@ void MeanReversionTrader::decide() {
 
   if (enterLong) {
     INFO_LOG(*logger) << "entering long bracket "
-                      << " bar time: " << timestamps.back();
+                      << " bar time: " << midas::toPtime(timestamps.back());
     const auto bracketBoundaries =
         decideProfitAndStopLossLevels(entryPrice, OrderDirection::BUY);
     enterBracket(instrument, entryQuantity, midas::OrderDirection::BUY,
                  entryPrice, bracketBoundaries.second, bracketBoundaries.first);
   } else if (enterShort) {
     INFO_LOG(*logger) << "entering short bracket "
-                      << " bar time: " << timestamps.back();
+                      << " bar time: " << midas::toPtime(timestamps.back());
     const auto bracketBoundaries =
         decideProfitAndStopLossLevels(entryPrice, OrderDirection::SELL);
     enterBracket(instrument, entryQuantity, midas::OrderDirection::SELL,
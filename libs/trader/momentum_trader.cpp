@@ -1,10 +1,8 @@
 #include "trader/momentum_trader.hpp"
 #include "broker-interface/order.hpp"
 #include "logging/logging.hpp"
-#include "ta_func.h"
 
 #include <algorithm>
-#include <array>
 #include <cmath>
 #include <memory>
 #include <string>
@@ -13,73 +11,62 @@
 using namespace midas::trader;
 
 MomentumTrader::MomentumTrader(
-    const std::shared_ptr<midas::DataStream> &source,
+    const CandleSource &source,
     const std::shared_ptr<midas::OrderManager> &orderManager,
     midas::InstrumentEnum instrument, std::size_t entryQuantity,
-    const std::shared_ptr<logging::thread_safe_logger_t> &logger)
+    const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+    const MomentumParameters &parameters)
     : MomentumTrader(100, source, orderManager, instrument, entryQuantity,
-                     logger) {}
+                     logger, parameters) {}
 
 MomentumTrader::MomentumTrader(
-    std::size_t bufferSize, const std::shared_ptr<midas::DataStream> &source,
+    std::size_t bufferSize, const CandleSource &source,
     const std::shared_ptr<midas::OrderManager> &orderManager,
     midas::InstrumentEnum instrument, std::size_t entryQuantity,
-    const std::shared_ptr<logging::thread_safe_logger_t> &logger)
+    const std::shared_ptr<logging::thread_safe_logger_t> &logger,
+    const MomentumParameters &parameters)
     : Trader(bufferSize, 5, source, orderManager, logger),
-      instrument(instrument), entryQuantity(entryQuantity) {
-  closePrices.reserve(data.lookBackSize);
-  volumes.reserve(data.lookBackSize);
-  highs.reserve(data.lookBackSize);
-  lows.reserve(data.lookBackSize);
-  opens.reserve(data.lookBackSize);
-  trades.reserve(data.lookBackSize);
-  timestamps.reserve(data.lookBackSize);
+      parameters(parameters), instrument(instrument),
+      instrumentSpec(getInstrumentSpec(instrument)),
+      entryQuantity(entryQuantity) {
+  IndicatorGraph &graph = data.indicatorGraph();
+  const IndicatorOutput close = graph.close();
+  analysis.fastMa = graph.ema(close, parameters.fastMATimePeriod);
+  analysis.slowMa = graph.ema(close, parameters.slowMATimePeriod);
+  analysis.volumeMa = graph.sma(graph.volume(), parameters.volumeMATimePeriod);
+  analysis.atr = graph.atr(parameters.atrTimePeriod);
+  analysis.atrMA = graph.ema(analysis.atr, parameters.atrSmoothingPeriod);
+  analysis.macd = graph.macd(close, parameters.macdFastPeriod,
+                             parameters.macdSlowPeriod,
+                             parameters.macdSignalPeriod);
+  analysis.rsi = graph.rsi(close, parameters.rsiTimePeriod);
+  analysis.bbands = graph.bollingerBands(close, 20, 2.0, 2.0);
+  for (const IndicatorOutput output :
+       {analysis.fastMa, analysis.slowMa, analysis.volumeMa,
+        analysis.macd.macd, analysis.macd.signal, analysis.rsi}) {
+    graph.subscribe(output, decisionCandles);
+  }
 }
 
-void MomentumTrader::calculateTechnicalAnalysis() {
-  clearBuffers();
-  data.copy(trades, highs, lows, opens, closePrices, vwaps, volumes,
-            timestamps);
-  TA_EMA(0, closePrices.size() - 1, closePrices.data(), fastMATimePeriod,
-         &fastMAOutBeg, &fastMAOutSize, fastMa.data());
-  TA_EMA(0, closePrices.size() - 1, closePrices.data(), slowMATimePeriod,
-         &slowMAOutBeg, &slowMAOutSize, slowMa.data());
-
-  TA_SMA(0, volumes.size() - 1, volumes.data(), volumeMATimePeriod,
-         &volumeMAOutBegin, &volumeMAOutSize, volumeMa.data());
-
-  TA_ATR(0, highs.size() - 1, highs.data(), lows.data(), closePrices.data(),
-         atrTimePeriod, &atrOutBegin, &atrOutSize, atr.data());
-  TA_MACD(0, closePrices.size() - 1, closePrices.data(), macdFastPeriod,
-          macdSlowPeriod, macdSignalPeriod, &macdOutBegin, &macdOutSize,
-          macd.data(), macdSignal.data(), macdHistogram.data());
-  TA_EMA(0, atrOutSize - 1, atr.data(), atrSmoothingPeriod, &atrMAOutBegin,
-         &atrMAOutSize, atrMA.data());
-  TA_RSI(0, closePrices.size() - 1, closePrices.data(), rsiTimePeriod,
-         &rsiOutBegin, &rsiOutSize, rsi.data());
-  TA_BBANDS(0, closePrices.size() - 1, closePrices.data(), 20, 2.0, 2.0,
-            TA_MAType_SMA, &bbBegIndex, &bbOutSize, bbUpper.data(),
-            bbMiddle.data(), bbLower.data());
-}
+void MomentumTrader::calculateTechnicalAnalysis() { loadCandles(); }
 
 MomentumTrader::candle_decision_t
 MomentumTrader::decideCandle(std::size_t candleEndOffset) {
   int sizeOffset = -1 - candleEndOffset;
-  
-  bool bullishMA = fastMa[fastMAOutSize + sizeOffset] >
-                   slowMa[slowMAOutSize + sizeOffset];
-  bool bullishMACD = macd[macdOutSize + sizeOffset] >
-                     macdSignal[macdOutSize + sizeOffset];
-  bool bullishRSI = rsi[rsiOutSize + sizeOffset] < 65;
-
-  bool bearishMA = fastMa[fastMAOutSize + sizeOffset] <
-                   slowMa[slowMAOutSize + sizeOffset];
-  bool bearishMACD = macd[macdOutSize + sizeOffset] <
-                     macdSignal[macdOutSize + sizeOffset];
-  bool bearishRSI = rsi[rsiOutSize + sizeOffset] > 25;
-
-  bool volumeAcceptable = volumes[volumes.size() + sizeOffset] >
-                          volumeMa[volumeMAOutSize + sizeOffset];
+  const auto at = [this, candleEndOffset](IndicatorOutput output) {
+    return indicatorValues->value(output, candleEndOffset);
+  };
+
+  bool bullishMA = at(analysis.fastMa) > at(analysis.slowMa);
+  bool bullishMACD = at(analysis.macd.macd) > at(analysis.macd.signal);
+  bool bullishRSI = at(analysis.rsi) < parameters.rsiOverbought;
+
+  bool bearishMA = at(analysis.fastMa) < at(analysis.slowMa);
+  bool bearishMACD = at(analysis.macd.macd) < at(analysis.macd.signal);
+  bool bearishRSI = at(analysis.rsi) > parameters.rsiOversold;
+
+  bool volumeAcceptable =
+      volumes[volumes.size() + sizeOffset] > at(analysis.volumeMa);
   
   double bullishIndicator = static_cast<double>(bullishMA) + bullishMACD +
                             bullishRSI + volumeAcceptable;
@@ -130,12 +117,17 @@ void MomentumTrader::decide() {
   }
 
   calculateTechnicalAnalysis();
+  if (candles->generation != streakGeneration) {
+    streakGeneration = candles->generation;
+    bullishCandlesinARow.store(0);
+    bearishCandlesInARow.store(0);
+  }
 
   double entryPrice = decideEntryPrice();
 
   const std::size_t entryQuantity = decideEntryQuantity();
   candle_decision_t candle_decision;
-  for (int i = 5; i >= 0; i -= 1) {
+  for (int i = decisionCandles - 1; i >= 0; i -= 1) {
     candle_decision = decideCandle(i);
   }
 
@@ -152,14 +144,14 @@ void MomentumTrader::decide() {
 
   if (enterLong) {
     INFO_LOG(*logger) << "entering long bracket "
-                      << " bar time: " << timestamps.back();
+                      << " bar time: " << midas::toPtime(timestamps.back());
     const auto bracketBoundaries =
         decideProfitAndStopLossLevels(entryPrice, OrderDirection::BUY);
     enterBracket(instrument, entryQuantity, midas::OrderDirection::BUY,
                  entryPrice, bracketBoundaries.second, bracketBoundaries.first);
   } else if (enterShort) {
     INFO_LOG(*logger) << "entering short bracket "
-                      << " bar time: " << timestamps.back();
+                      << " bar time: " << midas::toPtime(timestamps.back());
     const auto bracketBoundaries =
         decideProfitAndStopLossLevels(entryPrice, OrderDirection::SELL);
     enterBracket(instrument, entryQuantity, midas::OrderDirection::SELL,
@@ -169,7 +161,7 @@ void MomentumTrader::decide() {
 
 double MomentumTrader::decideEntryPrice() {
   double entryPrice = opens.back() + (highs.back() - lows.back()) / 2;
-  return std::round(entryPrice * roundingCoeff) / roundingCoeff;
+  return instrumentSpec.roundToTick(entryPrice);
 }
 
 std::size_t MomentumTrader::decideEntryQuantity() { return entryQuantity; }
@@ -177,38 +169,40 @@ std::size_t MomentumTrader::decideEntryQuantity() { return entryQuantity; }
 std::pair<double, double>
 MomentumTrader::decideProfitAndStopLossLevels(double entryPrice,
                                               OrderDirection orderDirection) {
-  double profitOffset = 5;
-  double stopLossOffset = -15;
+  double profitOffset = parameters.profitOffset;
+  double stopLossOffset = -parameters.stopLossOffset;
   if (orderDirection == OrderDirection::SELL) {
     profitOffset *= -1;
     stopLossOffset *= -1;
   }
 
-  double takeProfitLimit = entryPrice + profitOffset;
-  double stopLossLimit = entryPrice + stopLossOffset;
+  TickPrice takeProfitLimit = instrumentSpec.toTicks(entryPrice + profitOffset);
+  TickPrice stopLossLimit = instrumentSpec.toTicks(entryPrice + stopLossOffset);
 
-  if (std::fmod(takeProfitLimit, 5) == 0) {
-    takeProfitLimit -= 0.25;
+  // stay off round levels where orders cluster
+  const std::int64_t roundLevel = instrumentSpec.ticksIn(5);
+  const std::int64_t nudge = instrumentSpec.ticksIn(0.25);
+  if (takeProfitLimit.ticks % roundLevel == 0) {
+    takeProfitLimit = takeProfitLimit - nudge;
   }
-  if (std::fmod(stopLossLimit, 5) == 0) {
-    stopLossLimit += 0.25;
-  };
-
-  takeProfitLimit = std::round(takeProfitLimit * roundingCoeff) / roundingCoeff;
-  stopLossLimit = std::round(stopLossLimit * roundingCoeff) / roundingCoeff;
-  return {takeProfitLimit, stopLossLimit};
+  if (stopLossLimit.ticks % roundLevel == 0) {
+    stopLossLimit = stopLossLimit + nudge;
+  }
+  return {instrumentSpec.toPrice(takeProfitLimit),
+          instrumentSpec.toPrice(stopLossLimit)};
 }
 
-void MomentumTrader::clearBuffers() {
-
-  closePrices.clear();
-  volumes.clear();
-  highs.clear();
-  highs.clear();
-  lows.clear();
-  opens.clear();
-  trades.clear();
-  timestamps.clear();
+void MomentumTrader::loadCandles() {
+  indicatorValues = data.indicatorSnapshot();
+  candles = data.lookBack(indicatorValues->candles);
+  trades = candles->tradeCounts();
+  highs = candles->highs();
+  lows = candles->lows();
+  opens = candles->opens();
+  closePrices = candles->closes();
+  vwaps = candles->vwaps();
+  volumes = candles->volumes();
+  timestamps = candles->timestamps();
 }
 
 std::string MomentumTrader::traderName() const {
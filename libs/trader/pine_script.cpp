@@ -0,0 +1,1139 @@
+#include "trader/pine_script.hpp"
+#include "exceptions/script_error.hpp"
+#include "trader/batch_indicators.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using namespace midas::trader::pine;
+using namespace midas;
+using midas::trader::batch::firstValue;
+
+namespace {
+constexpr double notAvailable = std::numeric_limits<double>::quiet_NaN();
+
+inline bool truthy(double value) { return value != 0 && !std::isnan(value); }
+
+/**
+ * Calls visit with the function of a unary or binary operation code, shared
+ * by constant folding and the machine
+ */
+template <typename Visitor> void withOperation(OpCode code, Visitor &&visit) {
+  switch (code) {
+  case OpCode::Add:
+    visit([](double a, double b) { return a + b; });
+    break;
+  case OpCode::Subtract:
+    visit([](double a, double b) { return a - b; });
+    break;
+  case OpCode::Multiply:
+    visit([](double a, double b) { return a * b; });
+    break;
+  case OpCode::Divide:
+    visit([](double a, double b) { return a / b; });
+    break;
+  case OpCode::Modulo:
+    visit([](double a, double b) { return std::fmod(a, b); });
+    break;
+  case OpCode::Negate:
+    visit([](double a, double) { return -a; });
+    break;
+  case OpCode::Abs:
+    visit([](double a, double) { return std::abs(a); });
+    break;
+  case OpCode::Less:
+    visit([](double a, double b) { return static_cast<double>(a < b); });
+    break;
+  case OpCode::LessOrEqual:
+    visit([](double a, double b) { return static_cast<double>(a <= b); });
+    break;
+  case OpCode::Equal:
+    visit([](double a, double b) { return static_cast<double>(a == b); });
+    break;
+  case OpCode::NotEqual:
+    // comparisons with na are false
+    visit([](double a, double b) {
+      return static_cast<double>(!std::isnan(a) && !std::isnan(b) && a != b);
+    });
+    break;
+  case OpCode::And:
+    visit([](double a, double b) {
+      return static_cast<double>(truthy(a) && truthy(b));
+    });
+    break;
+  case OpCode::Or:
+    visit([](double a, double b) {
+      return static_cast<double>(truthy(a) || truthy(b));
+    });
+    break;
+  case OpCode::Not:
+    visit([](double a, double) { return static_cast<double>(!truthy(a)); });
+    break;
+  default:
+    throw std::logic_error("Not an elementwise operation");
+  }
+}
+
+/**
+ * ta.rma, Wilder's smoothing seeded with the simple average of the first
+ * period values
+ */
+void rma(std::span<const double> values, int period, std::span<double> out) {
+  std::ranges::fill(out, notAvailable);
+  const std::size_t from = firstValue(values);
+  const auto length = static_cast<std::size_t>(period);
+  if (values.size() - from < length) {
+    return;
+  }
+  double average = 0;
+  for (std::size_t i = from; i < from + length; i++) {
+    average += values[i];
+  }
+  average /= period;
+  out[from + length - 1] = average;
+  for (std::size_t i = from + length; i < values.size(); i++) {
+    average = (average * (period - 1) + values[i]) / period;
+    out[i] = average;
+  }
+}
+
+struct Token {
+  enum class Type { Number, Text, Name, Symbol, End };
+  Type type;
+  std::string text;
+  double number{0};
+};
+
+/**
+ * A statement, physical lines are joined while parentheses are open
+ */
+struct Line {
+  std::size_t number, indent;
+  std::vector<Token> tokens;
+};
+
+std::vector<Line> split(std::string_view source) {
+  std::vector<Line> lines;
+  std::size_t number = 0;
+  int depth = 0;
+  while (!source.empty()) {
+    const std::size_t end = std::min(source.find('\n'), source.size());
+    const std::string_view text = source.substr(0, end);
+    source.remove_prefix(std::min(end + 1, source.size()));
+    number++;
+    std::size_t indent = 0, i = 0;
+    for (; i < text.size() && (text[i] == ' ' || text[i] == '\t'); i++) {
+      indent += text[i] == '\t' ? 4 : 1;
+    }
+    const bool continued = depth > 0;
+    std::vector<Token> tokens;
+    while (i < text.size()) {
+      const char c = text[i];
+      if (c == ' ' || c == '\t' || c == '\r') {
+        i++;
+      } else if (text.substr(i, 2) == "//") {
+        break;
+      } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+                 (c == '.' && i + 1 < text.size() &&
+                  std::isdigit(static_cast<unsigned char>(text[i + 1])))) {
+        double value;
+        const auto [next, error] =
+            std::from_chars(text.data() + i, text.data() + text.size(), value);
+        if (error != std::errc()) {
+          throw ScriptError(number, "malformed number");
+        }
+        const std::size_t length = next - (text.data() + i);
+        tokens.push_back({Token::Type::Number,
+                          std::string(text.substr(i, length)), value});
+        i += length;
+      } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+        // dotted names such as ta.ema are a single token
+        const std::size_t start = i;
+        while (i < text.size() &&
+               (std::isalnum(static_cast<unsigned char>(text[i])) ||
+                text[i] == '_' || text[i] == '.')) {
+          i++;
+        }
+        tokens.push_back(
+            {Token::Type::Name, std::string(text.substr(start, i - start))});
+      } else if (c == '"' || c == '\'') {
+        const std::size_t close = text.find(c, i + 1);
+        if (close == std::string_view::npos) {
+          throw ScriptError(number, "unterminated string");
+        }
+        tokens.push_back({Token::Type::Text,
+                          std::string(text.substr(i + 1, close - i - 1))});
+        i = close + 1;
+      } else {
+        static constexpr std::string_view twoCharacters[] = {
+            "==", "!=", "<=", ">=", ":="};
+        std::string_view symbol = text.substr(i, 1);
+        for (const std::string_view candidate : twoCharacters) {
+          if (text.substr(i, 2) == candidate) {
+            symbol = candidate;
+          }
+        }
+        if (symbol.find_first_of("()[],=<>+-*/%?:!") != 0) {
+          throw ScriptError(number, "unexpected character " +
+                                        std::string(symbol));
+        }
+        depth += symbol == "(" || symbol == "[";
+        depth -= symbol == ")" || symbol == "]";
+        tokens.push_back({Token::Type::Symbol, std::string(symbol)});
+        i += symbol.size();
+      }
+    }
+    if (continued && !lines.empty()) {
+      auto &previous = lines.back().tokens;
+      previous.insert(previous.end(), tokens.begin(), tokens.end());
+    } else if (!tokens.empty()) {
+      lines.push_back({number, indent, std::move(tokens)});
+    }
+  }
+  if (depth != 0) {
+    throw ScriptError(number, "unbalanced parentheses");
+  }
+  for (Line &line : lines) {
+    line.tokens.push_back({Token::Type::End, ""});
+  }
+  return lines;
+}
+
+/**
+ * Result of an expression
+ */
+struct Value {
+  /**
+   * Known when compiling, folded rather than computed
+   */
+  std::optional<double> constant;
+  /**
+   * Several for the results of ta.macd and ta.dmi
+   */
+  std::vector<Register> registers;
+  std::optional<std::string> text;
+};
+
+struct Arguments {
+  std::vector<Value> positional;
+  std::map<std::string, Value, std::less<>> named;
+
+  const Value *find(std::size_t position, std::string_view name) const {
+    if (const auto found = named.find(name); found != named.end()) {
+      return &found->second;
+    }
+    return position < positional.size() ? &positional[position] : nullptr;
+  }
+};
+
+/**
+ * Recursive descent parser emitting code as it goes, a script is compiled in
+ * a single pass over its statements
+ */
+class Compiler {
+public:
+  explicit Compiler(std::string_view source) : lines(split(source)) {
+    // the runner sets these before every run
+    program.scalars = {0, 0};
+  }
+
+  std::shared_ptr<const Program> compile() {
+    statements(0);
+    if (line < lines.size()) {
+      fail("unexpected indentation");
+    }
+    for (std::size_t i = 0; i < program.entries.size(); i++) {
+      const Exit &exit = program.entries[i].exit;
+      if (!(exit.stop || exit.loss) ||
+          !(exit.limit || exit.profit || exit.trailPrice ||
+            exit.trailPoints)) {
+        throw ScriptError(entryLines[i],
+                          "entry " + program.entries[i].id +
+                              " needs a strategy.exit with a stop and a "
+                              "profit target, traders only place brackets");
+      }
+    }
+    for (std::uint32_t column = Program::inputColumns;
+         column < program.columns; column++) {
+      program.warmUp = std::max(program.warmUp, readyAt[column]);
+    }
+    return std::make_shared<const Program>(std::move(program));
+  }
+
+private:
+  std::vector<Line> lines;
+  std::size_t line{0}, position{0};
+  Program program;
+  std::map<std::string, Value, std::less<>> names;
+  // first candle every column register has a value for
+  std::vector<std::size_t> readyAt = std::vector<std::size_t>(
+      Program::inputColumns, 0);
+  // condition of the enclosing if blocks
+  std::vector<Value> conditions;
+  std::vector<std::size_t> entryLines;
+
+  [[noreturn]] void fail(const std::string &message) const {
+    throw ScriptError(lines[std::min(line, lines.size() - 1)].number, message);
+  }
+
+  const Token &peek(std::size_t ahead = 0) const {
+    const auto &tokens = lines[line].tokens;
+    return tokens[std::min(position + ahead, tokens.size() - 1)];
+  }
+  bool isSymbol(std::string_view symbol, std::size_t ahead = 0) const {
+    const Token &token = peek(ahead);
+    return token.type == Token::Type::Symbol && token.text == symbol;
+  }
+  bool isName(std::string_view name, std::size_t ahead = 0) const {
+    const Token &token = peek(ahead);
+    return token.type == Token::Type::Name && token.text == name;
+  }
+  bool accept(std::string_view symbol) {
+    if (isSymbol(symbol)) {
+      position++;
+      return true;
+    }
+    return false;
+  }
+  void expect(std::string_view symbol) {
+    if (!accept(symbol)) {
+      fail("expected " + std::string(symbol));
+    }
+  }
+  std::string name() {
+    if (peek().type != Token::Type::Name) {
+      fail("expected a name");
+    }
+    return lines[line].tokens[position++].text;
+  }
+  void endOfStatement() {
+    if (peek().type != Token::Type::End) {
+      fail("unexpected " + peek().text);
+    }
+    line++;
+    position = 0;
+  }
+
+  void statements(std::size_t indent) {
+    while (line < lines.size() && lines[line].indent == indent) {
+      statement(indent);
+    }
+  }
+
+  void statement(std::size_t indent) {
+    if (isName("if")) {
+      position++;
+      conditional(indent);
+    } else if (isName("else")) {
+      fail("else without if");
+    } else if (isSymbol("[")) {
+      tupleDeclaration();
+    } else if ((isName("float") || isName("int") || isName("bool")) &&
+               peek(1).type == Token::Type::Name && isSymbol("=", 2)) {
+      position++;
+      declaration();
+    } else if (peek().type == Token::Type::Name && isSymbol("=", 1)) {
+      declaration();
+    } else if (isName("var") || isName("varip") || isSymbol(":=", 1)) {
+      fail("variables that change between candles are not supported");
+    } else if (peek().type == Token::Type::Name && isSymbol("(", 1)) {
+      const std::string function = name();
+      expect("(");
+      call(function, arguments());
+      endOfStatement();
+    } else {
+      fail("unsupported statement");
+    }
+  }
+
+  void conditional(std::size_t indent) {
+    const Register condition = single(expression());
+    endOfStatement();
+    const auto block = [&](Value holds) {
+      if (line >= lines.size() || lines[line].indent <= indent) {
+        fail("expected an indented block");
+      }
+      conditions.push_back(conditions.empty()
+                               ? std::move(holds)
+                               : binary(OpCode::And, conditions.back(),
+                                        std::move(holds)));
+      statements(lines[line].indent);
+      conditions.pop_back();
+    };
+    block(Value{{}, {condition}, {}});
+    if (line < lines.size() && lines[line].indent == indent && isName("else")) {
+      position++;
+      const Value otherwise = unary(OpCode::Not, Value{{}, {condition}, {}});
+      conditions.push_back(conditions.empty()
+                               ? otherwise
+                               : binary(OpCode::And, conditions.back(),
+                                        otherwise));
+      if (isName("if")) {
+        position++;
+        conditional(indent);
+      } else {
+        endOfStatement();
+        if (line >= lines.size() || lines[line].indent <= indent) {
+          fail("expected an indented block");
+        }
+        statements(lines[line].indent);
+      }
+      conditions.pop_back();
+    }
+  }
+
+  void declare(const std::string &variable, Value value) {
+    if (!conditions.empty()) {
+      fail("declarations inside if blocks are not supported");
+    }
+    if (names.contains(variable)) {
+      fail(variable + " is already declared, := is not supported");
+    }
+    if (value.registers.size() == 1) {
+      program.variables.emplace(variable, value.registers.front());
+    } else if (value.constant) {
+      program.variables.emplace(variable, single(value));
+    }
+    names.emplace(variable, std::move(value));
+  }
+
+  void declaration() {
+    const std::string variable = name();
+    expect("=");
+    Value value = expression();
+    if (value.registers.size() > 1) {
+      fail("assign the results of " + variable + " to a tuple");
+    }
+    declare(variable, std::move(value));
+    endOfStatement();
+  }
+
+  void tupleDeclaration() {
+    expect("[");
+    std::vector<std::string> variables{name()};
+    while (accept(",")) {
+      variables.push_back(name());
+    }
+    expect("]");
+    expect("=");
+    const Value value = expression();
+    if (value.registers.size() != variables.size()) {
+      fail("expected " + std::to_string(value.registers.size()) +
+           " variables");
+    }
+    for (std::size_t i = 0; i < variables.size(); i++) {
+      declare(variables[i], Value{{}, {value.registers[i]}, {}});
+    }
+    endOfStatement();
+  }
+
+  Arguments arguments() {
+    Arguments result;
+    if (accept(")")) {
+      return result;
+    }
+    do {
+      if (peek().type == Token::Type::Name && isSymbol("=", 1)) {
+        std::string argument = name();
+        position++;
+        result.named.insert_or_assign(std::move(argument), expression());
+      } else if (!result.named.empty()) {
+        fail("positional argument after a named one");
+      } else {
+        result.positional.push_back(expression());
+      }
+    } while (accept(","));
+    expect(")");
+    return result;
+  }
+
+  /**
+   * Statement calls
+   */
+  void call(const std::string &function, const Arguments &arguments) {
+    if (function == "strategy") {
+      if (const Value *title = arguments.find(0, "title");
+          title && title->text) {
+        program.title = *title->text;
+      }
+    } else if (function == "strategy.entry") {
+      entry(arguments);
+    } else if (function == "strategy.exit") {
+      exit(arguments);
+    } else if (function.starts_with("plot") || function == "alertcondition" ||
+               function == "bgcolor") {
+      // drawing only
+    } else if (function == "indicator" || function == "study") {
+      fail("only strategies can be run");
+    } else {
+      fail("unsupported statement " + function);
+    }
+  }
+
+  std::string text(const Value *value, const std::string &argument) {
+    if (value == nullptr || !value->text) {
+      fail("expected a string " + argument);
+    }
+    return *value->text;
+  }
+
+  void entry(const Arguments &arguments) {
+    Entry entry;
+    entry.id = text(arguments.find(0, "id"), "id");
+    const Value *direction = arguments.find(1, "direction");
+    if (direction == nullptr || !direction->constant) {
+      fail("expected strategy.long or strategy.short");
+    }
+    entry.direction =
+        *direction->constant > 0 ? OrderDirection::BUY : OrderDirection::SELL;
+    if (arguments.find(3, "limit") || arguments.find(4, "stop")) {
+      fail("only market entries are supported");
+    }
+    if (const Value *quantity = arguments.find(2, "qty")) {
+      entry.quantity = single(*quantity);
+    }
+    Value when = conditions.empty() ? Value{1.0, {}, {}} : conditions.back();
+    if (const auto also = arguments.named.find("when");
+        also != arguments.named.end()) {
+      when = binary(OpCode::And, std::move(when), also->second);
+    }
+    entry.when = single(when);
+    if (std::ranges::any_of(program.entries, [&entry](const Entry &existing) {
+          return existing.id == entry.id;
+        })) {
+      fail("entry " + entry.id + " is declared twice");
+    }
+    program.entries.push_back(std::move(entry));
+    entryLines.push_back(lines[line].number);
+  }
+
+  void exit(const Arguments &arguments) {
+    const Value *from = arguments.find(1, "from_entry");
+    const auto price = [&](std::size_t position, std::string_view argument)
+        -> std::optional<Register> {
+      if (const Value *value = arguments.find(position, argument)) {
+        return single(*value);
+      }
+      return std::nullopt;
+    };
+    Exit exit{
+        .stop = price(7, "stop"),
+        .limit = price(5, "limit"),
+        .trailPrice = price(8, "trail_price"),
+        .loss = price(6, "loss"),
+        .profit = price(4, "profit"),
+        .trailPoints = price(9, "trail_points"),
+        .trailOffset = price(10, "trail_offset"),
+    };
+    bool matched = false;
+    for (Entry &entry : program.entries) {
+      // without from_entry an exit applies to every entry
+      if (from == nullptr || text(from, "from_entry") == entry.id) {
+        entry.exit = exit;
+        matched = true;
+      }
+    }
+    if (!matched) {
+      fail("strategy.exit for an entry that is not declared before it");
+    }
+  }
+
+  Register column(std::size_t ready) {
+    readyAt.push_back(ready);
+    return {program.columns++, false};
+  }
+
+  Register single(const Value &value) {
+    if (value.text) {
+      fail("expected a number or a series, not a string");
+    }
+    if (value.constant) {
+      program.scalars.push_back(*value.constant);
+      return {static_cast<std::uint32_t>(program.scalars.size() - 1), true};
+    }
+    if (value.registers.size() != 1) {
+      fail("a tuple can only be assigned");
+    }
+    return value.registers.front();
+  }
+
+  std::size_t ready(Register reg) const {
+    return reg.scalar ? 0 : readyAt[reg.index];
+  }
+
+  int period(const Arguments &arguments, std::size_t position,
+             std::string_view argument) {
+    const Value *value = arguments.find(position, argument);
+    if (value == nullptr || !value->constant || *value->constant < 1 ||
+        *value->constant != std::floor(*value->constant)) {
+      fail("expected a constant positive whole " + std::string(argument));
+    }
+    return static_cast<int>(*value->constant);
+  }
+
+  Register series(const Arguments &arguments, std::size_t position,
+                  std::string_view argument) {
+    const Value *value = arguments.find(position, argument);
+    if (value == nullptr) {
+      fail("missing " + std::string(argument));
+    }
+    const Register reg = single(*value);
+    if (reg.scalar) {
+      fail(std::string(argument) + " has to be a series");
+    }
+    return reg;
+  }
+
+  Value binary(OpCode code, Value left, Value right) {
+    if (left.constant && right.constant) {
+      double result = 0;
+      withOperation(code, [&](auto operation) {
+        result = operation(*left.constant, *right.constant);
+      });
+      return {result, {}, {}};
+    }
+    const Register a = single(left), b = single(right);
+    Instruction instruction{code, {}, a, b};
+    instruction.out = a.scalar && b.scalar
+                          ? single(Value{0.0, {}, {}})
+                          : column(std::max(ready(a), ready(b)));
+    program.code.push_back(instruction);
+    return {{}, {instruction.out}, {}};
+  }
+
+  Value unary(OpCode code, Value operand) {
+    return binary(code, std::move(operand), Value{0.0, {}, {}});
+  }
+
+  Value expression() {
+    Value condition = logical("or");
+    if (!accept("?")) {
+      return condition;
+    }
+    Value whenTrue = expression();
+    expect(":");
+    Value whenFalse = expression();
+    if (condition.constant) {
+      return truthy(*condition.constant) ? whenTrue : whenFalse;
+    }
+    const Register c = single(condition), a = single(whenTrue),
+                   b = single(whenFalse);
+    Instruction instruction{OpCode::Select, {}, a, b, c};
+    instruction.out =
+        a.scalar && b.scalar && c.scalar
+            ? single(Value{0.0, {}, {}})
+            : column(std::max({ready(a), ready(b), ready(c)}));
+    program.code.push_back(instruction);
+    return {{}, {instruction.out}, {}};
+  }
+
+  Value logical(std::string_view keyword) {
+    const bool isOr = keyword == "or";
+    Value left = isOr ? logical("and") : equality();
+    while (isName(keyword)) {
+      position++;
+      Value right = isOr ? logical("and") : equality();
+      left = binary(isOr ? OpCode::Or : OpCode::And, std::move(left),
+                    std::move(right));
+    }
+    return left;
+  }
+
+  Value equality() {
+    Value left = comparison();
+    while (isSymbol("==") || isSymbol("!=")) {
+      const OpCode code = isSymbol("==") ? OpCode::Equal : OpCode::NotEqual;
+      position++;
+      left = binary(code, std::move(left), comparison());
+    }
+    return left;
+  }
+
+  Value comparison() {
+    Value left = additive();
+    while (isSymbol("<") || isSymbol("<=") || isSymbol(">") ||
+           isSymbol(">=")) {
+      const std::string symbol = peek().text;
+      position++;
+      Value right = additive();
+      // greater is less with the operands swapped
+      const OpCode code = symbol.size() == 2 ? OpCode::LessOrEqual
+                                             : OpCode::Less;
+      left = symbol.front() == '<'
+                 ? binary(code, std::move(left), std::move(right))
+                 : binary(code, std::move(right), std::move(left));
+    }
+    return left;
+  }
+
+  Value additive() {
+    Value left = multiplicative();
+    while (isSymbol("+") || isSymbol("-")) {
+      const OpCode code = isSymbol("+") ? OpCode::Add : OpCode::Subtract;
+      position++;
+      left = binary(code, std::move(left), multiplicative());
+    }
+    return left;
+  }
+
+  Value multiplicative() {
+    Value left = prefix();
+    while (isSymbol("*") || isSymbol("/") || isSymbol("%")) {
+      const OpCode code = isSymbol("*")   ? OpCode::Multiply
+                          : isSymbol("/") ? OpCode::Divide
+                                          : OpCode::Modulo;
+      position++;
+      left = binary(code, std::move(left), prefix());
+    }
+    return left;
+  }
+
+  Value prefix() {
+    if (accept("-")) {
+      return unary(OpCode::Negate, prefix());
+    }
+    if (accept("+")) {
+      return prefix();
+    }
+    if (isName("not")) {
+      position++;
+      return unary(OpCode::Not, prefix());
+    }
+    return postfix();
+  }
+
+  Value postfix() {
+    Value value = primary();
+    while (accept("[")) {
+      const Value offset = expression();
+      expect("]");
+      if (!offset.constant || *offset.constant < 0 ||
+          *offset.constant != std::floor(*offset.constant)) {
+        fail("history references need a constant offset");
+      }
+      const Register source = single(value);
+      if (source.scalar || *offset.constant == 0) {
+        continue;
+      }
+      Instruction instruction{OpCode::Previous, {}, source};
+      instruction.periods[0] = static_cast<int>(*offset.constant);
+      instruction.out = column(ready(source) + instruction.periods[0]);
+      program.code.push_back(instruction);
+      value = {{}, {instruction.out}, {}};
+    }
+    return value;
+  }
+
+  Value primary() {
+    const Token token = peek();
+    position++;
+    switch (token.type) {
+    case Token::Type::Number:
+      return {token.number, {}, {}};
+    case Token::Type::Text:
+      return {{}, {}, token.text};
+    case Token::Type::Symbol:
+      if (token.text == "(") {
+        Value value = expression();
+        expect(")");
+        return value;
+      }
+      fail("unexpected " + token.text);
+    case Token::Type::End:
+      fail("unexpected end of line");
+    case Token::Type::Name:
+      break;
+    }
+    if (accept("(")) {
+      return function(token.text, arguments());
+    }
+    return variable(token.text);
+  }
+
+  Value variable(const std::string &variable) {
+    static const std::map<std::string, Register, std::less<>> candles{
+        {"open", {Program::open, false}},
+        {"high", {Program::high, false}},
+        {"low", {Program::low, false}},
+        {"close", {Program::close, false}},
+        {"volume", {Program::volume, false}},
+        {"strategy.position_size", {Program::positionSize, true}},
+        {"syminfo.mintick", {Program::minTick, true}},
+    };
+    static const std::map<std::string, double, std::less<>> constants{
+        {"strategy.long", 1},  {"strategy.short", -1}, {"true", 1},
+        {"false", 0},          {"na", notAvailable},
+    };
+    if (const auto found = names.find(variable); found != names.end()) {
+      return found->second;
+    }
+    if (const auto found = candles.find(variable); found != candles.end()) {
+      return {{}, {found->second}, {}};
+    }
+    if (const auto found = constants.find(variable); found != constants.end()) {
+      return {found->second, {}, {}};
+    }
+    fail("unknown variable " + variable);
+  }
+
+  Value indicator(OpCode code, Register input, std::array<int, 3> periods,
+                  std::size_t outputs, std::size_t ready) {
+    Instruction instruction{code, {}, input};
+    instruction.periods = periods;
+    instruction.out = column(ready);
+    for (std::size_t i = 1; i < outputs; i++) {
+      column(ready);
+    }
+    program.code.push_back(instruction);
+    Value value;
+    for (std::uint32_t i = 0; i < outputs; i++) {
+      value.registers.push_back({instruction.out.index + i, false});
+    }
+    return value;
+  }
+
+  /**
+   * Expression calls
+   */
+  Value function(const std::string &function, const Arguments &arguments) {
+    static const std::map<std::string, OpCode, std::less<>> windows{
+        {"ta.ema", OpCode::Ema},         {"ta.sma", OpCode::Sma},
+        {"ta.rsi", OpCode::Rsi},         {"ta.rising", OpCode::Rising},
+        {"ta.falling", OpCode::Falling}, {"ta.highest", OpCode::Highest},
+        {"ta.lowest", OpCode::Lowest},
+    };
+    if (const auto found = windows.find(function); found != windows.end()) {
+      const Register input = series(arguments, 0, "source");
+      const int length = period(arguments, 1, "length");
+      // ema and sma have their first value on the last candle of the first
+      // window, the others need one more candle
+      const bool average =
+          found->second == OpCode::Ema || found->second == OpCode::Sma ||
+          found->second == OpCode::Highest || found->second == OpCode::Lowest;
+      return indicator(found->second, input, {length}, 1,
+                       ready(input) + length - average);
+    }
+    if (function == "ta.atr") {
+      const int length = period(arguments, 0, "length");
+      return indicator(OpCode::Atr, {0, true}, {length}, 1, length);
+    }
+    if (function == "ta.macd") {
+      const Register input = series(arguments, 0, "source");
+      const int fast = period(arguments, 1, "fastlen"),
+                slow = period(arguments, 2, "slowlen"),
+                signal = period(arguments, 3, "siglen");
+      return indicator(OpCode::Macd, input, {fast, slow, signal}, 3,
+                       ready(input) + std::max(fast, slow) + signal - 2);
+    }
+    if (function == "ta.dmi") {
+      const int length = period(arguments, 0, "diLength"),
+                smoothing = period(arguments, 1, "adxSmoothing");
+      return indicator(OpCode::Dmi, {0, true}, {length, smoothing}, 3,
+                       length + smoothing - 1);
+    }
+    if (function == "ta.change") {
+      const Value *found = arguments.find(0, "source");
+      if (found == nullptr) {
+        fail("missing source");
+      }
+      Value source = *found, previous = *found;
+      const Value *length = arguments.find(1, "length");
+      const Register input = single(source);
+      if (!input.scalar) {
+        Instruction instruction{OpCode::Previous, {}, input};
+        instruction.periods[0] = length ? period(arguments, 1, "length") : 1;
+        instruction.out = column(ready(input) + instruction.periods[0]);
+        program.code.push_back(instruction);
+        previous = {{}, {instruction.out}, {}};
+      }
+      return binary(OpCode::Subtract, std::move(source), std::move(previous));
+    }
+    if (function == "math.abs") {
+      const Value *value = arguments.find(0, "number");
+      if (value == nullptr) {
+        fail("missing number");
+      }
+      return unary(OpCode::Abs, *value);
+    }
+    fail("unsupported function " + function);
+  }
+};
+
+template <typename Function>
+void emit(std::span<const double> values, std::span<double> out,
+          Function &&function) {
+  // indicators only see the candles their input has values for
+  const std::size_t from = firstValue(values);
+  function(values.subspan(from), out.subspan(from));
+}
+} // namespace
+
+std::shared_ptr<const Program> midas::trader::pine::compile(
+    std::string_view source) {
+  return Compiler(source).compile();
+}
+
+std::shared_ptr<const Program>
+midas::trader::pine::compileFile(const std::filesystem::path &path) {
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("Can not open " + path.string());
+  }
+  std::stringstream source;
+  source << file.rdbuf();
+  return compile(source.str());
+}
+
+Machine::Machine(std::shared_ptr<const Program> program)
+    : program(std::move(program)),
+      columns(this->program->columns - Program::inputColumns) {}
+
+std::span<const double> Machine::read(Register reg) const {
+  switch (reg.index) {
+  case Program::open:
+    return series.opens;
+  case Program::high:
+    return series.highs;
+  case Program::low:
+    return series.lows;
+  case Program::close:
+    return series.closes;
+  case Program::volume:
+    return series.volumes;
+  default:
+    return columns[reg.index - Program::inputColumns];
+  }
+}
+
+std::span<double> Machine::write(Register reg) {
+  return columns[reg.index - Program::inputColumns];
+}
+
+double Machine::value(Register reg, std::size_t offset) const {
+  if (reg.scalar) {
+    return scalars[reg.index];
+  }
+  return offset < candles ? read(reg)[candles - 1 - offset] : notAvailable;
+}
+
+bool Machine::holds(Register reg, std::size_t offset) const {
+  return truthy(value(reg, offset));
+}
+
+std::vector<double> Machine::values(Register reg) const {
+  if (reg.scalar) {
+    return std::vector<double>(candles, scalars[reg.index]);
+  }
+  const auto column = read(reg);
+  return {column.begin(), column.end()};
+}
+
+void Machine::run(const Series &series, const Inputs &inputs) {
+  const std::size_t size = series.closes.size();
+  for (const auto column :
+       {series.opens, series.highs, series.lows, series.volumes}) {
+    if (column.size() != size) {
+      throw std::invalid_argument("Candle columns must have the same size");
+    }
+  }
+  this->series = series;
+  candles = size;
+  scalars = program->scalars;
+  scalars[Program::positionSize] = inputs.positionSize;
+  scalars[Program::minTick] = inputs.minTick;
+  for (auto &column : columns) {
+    column.assign(candles, notAvailable);
+  }
+  for (const Instruction &instruction : program->code) {
+    execute(instruction);
+  }
+}
+
+template <typename Visitor>
+void Machine::withOperand(Register reg, Visitor &&visit) {
+  if (reg.scalar) {
+    visit(trader::batch::Broadcast{scalars[reg.index]});
+  } else {
+    visit(read(reg));
+  }
+}
+
+template <typename Operation>
+void Machine::binary(const Instruction &instruction, Operation &&operation) {
+  withOperand(instruction.a, [&](const auto &a) {
+    withOperand(instruction.b, [&](const auto &b) {
+      if (instruction.out.scalar) {
+        scalars[instruction.out.index] = operation(a[0], b[0]);
+        return;
+      }
+      const std::span<double> out = write(instruction.out);
+      for (std::size_t i = 0; i < candles; i++) {
+        out[i] = operation(a[i], b[i]);
+      }
+    });
+  });
+}
+
+void Machine::execute(const Instruction &instruction) {
+  const int period = instruction.periods[0];
+  switch (instruction.code) {
+  case OpCode::Select:
+    withOperand(instruction.c, [&](const auto &c) {
+      withOperand(instruction.a, [&](const auto &a) {
+        withOperand(instruction.b, [&](const auto &b) {
+          if (instruction.out.scalar) {
+            scalars[instruction.out.index] = truthy(c[0]) ? a[0] : b[0];
+            return;
+          }
+          const std::span<double> out = write(instruction.out);
+          for (std::size_t i = 0; i < candles; i++) {
+            out[i] = truthy(c[i]) ? a[i] : b[i];
+          }
+        });
+      });
+    });
+    return;
+  case OpCode::Previous: {
+    const auto values = read(instruction.a);
+    const std::span<double> out = write(instruction.out);
+    const auto offset = static_cast<std::size_t>(period);
+    for (std::size_t i = offset; i < candles; i++) {
+      out[i] = values[i - offset];
+    }
+    return;
+  }
+  case OpCode::Ema:
+    emit(read(instruction.a), write(instruction.out),
+         [period](auto values, auto out) {
+           trader::batch::ema(values, period, out);
+         });
+    return;
+  case OpCode::Sma:
+    emit(read(instruction.a), write(instruction.out),
+         [period](auto values, auto out) {
+           trader::batch::sma(values, period, out);
+         });
+    return;
+  case OpCode::Rsi:
+    emit(read(instruction.a), write(instruction.out),
+         [period](auto values, auto out) {
+           trader::batch::rsi(values, period, out);
+         });
+    return;
+  case OpCode::Atr:
+    trader::batch::atr(series.highs, series.lows, series.closes, period,
+                       write(instruction.out));
+    return;
+  case OpCode::Macd: {
+    const Register signal{instruction.out.index + 1, false},
+        histogram{instruction.out.index + 2, false};
+    const std::span<double> macd = write(instruction.out);
+    emit(read(instruction.a), macd, [period](auto values, auto out) {
+      trader::batch::ema(values, period, out);
+    });
+    // the slow average goes where the signal ends up
+    emit(read(instruction.a), write(signal),
+         [slow = instruction.periods[1]](auto values, auto out) {
+           trader::batch::ema(values, slow, out);
+         });
+    for (std::size_t i = 0; i < candles; i++) {
+      macd[i] -= read(signal)[i];
+    }
+    std::ranges::fill(write(signal), notAvailable);
+    emit(macd, write(signal),
+         [length = instruction.periods[2]](auto values, auto out) {
+           trader::batch::ema(values, length, out);
+         });
+    const std::span<double> out = write(histogram);
+    for (std::size_t i = 0; i < candles; i++) {
+      out[i] = macd[i] - read(signal)[i];
+    }
+    return;
+  }
+  case OpCode::Dmi:
+    dmi(instruction);
+    return;
+  case OpCode::Rising:
+  case OpCode::Falling: {
+    // greater or less than every value of the window before
+    const bool rising = instruction.code == OpCode::Rising;
+    const auto values = read(instruction.a);
+    auto &extreme = scratch[0];
+    extreme.assign(candles, notAvailable);
+    emit(values, extreme, [period, rising](auto values, auto out) {
+      rising ? trader::batch::rollingMax(values, period, out)
+             : trader::batch::rollingMin(values, period, out);
+    });
+    const std::span<double> out = write(instruction.out);
+    for (std::size_t i = 1; i < candles; i++) {
+      out[i] = std::isnan(extreme[i - 1])
+                   ? notAvailable
+                   : static_cast<double>(rising ? values[i] > extreme[i - 1]
+                                                : values[i] < extreme[i - 1]);
+    }
+    return;
+  }
+  case OpCode::Highest:
+  case OpCode::Lowest:
+    emit(read(instruction.a), write(instruction.out),
+         [period, highest = instruction.code == OpCode::Highest](auto values,
+                                                                 auto out) {
+           highest ? trader::batch::rollingMax(values, period, out)
+                   : trader::batch::rollingMin(values, period, out);
+         });
+    return;
+  default:
+    withOperation(instruction.code, [&](auto operation) {
+      binary(instruction, operation);
+    });
+  }
+}
+
+void Machine::dmi(const Instruction &instruction) {
+  // ta.dmi: directional movements and true ranges from the second candle on,
+  // each smoothed with ta.rma
+  const int length = instruction.periods[0];
+  const int smoothing = instruction.periods[1];
+  auto &[trueRanges, ups, downs, ranges] = scratch;
+  for (auto &column : scratch) {
+    column.assign(candles, notAvailable);
+  }
+  const auto highs = series.highs, lows = series.lows, closes = series.closes;
+  for (std::size_t i = 1; i < candles; i++) {
+    const double up = highs[i] - highs[i - 1];
+    const double down = lows[i - 1] - lows[i];
+    ups[i] = up > down && up > 0 ? up : 0;
+    downs[i] = down > up && down > 0 ? down : 0;
+    trueRanges[i] = std::max({highs[i] - lows[i],
+                              std::abs(highs[i] - closes[i - 1]),
+                              std::abs(lows[i] - closes[i - 1])});
+  }
+  const std::span<double> plus = write(instruction.out);
+  const std::span<double> minus =
+      write({instruction.out.index + 1, false});
+  const std::span<double> adx = write({instruction.out.index + 2, false});
+  rma(trueRanges, length, ranges);
+  rma(ups, length, plus);
+  rma(downs, length, minus);
+  double lastPlus = notAvailable, lastMinus = notAvailable;
+  for (std::size_t i = 0; i < candles; i++) {
+    // a flat range keeps the previous values, like fixnan
+    if (ranges[i] != 0 && !std::isnan(ranges[i])) {
+      lastPlus = 100 * plus[i] / ranges[i];
+      lastMinus = 100 * minus[i] / ranges[i];
+    }
+    plus[i] = std::isnan(ranges[i]) ? notAvailable : lastPlus;
+    minus[i] = std::isnan(ranges[i]) ? notAvailable : lastMinus;
+    const double sum = plus[i] + minus[i];
+    trueRanges[i] = std::abs(plus[i] - minus[i]) / (sum == 0 ? 1 : sum);
+  }
+  rma(trueRanges, smoothing, adx);
+  for (double &value : adx) {
+    value *= 100;
+  }
+}
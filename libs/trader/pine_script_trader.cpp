@@ -0,0 +1,100 @@
+#include "trader/pine_script_trader.hpp"
+#include "logging/logging.hpp"
+
+#include <cmath>
+#include <string>
+
+using namespace midas::trader;
+
+PineScriptTrader::PineScriptTrader(
+    std::shared_ptr<const pine::Program> program,
+    std::size_t candleSizeSeconds, const CandleSource &source,
+    const std::shared_ptr<midas::OrderManager> &orderManager,
+    midas::InstrumentEnum instrument, std::size_t entryQuantity,
+    const std::shared_ptr<logging::thread_safe_logger_t> &logger)
+    : Trader(std::max<std::size_t>(program->warmUp * warmUpFactor, 1),
+             candleSizeSeconds, source, orderManager, logger),
+      program(program), machine(program), instrument(instrument),
+      instrumentSpec(getInstrumentSpec(instrument)),
+      entryQuantity(entryQuantity) {}
+
+void PineScriptTrader::decide() {
+  if (!data.ok() || paused()) {
+    Trader::decision_params_t decisionParams{
+        {paused() ? "Paused" : "Not enough data", "true"}};
+    decisionParamsSignal(decisionParams);
+    return;
+  }
+  const auto candles = data.snapshot();
+  const std::pair candlesKey{candles->generation, candles->endIndex};
+  if (decided == candlesKey) {
+    return;
+  }
+  decided = candlesKey;
+  const bool inPosition = hasOpenPosition();
+  machine.run({candles->opens(), candles->highs(), candles->lows(),
+               candles->closes(), candles->volumes()},
+              {.positionSize = inPosition ? positionSize : 0,
+               .minTick = instrumentSpec.tickSize()});
+
+  Trader::decision_params_t decisionParams;
+  for (const pine::Entry &entry : program->entries) {
+    decisionParams.emplace_back(entry.id,
+                                machine.holds(entry.when) ? "true" : "false");
+  }
+  decisionParamsSignal(decisionParams);
+  if (inPosition) {
+    return;
+  }
+  for (const pine::Entry &entry : program->entries) {
+    if (machine.holds(entry.when)) {
+      enter(entry);
+      return;
+    }
+  }
+}
+
+void PineScriptTrader::enter(const pine::Entry &entry) {
+  const pine::Exit &exit = entry.exit;
+  const double sign = entry.direction == OrderDirection::BUY ? 1 : -1;
+  const double tick = instrumentSpec.tickSize();
+  const auto at = [this](const std::optional<pine::Register> &reg) {
+    return machine.value(*reg);
+  };
+  // market entries fill around the close of the candle they are decided on
+  const double entryPrice = instrumentSpec.roundToTick(
+      machine.value({pine::Program::close, false}));
+  const double stopLoss =
+      exit.stop ? at(exit.stop) : entryPrice - sign * at(exit.loss) * tick;
+  double profit;
+  if (exit.limit) {
+    profit = at(exit.limit);
+  } else if (exit.profit) {
+    profit = entryPrice + sign * at(exit.profit) * tick;
+  } else if (exit.trailPrice) {
+    profit = at(exit.trailPrice);
+  } else {
+    profit = entryPrice + sign * at(exit.trailPoints) * tick;
+  }
+  const double quantity = entry.quantity
+                              ? std::round(at(entry.quantity))
+                              : static_cast<double>(entryQuantity);
+  if (!(quantity >= 1) || !(sign * (profit - entryPrice) > 0) ||
+      !(sign * (entryPrice - stopLoss) > 0)) {
+    WARNING_LOG(*logger) << "skipping entry " << entry.id << " quantity "
+                         << quantity << " at " << entryPrice << " stop loss "
+                         << stopLoss << " profit " << profit;
+    return;
+  }
+  INFO_LOG(*logger) << "entering " << entry.id << " bar time: "
+                    << midas::toPtime(data.snapshot()->timestamps().back());
+  positionSize = sign * quantity;
+  enterBracket(instrument, static_cast<unsigned int>(quantity),
+               entry.direction, entryPrice,
+               instrumentSpec.roundToTick(stopLoss),
+               instrumentSpec.roundToTick(profit));
+}
+
+std::string PineScriptTrader::traderName() const {
+  return "Pine script trader " + program->title + " - " + instrument;
+}
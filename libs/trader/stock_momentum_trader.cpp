@@ -16,20 +16,23 @@ std::pair<double, double>
     profitOffset *= -1;
     stopOffset *= -1;
   }
-  double takeProfitLimit = entryPrice + profitOffset;
-  double stopLossLimit = entryPrice + stopOffset;
-  if (std::fmod(takeProfitLimit, 5) == 0) {
-    takeProfitLimit -= 0.25;
+  midas::TickPrice takeProfitLimit =
+      instrumentSpec.toTicks(entryPrice + profitOffset);
+  midas::TickPrice stopLossLimit =
+      instrumentSpec.toTicks(entryPrice + stopOffset);
+  const std::int64_t roundLevel = instrumentSpec.ticksIn(5);
+  const std::int64_t nudge = instrumentSpec.ticksIn(0.25);
+  if (takeProfitLimit.ticks % roundLevel == 0) {
+    takeProfitLimit = takeProfitLimit - nudge;
   }
-  if (std::fmod(stopLossLimit, 5) == 0) {
-    stopLossLimit += 0.25;
-  };
-  takeProfitLimit = std::round(takeProfitLimit * roundingCoeff) / roundingCoeff;
-  stopLossLimit = std::round(stopLossLimit * roundingCoeff) / roundingCoeff;
-  return {takeProfitLimit, stopLossLimit};
+  if (stopLossLimit.ticks % roundLevel == 0) {
+    stopLossLimit = stopLossLimit + nudge;
+  }
+  return {instrumentSpec.toPrice(takeProfitLimit),
+          instrumentSpec.toPrice(stopLossLimit)};
 }
 
 double midas::trader::StockMomentumTrader::decideEntryPrice() {
   double entryPrice = opens.back() + (highs.back() - lows.back()) / 2;
-  return std::round(entryPrice * roundingCoeff) / roundingCoeff;
+  return instrumentSpec.roundToTick(entryPrice);
 }
\ No newline at end of file
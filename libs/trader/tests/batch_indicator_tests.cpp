@@ -0,0 +1,241 @@
+#include "trader/batch_indicators.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <ta_func.h>
+#include <vector>
+
+using namespace midas::trader;
+
+namespace {
+struct Series {
+  std::vector<double> highs, lows, closes;
+  explicit Series(std::size_t size, double start = 20000) {
+    std::mt19937 generator(7);
+    std::normal_distribution<double> move(0, 2);
+    std::uniform_real_distribution<double> spread(0, 3);
+    double close = start;
+    for (std::size_t i = 0; i < size; i++) {
+      const double open = close;
+      close = open + move(generator);
+      // flat stretches exercise the zero variance and zero range paths
+      const bool flat = (i / 50) % 11 == 0;
+      closes.push_back(flat ? start : close);
+      const double wick = flat ? 0 : spread(generator);
+      highs.push_back(std::max(open, closes.back()) + wick);
+      lows.push_back(std::min(open, closes.back()) - wick);
+      if (flat) {
+        highs.back() = lows.back() = closes.back();
+      }
+    }
+  }
+  int end() const { return static_cast<int>(closes.size()) - 1; }
+};
+
+/**
+ * Runs check once per instruction set the CPU supports
+ */
+template <typename Check> void forEachInstructionSet(Check &&check) {
+  const batch::InstructionSet widest = batch::detectInstructionSet();
+  for (const auto instructionSet :
+       {batch::InstructionSet::Scalar, batch::InstructionSet::Avx2,
+        batch::InstructionSet::Avx512}) {
+    if (instructionSet > widest) {
+      break;
+    }
+    SCOPED_TRACE(batch::toString(instructionSet));
+    batch::useInstructionSet(instructionSet);
+    check();
+  }
+  batch::useInstructionSet(widest);
+}
+
+/**
+ * Batch outputs are NaN during the warm up and then follow TA-Lib, which
+ * starts writing at begin. Sums are associated differently, so values only
+ * agree relative to their magnitude.
+ */
+void expectMatches(const std::vector<double> &batch, std::size_t lookBack,
+                   const std::vector<double> &taLib, int begin, int size,
+                   double tolerance = 1e-9) {
+  ASSERT_EQ(static_cast<int>(lookBack), begin);
+  ASSERT_EQ(static_cast<int>(batch.size()) - begin, size);
+  for (std::size_t i = 0; i < batch.size(); i++) {
+    if (i < lookBack) {
+      ASSERT_TRUE(std::isnan(batch[i])) << "index " << i;
+      continue;
+    }
+    const double expected = taLib[i - begin];
+    EXPECT_NEAR(batch[i], expected,
+                tolerance * std::max(1.0, std::fabs(expected)))
+        << "index " << i;
+  }
+}
+} // namespace
+
+TEST(BatchIndicators, MovingAveragesMatchTaLib) {
+  const Series series(5003);
+  forEachInstructionSet([&] {
+    for (const int period : {2, 5, 15, 200}) {
+      std::vector<double> out(series.closes.size()),
+          expected(series.closes.size());
+      int begin = 0, size = 0;
+      std::size_t lookBack = batch::sma(series.closes, period, out);
+      TA_SMA(0, series.end(), series.closes.data(), period, &begin, &size,
+             expected.data());
+      expectMatches(out, lookBack, expected, begin, size);
+
+      lookBack = batch::ema(series.closes, period, out);
+      TA_EMA(0, series.end(), series.closes.data(), period, &begin, &size,
+             expected.data());
+      expectMatches(out, lookBack, expected, begin, size);
+    }
+  });
+}
+
+TEST(BatchIndicators, RollingExtremesMatchTaLib) {
+  const Series series(5003);
+  forEachInstructionSet([&] {
+    for (const int period : {2, 7, 64}) {
+      std::vector<double> out(series.closes.size()),
+          expected(series.closes.size());
+      int begin = 0, size = 0;
+      std::size_t lookBack = batch::rollingMin(series.lows, period, out);
+      TA_MIN(0, series.end(), series.lows.data(), period, &begin, &size,
+             expected.data());
+      expectMatches(out, lookBack, expected, begin, size, 0);
+
+      lookBack = batch::rollingMax(series.highs, period, out);
+      TA_MAX(0, series.end(), series.highs.data(), period, &begin, &size,
+             expected.data());
+      expectMatches(out, lookBack, expected, begin, size, 0);
+    }
+  });
+}
+
+TEST(BatchIndicators, DeviationsMatchTaLib) {
+  // TA-Lib sums raw squares, which only keeps enough digits while prices are
+  // close to their deviation
+  const Series series(5003, 100);
+  const double tolerance = 1e-8;
+  forEachInstructionSet([&] {
+    for (const int period : {5, 20}) {
+      const std::size_t length = series.closes.size();
+      std::vector<double> out(length), expected(length);
+      int begin = 0, size = 0;
+      std::size_t lookBack =
+          batch::rollingStdDev(series.closes, period, 1.5, out);
+      TA_STDDEV(0, series.end(), series.closes.data(), period, 1.5, &begin,
+                &size, expected.data());
+      expectMatches(out, lookBack, expected, begin, size, tolerance);
+
+      std::vector<double> upper(length), middle(length), lower(length),
+          expectedUpper(length), expectedMiddle(length),
+          expectedLower(length);
+      lookBack = batch::bollingerBands(series.closes, period, 2.0, 1.0, upper,
+                                       middle, lower);
+      TA_BBANDS(0, series.end(), series.closes.data(), period, 2.0, 1.0,
+                TA_MAType_SMA, &begin, &size, expectedUpper.data(),
+                expectedMiddle.data(), expectedLower.data());
+      expectMatches(upper, lookBack, expectedUpper, begin, size, tolerance);
+      expectMatches(middle, lookBack, expectedMiddle, begin, size);
+      expectMatches(lower, lookBack, expectedLower, begin, size, tolerance);
+    }
+  });
+}
+
+TEST(BatchIndicators, DeviationsStayAccurateAtHighPrices) {
+  const Series series(10007);
+  const int period = 20;
+  std::vector<double> exact(series.closes.size());
+  for (std::size_t i = period - 1; i < exact.size(); i++) {
+    const auto window = std::span(series.closes).subspan(i + 1 - period, period);
+    double mean = 0, variance = 0;
+    for (const double value : window) {
+      mean += value / period;
+    }
+    for (const double value : window) {
+      variance += (value - mean) * (value - mean) / period;
+    }
+    exact[i] = variance < 1e-8 ? 0 : std::sqrt(variance);
+  }
+  forEachInstructionSet([&] {
+    std::vector<double> out(series.closes.size());
+    batch::rollingStdDev(series.closes, period, 1, out);
+    for (std::size_t i = period - 1; i < exact.size(); i++) {
+      EXPECT_NEAR(out[i], exact[i], 1e-7) << "index " << i;
+    }
+  });
+}
+
+TEST(BatchIndicators, WilderSmoothingMatchesTaLib) {
+  const Series series(5003);
+  forEachInstructionSet([&] {
+    for (const int period : {1, 6, 14, 21}) {
+      std::vector<double> out(series.closes.size()),
+          expected(series.closes.size());
+      int begin = 0, size = 0;
+      std::size_t lookBack = batch::atr(series.highs, series.lows,
+                                        series.closes, period, out);
+      TA_ATR(0, series.end(), series.highs.data(), series.lows.data(),
+             series.closes.data(), period, &begin, &size, expected.data());
+      expectMatches(out, lookBack, expected, begin, size);
+      if (period == 1) {
+        // TA-Lib needs at least two periods for RSI
+        continue;
+      }
+      lookBack = batch::rsi(series.closes, period, out);
+      TA_RSI(0, series.end(), series.closes.data(), period, &begin, &size,
+             expected.data());
+      expectMatches(out, lookBack, expected, begin, size);
+    }
+  });
+}
+
+TEST(BatchIndicators, FindsTheFirstTouchedLevel) {
+  const Series series(5003);
+  forEachInstructionSet([&] {
+    for (std::size_t from = 0; from < series.closes.size(); from += 97) {
+      const double price = series.closes[from];
+      for (const double distance : {0.0, 1.0, 5.0, 40.0, 1e6}) {
+        const std::span<const double> highs =
+            std::span(series.highs).subspan(from);
+        const std::span<const double> lows =
+            std::span(series.lows).subspan(from);
+        std::size_t expected = 0;
+        while (expected < highs.size() &&
+               lows[expected] > price - distance &&
+               highs[expected] < price + distance) {
+          expected++;
+        }
+        EXPECT_EQ(batch::firstTouch(highs, lows, price - distance,
+                                    price + distance),
+                  expected)
+            << "from " << from << " distance " << distance;
+      }
+    }
+  });
+}
+
+TEST(BatchIndicators, ShortInputsOnlyWarmUp) {
+  const std::vector<double> values{1, 2, 3};
+  std::vector<double> out(values.size());
+  EXPECT_EQ(batch::rsi(values, 5, out), 5);
+  for (const double value : out) {
+    EXPECT_TRUE(std::isnan(value));
+  }
+  EXPECT_EQ(batch::sma(values, 3, out), 2);
+  EXPECT_DOUBLE_EQ(out.back(), 2);
+}
+
+TEST(BatchIndicators, RejectsMismatchedColumns) {
+  const std::vector<double> values(10, 1.0);
+  std::vector<double> out(9);
+  EXPECT_THROW(batch::sma(values, 3, out), std::invalid_argument);
+  out.resize(10);
+  EXPECT_THROW(batch::ema(values, 0, out), std::invalid_argument);
+  EXPECT_THROW(batch::firstTouch(values, std::span(values).first(9), 0, 2),
+               std::invalid_argument);
+}
@@ -0,0 +1,30 @@
+# Fails if an object compiled for a wider instruction set defines anything
+# but its own kernel table. Weak symbols, such as standard library template
+# instantiations, are merged across the program at link time and the copy
+# kept may be the AVX one, which the scalar path would then run.
+#
+# cmake -DNM=<nm> -DOBJECTS=<objects of the trader library> -P <this file>
+foreach(object IN LISTS OBJECTS)
+  if(NOT object MATCHES "batch_kernels_avx")
+    continue()
+  endif()
+  execute_process(COMMAND ${NM} --defined-only --extern-only ${object}
+          OUTPUT_VARIABLE symbols RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${NM} failed on ${object}")
+  endif()
+  string(REPLACE "\n" ";" symbols "${symbols}")
+  foreach(symbol IN LISTS symbols)
+    # the kernel table getter, and the personality routine reference of the
+    # exception tables
+    if(symbol STREQUAL "" OR symbol MATCHES "Kernels[Ev]*$" OR
+            symbol MATCHES "DW\\.ref\\.__gxx_personality_v0$")
+      continue()
+    endif()
+    message(SEND_ERROR "${object} exports ${symbol}")
+  endforeach()
+  set(checked TRUE)
+endforeach()
+if(NOT checked)
+  message(FATAL_ERROR "No instruction set specific kernel objects given")
+endif()
@@ -0,0 +1,244 @@
+#include "broker-interface/instruments.hpp"
+#include "broker-interface/order.hpp"
+#include "data/bar.hpp"
+#include "data/data_stream.hpp"
+#include "logging/logging.hpp"
+#include "trader/coroutine_trader.hpp"
+#include "trader/macd_strategy.hpp"
+#include "trader/macd_trader.hpp"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas;
+using namespace midas::trader;
+
+namespace {
+/**
+ * Appends random walk bars of 5 seconds to a stream
+ */
+struct BarFeed {
+  std::shared_ptr<DataStream> stream = std::make_shared<DataStream>(5);
+  std::mt19937 generator{5};
+  double close = 18000;
+  Timestamp time = midas::fromUnixSeconds(1'699'999'200);
+
+  void add(std::size_t count) {
+    std::normal_distribution<double> move(0, 1.5);
+    std::uniform_int_distribution<int> volume(10, 40);
+    std::vector<Bar> bars;
+    for (std::size_t i = 0; i < count; i++) {
+      const double open = close;
+      close += move(generator);
+      bars.emplace_back(5, 10, std::max(open, close) + 0.5,
+                        std::min(open, close) - 0.5, open, close, close,
+                        volume(generator), time);
+      time += midas::fromUnixSeconds(5);
+    }
+    stream->addBars(bars.begin(), bars.end());
+    stream->waitForData(0ms);
+  }
+};
+
+/**
+ * Keeps every transmitted order, filling market orders on the spot if asked
+ */
+struct RecordingOrderManager : public OrderManager {
+  std::vector<std::shared_ptr<Order>> orders;
+  bool fillMarketOrders{false};
+  RecordingOrderManager(std::shared_ptr<logging::thread_safe_logger_t> &logger)
+      : OrderManager(logger) {}
+  void transmit(std::shared_ptr<Order> order) override {
+    orders.push_back(order);
+    order->setTransmitted();
+    if (fillMarketOrders && order->execType == ExecutionType::MKT) {
+      order->setFilled(100, 0, order->requestedQuantity);
+    }
+  }
+  bool hasActiveOrders() override { return false; }
+  std::list<Order *> getFilledOrders() override { return {}; }
+};
+
+class CoroutineTraderTest : public ::testing::Test {
+protected:
+  std::shared_ptr<logging::thread_safe_logger_t> logger =
+      std::make_shared<logging::thread_safe_logger_t>(
+          logging::create_channel_logger("Coroutine Trader Test Logger"));
+  std::shared_ptr<RecordingOrderManager> orderManager =
+      std::make_shared<RecordingOrderManager>(logger);
+  BarFeed feed;
+
+  /**
+   * The macd strategy and the MacdTrader place the same orders with the
+   * parameters
+   */
+  void expectMacdOrders(const MacdParameters &parameters) {
+    orderManager->fillMarketOrders = true;
+    auto coroutineTrader = std::make_unique<CoroutineTrader>(
+        "MACD coroutine trader", macdStrategyLookBack, 120, feed.stream,
+        orderManager, InstrumentEnum::MicroNasdaqFutures, logger);
+    coroutineTrader->spawn(macdStrategy, 1, parameters);
+    const auto macdOrders = std::make_shared<RecordingOrderManager>(logger);
+    macdOrders->fillMarketOrders = true;
+    MacdTrader macdTrader(feed.stream, macdOrders,
+                          InstrumentEnum::MicroNasdaqFutures, 1, logger,
+                          parameters);
+    for (int candle = 0; candle < 1500; candle++) {
+      feed.add(24);
+      coroutineTrader->decide();
+      macdTrader.decide();
+    }
+    ASSERT_GT(macdOrders->orders.size(), 2);
+    ASSERT_EQ(orderManager->orders.size(), macdOrders->orders.size());
+    for (std::size_t i = 0; i < macdOrders->orders.size(); i++) {
+      EXPECT_EQ(orderManager->orders[i]->direction,
+                macdOrders->orders[i]->direction)
+          << i;
+    }
+  }
+
+  std::unique_ptr<CoroutineTrader> minuteTrader() {
+    return std::make_unique<CoroutineTrader>(
+        "Test", 1, 60, feed.stream, orderManager,
+        InstrumentEnum::MicroNasdaqFutures, logger);
+  }
+};
+
+Strategy roundTrip(CoroutineTrader &trader, std::vector<std::string> *events) {
+  co_await trader.nextCandle();
+  const Timestamp start = trader.candles().timestamps().back();
+  events->push_back("candle");
+  const auto entry = trader.market(OrderDirection::BUY, 2);
+  events->push_back(co_await trader.fill(entry) == OrderStatusEnum::Filled
+                        ? "filled"
+                        : "cancelled");
+  co_await trader.timeout(3min);
+  events->push_back(
+      std::to_string(secondsBetween(start, trader.candles().timestamps().back())));
+  const auto exit = trader.limit(OrderDirection::SELL, 2, 1e6);
+  // never filled, gives up two minutes later
+  const OrderStatusEnum status = co_await trader.fill(exit, 2min);
+  events->push_back(
+      std::to_string(secondsBetween(start, trader.candles().timestamps().back())));
+  events->push_back(status == OrderStatusEnum::Filled ? "filled" : "waiting");
+}
+
+Strategy countCandles(CoroutineTrader &trader, int candles, int *total) {
+  for (int i = 0; i < candles; i++) {
+    co_await trader.nextCandle();
+    ++*total;
+  }
+}
+
+Strategy failOnSecondCandle(CoroutineTrader &trader) {
+  co_await trader.nextCandle();
+  co_await trader.nextCandle();
+  throw std::runtime_error("strategy failure");
+}
+} // namespace
+
+TEST_F(CoroutineTraderTest, ResumesStrategiesInSequence) {
+  auto trader = minuteTrader();
+  std::vector<std::string> events;
+  trader->spawn(roundTrip, &events);
+  trader->decide();
+  EXPECT_TRUE(events.empty());
+
+  feed.add(13);
+  trader->decide();
+  ASSERT_EQ(events, std::vector<std::string>{"candle"});
+  ASSERT_EQ(orderManager->orders.size(), 1);
+  EXPECT_EQ(orderManager->orders[0]->execType, ExecutionType::MKT);
+  // no new candle nor fill, nothing resumes
+  trader->decide();
+  EXPECT_EQ(events.size(), 1);
+
+  orderManager->orders[0]->setFilled(100, 0, 2);
+  trader->decide();
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(events[1], "filled");
+
+  for (int minute = 1; minute <= 3; minute++) {
+    EXPECT_EQ(events.size(), 2) << minute;
+    feed.add(12);
+    trader->decide();
+  }
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(events[2], "180");
+  ASSERT_EQ(orderManager->orders.size(), 2);
+  EXPECT_EQ(orderManager->orders[1]->execType, ExecutionType::Limit);
+
+  feed.add(12);
+  trader->decide();
+  EXPECT_EQ(events.size(), 3);
+  feed.add(12);
+  trader->decide();
+  EXPECT_EQ(events,
+            (std::vector<std::string>{"candle", "filled", "180", "300", "waiting"}));
+  EXPECT_EQ(trader->running(), 0);
+}
+
+TEST_F(CoroutineTraderTest, RunsHundredsOfStrategiesFromAPool) {
+  auto trader = minuteTrader();
+  int total = 0;
+  for (int i = 0; i < 500; i++) {
+    trader->spawn(countCandles, 1 + i % 3, &total);
+  }
+  EXPECT_EQ(trader->running(), 500);
+  const std::size_t reserved = trader->frames().reserved();
+  // frames are carved out of a few chunks rather than allocated one by one
+  EXPECT_GT(reserved, 0);
+  EXPECT_LE(reserved, 500 * FramePool::maxPooledSize / 4);
+
+  for (int minute = 0; minute < 3; minute++) {
+    feed.add(12);
+    trader->decide();
+  }
+  feed.add(1);
+  trader->decide();
+  EXPECT_EQ(total, 167 * 1 + 167 * 2 + 166 * 3);
+  EXPECT_EQ(trader->running(), 0);
+
+  // released frames are taken again
+  for (int i = 0; i < 500; i++) {
+    trader->spawn(countCandles, 1, &total);
+  }
+  EXPECT_EQ(trader->frames().reserved(), reserved);
+}
+
+TEST_F(CoroutineTraderTest, EndsStrategiesThatThrow) {
+  auto trader = minuteTrader();
+  int total = 0;
+  trader->spawn(failOnSecondCandle);
+  trader->spawn(countCandles, 3, &total);
+  for (int minute = 0; minute < 2; minute++) {
+    feed.add(12);
+    trader->decide();
+  }
+  EXPECT_EQ(trader->running(), 1);
+  feed.add(12);
+  trader->decide();
+  EXPECT_EQ(total, 3);
+  EXPECT_EQ(trader->running(), 0);
+}
+
+TEST_F(CoroutineTraderTest, MacdStrategyTradesAsTheMacdTrader) {
+  expectMacdOrders(MacdTrader::defaultParameters);
+}
+
+TEST_F(CoroutineTraderTest, MacdStrategyTakesTheMacdTraderParameters) {
+  MacdParameters parameters;
+  parameters.macdFastPeriod = 5;
+  parameters.rsiTimePeriod = 9;
+  parameters.maxCrossOverDistance = 15;
+  parameters.rsiOverbought = 65;
+  parameters.rsiOversold = 35;
+  parameters.numberOfConsecutivePeriodsRequired = 2;
+  expectMacdOrders(parameters);
+}
@@ -0,0 +1,185 @@
+/**
+ * Times the batch indicator kernels on every supported instruction set
+ * against the matching TA-Lib functions over a long synthetic 5 second
+ * series, then the indicators of the momentum trader as separate TA-Lib
+ * passes, as streaming indicators and as a fused pipeline. Build with
+ * optimizations, the numbers are meaningless otherwise.
+ * usage: indicator_benchmark [bar count]
+ */
+#include "trader/batch_indicators.hpp"
+#include "trader/indicators.hpp"
+#include "trader/momentum_trader.hpp"
+#include "trader/pipeline.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <ta_func.h>
+#include <vector>
+
+using namespace midas::trader;
+
+namespace {
+constexpr int repetitions = 5;
+
+constexpr MomentumParameters momentum = MomentumTrader::defaultParameters;
+/**
+ * The indicators of the momentum trader with its default parameters
+ */
+using momentum_pipeline_t = pipeline::Pipeline<
+    pipeline::Ema<momentum.fastMATimePeriod>,
+    pipeline::Ema<momentum.slowMATimePeriod>,
+    pipeline::Sma<momentum.volumeMATimePeriod, pipeline::Field::Volume>,
+    pipeline::Macd<momentum.macdFastPeriod, momentum.macdSlowPeriod,
+                   momentum.macdSignalPeriod>,
+    pipeline::Rsi<momentum.rsiTimePeriod>>;
+
+/**
+ * Best of a few runs, in seconds
+ */
+double time(const std::function<void()> &run) {
+  double best = 0;
+  for (int i = 0; i < repetitions; i++) {
+    const auto start = std::chrono::steady_clock::now();
+    run();
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (i == 0 || elapsed.count() < best) {
+      best = elapsed.count();
+    }
+  }
+  return best;
+}
+
+void report(const char *indicator, const char *implementation,
+            std::size_t bars, double seconds) {
+  std::printf("%-10s %-8s %10.2f ms %10.1f Mbars/s\n", indicator,
+              implementation, seconds * 1e3, bars / seconds / 1e6);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t bars = argc > 1 ? std::strtoull(argv[1], nullptr, 10)
+                                    : std::size_t{1} << 22;
+  std::mt19937 generator(1);
+  std::normal_distribution<double> move(0, 2);
+  std::uniform_real_distribution<double> spread(0, 3);
+  std::vector<double> highs(bars), lows(bars), closes(bars), volumes(bars),
+      out(bars), upper(bars), lower(bars);
+  double close = 20000;
+  for (std::size_t i = 0; i < bars; i++) {
+    const double open = close;
+    close += move(generator);
+    closes[i] = close;
+    highs[i] = std::max(open, close) + spread(generator);
+    lows[i] = std::min(open, close) - spread(generator);
+    volumes[i] = 100 + 50 * spread(generator);
+  }
+  const int end = static_cast<int>(bars) - 1;
+  int begin = 0, size = 0;
+
+  const std::vector<std::pair<const char *, std::function<void()>>> taLib{
+      {"SMA(20)",
+       [&] { TA_SMA(0, end, closes.data(), 20, &begin, &size, out.data()); }},
+      {"EMA(20)",
+       [&] { TA_EMA(0, end, closes.data(), 20, &begin, &size, out.data()); }},
+      {"MAX(50)",
+       [&] { TA_MAX(0, end, highs.data(), 50, &begin, &size, out.data()); }},
+      {"STDDEV(20)",
+       [&] {
+         TA_STDDEV(0, end, closes.data(), 20, 1, &begin, &size, out.data());
+       }},
+      {"BBANDS(20)",
+       [&] {
+         TA_BBANDS(0, end, closes.data(), 20, 2, 2, TA_MAType_SMA, &begin,
+                   &size, upper.data(), out.data(), lower.data());
+       }},
+      {"RSI(14)",
+       [&] { TA_RSI(0, end, closes.data(), 14, &begin, &size, out.data()); }},
+      {"ATR(14)",
+       [&] {
+         TA_ATR(0, end, highs.data(), lows.data(), closes.data(), 14, &begin,
+                &size, out.data());
+       }},
+  };
+  const std::vector<std::function<void()>> kernels{
+      [&] { batch::sma(closes, 20, out); },
+      [&] { batch::ema(closes, 20, out); },
+      [&] { batch::rollingMax(highs, 50, out); },
+      [&] { batch::rollingStdDev(closes, 20, 1, out); },
+      [&] { batch::bollingerBands(closes, 20, 2, 2, upper, out, lower); },
+      [&] { batch::rsi(closes, 14, out); },
+      [&] { batch::atr(highs, lows, closes, 14, out); },
+  };
+
+  const batch::InstructionSet widest = batch::detectInstructionSet();
+  for (std::size_t i = 0; i < taLib.size(); i++) {
+    report(taLib[i].first, "TA-Lib", bars, time(taLib[i].second));
+    for (const auto instructionSet :
+         {batch::InstructionSet::Scalar, batch::InstructionSet::Avx2,
+          batch::InstructionSet::Avx512}) {
+      if (instructionSet > widest) {
+        break;
+      }
+      batch::useInstructionSet(instructionSet);
+      report(taLib[i].first, batch::toString(instructionSet), bars,
+             time(kernels[i]));
+    }
+  }
+
+  // every implementation writes all seven outputs of the momentum trader
+  std::vector<double> fastMa(bars), slowMa(bars), volumeMa(bars), macd(bars),
+      signal(bars), histogram(bars), rsi(bars);
+  report("MOMENTUM", "TA-Lib", bars, time([&] {
+           TA_EMA(0, end, closes.data(), momentum.fastMATimePeriod, &begin,
+                  &size, fastMa.data());
+           TA_EMA(0, end, closes.data(), momentum.slowMATimePeriod, &begin,
+                  &size, slowMa.data());
+           TA_SMA(0, end, volumes.data(), momentum.volumeMATimePeriod,
+                  &begin, &size, volumeMa.data());
+           TA_MACD(0, end, closes.data(), momentum.macdFastPeriod,
+                   momentum.macdSlowPeriod, momentum.macdSignalPeriod,
+                   &begin, &size, macd.data(), signal.data(),
+                   histogram.data());
+           TA_RSI(0, end, closes.data(), momentum.rsiTimePeriod, &begin,
+                  &size, rsi.data());
+         }));
+  report("MOMENTUM", "stream", bars, time([&] {
+           indicators::Ema fast(momentum.fastMATimePeriod),
+               slow(momentum.slowMATimePeriod);
+           indicators::Sma volumeAverage(momentum.volumeMATimePeriod);
+           indicators::Macd convergence(momentum.macdFastPeriod,
+                                        momentum.macdSlowPeriod,
+                                        momentum.macdSignalPeriod);
+           indicators::Rsi strength(momentum.rsiTimePeriod);
+           for (std::size_t i = 0; i < bars; i++) {
+             fast.add(closes[i]);
+             slow.add(closes[i]);
+             volumeAverage.add(volumes[i]);
+             convergence.add(closes[i]);
+             strength.add(closes[i]);
+             fastMa[i] = fast.value();
+             slowMa[i] = slow.value();
+             volumeMa[i] = volumeAverage.value();
+             macd[i] = convergence.macd();
+             signal[i] = convergence.signal();
+             histogram[i] = convergence.histogram();
+             rsi[i] = strength.value();
+           }
+         }));
+  report("MOMENTUM", "fused", bars, time([&] {
+           momentum_pipeline_t pipeline;
+           pipeline.run({.closes = closes, .volumes = volumes},
+                        [&](std::size_t i, const auto &values) {
+                          fastMa[i] = values.template get<0>().value();
+                          slowMa[i] = values.template get<1>().value();
+                          volumeMa[i] = values.template get<2>().value();
+                          macd[i] = values.template get<3>().macd();
+                          signal[i] = values.template get<3>().signal();
+                          histogram[i] = values.template get<3>().histogram();
+                          rsi[i] = values.template get<4>().value();
+                        });
+         }));
+  return 0;
+}
@@ -0,0 +1,259 @@
+#include "data/data_stream.hpp"
+#include "exceptions/sampling_error.hpp"
+#include "trader/indicator_graph.hpp"
+#include "trader/trader_data.hpp"
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+using namespace std::chrono_literals;
+
+using namespace midas;
+using namespace midas::trader;
+
+namespace {
+/**
+ * Appends random walk candles to a series and its graph, one minute apart
+ */
+struct CandleFeed {
+  CandleSeries &series;
+  IndicatorGraph &graph;
+  std::mt19937 generator{7};
+  double close = 100;
+  Timestamp time = midas::fromUnixSeconds(60);
+
+  void add(std::size_t count) {
+    std::normal_distribution<double> move(0, 1);
+    for (std::size_t i = 0; i < count; i++) {
+      const double open = close;
+      close += move(generator);
+      const double high = std::max(open, close) + 0.5;
+      const double low = std::min(open, close) - 0.5;
+      const Bar candle(60, 1, high, low, open, close, close, 10 + i % 7,
+                       time);
+      series.append(candle);
+      graph.append(candle);
+      time += midas::fromUnixSeconds(60);
+    }
+    series.publish(std::nullopt);
+    graph.publish();
+  }
+};
+} // namespace
+
+TEST(IndicatorGraph, RegistersEachIndicatorOnce) {
+  const auto series = std::make_shared<CandleSeries>(60, 10);
+  IndicatorGraph graph(series);
+  const auto ema = graph.ema(graph.close(), 5);
+  EXPECT_EQ(graph.ema(graph.close(), 5), ema);
+  EXPECT_NE(graph.ema(graph.close(), 6), ema);
+  EXPECT_NE(graph.ema(graph.volume(), 5), ema);
+  const auto macd = graph.macd(graph.close(), 6, 13, 4);
+  EXPECT_EQ(graph.macd(graph.close(), 6, 13, 4).histogram, macd.histogram);
+  EXPECT_EQ(graph.atr(14), graph.atr(14));
+  // close, volume, three averages, macd, high, low and atr
+  EXPECT_EQ(graph.size(), 9);
+
+  EXPECT_THROW(graph.sma(graph.close(), 0), std::invalid_argument);
+  EXPECT_THROW(graph.ema({1000}, 5), std::invalid_argument);
+  EXPECT_THROW(graph.subscribe({1000}, 5), std::invalid_argument);
+}
+
+TEST(IndicatorGraph, MatchesStreamingIndicators) {
+  const auto series = std::make_shared<CandleSeries>(60, 300);
+  IndicatorGraph graph(series);
+  CandleFeed feed{*series, graph};
+  const auto atr = graph.atr(14);
+  const auto atrAverage = graph.ema(atr, 9);
+  const auto bands = graph.bollingerBands(graph.close(), 20, 2.0, 2.0);
+  graph.subscribe(atrAverage, 5);
+
+  indicators::Atr expectedAtr(14);
+  indicators::Ema expectedAverage(9);
+  indicators::BollingerBands expectedBands(20, 2.0, 2.0);
+  std::vector<double> averages;
+  std::size_t added = 0;
+  const auto check = [&] {
+    const auto values = graph.snapshot();
+    const auto candles = values->candles;
+    for (; added < candles->size(); added++) {
+      expectedAtr.add(candles->highs()[added], candles->lows()[added],
+                      candles->closes()[added]);
+      if (expectedAtr.ready()) {
+        expectedAverage.add(expectedAtr.value());
+      }
+      expectedBands.add(candles->closes()[added]);
+      if (expectedAverage.ready()) {
+        averages.push_back(expectedAverage.value());
+      }
+    }
+    ASSERT_EQ(values->ready(atrAverage), expectedAverage.ready());
+    ASSERT_EQ(values->ready(bands.upper), expectedBands.ready());
+    if (expectedAverage.ready()) {
+      EXPECT_EQ(values->value(atr), expectedAtr.value());
+      const std::size_t kept = std::min<std::size_t>(averages.size(), 5);
+      ASSERT_EQ(values->size(atrAverage), kept);
+      for (std::size_t offset = 0; offset < kept; offset++) {
+        EXPECT_EQ(values->value(atrAverage, offset),
+                  averages[averages.size() - 1 - offset]);
+      }
+    }
+    if (expectedBands.ready()) {
+      EXPECT_EQ(values->value(bands.upper), expectedBands.upper());
+      EXPECT_EQ(values->value(bands.lower), expectedBands.lower());
+    }
+  };
+  // values follow the candles one at a time, or several at once
+  for (int i = 0; i < 30; i++) {
+    feed.add(1);
+    check();
+  }
+  feed.add(40);
+  check();
+  EXPECT_TRUE(std::isnan(graph.snapshot()->value(atrAverage, 5)));
+}
+
+TEST(IndicatorGraph, LateRegistrationsReplayRetainedCandles) {
+  const auto series = std::make_shared<CandleSeries>(60, 50);
+  IndicatorGraph graph(series);
+  CandleFeed feed{*series, graph};
+  const auto fast = graph.ema(graph.close(), 5);
+  feed.add(30);
+  EXPECT_FALSE(graph.pending());
+  const auto before = graph.snapshot();
+  const auto slow = graph.sma(graph.close(), 10);
+  EXPECT_TRUE(graph.pending());
+  EXPECT_EQ(graph.snapshot(), before);
+  graph.publish();
+  const auto values = graph.snapshot();
+  EXPECT_NE(values, before);
+  EXPECT_EQ(values->value(fast), before->value(fast));
+
+  indicators::Sma expected(10);
+  for (const double close : values->candles->closes()) {
+    expected.add(close);
+  }
+  EXPECT_EQ(values->value(slow), expected.value());
+  EXPECT_TRUE(before->ready(fast));
+
+  // the series starting over starts the indicators over
+  series->clear();
+  graph.clear();
+  feed.add(3);
+  const auto cleared = graph.snapshot();
+  EXPECT_FALSE(cleared->ready(fast));
+  EXPECT_TRUE(std::isnan(cleared->value(slow)));
+  feed.add(2);
+  EXPECT_TRUE(graph.snapshot()->ready(fast));
+}
+
+TEST(IndicatorGraph, TradersShareIndicatorsOfALevel) {
+  const auto streamPtr = std::make_shared<DataStream>(5);
+  const auto pyramid = std::make_shared<CandlePyramid>(streamPtr);
+  TraderData first(3, 120, pyramid);
+  TraderData second(10, 120, pyramid);
+  TraderData other(3, 300, pyramid);
+  EXPECT_EQ(&first.indicatorGraph(), &second.indicatorGraph());
+  EXPECT_NE(&first.indicatorGraph(), &other.indicatorGraph());
+
+  const auto macd = first.indicatorGraph().macd(
+      first.indicatorGraph().close(), 6, 13, 4);
+  EXPECT_EQ(second.indicatorGraph()
+                .macd(second.indicatorGraph().close(), 6, 13, 4)
+                .signal,
+            macd.signal);
+  EXPECT_EQ(first.indicatorGraph().size(), 2);
+  EXPECT_THROW(pyramid->indicators(180), SamplingError);
+
+  // indicators registered after the candles do not wait for the next bar
+  Timestamp time = midas::fromUnixSeconds(5);
+  for (int i = 0; i < 24 * 20; i++) {
+    streamPtr->addBars(Bar(5, 1, i + 1, i - 1, i, i, i, 1, time));
+    time += midas::fromUnixSeconds(5);
+  }
+  streamPtr->waitForData(0ms);
+  EXPECT_TRUE(first.indicatorSnapshot()->ready(macd.signal));
+  // late ones only see the ten candles the level retains
+  const auto average = second.indicatorGraph().sma(
+      second.indicatorGraph().close(), 5);
+  EXPECT_TRUE(second.indicatorSnapshot()->ready(average));
+  // the first candle closes on bar 22, the next ones every 24 bars
+  EXPECT_EQ(first.indicatorSnapshot()->value(average), 22 + 24 * 17);
+  EXPECT_EQ(first.indicatorSnapshot()->size(average), 1);
+}
+
+TEST(IndicatorGraph, FeatureMatrixMatchesStreaming) {
+  std::mt19937 generator{11};
+  std::normal_distribution<double> move(0, 1);
+  DataStream history(5);
+  Timestamp time = midas::fromUnixSeconds(5);
+  double close = 100;
+  // a day of 5 second bars
+  std::vector<Bar> bars;
+  for (int i = 0; i < 17280; i++) {
+    const double open = close;
+    close += move(generator);
+    bars.emplace_back(5, 1, std::max(open, close) + 0.25,
+                      std::min(open, close) - 0.25, open, close, close,
+                      1 + i % 5, time);
+    time += midas::fromUnixSeconds(5);
+  }
+  history.addBars(bars.begin(), bars.end());
+  history.waitForData(0ms);
+  ASSERT_EQ(history.size(), bars.size());
+
+  struct Run {
+    std::shared_ptr<DataStream> stream = std::make_shared<DataStream>(5);
+    std::shared_ptr<CandlePyramid> pyramid =
+        std::make_shared<CandlePyramid>(stream);
+    TraderData data{30, 300, pyramid};
+    std::vector<IndicatorOutput> outputs;
+    Run() {
+      IndicatorGraph &graph = data.indicatorGraph();
+      const auto macd = graph.macd(graph.close(), 6, 13, 4);
+      const auto bands = graph.bollingerBands(graph.close(), 20, 2.0, 2.0);
+      const auto atr = graph.atr(14);
+      outputs = {macd.macd,    macd.histogram, bands.upper,
+                 bands.lower,  atr,            graph.ema(atr, 9),
+                 graph.rsi(graph.close(), 6),  graph.sma(graph.volume(), 15)};
+      for (const IndicatorOutput output : outputs) {
+        graph.subscribe(output, 4);
+      }
+    }
+  };
+  Run streaming, precomputed;
+  precomputed.pyramid->precomputeFeatures(history);
+
+  // replayed in uneven chunks, as a back test does
+  for (std::size_t first = 0; first < bars.size();) {
+    const std::size_t last = std::min(bars.size(), first + 1 + first % 97);
+    for (Run *run : {&streaming, &precomputed}) {
+      run->stream->addBars(bars.begin() + first, bars.begin() + last);
+      run->stream->waitForData(0ms);
+    }
+    first = last;
+    const auto expected = streaming.data.indicatorSnapshot();
+    const auto values = precomputed.data.indicatorSnapshot();
+    ASSERT_EQ(values->candles->endIndex, expected->candles->endIndex);
+    for (const IndicatorOutput output : streaming.outputs) {
+      ASSERT_EQ(values->size(output), expected->size(output));
+      for (std::size_t offset = 0; offset < expected->size(output);
+           offset++) {
+        // the batch kernels only differ in rounding
+        const double value = expected->value(output, offset);
+        ASSERT_NEAR(values->value(output, offset), value,
+                    1e-9 * std::max(1.0, std::fabs(value)));
+      }
+    }
+  }
+  EXPECT_EQ(streaming.data.indicatorSnapshot()->size(streaming.outputs[0]),
+            4);
+
+  // the series starting over drops the features
+  precomputed.data.clear();
+  EXPECT_EQ(precomputed.data.indicatorSnapshot()->size(streaming.outputs[0]),
+            0);
+}
@@ -0,0 +1,292 @@
+#include "trader/indicators.hpp"
+#include "trader/pipeline.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <tuple>
+#include <ta_func.h>
+#include <vector>
+
+using namespace midas::trader::indicators;
+
+namespace {
+// streaming and batch sums are done in the same order
+constexpr double tolerance = 1e-9;
+
+struct Series {
+  std::vector<double> highs, lows, closes;
+  explicit Series(std::size_t size) {
+    std::mt19937 generator(42);
+    std::normal_distribution<double> move(0, 2);
+    std::uniform_real_distribution<double> spread(0, 3);
+    double close = 20000;
+    for (std::size_t i = 0; i < size; i++) {
+      const double open = close;
+      close = open + move(generator);
+      // flat candles exercise the zero range paths
+      const bool flat = i % 37 == 0;
+      closes.push_back(flat ? open : close);
+      const double wick = flat ? 0 : spread(generator);
+      highs.push_back(std::max(open, closes.back()) + wick);
+      lows.push_back(std::min(open, closes.back()) - wick);
+    }
+  }
+  int end() const { return static_cast<int>(closes.size()) - 1; }
+};
+
+/**
+ * Checks streamed values against a batch output that starts at begin
+ */
+void expectMatches(const std::vector<double> &streamed,
+                   const std::vector<bool> &ready,
+                   const std::vector<double> &batch, int begin, int size) {
+  ASSERT_GT(size, 0);
+  for (std::size_t i = 0; i < streamed.size(); i++) {
+    const bool hasBatchValue = static_cast<int>(i) >= begin;
+    ASSERT_EQ(ready[i], hasBatchValue) << "index " << i;
+    if (hasBatchValue) {
+      EXPECT_NEAR(streamed[i], batch[i - begin], tolerance) << "index " << i;
+    }
+  }
+}
+} // namespace
+
+TEST(Indicators, EmaMatchesTaLib) {
+  const Series series(500);
+  for (const int period : {2, 5, 15}) {
+    Ema ema(period);
+    std::vector<double> streamed;
+    std::vector<bool> ready;
+    for (const double close : series.closes) {
+      ema.add(close);
+      streamed.push_back(ema.value());
+      ready.push_back(ema.ready());
+    }
+    std::vector<double> batch(series.closes.size());
+    int begin = 0, size = 0;
+    TA_EMA(0, series.end(), series.closes.data(), period, &begin, &size,
+           batch.data());
+    expectMatches(streamed, ready, batch, begin, size);
+  }
+}
+
+TEST(Indicators, SmaMatchesTaLib) {
+  const Series series(500);
+  for (const int period : {2, 3, 15}) {
+    Sma sma(period);
+    std::vector<double> streamed;
+    std::vector<bool> ready;
+    for (const double close : series.closes) {
+      sma.add(close);
+      streamed.push_back(sma.value());
+      ready.push_back(sma.ready());
+    }
+    std::vector<double> batch(series.closes.size());
+    int begin = 0, size = 0;
+    TA_SMA(0, series.end(), series.closes.data(), period, &begin, &size,
+           batch.data());
+    expectMatches(streamed, ready, batch, begin, size);
+  }
+}
+
+TEST(Indicators, RsiMatchesTaLib) {
+  const Series series(500);
+  for (const int period : {2, 6, 14}) {
+    Rsi rsi(period);
+    std::vector<double> streamed;
+    std::vector<bool> ready;
+    for (const double close : series.closes) {
+      rsi.add(close);
+      streamed.push_back(rsi.value());
+      ready.push_back(rsi.ready());
+    }
+    std::vector<double> batch(series.closes.size());
+    int begin = 0, size = 0;
+    TA_RSI(0, series.end(), series.closes.data(), period, &begin, &size,
+           batch.data());
+    expectMatches(streamed, ready, batch, begin, size);
+  }
+}
+
+TEST(Indicators, AtrMatchesTaLib) {
+  const Series series(500);
+  for (const int period : {1, 14, 21}) {
+    Atr atr(period);
+    std::vector<double> streamed;
+    std::vector<bool> ready;
+    for (std::size_t i = 0; i < series.closes.size(); i++) {
+      atr.add(series.highs[i], series.lows[i], series.closes[i]);
+      streamed.push_back(atr.value());
+      ready.push_back(atr.ready());
+    }
+    std::vector<double> batch(series.closes.size());
+    int begin = 0, size = 0;
+    TA_ATR(0, series.end(), series.highs.data(), series.lows.data(),
+           series.closes.data(), period, &begin, &size, batch.data());
+    expectMatches(streamed, ready, batch, begin, size);
+  }
+}
+
+TEST(Indicators, MacdMatchesTaLib) {
+  const Series series(500);
+  for (const auto &[fast, slow, signal] :
+       {std::tuple{6, 13, 4}, std::tuple{12, 26, 9}, std::tuple{26, 12, 9}}) {
+    Macd macd(fast, slow, signal);
+    std::vector<double> line, signalLine, histogram;
+    std::vector<bool> ready;
+    for (const double close : series.closes) {
+      macd.add(close);
+      line.push_back(macd.macd());
+      signalLine.push_back(macd.signal());
+      histogram.push_back(macd.histogram());
+      ready.push_back(macd.ready());
+    }
+    const std::size_t length = series.closes.size();
+    std::vector<double> batchLine(length), batchSignal(length),
+        batchHistogram(length);
+    int begin = 0, size = 0;
+    TA_MACD(0, series.end(), series.closes.data(), fast, slow, signal, &begin,
+            &size, batchLine.data(), batchSignal.data(),
+            batchHistogram.data());
+    expectMatches(line, ready, batchLine, begin, size);
+    expectMatches(signalLine, ready, batchSignal, begin, size);
+    expectMatches(histogram, ready, batchHistogram, begin, size);
+  }
+}
+
+TEST(Indicators, BollingerBandsMatchTaLib) {
+  const Series series(500);
+  for (const auto &[up, down] : {std::pair{2.0, 2.0}, std::pair{1.0, 1.0},
+                                std::pair{1.5, 2.5}}) {
+    BollingerBands bands(20, up, down);
+    std::vector<double> upper, middle, lower;
+    std::vector<bool> ready;
+    for (const double close : series.closes) {
+      bands.add(close);
+      upper.push_back(bands.upper());
+      middle.push_back(bands.middle());
+      lower.push_back(bands.lower());
+      ready.push_back(bands.ready());
+    }
+    const std::size_t length = series.closes.size();
+    std::vector<double> batchUpper(length), batchMiddle(length),
+        batchLower(length);
+    int begin = 0, size = 0;
+    TA_BBANDS(0, series.end(), series.closes.data(), 20, up, down,
+              TA_MAType_SMA, &begin, &size, batchUpper.data(),
+              batchMiddle.data(), batchLower.data());
+    expectMatches(upper, ready, batchUpper, begin, size);
+    expectMatches(middle, ready, batchMiddle, begin, size);
+    expectMatches(lower, ready, batchLower, begin, size);
+  }
+}
+
+TEST(Indicators, DirectionalMovementMatchesTaLib) {
+  const Series series(500);
+  for (const int period : {5, 14}) {
+    DirectionalMovement movement(period);
+    std::vector<double> plus, minus, adx;
+    std::vector<bool> directionalReady, ready;
+    for (std::size_t i = 0; i < series.closes.size(); i++) {
+      movement.add(series.highs[i], series.lows[i], series.closes[i]);
+      plus.push_back(movement.plusDI());
+      minus.push_back(movement.minusDI());
+      adx.push_back(movement.adx());
+      directionalReady.push_back(movement.directionalReady());
+      ready.push_back(movement.ready());
+    }
+    std::vector<double> batch(series.closes.size());
+    int begin = 0, size = 0;
+    TA_PLUS_DI(0, series.end(), series.highs.data(), series.lows.data(),
+               series.closes.data(), period, &begin, &size, batch.data());
+    expectMatches(plus, directionalReady, batch, begin, size);
+    TA_MINUS_DI(0, series.end(), series.highs.data(), series.lows.data(),
+                series.closes.data(), period, &begin, &size, batch.data());
+    expectMatches(minus, directionalReady, batch, begin, size);
+    TA_ADX(0, series.end(), series.highs.data(), series.lows.data(),
+           series.closes.data(), period, &begin, &size, batch.data());
+    expectMatches(adx, ready, batch, begin, size);
+  }
+}
+
+TEST(Indicators, PeekLeavesStateUntouched) {
+  const Series series(50);
+  Macd macd(6, 13, 4);
+  for (const double close : series.closes) {
+    macd.add(close);
+  }
+  const double before = macd.macd();
+  const Macd forming = peek(macd, series.closes.back() + 10);
+  EXPECT_GT(forming.macd(), before);
+  EXPECT_EQ(macd.macd(), before);
+
+  Macd completed = macd;
+  completed.add(series.closes.back() + 10);
+  EXPECT_EQ(completed.macd(), forming.macd());
+  EXPECT_EQ(completed.histogram(), forming.histogram());
+}
+
+TEST(Indicators, History) {
+  History history(3);
+  EXPECT_EQ(history.size(), 0);
+  for (int i = 1; i <= 5; i++) {
+    history.push(i);
+  }
+  EXPECT_TRUE(history.full());
+  EXPECT_EQ(history.size(), 3);
+  EXPECT_EQ(history.back(), 5);
+  EXPECT_EQ(history.back(2), 3);
+}
+
+TEST(Pipeline, MatchesStreamingIndicators) {
+  const Series series(300);
+  std::vector<double> volumes(series.closes.size());
+  for (std::size_t i = 0; i < volumes.size(); i++) {
+    volumes[i] = 10 + i % 13;
+  }
+  namespace fused = midas::trader::pipeline;
+  using Indicators =
+      fused::Pipeline<fused::Ema<5>, fused::Sma<15, fused::Field::Volume>,
+                      fused::Macd<13, 6, 4>, fused::Rsi<6>, fused::Atr<21>,
+                      fused::BollingerBands<20, 2.0, 1.5>>;
+  static_assert(Indicators::lookBack == 21);
+
+  Ema ema(5);
+  Sma volumeAverage(15);
+  Macd macd(13, 6, 4);
+  Rsi rsi(6);
+  Atr atr(21);
+  BollingerBands bands(20, 2.0, 1.5);
+  Indicators indicators;
+  std::size_t firstReady = 0;
+  const fused::Columns columns{.highs = series.highs,
+                               .lows = series.lows,
+                               .closes = series.closes,
+                               .volumes = volumes};
+  indicators.run(columns, [&](std::size_t i, const Indicators &fused) {
+    ema.add(series.closes[i]);
+    volumeAverage.add(volumes[i]);
+    macd.add(series.closes[i]);
+    rsi.add(series.closes[i]);
+    atr.add(series.highs[i], series.lows[i], series.closes[i]);
+    bands.add(series.closes[i]);
+    // the same operations in the same order, values are identical
+    ASSERT_EQ(fused.get<0>().ready(), ema.ready());
+    EXPECT_EQ(fused.get<0>().value(), ema.value());
+    ASSERT_EQ(fused.get<1>().ready(), volumeAverage.ready());
+    EXPECT_EQ(fused.get<1>().value(), volumeAverage.value());
+    ASSERT_EQ(fused.get<2>().ready(), macd.ready());
+    EXPECT_EQ(fused.get<2>().macd(), macd.macd());
+    EXPECT_EQ(fused.get<2>().histogram(), macd.histogram());
+    ASSERT_EQ(fused.get<3>().ready(), rsi.ready());
+    EXPECT_EQ(fused.get<3>().value(), rsi.value());
+    ASSERT_EQ(fused.get<4>().ready(), atr.ready());
+    EXPECT_EQ(fused.get<4>().value(), atr.value());
+    ASSERT_EQ(fused.get<5>().ready(), bands.ready());
+    EXPECT_EQ(fused.get<5>().upper(), bands.upper());
+    EXPECT_EQ(fused.get<5>().lower(), bands.lower());
+    if (!fused.ready()) {
+      firstReady = i + 1;
+    }
+  });
+  EXPECT_EQ(firstReady, Indicators::lookBack);
+}
@@ -0,0 +1,273 @@
+#include "broker-interface/instruments.hpp"
+#include "broker-interface/order.hpp"
+#include "data/bar.hpp"
+#include "data/data_stream.hpp"
+#include "exceptions/script_error.hpp"
+#include "logging/logging.hpp"
+#include "trader/batch_indicators.hpp"
+#include "trader/pine_script.hpp"
+#include "trader/pine_script_trader.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas;
+using namespace midas::trader;
+
+namespace {
+struct Candles {
+  std::vector<double> opens, highs, lows, closes, volumes;
+  explicit Candles(std::size_t size) {
+    std::mt19937 generator(11);
+    std::normal_distribution<double> move(0, 2);
+    std::uniform_real_distribution<double> wick(0, 2);
+    double close = 18000;
+    for (std::size_t i = 0; i < size; i++) {
+      const double open = close;
+      close += move(generator);
+      opens.push_back(open);
+      closes.push_back(close);
+      highs.push_back(std::max(open, close) + wick(generator));
+      lows.push_back(std::min(open, close) - wick(generator));
+      volumes.push_back(50 + static_cast<double>(i % 17));
+    }
+  }
+  pine::Series series() const { return {opens, highs, lows, closes, volumes}; }
+};
+
+std::shared_ptr<const pine::Program> sample(const std::string &name) {
+  return pine::compileFile(std::string(PINE_SCRIPT_SAMPLES) + "/" + name);
+}
+
+/**
+ * Line of the ScriptError compiling source throws
+ */
+std::size_t errorLine(const std::string &source) {
+  try {
+    pine::compile(source);
+  } catch (const ScriptError &error) {
+    return error.line;
+  }
+  return 0;
+}
+} // namespace
+
+TEST(PineScript, CompilesTheSamples) {
+  for (const std::string name :
+       {"2_min_momentum.pinescript", "2min_momentum_limits.pinescript"}) {
+    const auto program = sample(name);
+    EXPECT_EQ(program->title, "ActiveBoi");
+    ASSERT_EQ(program->entries.size(), 1) << name;
+    const pine::Entry &entry = program->entries.front();
+    EXPECT_EQ(entry.id, "long");
+    EXPECT_EQ(entry.direction, OrderDirection::BUY);
+    EXPECT_TRUE(entry.quantity);
+    EXPECT_TRUE(entry.exit.stop);
+    // the slowest indicator is the ema of 100 candles
+    EXPECT_EQ(program->warmUp, 99);
+  }
+  const pine::Exit trailing = sample("2_min_momentum.pinescript")
+                                  ->entries.front()
+                                  .exit;
+  EXPECT_TRUE(trailing.trailPrice && trailing.trailOffset);
+  EXPECT_FALSE(trailing.limit);
+  EXPECT_TRUE(sample("2min_momentum_limits.pinescript")
+                  ->entries.front()
+                  .exit.limit);
+}
+
+TEST(PineScript, EvaluatesTheSampleColumnWise) {
+  const Candles candles(600);
+  const auto program = sample("2min_momentum_limits.pinescript");
+  pine::Machine machine(program);
+  machine.run(candles.series(), {.positionSize = 0, .minTick = 0.25});
+  ASSERT_EQ(machine.size(), 600);
+  const auto column = [&](const std::string &name) {
+    return machine.values(program->variables.at(name));
+  };
+
+  std::vector<double> expected(600);
+  batch::ema(candles.closes, 9, expected);
+  const auto fast = column("fast_ma");
+  for (std::size_t i = 8; i < expected.size(); i++) {
+    EXPECT_DOUBLE_EQ(fast[i], expected[i]) << i;
+  }
+  // macd is the difference of the averages, the signal averages it
+  std::vector<double> fastMacd(600), slowMacd(600);
+  batch::ema(candles.closes, 6, fastMacd);
+  batch::ema(candles.closes, 13, slowMacd);
+  const auto macd = column("macdLine"), signal = column("macdSignal"),
+             histogram = column("macdHistogram");
+  for (std::size_t i = 12; i < macd.size(); i++) {
+    EXPECT_NEAR(macd[i], fastMacd[i] - slowMacd[i], 1e-9) << i;
+  }
+  EXPECT_TRUE(std::isnan(signal[15]));
+  EXPECT_FALSE(std::isnan(signal[16]));
+  EXPECT_DOUBLE_EQ(histogram[100], macd[100] - signal[100]);
+
+  const auto slow = column("slow_ma"), rsi = column("rsi"),
+             averageVolume = column("avg_volume"), plus = column("diplus"),
+             minus = column("dineg"), adx = column("adx");
+  const Candles &c = candles;
+  std::size_t entries = 0;
+  for (std::size_t i = 0; i < machine.size(); i++) {
+    const auto risingFor = [&](const std::vector<double> &values, bool up) {
+      if (i < 3) {
+        return false;
+      }
+      for (std::size_t back = 1; back <= 3; back++) {
+        if (up ? !(values[i] > values[i - back])
+               : !(values[i] < values[i - back])) {
+          return false;
+        }
+      }
+      return true;
+    };
+    const bool bullishDmi =
+        ((plus[i] > minus[i]) ||
+         (risingFor(plus, true) && risingFor(minus, false))) &&
+        adx[i] > 20;
+    const bool holds = fast[i] > slow[i] && macd[i] > signal[i] &&
+                       rsi[i] < 70 && rsi[i] > 45 && bullishDmi &&
+                       c.volumes[i] > averageVolume[i];
+    const pine::Register when = program->entries.front().when;
+    EXPECT_EQ(machine.holds(when, machine.size() - 1 - i), holds) << i;
+    entries += holds;
+  }
+  EXPECT_GT(entries, 0);
+
+  machine.run(candles.series(), {.positionSize = 2, .minTick = 0.25});
+  for (std::size_t offset = 0; offset < machine.size(); offset++) {
+    EXPECT_FALSE(machine.holds(program->entries.front().when, offset));
+  }
+}
+
+TEST(PineScript, DirectionalMovementOfASteadyRise) {
+  const auto program = pine::compile(R"(
+strategy("dmi")
+[plus, minus, adx] = ta.dmi(14, 14)
+)");
+  EXPECT_EQ(program->warmUp, 27);
+  std::vector<double> opens, highs, lows, closes, volumes;
+  for (int i = 0; i < 60; i++) {
+    opens.push_back(100 + i);
+    closes.push_back(101 + i);
+    highs.push_back(101.5 + i);
+    lows.push_back(99.5 + i);
+    volumes.push_back(10);
+  }
+  pine::Machine machine(program);
+  machine.run({opens, highs, lows, closes, volumes}, {});
+  const auto adx = machine.values(program->variables.at("adx"));
+  EXPECT_TRUE(std::isnan(adx[26]));
+  EXPECT_DOUBLE_EQ(adx[27], 100);
+  // true ranges of 2, rises of 1
+  EXPECT_DOUBLE_EQ(machine.value(program->variables.at("plus")), 50);
+  EXPECT_DOUBLE_EQ(machine.value(program->variables.at("minus")), 0);
+}
+
+TEST(PineScript, EvaluatesOperators) {
+  const auto program = pine::compile(R"(
+strategy("operators")
+float factor = 2 * 3 - 1 // folded
+doubled = close * factor / 5
+previous = close[2]
+change = ta.change(close)
+bigger = close > 3 ? close : -close
+rising = ta.rising(close, 2)
+flat = not (close != close[1]) or close % 4 == 0
+)");
+  std::vector<double> closes{1, 2, 4, 3, 5, 6, 6};
+  const std::vector<double> none(closes.size(), 0);
+  pine::Machine machine(program);
+  machine.run({closes, closes, closes, closes, none}, {});
+  const auto values = [&](const std::string &name) {
+    return machine.values(program->variables.at(name));
+  };
+  EXPECT_TRUE(program->variables.at("factor").scalar);
+  EXPECT_EQ(values("doubled"), closes);
+  const auto previous = values("previous");
+  EXPECT_TRUE(std::isnan(previous[1]));
+  EXPECT_EQ(previous[2], 1);
+  EXPECT_EQ(previous[6], 5);
+  EXPECT_EQ(values("change")[3], -1);
+  EXPECT_EQ(values("bigger"),
+            (std::vector<double>{-1, -2, 4, -3, 5, 6, 6}));
+  const auto rising = values("rising");
+  EXPECT_TRUE(std::isnan(rising[1]));
+  EXPECT_EQ(std::vector(rising.begin() + 2, rising.end()),
+            (std::vector<double>{1, 0, 1, 1, 0}));
+  EXPECT_EQ(values("flat"), (std::vector<double>{1, 0, 1, 0, 0, 0, 1}));
+}
+
+TEST(PineScript, RejectsUnsupportedScripts) {
+  EXPECT_EQ(errorLine("a = close\nb = ta.vwma(close, 3)"), 2);
+  EXPECT_EQ(errorLine("a = close\n\na := 3"), 3);
+  EXPECT_EQ(errorLine("a = close\na = open"), 2);
+  EXPECT_EQ(errorLine("length = close\na = ta.ema(close, length)"), 2);
+  EXPECT_EQ(errorLine("if close > open\n    a = 1"), 2);
+  EXPECT_EQ(errorLine("a = (close\n + 1"), 2);
+  // entries need a bracket
+  EXPECT_EQ(errorLine("strategy(\"s\")\n"
+                      "if close > open\n"
+                      "    strategy.entry(\"long\", strategy.long)\n"
+                      "    strategy.exit(\"x\", \"long\", stop = low)"),
+            3);
+  EXPECT_THROW(pine::compileFile("missing.pinescript"), std::runtime_error);
+}
+
+namespace {
+struct RecordingOrderManager : public OrderManager {
+  std::vector<std::shared_ptr<BracketedOrder>> brackets;
+  RecordingOrderManager(std::shared_ptr<logging::thread_safe_logger_t> &logger)
+      : OrderManager(logger) {}
+  void transmit(std::shared_ptr<Order> order) override {
+    brackets.push_back(std::dynamic_pointer_cast<BracketedOrder>(order));
+    order->setTransmitted();
+  }
+  bool hasActiveOrders() override { return !brackets.empty(); }
+  std::list<Order *> getFilledOrders() override { return {}; }
+};
+} // namespace
+
+TEST(PineScript, TradesAsATrader) {
+  auto logger = std::make_shared<logging::thread_safe_logger_t>(
+      logging::create_channel_logger("Pine Script Test Logger"));
+  const auto orderManager = std::make_shared<RecordingOrderManager>(logger);
+  auto stream = std::make_shared<DataStream>(5);
+  std::vector<Bar> bars;
+  Timestamp time = midas::fromUnixSeconds(1'699'999'980);
+  for (int i = 0; i < 24; i++) {
+    bars.emplace_back(5, 10, 101 + i, 100 + i, 100 + i, 101 + i, 101 + i, 10,
+                      time);
+    time += midas::fromUnixSeconds(5);
+  }
+  stream->addBars(bars.begin(), bars.end());
+  stream->waitForData(0ms);
+
+  const auto program = pine::compile(R"(
+strategy("up")
+if close > open and strategy.position_size == 0
+    strategy.entry("long", strategy.long, qty = 2)
+    strategy.exit("exit", "long", stop = close - 2, limit = close + 3)
+)");
+  PineScriptTrader trader(program, 60, stream, orderManager,
+                          InstrumentEnum::MicroNasdaqFutures, 1, logger);
+  trader.decide();
+  ASSERT_EQ(orderManager->brackets.size(), 1);
+  BracketedOrder &bracket = *orderManager->brackets.front();
+  EXPECT_EQ(bracket.requestedQuantity, 2);
+  EXPECT_EQ(bracket.direction, OrderDirection::BUY);
+  // at the close of the second minute
+  EXPECT_EQ(bracket.getEntryOrder().targetPrice, 124);
+  EXPECT_EQ(bracket.getStopOrder().targetPrice, 122);
+  EXPECT_EQ(bracket.getProfitTakerOrder().targetPrice, 127);
+  trader.decide();
+  EXPECT_EQ(orderManager->brackets.size(), 1);
+}
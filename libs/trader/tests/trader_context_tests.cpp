@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "broker-interface/broker.hpp"
+#include "broker-interface/instruments.hpp"
+#include "broker-interface/order.hpp"
+#include "broker-interface/subscription.hpp"
+#include "data/bar.hpp"
+#include "logging/logging.hpp"
+#include "trader/trader_context.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas;
+
+namespace {
+std::shared_ptr<logging::thread_safe_logger_t> testLogger =
+    std::make_shared<logging::thread_safe_logger_t>(
+        logging::create_channel_logger("trader context tests"));
+
+struct NoOrderManager : public OrderManager {
+  NoOrderManager() : OrderManager(testLogger) {}
+  void transmit(std::shared_ptr<Order> order) override {
+    order->setTransmitted();
+  }
+  bool hasActiveOrders() override { return false; }
+  std::list<Order *> getFilledOrders() override { return {}; }
+};
+
+/**
+ * Keeps the subscriptions, the test plays the bars
+ */
+struct RecordingBroker : public Broker {
+  std::mutex mutex;
+  std::vector<std::weak_ptr<Subscription>> subscriptions;
+  std::shared_ptr<OrderManager> orderManager =
+      std::make_shared<NoOrderManager>();
+
+  void connect() override {}
+  void disconnect() override {}
+  bool isConnected() const override { return true; }
+  void addSubscription(std::weak_ptr<Subscription> subscription) override {
+    std::scoped_lock lock(mutex);
+    subscriptions.push_back(subscription);
+  }
+  bool processCycle() override {
+    std::this_thread::sleep_for(1ms);
+    return false;
+  }
+  unsigned int estimateHistoricalBarSizeSeconds(
+      const HistorySubscriptionStartPoint &) const override {
+    return 5;
+  }
+  std::shared_ptr<OrderManager> getOrderManager() override {
+    return orderManager;
+  }
+  std::size_t size() {
+    std::scoped_lock lock(mutex);
+    return subscriptions.size();
+  }
+};
+
+struct StopProcessing {
+  std::atomic<bool> &stop;
+  ~StopProcessing() { stop = true; }
+};
+} // namespace
+
+TEST(TraderContext, TradersOfAnInstrumentShareThePyramid) {
+  std::atomic<bool> stop{false};
+  const auto broker = std::make_shared<RecordingBroker>();
+  TradingContext context(broker, &stop);
+  StopProcessing stopProcessing{stop};
+
+  TraderContext first(100 * 120, &context, InstrumentEnum::MicroNasdaqFutures,
+                      1, trader::TraderType::MomentumTrader);
+  const auto pyramid = first.feed->pyramid;
+  const std::size_t indicators = pyramid->indicators(5)->size();
+  ASSERT_GT(indicators, 0);
+  TraderContext second(100 * 120, &context,
+                       InstrumentEnum::MicroNasdaqFutures, 1,
+                       trader::TraderType::MomentumTrader);
+  EXPECT_EQ(second.feed, first.feed);
+  // the same indicators of the same candles are registered once
+  EXPECT_EQ(pyramid->indicators(5)->size(), indicators);
+  TraderContext other(100 * 120, &context, InstrumentEnum::MicroSPXFutures, 1,
+                      trader::TraderType::MomentumTrader);
+  EXPECT_NE(other.feed, first.feed);
+  // one history subscription per instrument
+  ASSERT_EQ(broker->size(), 2);
+
+  const auto history = broker->subscriptions.front().lock();
+  ASSERT_TRUE(history);
+  for (int i = 0; i < 200; i++) {
+    history->barSignal(*history,
+                       Bar(5, 1, 101 + i, 99 + i, 100 + i, 100 + i, 100 + i,
+                           10, midas::fromUnixSeconds(1'700'000'000 + 5 * i)));
+  }
+  EXPECT_FALSE(first.registration);
+  history->endSignal(*history);
+  ASSERT_TRUE(first.registration);
+  ASSERT_TRUE(second.registration);
+  EXPECT_FALSE(other.registration);
+  // the history is processed once, for both traders
+  context.scheduler->wait();
+  EXPECT_EQ(first.trader->closedCandles().second, 200);
+  EXPECT_EQ(second.trader->closedCandles().second, 200);
+  EXPECT_EQ(broker->size(), 3);
+
+  // traders joining later start from the loaded history
+  TraderContext late(100 * 120, &context, InstrumentEnum::MicroNasdaqFutures, 1,
+                     trader::TraderType::MomentumTrader);
+  EXPECT_TRUE(late.registration);
+  context.scheduler->wait();
+  EXPECT_EQ(late.trader->closedCandles().second, 200);
+  EXPECT_EQ(pyramid->indicators(5)->size(), indicators);
+}
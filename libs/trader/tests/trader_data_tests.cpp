@@ -1,12 +1,31 @@
 #include "data/data_stream.hpp"
 #include "exceptions/sampling_error.hpp"
 #include "trader/trader.hpp"
+#include <boost/date_time/posix_time/time_parsers.hpp>
+#include <algorithm>
 #include <gtest/gtest.h>
 #include <memory>
+#include <vector>
 using namespace std::chrono_literals;
 
 using namespace midas;
 
+namespace {
+/**
+ * Consecutive bar timestamps starting on a minute boundary
+ */
+struct BarClock {
+  const Timestamp barSize;
+  Timestamp next = midas::fromPtime(
+      boost::posix_time::time_from_string("2025-01-06 14:30:00.000"));
+  Timestamp operator()() {
+    const Timestamp time = next;
+    next += barSize;
+    return time;
+  }
+};
+} // namespace
+
 TEST(TraderData, TraderDataSampling) {
   const int streamBarSeconds = 5;
   const auto streamPtr = std::make_shared<DataStream>(streamBarSeconds);
@@ -16,10 +35,10 @@ TEST(TraderData, TraderDataSampling) {
   const int traderToStreamBarRatio = traderCandleSeconds / streamBarSeconds;
   //  Enough for down sampling
   const int barsPerLookBack = lookBack * traderCandleSeconds;
+  BarClock clock{midas::fromUnixSeconds(streamBarSeconds)};
 
   for (; streamBarsAdded < 13; streamBarsAdded++) {
-    Bar bar(5, 10, 300, 100, 150, 250, 400, 1000,
-            boost::posix_time::second_clock::universal_time());
+    Bar bar(5, 10, 300, 100, 150, 250, 400, 1000, clock());
     streamPtr->addBars(bar);
   }
   streamPtr->waitForData(200ms);
@@ -28,20 +47,20 @@ TEST(TraderData, TraderDataSampling) {
   EXPECT_FALSE(trader.ok());
   EXPECT_EQ(trader.size(), 0);
   for (; streamBarsAdded < traderToStreamBarRatio; streamBarsAdded++) {
-    Bar bar(5, 10, 300, 100, 150, 250, 400, 1000,
-            boost::posix_time::second_clock::universal_time());
+    Bar bar(5, 10, 300, 100, 150, 250, 400, 1000, clock());
     streamPtr->addBars(bar);
   }
   streamPtr->waitForData(200ms);
   EXPECT_FALSE(trader.ok());
   EXPECT_EQ(trader.size(), 1);
+  EXPECT_FALSE(trader.snapshot()->forming);
 
   for (; streamBarsAdded < barsPerLookBack;
        streamBarsAdded += traderToStreamBarRatio) {
-    std::vector<Bar> bars(
-        traderToStreamBarRatio,
-        Bar(5, 10, 300, 100, 150, 250, 400, 1000,
-            boost::posix_time::second_clock::universal_time()));
+    std::vector<Bar> bars;
+    for (int i = 0; i < traderToStreamBarRatio; i++) {
+      bars.emplace_back(5, 10, 300, 100, 150, 250, 400, 1000, clock());
+    }
     streamPtr->addBars(bars.begin(), bars.end());
   }
   streamPtr->waitForData(200ms);
@@ -59,11 +78,12 @@ TEST(TraderData, ContinuousDataFeed) {
   const int streamBarSeconds = 5;
   const auto streamPtr = std::make_shared<DataStream>(streamBarSeconds);
   trader::TraderData trader(10, 60, streamPtr);
+  BarClock clock{midas::fromUnixSeconds(streamBarSeconds)};
 
   // Feed 20 bars in two batches, enough for 2 full downsampled candles
   for (int i = 0; i < 24; ++i) {
       streamPtr->addBars(Bar(5, 10 + i, 8 + i, 9 + i, 10 + i, 11 + i, 50 + i, 100 + i,
-            boost::posix_time::second_clock::universal_time()));
+            clock()));
   }
   streamPtr->waitForData(0ms);
   trader.processSource();
@@ -74,11 +94,255 @@ TEST(TraderData, ContinuousDataFeed) {
   // Now add more bars and validate size increments as expected
   for (int i = 0; i < 240; ++i) {
       streamPtr->addBars(Bar(5, 12 + i, 7 + i, 8 + i, 9 + i, 10 + i, 40 + i, 90 + i,
-            boost::posix_time::second_clock::universal_time()));
+            clock()));
   }
   streamPtr->waitForData(0ms);
   trader.processSource();
 
   EXPECT_EQ(trader.size(), 10);  // Should fill up to the lookBack limit
   EXPECT_TRUE(trader.ok());      // Check that the lookback capacity is met
-}
\ No newline at end of file
+}
+TEST(TraderData, SamplingContinuesAcrossEviction) {
+  const auto streamPtr = std::make_shared<DataStream>(5);
+  streamPtr->setRetentionPolicy({.retainedBars = 4, .blockSize = 8});
+  trader::TraderData data(3, 10, streamPtr);
+  EXPECT_EQ(data.requiredSourceBars(), 6);
+  const auto start = midas::fromPtime(
+      boost::posix_time::time_from_string("2025-01-06 14:30:00.000"));
+  for (int i = 0; i < 40; i++) {
+    streamPtr->addBars(Bar(5, 1, i, i, i, i, i, 1,
+                           start + midas::fromUnixSeconds(5 * i)));
+    streamPtr->waitForData(0ms);
+  }
+  EXPECT_GT(streamPtr->baseIndex(), 0);
+  ASSERT_TRUE(data.ok());
+  const auto candles = data.snapshot();
+  EXPECT_TRUE(std::ranges::equal(candles->opens(),
+                                 std::vector<double>({34, 36, 38})));
+  EXPECT_TRUE(std::ranges::equal(candles->closes(),
+                                 std::vector<double>({35, 37, 39})));
+}
+
+TEST(TraderData, SnapshotIsStable) {
+  const auto streamPtr = std::make_shared<DataStream>(5);
+  trader::TraderData data(3, 10, streamPtr);
+  const auto start = midas::fromPtime(
+      boost::posix_time::time_from_string("2025-01-06 14:30:00.000"));
+  const auto addCandle = [&](int i) {
+    streamPtr->addBars(Bar(5, 1, i, i, i, i, i, 1,
+                           start + midas::fromUnixSeconds(10 * i)));
+    streamPtr->addBars(Bar(5, 1, i, i, i, i + 0.5, i, 1,
+                           start + midas::fromUnixSeconds(10 * i + 5)));
+    streamPtr->waitForData(0ms);
+  };
+  for (int i = 0; i < 3; i++) {
+    addCandle(i);
+  }
+  const auto held = data.snapshot();
+  ASSERT_EQ(held->size(), 3);
+  const double *heldCloses = held->closes().data();
+
+  // enough candles to replace the storage several times over
+  for (int i = 3; i < 50; i++) {
+    addCandle(i);
+  }
+  const auto latest = data.snapshot();
+  EXPECT_GT(latest->sequence, held->sequence);
+  EXPECT_EQ(held->closes().data(), heldCloses);
+  EXPECT_TRUE(std::ranges::equal(held->closes(),
+                                 std::vector<double>({0.5, 1.5, 2.5})));
+  EXPECT_TRUE(std::ranges::equal(latest->closes(),
+                                 std::vector<double>({47.5, 48.5, 49.5})));
+  EXPECT_TRUE(std::ranges::equal(
+      latest->timestamps(),
+      std::vector<midas::Timestamp>({start + midas::fromUnixSeconds(475),
+                                     start + midas::fromUnixSeconds(485),
+                                     start + midas::fromUnixSeconds(495)})));
+
+  const auto beforeClear = latest->sequence;
+  data.clear();
+  EXPECT_TRUE(data.snapshot()->empty());
+  EXPECT_GT(data.snapshot()->sequence, beforeClear);
+  EXPECT_EQ(latest->size(), 3);
+}
+
+TEST(CandlePyramid, LevelsBuildOnEachOther) {
+  const auto streamPtr = std::make_shared<DataStream>(5);
+  const auto pyramid = std::make_shared<trader::CandlePyramid>(
+      streamPtr, std::vector<std::size_t>{60, 120, 3600});
+  const auto minutes = pyramid->subscribe(60, 200);
+  const auto twoMinutes = pyramid->subscribe(120, 100);
+  const auto hours = pyramid->subscribe(3600, 2);
+  BarClock clock{midas::fromUnixSeconds(5)};
+  // an hour and a half of 5 second bars
+  for (int i = 0; i < 1080; i++) {
+    streamPtr->addBars(Bar(5, 1, i + 1, i - 1, i, i, i, 1, clock()));
+  }
+  streamPtr->waitForData(0ms);
+
+  const auto minuteCandles = minutes->snapshot();
+  const auto twoMinuteCandles = twoMinutes->snapshot();
+  ASSERT_EQ(minuteCandles->size(), 90);
+  ASSERT_EQ(twoMinuteCandles->size(), 45);
+  for (std::size_t i = 0; i < twoMinuteCandles->size(); i++) {
+    EXPECT_EQ(twoMinuteCandles->opens()[i], minuteCandles->opens()[2 * i]);
+    EXPECT_EQ(twoMinuteCandles->closes()[i],
+              minuteCandles->closes()[2 * i + 1]);
+    EXPECT_EQ(twoMinuteCandles->highs()[i],
+              minuteCandles->highs()[2 * i + 1]);
+    EXPECT_EQ(twoMinuteCandles->tradeCounts()[i], 24);
+  }
+  EXPECT_FALSE(twoMinuteCandles->forming);
+
+  // hours are aligned to UTC, the first one only had half an hour of bars
+  const auto hourCandles = hours->snapshot();
+  ASSERT_EQ(hourCandles->size(), 2);
+  EXPECT_EQ(hourCandles->tradeCounts()[0], 360);
+  EXPECT_EQ(hourCandles->tradeCounts()[1], 720);
+  EXPECT_FALSE(hourCandles->forming);
+
+  // both a completed and a forming minute are part of the forming hour
+  for (int i = 1080; i < 1080 + 18; i++) {
+    streamPtr->addBars(Bar(5, 1, i + 1, i - 1, i, i, i, 1, clock()));
+  }
+  streamPtr->waitForData(0ms);
+  const auto forming = hours->snapshot()->forming;
+  ASSERT_TRUE(forming);
+  EXPECT_EQ(forming->open, 1080);
+  EXPECT_EQ(forming->close, 1097);
+  EXPECT_EQ(forming->high, 1098);
+  EXPECT_EQ(forming->low, 1079);
+  EXPECT_EQ(forming->tradeCount, 18);
+  EXPECT_EQ(forming->barSizeSeconds, 3600);
+  EXPECT_EQ(minutes->snapshot()->forming->tradeCount, 6);
+}
+
+TEST(CandlePyramid, TradersShareLevels) {
+  const auto streamPtr = std::make_shared<DataStream>(5);
+  const auto pyramid = std::make_shared<trader::CandlePyramid>(streamPtr);
+  trader::TraderData shortLookBack(3, 120, pyramid);
+  trader::TraderData longLookBack(10, 120, pyramid);
+  // the bars themselves are a level too
+  trader::TraderData bars(3, 5, pyramid);
+  EXPECT_EQ(shortLookBack.requiredSourceBars(), 72);
+  BarClock clock{midas::fromUnixSeconds(5)};
+  // 16 minutes, eight two minute candles
+  for (int i = 0; i < 16 * 12; i++) {
+    streamPtr->addBars(Bar(5, 1, i, i, i, i, i, 1, clock()));
+  }
+  streamPtr->waitForData(0ms);
+  ASSERT_TRUE(shortLookBack.ok());
+  EXPECT_FALSE(longLookBack.ok());
+  EXPECT_EQ(shortLookBack.size(), 3);
+  EXPECT_EQ(longLookBack.size(), 8);
+  // same storage, the short look back sees the tail of the long one
+  EXPECT_EQ(shortLookBack.snapshot()->closes().data(),
+            longLookBack.snapshot()->closes().data() + 5);
+
+  ASSERT_TRUE(bars.ok());
+  EXPECT_EQ(bars.snapshot()->closes().back(), 16 * 12 - 1);
+
+  EXPECT_THROW(trader::TraderData(3, 180, pyramid), SamplingError);
+  EXPECT_THROW(trader::CandlePyramid(streamPtr, {60, 92}), SamplingError);
+}
+
+TEST(CandlePyramid, ReordersRepairFromACheckpoint) {
+  // the live stream only retains the most recent bars, rebuilding from them
+  // would lose older candles
+  const auto live = std::make_shared<DataStream>(5);
+  live->setRetentionPolicy({.retainedBars = 300, .blockSize = 64});
+  const auto reference = std::make_shared<DataStream>(5);
+  trader::CandlePyramid livePyramid(live, {60});
+  trader::CandlePyramid referencePyramid(reference, {60});
+  const auto liveMinutes = livePyramid.subscribe(60, 1000);
+  const auto referenceMinutes = referencePyramid.subscribe(60, 1000);
+  const auto liveEma =
+      livePyramid.indicators(60)->ema(livePyramid.indicators(60)->close(), 10);
+  const auto referenceEma = referencePyramid.indicators(60)->ema(
+      referencePyramid.indicators(60)->close(), 10);
+  livePyramid.indicators(60)->subscribe(liveEma, 1000);
+  referencePyramid.indicators(60)->subscribe(referenceEma, 1000);
+
+  BarClock clock{midas::fromUnixSeconds(5)};
+  std::vector<Bar> bars;
+  for (int i = 0; i < 2000; i++) {
+    const double close = i % 7 + i * 0.1;
+    bars.emplace_back(5, 1, close + 1, close - 1, close, close, close, 1,
+                      clock());
+  }
+  reference->addBars(bars.begin(), bars.end());
+  reference->waitForData(0ms);
+  constexpr int late = 1900;
+  for (int i = 0; i < 2000; i += 100) {
+    for (int bar = i; bar < i + 100; bar++) {
+      if (bar != late) {
+        live->addBars(bars[bar]);
+      }
+    }
+    live->waitForData(0ms);
+  }
+  const auto beforeRepair = liveMinutes->snapshot();
+  const std::vector<double> heldCloses(beforeRepair->closes().begin(),
+                                       beforeRepair->closes().end());
+  live->addBars(bars[late]);
+  live->waitForData(0ms);
+  ASSERT_GT(live->baseIndex(), 0);
+
+  const auto repaired = liveMinutes->snapshot();
+  const auto expected = referenceMinutes->snapshot();
+  EXPECT_GT(repaired->generation, beforeRepair->generation);
+  ASSERT_EQ(repaired->size(), expected->size());
+  EXPECT_TRUE(std::ranges::equal(repaired->closes(), expected->closes()));
+  EXPECT_TRUE(std::ranges::equal(repaired->tradeCounts(),
+                                 expected->tradeCounts()));
+  EXPECT_TRUE(std::ranges::equal(repaired->timestamps(),
+                                 expected->timestamps()));
+  const auto repairedValues = livePyramid.indicators(60)->snapshot();
+  const auto expectedValues = referencePyramid.indicators(60)->snapshot();
+  ASSERT_EQ(repairedValues->size(liveEma), expectedValues->size(referenceEma));
+  for (std::size_t offset = 0; offset < expectedValues->size(referenceEma);
+       offset++) {
+    EXPECT_DOUBLE_EQ(repairedValues->value(liveEma, offset),
+                     expectedValues->value(referenceEma, offset))
+        << offset;
+  }
+  // readers holding the snapshot from before never see the repair
+  EXPECT_TRUE(std::ranges::equal(beforeRepair->closes(), heldCloses));
+}
+
+TEST(CandleCursor, VisitsEachCandleOnce) {
+  BarClock clock{midas::fromUnixSeconds(60)};
+  trader::CandleSeries series(60, 3);
+  trader::CandleCursor cursor;
+  std::vector<double> visited;
+  int resets = 0;
+  const auto advance = [&] {
+    const auto candles = series.snapshot();
+    cursor.advance(
+        *candles, [&] { resets++; },
+        [&](std::size_t index) { visited.push_back(candles->closes()[index]); });
+  };
+  for (int close = 1; close <= 2; close++) {
+    series.append(Bar(60, 1, close, close, close, close, close, 1, clock()));
+  }
+  series.publish(std::nullopt);
+  advance();
+  advance();
+  EXPECT_EQ(visited, (std::vector<double>{1, 2}));
+
+  // candles that were evicted before they were read are skipped
+  for (int close = 3; close <= 7; close++) {
+    series.append(Bar(60, 1, close, close, close, close, close, 1, clock()));
+  }
+  series.publish(std::nullopt);
+  advance();
+  EXPECT_EQ(visited, (std::vector<double>{1, 2, 5, 6, 7}));
+  EXPECT_EQ(resets, 0);
+
+  series.clear();
+  series.append(Bar(60, 1, 8, 8, 8, 8, 8, 1, clock()));
+  series.publish(std::nullopt);
+  advance();
+  EXPECT_EQ(resets, 1);
+  EXPECT_EQ(visited.back(), 8);
+}
@@ -2,12 +2,16 @@
 #include "data/data_stream.hpp"
 #include "trader/trader.hpp"
 #include "gtest/gtest.h"
+#include <boost/date_time/posix_time/time_parsers.hpp>
 using midas::Bar;
 using namespace std::chrono_literals;
 // Set up mock data source
 class MockDataStream : public midas::DataStream {
 public:
-  MockDataStream(std::size_t barSize) : midas::DataStream(barSize) {}
+  MockDataStream(std::size_t barSize)
+      : midas::DataStream(barSize), nextTimestamp(midas::fromPtime(
+                                        boost::posix_time::time_from_string(
+                                            "2025-01-06 14:30:00.000"))) {}
 
   void addBar(double open, double high, double low, double close,
               double volume) {
@@ -19,8 +23,12 @@ public:
     tradeCounts.push_back(1); // Adding a trade count for simplicity
     double wap = (high + low + close) / 3.0;
     waps.push_back(wap);
-    timestamps.push_back(boost::posix_time::second_clock::universal_time());
+    timestamps.push_back(nextTimestamp);
+    nextTimestamp += midas::fromUnixSeconds(barSizeSeconds);
   }
+
+private:
+  midas::Timestamp nextTimestamp;
 };
 
 class TraderDataTest : public ::testing::Test {
@@ -48,7 +56,7 @@ TEST_F(TraderDataTest, BasicDownsampling) {
   EXPECT_EQ(traderData->size(), 2);
   std::vector<unsigned int> trades;
   std::vector<double> closes, volumes, highs, lows, opens, vwaps;
-  std::vector<boost::posix_time::ptime> timestamps;
+  std::vector<midas::Timestamp> timestamps;
   traderData->copy(trades, highs, lows, opens, closes, vwaps, volumes,
                    timestamps);
   EXPECT_EQ(opens[0], 1.0);  // First open
@@ -61,44 +69,50 @@ TEST(VWAPTests, VWAPCalculation) {
   const auto streamPtr = std::make_shared<midas::DataStream>(5);
   midas::trader::TraderData trader(10, 60,
                                    streamPtr); // Downsample to 1-minute candles
+  const auto start = midas::fromPtime(
+      boost::posix_time::time_from_string("2025-01-06 14:30:00.000"));
+  int barsAdded = 0;
+  const auto nextTime = [&] {
+    return start + midas::fromUnixSeconds(streamBarSeconds * barsAdded++);
+  };
 
   // Adding 12 bars to form a full 1-minute candle (each bar is 5 seconds)
   streamPtr->addBars(
       midas::Bar(5, 10, 310, 150, 160, 290, 220, 1000,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 315, 155, 165, 295, 230, 1200,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 320, 160, 170, 300, 240, 1100,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 325, 155, 175, 305, 250, 900,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 330, 160, 180, 310, 260, 1300,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 335, 165, 185, 315, 270, 800,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 340, 170, 190, 320, 280, 1200,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 345, 175, 195, 325, 290, 1500,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 350, 180, 200, 330, 300, 1400,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 355, 185, 205, 335, 310, 1600,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 360, 190, 210, 340, 320, 1100,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
   streamPtr->addBars(
       midas::Bar(5, 10, 365, 195, 215, 345, 330, 1000,
-                 boost::posix_time::second_clock::universal_time()));
+                 nextTime()));
 
   // Wait for data to be processed and generate the downsampled 1-minute bar
   streamPtr->waitForData(0ms);
@@ -115,7 +129,7 @@ TEST(VWAPTests, VWAPCalculation) {
   EXPECT_EQ(trader.size(), 1); // We expect one downsampled bar
   std::vector<unsigned int> trades;
   std::vector<double> closes, volumes, highs, lows, opens, vwaps;
-  std::vector<boost::posix_time::ptime> timestamps;
+  std::vector<midas::Timestamp> timestamps;
   trader.copy(trades, highs, lows, opens, closes, vwaps, volumes, timestamps);
   EXPECT_NEAR(vwaps.back(), expectedVWAP, 0.01);
 }
@@ -125,14 +139,14 @@ TEST(VWAPTests, ZeroVolumeVWAP) {
   const auto streamPtr = std::make_shared<midas::DataStream>(streamBarSeconds);
   midas::trader::TraderData trader(10, 60,
                                    streamPtr); // Downsample to 1-minute candles
+  const auto start = midas::fromPtime(
+      boost::posix_time::time_from_string("2025-01-06 14:30:00.000"));
 
   // Adding 12 bars with zero volume
-  std::vector<midas::Bar> zeroVolumeBars(
-      12, midas::Bar(5, 10, 300, 100, 150, 250, 200, 0, // volume is zero
-                     boost::posix_time::second_clock::universal_time()));
-
-  for (const auto &bar : zeroVolumeBars) {
-    streamPtr->addBars(bar);
+  for (int i = 0; i < 12; i++) {
+    streamPtr->addBars(
+        midas::Bar(5, 10, 300, 100, 150, 250, 200, 0, // volume is zero
+                   start + midas::fromUnixSeconds(streamBarSeconds * i)));
   }
 
   streamPtr->waitForData(200ms);
@@ -141,7 +155,72 @@ TEST(VWAPTests, ZeroVolumeVWAP) {
   EXPECT_EQ(trader.size(), 1); // One downsampled bar expected
   std::vector<unsigned int> trades;
   std::vector<double> closes, volumes, highs, lows, opens, vwaps;
-  std::vector<boost::posix_time::ptime> timestamps;
+  std::vector<midas::Timestamp> timestamps;
   trader.copy(trades, highs, lows, opens, closes, vwaps, volumes, timestamps);
   EXPECT_EQ(vwaps.back(), 0.0); // VWAP should be zero due to zero volume
-}
\ No newline at end of file
+}
+TEST(CandleAggregator, FormingCandle) {
+  const auto start = midas::fromPtime(
+      boost::posix_time::time_from_string("2025-01-06 14:30:00.000"));
+  midas::trader::CandleAggregator aggregator(15, 5);
+  std::vector<Bar> completed;
+  const auto add = [&](int offsetSeconds, double price, double volume) {
+    aggregator.add(Bar(5, 1, price + 1, price - 1, price, price, price, volume,
+                       start + midas::fromUnixSeconds(offsetSeconds)),
+                   [&](const Bar &candle) { completed.push_back(candle); });
+  };
+  EXPECT_FALSE(aggregator.forming());
+  add(0, 10, 1);
+  add(5, 20, 3);
+  ASSERT_TRUE(aggregator.forming());
+  EXPECT_TRUE(completed.empty());
+  EXPECT_EQ(aggregator.forming()->open, 10);
+  EXPECT_EQ(aggregator.forming()->close, 20);
+  EXPECT_EQ(aggregator.forming()->high, 21);
+  EXPECT_EQ(aggregator.forming()->low, 9);
+  EXPECT_EQ(aggregator.forming()->tradeCount, 2);
+  EXPECT_DOUBLE_EQ(aggregator.forming()->wap, 17.5);
+
+  // last bar of the window completes the candle straight away
+  add(10, 30, 0);
+  ASSERT_EQ(completed.size(), 1);
+  EXPECT_FALSE(aggregator.forming());
+  EXPECT_EQ(completed[0].close, 30);
+  EXPECT_EQ(completed[0].volume, 4);
+  EXPECT_EQ(completed[0].barSizeSeconds, 15);
+
+  // a gap completes the forming candle when the next window starts
+  add(15, 40, 1);
+  add(35, 50, 1);
+  ASSERT_EQ(completed.size(), 2);
+  EXPECT_EQ(completed[1].open, 40);
+  EXPECT_EQ(completed[1].close, 40);
+  EXPECT_EQ(aggregator.forming()->open, 50);
+}
+
+TEST(CandleAggregator, SessionAlignment) {
+  // 09:30 to 16:00 New York, as UTC
+  const auto open = midas::fromPtime(
+      boost::posix_time::time_from_string("2025-01-06 14:30:00.000"));
+  const midas::trader::TradingSession session{
+      .open = open, .length = midas::fromUnixSeconds(6 * 3600 + 1800)};
+  midas::trader::CandleAggregator aggregator(3600, 5, session);
+  std::vector<Bar> completed;
+  const auto add = [&](midas::Timestamp time) {
+    aggregator.add(Bar(5, 1, 1, 1, 1, 1, 1, 1, time),
+                   [&](const Bar &candle) { completed.push_back(candle); });
+  };
+  // before the open, ignored
+  add(open - midas::fromUnixSeconds(5));
+  EXPECT_FALSE(aggregator.forming());
+  // hourly candles start on the half hour, the next day too
+  add(open + midas::fromUnixSeconds(3595));
+  ASSERT_EQ(completed.size(), 1);
+  EXPECT_EQ(completed[0].tradeCount, 1);
+  // the last candle closes with the session after half an hour
+  add(open + midas::fromUnixSeconds(6 * 3600 + 1795));
+  ASSERT_EQ(completed.size(), 2);
+  add(open + midas::nanosPerDay);
+  ASSERT_TRUE(aggregator.forming());
+  EXPECT_EQ(aggregator.forming()->utcTime, open + midas::nanosPerDay);
+}
@@ -0,0 +1,187 @@
+#include "broker-interface/instruments.hpp"
+#include "broker-interface/order.hpp"
+#include "data/bar.hpp"
+#include "data/data_stream.hpp"
+#include "logging/logging.hpp"
+#include "timer_wheel.hpp"
+#include "trader/base_trader.hpp"
+#include "trader/trader_scheduler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas;
+using namespace midas::trader;
+
+TEST(TimerWheel, ExpiresTimersOnTheirTick) {
+  TimerWheel wheel(8, 100);
+  EXPECT_TRUE(wheel.empty());
+  wheel.arm(1, 103);
+  wheel.arm(2, 101);
+  // a turn and a half away, in the same slot as the first
+  wheel.arm(3, 111);
+  // already due
+  wheel.arm(4, 90);
+  std::vector<TimerWheel::Timer> expired;
+  wheel.advance(101, expired);
+  ASSERT_EQ(expired.size(), 2);
+  EXPECT_EQ(expired[0].id, 2);
+  EXPECT_EQ(expired[1].id, 4);
+  expired.clear();
+  wheel.advance(103, expired);
+  ASSERT_EQ(expired.size(), 1);
+  EXPECT_EQ(expired[0].id, 1);
+  expired.clear();
+  wheel.advance(110, expired);
+  EXPECT_TRUE(expired.empty());
+  EXPECT_FALSE(wheel.empty());
+  // jumping past several turns visits every slot once
+  wheel.arm(5, 130);
+  wheel.advance(1000, expired);
+  ASSERT_EQ(expired.size(), 2);
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.current(), 1000);
+}
+
+TEST(TimerWheel, CancelsTimers) {
+  TimerWheel wheel(8, 100);
+  wheel.arm(1, 103);
+  wheel.arm(2, 111);
+  wheel.cancel(2);
+  // arming again replaces the timer
+  wheel.arm(1, 105);
+  wheel.cancel(3);
+  std::vector<TimerWheel::Timer> expired;
+  wheel.advance(104, expired);
+  EXPECT_TRUE(expired.empty());
+  wheel.advance(120, expired);
+  ASSERT_EQ(expired.size(), 1);
+  EXPECT_EQ(expired[0].tick, 105);
+  EXPECT_TRUE(wheel.empty());
+  wheel.arm(4, 130);
+  wheel.cancel(4);
+  EXPECT_TRUE(wheel.empty());
+}
+
+namespace {
+struct ImmediateOrderManager : public OrderManager {
+  std::vector<std::shared_ptr<Order>> orders;
+  ImmediateOrderManager(std::shared_ptr<logging::thread_safe_logger_t> &logger)
+      : OrderManager(logger) {}
+  void transmit(std::shared_ptr<Order> order) override {
+    orders.push_back(order);
+    order->setTransmitted();
+  }
+  bool hasActiveOrders() override { return false; }
+  std::list<Order *> getFilledOrders() override { return {}; }
+};
+
+struct CountingTrader : public Trader {
+  std::atomic<int> decisions{0};
+  CountingTrader(std::size_t candleSizeSeconds,
+                 std::shared_ptr<DataStream> stream,
+                 std::shared_ptr<OrderManager> orderManager,
+                 std::shared_ptr<logging::thread_safe_logger_t> logger)
+      : Trader(1, candleSizeSeconds, stream, orderManager, logger) {}
+  void decide() override { decisions++; }
+  std::string traderName() const override { return "Counting trader"; }
+  void buy() {
+    executeMarket(InstrumentEnum::MicroNasdaqFutures, 1, OrderDirection::BUY,
+                  [](Order::StatusChangeEvent) {});
+  }
+};
+
+void addBars(DataStream &stream, Timestamp &time, std::size_t count) {
+  std::vector<Bar> bars;
+  for (std::size_t i = 0; i < count; i++) {
+    bars.emplace_back(5, 10, 101, 99, 100, 100, 100, 10, time);
+    time += midas::fromUnixSeconds(5);
+  }
+  stream.addBars(bars.begin(), bars.end());
+}
+
+class TraderSchedulerTest : public ::testing::Test {
+protected:
+  std::shared_ptr<logging::thread_safe_logger_t> logger =
+      std::make_shared<logging::thread_safe_logger_t>(
+          logging::create_channel_logger("Trader Scheduler Test Logger"));
+  std::shared_ptr<ImmediateOrderManager> orderManager =
+      std::make_shared<ImmediateOrderManager>(logger);
+  Timestamp time = midas::fromUnixSeconds(1'699'999'200);
+};
+} // namespace
+
+TEST_F(TraderSchedulerTest, DecidesWhenACandleCloses) {
+  TraderScheduler scheduler(2);
+  auto stream = std::make_shared<DataStream>(5);
+  CountingTrader trader(60, stream, orderManager, logger);
+  const auto registration = scheduler.add(stream, trader);
+
+  addBars(*stream, time, 6);
+  registration->barsAdded();
+  scheduler.wait();
+  EXPECT_EQ(trader.decisions, 0);
+  addBars(*stream, time, 6);
+  registration->barsAdded();
+  scheduler.wait();
+  EXPECT_EQ(trader.decisions, 1);
+  // nothing new
+  registration->barsAdded();
+  scheduler.wait();
+  EXPECT_EQ(trader.decisions, 1);
+
+  trader.buy();
+  scheduler.wait();
+  EXPECT_EQ(trader.decisions, 1);
+  orderManager->orders.front()->setFilled(100, 0, 1);
+  scheduler.wait();
+  EXPECT_EQ(trader.decisions, 2);
+}
+
+TEST_F(TraderSchedulerTest, RunsHundredsOfTradersOnAFewWorkers) {
+  TraderScheduler scheduler(2);
+  std::vector<std::shared_ptr<DataStream>> streams;
+  std::vector<std::unique_ptr<CountingTrader>> traders;
+  std::vector<std::unique_ptr<TraderScheduler::Registration>> registrations;
+  for (int i = 0; i < 300; i++) {
+    streams.push_back(std::make_shared<DataStream>(5));
+    traders.push_back(std::make_unique<CountingTrader>(60, streams.back(),
+                                                       orderManager, logger));
+    registrations.push_back(scheduler.add(streams.back(), *traders.back()));
+  }
+  // bars arrive on another thread while the workers process them
+  std::thread feed([&] {
+    for (int candle = 0; candle < 3; candle++) {
+      for (std::size_t i = 0; i < streams.size(); i++) {
+        Timestamp start = time + midas::fromUnixSeconds(60 * candle);
+        addBars(*streams[i], start, 12);
+        registrations[i]->barsAdded();
+      }
+    }
+  });
+  feed.join();
+  scheduler.wait();
+  for (const auto &trader : traders) {
+    // at most one decision per closed candle
+    EXPECT_GE(trader->decisions, 1);
+    EXPECT_LE(trader->decisions, 3);
+    EXPECT_EQ(trader->closedCandles().second, 3);
+  }
+}
+
+TEST_F(TraderSchedulerTest, DecidesOnStalledFeeds) {
+  TraderScheduler scheduler(1, 0s);
+  auto stream = std::make_shared<DataStream>(1);
+  CountingTrader trader(1, stream, orderManager, logger);
+  const auto registration = scheduler.add(stream, trader);
+  // a deadline passes every second without any bars
+  for (int waited = 0; waited < 30 && trader.decisions == 0; waited++) {
+    std::this_thread::sleep_for(100ms);
+  }
+  EXPECT_GT(trader.decisions, 0);
+}
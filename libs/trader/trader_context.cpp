@@ -1,8 +1,8 @@
 
-
 #include "trader/trader_context.hpp"
 #include "broker-interface/broker.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <thread>
@@ -10,29 +10,58 @@
 
 using namespace std::chrono_literals;
 using namespace midas;
-TradingContext::TradingContext(std::atomic<bool> *stopProcessingPtr) {
-  broker = createIBKRBroker();
-  broker->connect();
+
+// Roughly a day of 5 second bars. Candles are kept by the pyramid, the
+// stream is only read again to rebuild them after a re-order.
+constexpr std::size_t minimumRetainedBars = 17280;
+
+TradingContext::TradingContext(std::atomic<bool> *stopProcessingPtr)
+    : TradingContext(createIBKRBroker(), stopProcessingPtr) {}
+
+TradingContext::TradingContext(std::shared_ptr<midas::Broker> broker,
+                               std::atomic<bool> *stopProcessingPtr)
+    : broker(std::move(broker)),
+      scheduler(std::make_shared<trader::TraderScheduler>()) {
+  this->broker->connect();
   brokerProcessor = std::jthread([this, stopProcessingPtr] {
     while (!stopProcessingPtr->load()) {
-      broker->processCycle();
+      this->broker->processCycle();
     }
   });
-  orderManager = broker->getOrderManager();
+  orderManager = this->broker->getOrderManager();
 }
 
-TraderContext::TraderContext(std::atomic<bool> *stopProcessingPtr,
-                             unsigned int numSecondsHistory,
-                             TradingContext *context,
-                             midas::InstrumentEnum instrument,
-                             int entryQuantity, midas::trader::TraderType type)
-    : streamPtr(new midas::DataStream(5)),
-      trader(midas::trader::createTrader(type, streamPtr, context->orderManager,
-                                            instrument, entryQuantity)) {
-  // Subscribe to data stream
+std::shared_ptr<InstrumentFeed>
+TradingContext::feed(midas::InstrumentEnum instrument,
+                     unsigned int numSecondsHistory) {
+  std::scoped_lock lock(feedsMutex);
+  auto &feed = feeds[instrument];
+  if (!feed) {
+    feed = std::make_shared<InstrumentFeed>(numSecondsHistory, this,
+                                            instrument);
+  }
+  return feed;
+}
+
+InstrumentFeed::InstrumentFeed(unsigned int numSecondsHistory,
+                               TradingContext *context,
+                               midas::InstrumentEnum instrument)
+    : streamPtr(std::make_shared<midas::DataStream>(5)),
+      pyramid(std::make_shared<midas::trader::CandlePyramid>(streamPtr)) {
+  // bound the stream so memory stays flat over long sessions
+  streamPtr->setRetentionPolicy({.retainedBars = minimumRetainedBars,
+                                 .blockSize = 4096,
+                                 .spillDirectory = std::nullopt});
+  // Bars only ever come from the broker thread, so it can hand them over
+  // without contending with the scheduler. The scheduler never waits for
+  // bars, so there is nothing to spin for.
+  streamPtr->setRingIngestPolicy({.capacity = 4096});
   auto subscriptionDataHandler =
       [this]([[maybe_unused]] const midas::Subscription &sub, midas::Bar bar) {
         streamPtr->addBars(bar);
+        // history is processed in one go once it has all arrived, nothing
+        // is connected until then
+        barsAddedSignal();
       };
   historicalSubscription = std::make_shared<midas::Subscription>(
       instrument,
@@ -42,23 +71,46 @@ TraderContext::TraderContext(std::atomic<bool> *stopProcessingPtr,
       false);
   historicalBarConn =
       historicalSubscription->barSignal.connect(subscriptionDataHandler);
-
   historicalEndCon = historicalSubscription->endSignal.connect(
-      [this, context, stopProcessingPtr, subscriptionDataHandler,
+      [this, context, subscriptionDataHandler,
        instrument]([[maybe_unused]] const midas::Subscription &sub) {
+        {
+          std::scoped_lock lock(mutex);
+          historyLoaded = true;
+          historyEndSignal();
+        }
         realtimeSubscription =
             std::make_shared<midas::Subscription>(instrument, false);
         realtimeBarCon =
             realtimeSubscription->barSignal.connect(subscriptionDataHandler);
-
         context->broker->addSubscription(realtimeSubscription);
-        trader->triggerSourceProcessing();
-        streamProcessingThread = std::jthread([stopProcessingPtr, this] {
-          while (!stopProcessingPtr->load()) {
-            streamPtr->waitForData(100ms);
-            trader->decide();
-          }
-        });
       });
   context->broker->addSubscription(historicalSubscription);
-}
\ No newline at end of file
+}
+
+TraderContext::TraderContext(unsigned int numSecondsHistory,
+                             TradingContext *context,
+                             midas::InstrumentEnum instrument,
+                             int entryQuantity, midas::trader::TraderType type)
+    : feed(context->feed(instrument, numSecondsHistory)),
+      scheduler(context->scheduler),
+      trader(midas::trader::createTrader(type, feed->pyramid,
+                                         context->orderManager, instrument,
+                                         entryQuantity)) {
+  std::scoped_lock lock(feed->mutex);
+  if (feed->historyLoaded) {
+    schedule();
+  } else {
+    historyEndCon = feed->historyEndSignal.connect([this] { schedule(); });
+  }
+}
+
+void TraderContext::schedule() {
+  // the bars are processed by the scheduler, other traders of the feed may
+  // already be reading them
+  registration = scheduler->add(feed->streamPtr, *trader);
+  // connected first, so bars added from here on are not missed
+  barsAddedCon =
+      feed->barsAddedSignal.connect([this] { registration->barsAdded(); });
+  registration->barsAdded();
+}
@@ -1,134 +1,60 @@
 #include "trader/trader_data.hpp"
-#include "exceptions/sampling_error.hpp"
-#include <boost/circular_buffer.hpp>
-#include <cstddef>
-#include <execution>
-#include <numeric>
 
-midas::trader::TraderData::TraderData(std::size_t lookBackSize,
-                                      std::size_t candleSizeSeconds,
-                                      std::shared_ptr<DataStream> source)
-    : lookBackSize(lookBackSize), candleSizeSeconds(candleSizeSeconds),
-      downSampleRate(candleSizeSeconds / source->barSizeSeconds),
-      lastReadIndex(0), source(source), tradeCounts(lookBackSize),
-      highs(lookBackSize), lows(lookBackSize), opens(lookBackSize),
-      closes(lookBackSize), vwaps(lookBackSize), volumes(lookBackSize),
-      timestamps(lookBackSize),
-      updateListenerConnection(source->addUpdateListener(
-          std::bind(&TraderData::processSource, this))),
-      reOrderListenerConnection(
-          source->addReOrderListener(std::bind(&TraderData::clear, this))) {
-
-  if (candleSizeSeconds % source->barSizeSeconds != 0) {
-    throw SamplingError(
-        "Requested candle size is not divisible by stream bar size");
+namespace {
+std::shared_ptr<midas::trader::CandlePyramid>
+pyramidFor(std::size_t candleSizeSeconds,
+           const midas::trader::CandleSource &source,
+           midas::trader::TradingSession session) {
+  if (source.pyramid) {
+    return source.pyramid;
   }
+  // a private single level pyramid
+  if (source.replay) {
+    return std::make_shared<midas::trader::CandlePyramid>(
+        source.replay, std::vector<std::size_t>{candleSizeSeconds}, session);
+  }
+  return std::make_shared<midas::trader::CandlePyramid>(
+      source.stream, std::vector<std::size_t>{candleSizeSeconds}, session);
 }
+} // namespace
 
-midas::trader::TraderData::~TraderData() {
-  updateListenerConnection.disconnect();
-  reOrderListenerConnection.disconnect();
-}
+midas::trader::TraderData::TraderData(std::size_t lookBackSize,
+                                      std::size_t candleSizeSeconds,
+                                      const CandleSource &source,
+                                      TradingSession session)
+    : lookBackSize(lookBackSize), candleSizeSeconds(candleSizeSeconds),
+      pyramid(pyramidFor(candleSizeSeconds, source, session)),
+      series(pyramid->subscribe(candleSizeSeconds, lookBackSize)),
+      indicators(pyramid->indicators(candleSizeSeconds)),
+      downSampleRate(candleSizeSeconds / pyramid->barSizeSeconds()) {}
 
 bool midas::trader::TraderData::ok() {
-  std::scoped_lock lock(buffersMutex);
-  // Depends on the vectors being kept at the same
-  return tradeCounts.size() >= lookBackSize && highs.size() >= lookBackSize &&
-         lows.size() >= lookBackSize && opens.size() >= lookBackSize &&
-         closes.size() >= lookBackSize && closes.size() >= lookBackSize &&
-         vwaps.size() >= lookBackSize && volumes.size() >= lookBackSize &&
-         timestamps.size() >= lookBackSize;
+  return snapshot()->size() >= lookBackSize;
 }
 
-void midas::trader::TraderData::clear() {
-  std::scoped_lock lock(buffersMutex);
-  tradeCounts.clear();
-  highs.clear();
-  lows.clear();
-  opens.clear();
-  closes.clear();
-  vwaps.clear();
-  volumes.clear();
-  timestamps.clear();
-  lastReadIndex = 0;
+std::shared_ptr<const midas::trader::CandleSnapshot>
+midas::trader::TraderData::snapshot() const {
+  return lookBack(series->snapshot());
 }
 
-enum class ParallelPolicy { unseq, parallel };
-
-/**
- * We need this to dynamically select an execution policy at runtime
- */
-template <class Func> auto maybeParallel(Func f, ParallelPolicy policy) {
-  switch (policy) {
-  case ParallelPolicy::unseq:
-    return f(std::execution::unseq);
-  default:
-    return f(std::execution::par_unseq);
+std::shared_ptr<const midas::trader::CandleSnapshot>
+midas::trader::TraderData::lookBack(
+    std::shared_ptr<const CandleSnapshot> candles) const {
+  if (candles->size() <= lookBackSize) {
+    return candles;
   }
+  // the level is shared with traders looking further back
+  return std::make_shared<const CandleSnapshot>(candles->last(lookBackSize));
 }
 
-void midas::trader::TraderData::processSource() {
-  std::scoped_lock lock(buffersMutex);
-  const std::ptrdiff_t numCompleteSamples = source->size() / downSampleRate;
-  if (numCompleteSamples == 0) {
-    return;
+std::shared_ptr<const midas::trader::IndicatorSnapshot>
+midas::trader::TraderData::indicatorSnapshot() const {
+  if (indicators->pending()) {
+    pyramid->publishIndicators();
   }
-  const ParallelPolicy executionPolicy =
-      downSampleRate >= 1000 ? ParallelPolicy::parallel : ParallelPolicy::unseq;
-  for (; lastReadIndex + downSampleRate <= source->size();
-       lastReadIndex += downSampleRate) {
-
-    // we preserve low by getting the min of the range
-    const auto lowIterator = maybeParallel(
-        [&](auto &pol) {
-          return std::min_element(pol, source->lows.begin() + lastReadIndex,
-                                  source->lows.begin() + lastReadIndex +
-                                      downSampleRate);
-        },
-        executionPolicy);
-    // we preserve high by getting the max of the range
-    const auto highIterator = maybeParallel(
-        [&](auto &pol) {
-          return std::max_element(pol, source->highs.begin() + lastReadIndex,
-                                  source->highs.begin() + lastReadIndex +
-                                      downSampleRate);
-        },
-        executionPolicy);
-    // trades are just summed
-    const auto tradesSum = maybeParallel(
-        [&](auto &pol) {
-          return std::reduce(pol, source->tradeCounts.begin() + lastReadIndex,
-                             source->tradeCounts.begin() + lastReadIndex +
-                                 downSampleRate);
-        },
-        executionPolicy);
-    // volume is summed as well
-    const auto volumeSum = maybeParallel(
-        [&](auto &pol) {
-          return std::reduce(pol, source->volumes.begin() + lastReadIndex,
-                             source->volumes.begin() + lastReadIndex +
-                                 downSampleRate);
-        },
-        executionPolicy);
-    // WAP is more useful for small time periods, we convert into VWAP by
-    // multiplying waps by volume and dividing by total volume
-    const auto wapSum = std::inner_product(
-        source->waps.begin() + lastReadIndex,
-        source->waps.begin() + lastReadIndex + downSampleRate,
-        source->volumes.begin() + lastReadIndex, 0.0);
+  return indicators->snapshot();
+}
 
-    lows.push_back(*lowIterator);
-    highs.push_back(*highIterator);
-    opens.push_back(source->opens[lastReadIndex]);
-    closes.push_back(source->closes[lastReadIndex + downSampleRate - 1]);
-    tradeCounts.push_back(tradesSum);
-    volumes.push_back(volumeSum);
-    // divide wapSum by total volume to get vwap
-    // Might be zero due to no trades happening in the interval
-    double vwap = (volumeSum != 0) ? (wapSum / volumeSum) : 0.0;
-    vwaps.push_back(vwap);
+void midas::trader::TraderData::processSource() { pyramid->processSource(); }
 
-    timestamps.push_back(
-        source->timestamps[lastReadIndex + downSampleRate - 1]);
-  }
-}
\ No newline at end of file
+void midas::trader::TraderData::clear() { pyramid->clear(); }
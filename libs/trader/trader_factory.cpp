@@ -1,54 +1,119 @@
 #include "trader/momentum_trader.hpp"
 #include "trader/trader.hpp"
 
+#include <trader/coroutine_trader.hpp>
+#include <trader/macd_strategy.hpp>
 #include <trader/macd_trader.hpp>
 #include <trader/mean_reversion_trader.hpp>
+#include <trader/pine_script_trader.hpp>
 using namespace midas::trader;
 using namespace midas;
 std::unique_ptr<midas::trader::Trader> midas::trader::momentumExploit(
-    std::shared_ptr<midas::DataStream> source,
+    const CandleSource &source,
     std::shared_ptr<midas::OrderManager> orderManager,
     InstrumentEnum instrument, std::size_t entryQuantity) {
+  return momentumExploit(source, orderManager, instrument, entryQuantity,
+                         MomentumTrader::defaultParameters);
+}
+
+std::unique_ptr<midas::trader::Trader> midas::trader::momentumExploit(
+    const CandleSource &source,
+    std::shared_ptr<midas::OrderManager> orderManager,
+    InstrumentEnum instrument, std::size_t entryQuantity,
+    const MomentumParameters &parameters) {
   switch (instrument) {
   case InstrumentEnum::TSLA:
   case InstrumentEnum::NVDA:
     return std::make_unique<StockMomentumTrader>(
         source, orderManager, instrument, entryQuantity,
         std::make_shared<logging::thread_safe_logger_t>(
-            logging::create_channel_logger("Momentum Trader " + instrument)));
+            logging::create_channel_logger("Momentum Trader " + instrument)),
+        parameters);
   default:
     return std::make_unique<MomentumTrader>(
         source, orderManager, instrument, entryQuantity,
         std::make_shared<logging::thread_safe_logger_t>(
-            logging::create_channel_logger("Momentum Trader " + instrument)));
+            logging::create_channel_logger("Momentum Trader " + instrument)),
+        parameters);
   }
 }
 
 std::unique_ptr<midas::trader::Trader>
-midas::trader::meanReversion(std::shared_ptr<midas::DataStream> source,
+midas::trader::meanReversion(const CandleSource &source,
                              std::shared_ptr<midas::OrderManager> orderManager,
                              InstrumentEnum instrument,
                              std::size_t entryQuantity) {
+  return meanReversion(source, orderManager, instrument, entryQuantity,
+                       MeanReversionTrader::defaultParameters);
+}
+
+std::unique_ptr<midas::trader::Trader> midas::trader::meanReversion(
+    const CandleSource &source,
+    std::shared_ptr<midas::OrderManager> orderManager,
+    InstrumentEnum instrument, std::size_t entryQuantity,
+    const MeanReversionParameters &parameters) {
   return std::make_unique<MeanReversionTrader>(
       source, orderManager, instrument, entryQuantity,
       std::make_shared<logging::thread_safe_logger_t>(
           logging::create_channel_logger("Mean Reversion Trader " +
-                                         instrument)));
+                                         instrument)),
+      parameters);
 }
 
 std::unique_ptr<Trader>
-midas::trader::macdExploit(std::shared_ptr<DataStream> source,
+midas::trader::macdExploit(const CandleSource &source,
                            std::shared_ptr<midas::OrderManager> orderManager,
                            InstrumentEnum instrument,
                            std::size_t entryQuantity) {
+  return macdExploit(source, orderManager, instrument, entryQuantity,
+                     MacdTrader::defaultParameters);
+}
+
+std::unique_ptr<Trader>
+midas::trader::macdExploit(const CandleSource &source,
+                           std::shared_ptr<midas::OrderManager> orderManager,
+                           InstrumentEnum instrument,
+                           std::size_t entryQuantity,
+                           const MacdParameters &parameters) {
   return std::make_unique<MacdTrader>(
       source, orderManager, instrument, entryQuantity,
       std::make_shared<logging::thread_safe_logger_t>(
-          logging::create_channel_logger("MACD Trader " + instrument)));
+          logging::create_channel_logger("MACD Trader " + instrument)),
+      parameters);
+}
+
+std::unique_ptr<Trader>
+midas::trader::macdCoroutine(const CandleSource &source,
+                             std::shared_ptr<midas::OrderManager> orderManager,
+                             InstrumentEnum instrument,
+                             std::size_t entryQuantity) {
+  auto trader = std::make_unique<CoroutineTrader>(
+      "MACD coroutine trader", macdStrategyLookBack, 120, source, orderManager,
+      instrument,
+      std::make_shared<logging::thread_safe_logger_t>(
+          logging::create_channel_logger("MACD Coroutine Trader " +
+                                         instrument)));
+  trader->spawn(macdStrategy, entryQuantity, MacdTrader::defaultParameters);
+  return trader;
+}
+
+std::unique_ptr<Trader> midas::trader::pineScript(
+    const CandleSource &source,
+    std::shared_ptr<midas::OrderManager> orderManager,
+    InstrumentEnum instrument, std::size_t entryQuantity,
+    std::shared_ptr<const pine::Program> program,
+    std::size_t candleSizeSeconds) {
+  const std::string title = program->title;
+  return std::make_unique<PineScriptTrader>(
+      std::move(program), candleSizeSeconds, source, orderManager, instrument,
+      entryQuantity,
+      std::make_shared<logging::thread_safe_logger_t>(
+          logging::create_channel_logger("Pine Script Trader " + title + " " +
+                                         instrument)));
 }
 
 std::unique_ptr<Trader>
-midas::trader::createTrader(TraderType type, std::shared_ptr<DataStream> source,
+midas::trader::createTrader(TraderType type, const CandleSource &source,
                             std::shared_ptr<midas::OrderManager> orderManager,
                             InstrumentEnum instrument,
                             std::size_t entryQuantity) {
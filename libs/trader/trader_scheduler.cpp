@@ -0,0 +1,181 @@
+#include "trader/trader_scheduler.hpp"
+#include "data/timestamp.hpp"
+#include "timer_wheel.hpp"
+
+#include <exception>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace midas::trader;
+
+namespace {
+// deadlines are whole seconds, a turn covers candles of up to an hour
+constexpr std::size_t deadlineSlots = 4096;
+
+std::int64_t currentSecond() {
+  return midas::utcNow() / midas::nanosPerSecond;
+}
+} // namespace
+
+TraderScheduler::TraderScheduler(std::size_t workers,
+                                 std::chrono::seconds closeGrace)
+    : closeGrace(closeGrace),
+      logger(std::make_shared<logging::thread_safe_logger_t>(
+          logging::create_channel_logger("Trader scheduler"))),
+      arena(static_cast<int>(workers)),
+      deadlines(std::make_unique<TimerWheel>(deadlineSlots, currentSecond())),
+      deadlineThread([this](std::stop_token stop) { expireDeadlines(stop); }) {
+}
+
+TraderScheduler::~TraderScheduler() {
+  deadlineThread.request_stop();
+  deadlineThread.join();
+  wait();
+}
+
+std::unique_ptr<TraderScheduler::Registration>
+TraderScheduler::add(std::shared_ptr<DataStream> stream, Trader &trader) {
+  std::shared_ptr<Scheduled> scheduled;
+  {
+    std::scoped_lock lock(mutex);
+    std::erase_if(streamMutexes,
+                  [](const auto &entry) { return entry.second.expired(); });
+    std::shared_ptr<std::mutex> streamMutex =
+        streamMutexes[stream.get()].lock();
+    if (!streamMutex) {
+      streamMutex = std::make_shared<std::mutex>();
+      streamMutexes[stream.get()] = streamMutex;
+    }
+    scheduled = std::make_shared<Scheduled>(nextId++, std::move(stream),
+                                            std::move(streamMutex), trader);
+    // candles already there have been decided on by whoever drove it before
+    scheduled->decidedOn = trader.closedCandles();
+    traders.emplace(scheduled->id, scheduled);
+    deadlines->arm(scheduled->id, deadlineAfter(currentSecond(), *scheduled));
+  }
+  deadlineCv.notify_all();
+  trader.setOrderEventListener(
+      [this, weak = std::weak_ptr(scheduled)] {
+        if (const auto scheduled = weak.lock()) {
+          notify(scheduled, OrderChanged);
+        }
+      });
+  return std::unique_ptr<Registration>(new Registration(*this, scheduled));
+}
+
+void TraderScheduler::wait() {
+  for (std::size_t running = inFlight.load(); running != 0;
+       running = inFlight.load()) {
+    inFlight.wait(running);
+  }
+}
+
+void TraderScheduler::notify(const std::shared_ptr<Scheduled> &scheduled,
+                             Event event) {
+  const std::uint32_t previous =
+      scheduled->state.fetch_or(event | Queued, std::memory_order::acq_rel);
+  if (previous & Queued) {
+    // the worker holding the trader picks the event up
+    return;
+  }
+  inFlight.fetch_add(1);
+  arena.enqueue([this, scheduled] { run(scheduled); });
+}
+
+void TraderScheduler::run(const std::shared_ptr<Scheduled> &scheduled) {
+  while (true) {
+    const std::uint32_t events =
+        scheduled->state.exchange(Queued, std::memory_order::acq_rel) &
+        ~Queued;
+    if (!scheduled->removed.load(std::memory_order::acquire)) {
+      try {
+        process(*scheduled, events);
+      } catch (const std::exception &e) {
+        ERROR_LOG(*logger) << scheduled->trader.traderName()
+                           << " failed to decide: " << e.what();
+      }
+    }
+    std::uint32_t expected = Queued;
+    // events that came in meanwhile are processed right away
+    if (scheduled->state.compare_exchange_strong(expected, 0,
+                                                 std::memory_order::acq_rel)) {
+      break;
+    }
+  }
+  scheduled->state.notify_all();
+  if (inFlight.fetch_sub(1) == 1) {
+    inFlight.notify_all();
+  }
+}
+
+void TraderScheduler::process(Scheduled &scheduled, std::uint32_t events) {
+  // the stream is drained by a single thread at a time, and the candles
+  // built from it are not read while they are written
+  std::scoped_lock lock(*scheduled.streamMutex);
+  if (events & BarsAdded) {
+    scheduled.stream->waitForData(0ms);
+  }
+  const auto candles = scheduled.trader.closedCandles();
+  const bool candleClosed = scheduled.decidedOn != candles;
+  const bool deadline = events & CandleDeadline;
+  // no candle closed over a whole period
+  const bool stalled = deadline && !scheduled.decidedSinceDeadline;
+  if (deadline) {
+    scheduled.decidedSinceDeadline = false;
+  }
+  if (candleClosed || (events & OrderChanged) || stalled) {
+    scheduled.decidedOn = candles;
+    scheduled.trader.decide();
+    scheduled.decidedSinceDeadline = !deadline;
+  }
+}
+
+void TraderScheduler::remove(Scheduled &scheduled) {
+  scheduled.removed.store(true, std::memory_order::release);
+  {
+    std::scoped_lock lock(mutex);
+    traders.erase(scheduled.id);
+    // the deadline thread stops ticking once no trader is left
+    deadlines->cancel(scheduled.id);
+  }
+  for (std::uint32_t state = scheduled.state.load(); state & Queued;
+       state = scheduled.state.load()) {
+    scheduled.state.wait(state);
+  }
+}
+
+std::int64_t TraderScheduler::deadlineAfter(std::int64_t now,
+                                            const Scheduled &scheduled) const {
+  const auto candleSize =
+      static_cast<std::int64_t>(scheduled.trader.candleSizeSeconds());
+  return (now / candleSize + 1) * candleSize + closeGrace.count();
+}
+
+void TraderScheduler::expireDeadlines(std::stop_token stop) {
+  std::vector<TimerWheel::Timer> expired;
+  std::unique_lock lock(mutex);
+  while (!stop.stop_requested()) {
+    if (deadlines->empty()) {
+      deadlineCv.wait(lock, stop, [this] { return !deadlines->empty(); });
+      continue;
+    }
+    const auto nextTick = std::chrono::system_clock::time_point(
+        std::chrono::seconds(deadlines->current() + 1));
+    if (deadlineCv.wait_until(lock, stop, nextTick, [] { return false; });
+        stop.stop_requested()) {
+      break;
+    }
+    const std::int64_t now = currentSecond();
+    expired.clear();
+    deadlines->advance(now, expired);
+    for (const TimerWheel::Timer &timer : expired) {
+      const auto found = traders.find(timer.id);
+      if (found == traders.end()) {
+        // removed since
+        continue;
+      }
+      deadlines->arm(timer.id, deadlineAfter(now, *found->second));
+      notify(found->second, CandleDeadline);
+    }
+  }
+}